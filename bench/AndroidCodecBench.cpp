@@ -12,12 +12,15 @@
 #include "SkCommandLineFlags.h"
 #include "SkOSFile.h"
 
-AndroidCodecBench::AndroidCodecBench(SkString baseName, SkData* encoded, int sampleSize)
+AndroidCodecBench::AndroidCodecBench(SkString baseName, SkData* encoded, int sampleSize,
+                                     bool areaAverage)
     : fData(SkRef(encoded))
     , fSampleSize(sampleSize)
+    , fAreaAverage(areaAverage)
 {
     // Parse filename and the color type to give the benchmark a useful name
-    fName.printf("AndroidCodec_%s_SampleSize%d", baseName.c_str(), sampleSize);
+    fName.printf("AndroidCodec_%s_SampleSize%d%s", baseName.c_str(), sampleSize,
+                 areaAverage ? "_AreaAverage" : "");
 }
 
 const char* AndroidCodecBench::onGetName() {
@@ -45,6 +48,7 @@ void AndroidCodecBench::onDraw(int n, SkCanvas* canvas) {
     std::unique_ptr<SkAndroidCodec> codec;
     SkAndroidCodec::AndroidOptions options;
     options.fSampleSize = fSampleSize;
+    options.fAreaAverage = fAreaAverage;
     for (int i = 0; i < n; i++) {
         codec = SkAndroidCodec::MakeFromData(fData);
 #ifdef SK_DEBUG
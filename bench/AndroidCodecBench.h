@@ -21,7 +21,9 @@
 class AndroidCodecBench : public Benchmark {
 public:
     // Calls encoded->ref()
-    AndroidCodecBench(SkString basename, SkData* encoded, int sampleSize);
+    // If areaAverage, decodes to the same size with AndroidOptions::fAreaAverage.
+    AndroidCodecBench(SkString basename, SkData* encoded, int sampleSize,
+                      bool areaAverage = false);
 
 protected:
     const char* onGetName() override;
@@ -33,6 +35,7 @@ private:
     SkString                fName;
     sk_sp<SkData>           fData;
     const int               fSampleSize;
+    const bool              fAreaAverage;
     SkImageInfo             fInfo;          // Set in onDelayedSetup.
     SkAutoMalloc            fPixelStorage;  // Set in onDelayedSetup.
     typedef Benchmark INHERITED;
@@ -8,15 +8,17 @@
 #include "BitmapRegionDecoderBench.h"
 #include "CodecBenchPriv.h"
 #include "SkBitmap.h"
+#include "SkCodec.h"
 #include "SkOSFile.h"
 
 BitmapRegionDecoderBench::BitmapRegionDecoderBench(const char* baseName, SkData* encoded,
-        SkColorType colorType, uint32_t sampleSize, const SkIRect& subset)
+        SkColorType colorType, uint32_t sampleSize, const SkIRect& subset, bool useRegionIndex)
     : fBRD(nullptr)
     , fData(SkRef(encoded))
     , fColorType(colorType)
     , fSampleSize(sampleSize)
     , fSubset(subset)
+    , fUseRegionIndex(useRegionIndex)
 {
     // Choose a useful name for the color type
     const char* colorName = color_type_to_str(colorType);
@@ -25,6 +27,9 @@ BitmapRegionDecoderBench::BitmapRegionDecoderBench(const char* baseName, SkData*
     if (1 != sampleSize) {
         fName.appendf("_%.3f", 1.0f / (float) sampleSize);
     }
+    if (useRegionIndex) {
+        fName.append("_indexed");
+    }
 }
 
 const char* BitmapRegionDecoderBench::onGetName() {
@@ -36,10 +41,36 @@ bool BitmapRegionDecoderBench::isSuitableFor(Backend backend) {
 }
 
 void BitmapRegionDecoderBench::onDelayedSetup() {
+    if (fUseRegionIndex) {
+        sk_sp<SkData> index = SkCodec::MakeFromData(fData)->makeRegionIndex();
+        std::unique_ptr<SkCodec> codec = SkCodec::MakeFromData(fData);
+        SkAssertResult(index && codec->setRegionIndex(*index));
+        fIndexedCodec = SkAndroidCodec::MakeFromCodec(std::move(codec));
+        return;
+    }
     fBRD.reset(SkBitmapRegionDecoder::Create(fData, SkBitmapRegionDecoder::kAndroidCodec_Strategy));
 }
 
 void BitmapRegionDecoderBench::onDraw(int n, SkCanvas* canvas) {
+    if (fIndexedCodec) {
+        SkISize size = fIndexedCodec->getSampledSubsetDimensions(fSampleSize, fSubset);
+        SkImageInfo info = fIndexedCodec->getInfo().makeWH(size.width(), size.height())
+                .makeColorType(fIndexedCodec->computeOutputColorType(fColorType))
+                .makeAlphaType(fIndexedCodec->computeOutputAlphaType(false));
+        info = info.makeColorSpace(
+                fIndexedCodec->computeOutputColorSpace(info.colorType(), nullptr));
+        SkIRect subset = fSubset;
+        SkAndroidCodec::AndroidOptions options;
+        options.fSampleSize = fSampleSize;
+        options.fSubset = &subset;
+        for (int i = 0; i < n; i++) {
+            SkBitmap bm;
+            bm.allocPixels(info);
+            SkAssertResult(SkCodec::kSuccess == fIndexedCodec->getAndroidPixels(
+                    info, bm.getPixels(), bm.rowBytes(), &options));
+        }
+        return;
+    }
     auto ct = fBRD->computeOutputColorType(fColorType);
     auto cs = fBRD->computeOutputColorSpace(ct, nullptr);
     for (int i = 0; i < n; i++) {
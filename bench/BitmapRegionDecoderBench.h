@@ -9,6 +9,7 @@
 #define BitmapRegionDecoderBench_DEFINED
 
 #include "Benchmark.h"
+#include "SkAndroidCodec.h"
 #include "SkBitmapRegionDecoder.h"
 #include "SkData.h"
 #include "SkImageInfo.h"
@@ -20,12 +21,15 @@
  *
  *  nanobench.cpp handles creating benchmarks for interesting scaled subsets.  We strive to test
  *  on real use cases.
+ *
+ *  With useRegionIndex, the codec is given a region index made ahead of time, as a tile server
+ *  would keep next to the encoded data.
  */
 class BitmapRegionDecoderBench : public Benchmark {
 public:
     // Calls encoded->ref()
     BitmapRegionDecoderBench(const char* basename, SkData* encoded, SkColorType colorType,
-            uint32_t sampleSize, const SkIRect& subset);
+            uint32_t sampleSize, const SkIRect& subset, bool useRegionIndex = false);
 
 protected:
     const char* onGetName() override;
@@ -36,10 +40,12 @@ protected:
 private:
     SkString                                       fName;
     std::unique_ptr<SkBitmapRegionDecoder>         fBRD;
+    std::unique_ptr<SkAndroidCodec>                fIndexedCodec;
     sk_sp<SkData>                                  fData;
     const SkColorType                              fColorType;
     const uint32_t                                 fSampleSize;
     const SkIRect                                  fSubset;
+    const bool                                     fUseRegionIndex;
     typedef Benchmark INHERITED;
 };
 #endif // BitmapRegionDecoderBench_DEFINED
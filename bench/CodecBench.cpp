@@ -10,24 +10,31 @@
 #include "SkBitmap.h"
 #include "SkCodec.h"
 #include "SkCommandLineFlags.h"
+#include "SkExecutor.h"
 #include "SkOSFile.h"
 
 // Actually zeroing the memory would throw off timing, so we just lie.
 DEFINE_bool(zero_init, false, "Pretend our destination is zero-intialized, simulating Android?");
 
 CodecBench::CodecBench(SkString baseName, SkData* encoded, SkColorType colorType,
-        SkAlphaType alphaType)
+        SkAlphaType alphaType, int parallelThreads)
     : fColorType(colorType)
     , fAlphaType(alphaType)
     , fData(SkRef(encoded))
+    , fParallelThreads(parallelThreads)
 {
     // Parse filename and the color type to give the benchmark a useful name
     fName.printf("Codec_%s_%s%s", baseName.c_str(), color_type_to_str(colorType),
             alpha_type_to_str(alphaType));
+    if (parallelThreads > 0) {
+        fName.appendf("_threads_%d", parallelThreads);
+    }
     // Ensure that we can create an SkCodec from this data.
     SkASSERT(SkCodec::MakeFromData(fData));
 }
 
+CodecBench::~CodecBench() {}
+
 const char* CodecBench::onGetName() {
     return fName.c_str();
 }
@@ -44,6 +51,10 @@ void CodecBench::onDelayedSetup() {
                             .makeColorSpace(nullptr);
 
     fPixelStorage.reset(fInfo.computeMinByteSize());
+
+    if (fParallelThreads > 0) {
+        fExecutor = SkExecutor::MakeFIFOThreadPool(fParallelThreads);
+    }
 }
 
 void CodecBench::onDraw(int n, SkCanvas* canvas) {
@@ -52,6 +63,7 @@ void CodecBench::onDraw(int n, SkCanvas* canvas) {
     if (FLAGS_zero_init) {
         options.fZeroInitialized = SkCodec::kYes_ZeroInitialized;
     }
+    options.fExecutor = fExecutor.get();
     for (int i = 0; i < n; i++) {
         codec = SkCodec::MakeFromData(fData);
 #ifdef SK_DEBUG
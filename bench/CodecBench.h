@@ -15,13 +15,21 @@
 #include "SkRefCnt.h"
 #include "SkString.h"
 
+#include <memory>
+
+class SkExecutor;
+
 /**
  *  Time SkCodec.
+ *
+ *  With parallelThreads > 0, getPixels() is given an executor with that many threads.
  */
 class CodecBench : public Benchmark {
 public:
     // Calls encoded->ref()
-    CodecBench(SkString basename, SkData* encoded, SkColorType colorType, SkAlphaType alphaType);
+    CodecBench(SkString basename, SkData* encoded, SkColorType colorType, SkAlphaType alphaType,
+               int parallelThreads = 0);
+    ~CodecBench() override;
 
 protected:
     const char* onGetName() override;
@@ -36,6 +44,8 @@ private:
     sk_sp<SkData>           fData;
     SkImageInfo             fInfo;          // Set in onDelayedSetup.
     SkAutoMalloc            fPixelStorage;
+    const int               fParallelThreads;
+    std::unique_ptr<SkExecutor> fExecutor;
     typedef Benchmark INHERITED;
 };
 #endif // CodecBench_DEFINED
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "DDLSKPBench.h"
+#include "DDLTileHelper.h"
+#include "SkCanvas.h"
+#include "SkExecutor.h"
+#include "SkImage.h"
+#include "SkSurface.h"
+
+#include "GrContext.h"
+
+DDLSKPBench::DDLSKPBench(const char* name, const SkPicture* pic, const SkIRect& clip,
+                         int numDivisions, int recordThreads, Mode mode)
+    : fPic(SkRef(pic))
+    , fClip(clip)
+    , fNumDivisions(numDivisions)
+    , fRecordThreads(recordThreads)
+    , fMode(mode)
+    , fName(name) {
+    fUniqueName.printf("%s_ddl_%s_%dx%d_threads_%d", name,
+                       Mode::kRecord == mode ? "record" : "record_draw",
+                       numDivisions, numDivisions, recordThreads);
+}
+
+DDLSKPBench::~DDLSKPBench() {}
+
+const char* DDLSKPBench::onGetName() {
+    return fName.c_str();
+}
+
+const char* DDLSKPBench::onGetUniqueName() {
+    return fUniqueName.c_str();
+}
+
+bool DDLSKPBench::isSuitableFor(Backend backend) {
+    return backend == kGPU_Backend;
+}
+
+SkIPoint DDLSKPBench::onGetSize() {
+    return SkIPoint::Make(fClip.width(), fClip.height());
+}
+
+void DDLSKPBench::onPerCanvasPreDraw(SkCanvas* canvas) {
+    GrContext* context = canvas->getGrContext();
+    SkASSERT(context);
+
+    fExecutor = SkExecutor::MakeFIFOThreadPool(fRecordThreads);
+    fCompressedPicture = fPromiseImageHelper.deflateSKP(fPic.get());
+    if (!fCompressedPicture) {
+        return;
+    }
+    fPromiseImageHelper.uploadAllToGPU(context);
+
+    // The tiles cover the top left of the picture, the size of the clip.
+    fTiles.reset(new DDLTileHelper(canvas, SkIRect::MakeWH(fClip.width(), fClip.height()),
+                                   fNumDivisions));
+    fTiles->createSKPPerTile(fCompressedPicture.get(), fPromiseImageHelper);
+    fDrawTime = 0;
+    fDrawLoops = 0;
+}
+
+void DDLSKPBench::onPerCanvasPostDraw(SkCanvas* canvas) {
+    if (fTiles && Mode::kRecordAndDraw == fMode) {
+        // Show the last frame in the master canvas in case we're saving the images.
+        fTiles->composeAllTiles(canvas);
+    }
+    fTiles.reset();
+    fCompressedPicture.reset();
+    fPromiseImageHelper.reset();
+    fExecutor.reset();
+}
+
+void DDLSKPBench::onDraw(int loops, SkCanvas* canvas) {
+    if (!fTiles) {
+        return;
+    }
+    for (int i = 0; i < loops; ++i) {
+        if (Mode::kRecord == fMode) {
+            fTiles->createDDLsInParallel(fExecutor.get());
+        } else {
+            double drawTime;
+            fTiles->createAndDrawDDLsConcurrently(fExecutor.get(), canvas->getGrContext(), true,
+                                                  &drawTime);
+            fDrawTime += drawTime;
+            fDrawLoops++;
+        }
+        // DDLs can't be drawn twice, so each loop records them again.
+        fTiles->resetAllTiles();
+    }
+}
+
+void DDLSKPBench::getGpuStats(SkCanvas*, SkTArray<SkString>* keys, SkTArray<double>* values) {
+    if (fDrawLoops > 0) {
+        keys->push_back(SkString("ddl_draw_ms"));
+        values->push_back(fDrawTime * 1000 / fDrawLoops);
+    }
+}
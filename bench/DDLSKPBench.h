@@ -0,0 +1,69 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef DDLSKPBench_DEFINED
+#define DDLSKPBench_DEFINED
+
+#include "Benchmark.h"
+#include "DDLPromiseImageHelper.h"
+#include "SkPicture.h"
+
+#include <memory>
+
+class DDLTileHelper;
+class SkData;
+class SkExecutor;
+
+/**
+ * Records an SkPicture into a DDL per tile on a pool of threads, as Chrome would with OOP-R.
+ * With kRecord, only the recording is timed. With kRecordAndDraw, this thread also draws each
+ * DDL into its tile as soon as it has been recorded, and then flushes, so that the time is that
+ * of a whole frame. That mode reports the time spent drawing as a GPU stat. GPU only.
+ */
+class DDLSKPBench : public Benchmark {
+public:
+    enum class Mode {
+        kRecord,
+        kRecordAndDraw,
+    };
+
+    DDLSKPBench(const char* name, const SkPicture*, const SkIRect& devClip, int numDivisions,
+                int recordThreads, Mode);
+    ~DDLSKPBench() override;
+
+    void getGpuStats(SkCanvas*, SkTArray<SkString>* keys, SkTArray<double>* values) override;
+
+protected:
+    const char* onGetName() override;
+    const char* onGetUniqueName() override;
+    void onPerCanvasPreDraw(SkCanvas*) override;
+    void onPerCanvasPostDraw(SkCanvas*) override;
+    bool isSuitableFor(Backend backend) override;
+    void onDraw(int loops, SkCanvas* canvas) override;
+    SkIPoint onGetSize() override;
+
+private:
+    sk_sp<const SkPicture> fPic;
+    const SkIRect fClip;
+    const int fNumDivisions;
+    const int fRecordThreads;
+    const Mode fMode;
+    SkString fName;
+    SkString fUniqueName;
+
+    std::unique_ptr<SkExecutor> fExecutor;
+    DDLPromiseImageHelper fPromiseImageHelper;
+    sk_sp<SkData> fCompressedPicture;
+    std::unique_ptr<DDLTileHelper> fTiles;
+
+    double fDrawTime = 0;   // In seconds, over fDrawLoops loops.
+    int fDrawLoops = 0;
+
+    typedef Benchmark INHERITED;
+};
+
+#endif
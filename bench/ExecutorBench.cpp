@@ -0,0 +1,94 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Benchmark.h"
+#include "SkExecutor.h"
+#include "SkString.h"
+#include "SkTaskGroup.h"
+#include <atomic>
+
+// Pushes many tiny tasks through an SkTaskGroup to measure the executor's own overhead.
+// With fanout > 0, each task spawns fanout more tasks from the worker thread and waits on them,
+// the pattern that lets a work-stealing pool keep work local to the thread that made it.
+class ExecutorBench : public Benchmark {
+public:
+    enum Pool { kFIFO, kLIFO, kWorkStealing };
+
+    ExecutorBench(Pool pool, int tasks, int fanout, bool batched)
+        : fPool(pool)
+        , fTasks(tasks)
+        , fFanout(fanout)
+        , fBatched(batched) {
+        static const char* kNames[] = { "fifo", "lifo", "worksteal" };
+        fName.printf("executor_%s_%d_%d%s", kNames[pool], tasks, fanout, batched ? "_batch" : "");
+    }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+
+    void onDelayedSetup() override {
+        switch (fPool) {
+            case kFIFO:         fExecutor = SkExecutor::MakeFIFOThreadPool();   break;
+            case kLIFO:         fExecutor = SkExecutor::MakeLIFOThreadPool();   break;
+            case kWorkStealing: fExecutor = SkExecutor::MakeWorkStealingPool(); break;
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        std::atomic<int> count{0};
+        for (int i = 0; i < loops; i++) {
+            SkTaskGroup group(*fExecutor);
+            this->spawn(&group, fTasks, [&] {
+                if (fFanout > 0) {
+                    SkTaskGroup inner(*fExecutor);
+                    this->spawn(&inner, fFanout, [&] {
+                        count.fetch_add(1, std::memory_order_relaxed);
+                    });
+                    inner.wait();
+                }
+                count.fetch_add(1, std::memory_order_relaxed);
+            });
+            group.wait();
+        }
+        SkASSERT(count.load() == loops * fTasks * (1 + fFanout));
+    }
+
+private:
+    // The tasks may run after spawn() returns, so they each keep their own copy of fn.
+    void spawn(SkTaskGroup* group, int N, const std::function<void(void)>& fn) {
+        if (fBatched) {
+            group->batch(N, [fn](int) { fn(); });
+        } else {
+            for (int i = 0; i < N; i++) {
+                group->add([fn] { fn(); });
+            }
+        }
+    }
+
+    Pool                        fPool;
+    int                         fTasks;
+    int                         fFanout;
+    bool                        fBatched;
+    SkString                    fName;
+    std::unique_ptr<SkExecutor> fExecutor;
+
+    typedef Benchmark INHERITED;
+};
+
+#define EXECUTOR_BENCHES(tasks, fanout, batched)                                                 \
+    DEF_BENCH(return new ExecutorBench(ExecutorBench::kFIFO,         tasks, fanout, batched);)  \
+    DEF_BENCH(return new ExecutorBench(ExecutorBench::kLIFO,         tasks, fanout, batched);)  \
+    DEF_BENCH(return new ExecutorBench(ExecutorBench::kWorkStealing, tasks, fanout, batched);)
+
+EXECUTOR_BENCHES(1000,  0, false)
+EXECUTOR_BENCHES(1000,  0, true)
+EXECUTOR_BENCHES( 100, 16, false)
+EXECUTOR_BENCHES( 100, 16, true)
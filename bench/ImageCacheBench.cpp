@@ -6,7 +6,9 @@
  */
 
 #include "Benchmark.h"
+#include "SkExecutor.h"
 #include "SkResourceCache.h"
+#include "SkTaskGroup.h"
 
 namespace {
 static void* gGlobalAddress;
@@ -72,6 +74,70 @@ private:
     typedef Benchmark INHERITED;
 };
 
+// Several threads finding (and so re-ordering) recs in the global cache at once, the way
+// threaded rasterization uses it.  With enough shards this should scale with the thread count.
+class ImageCacheThreadedBench : public Benchmark {
+    enum {
+        CACHE_COUNT = 500
+    };
+public:
+    ImageCacheThreadedBench(int threads, int shards) : fThreads(threads), fShards(shards) {
+        fName.printf("imagecache_threaded_%d_shards_%d", threads, shards);
+    }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+
+    void onDelayedSetup() override {
+        fExecutor = SkExecutor::MakeFIFOThreadPool(fThreads);
+    }
+
+    void onPreDraw(SkCanvas*) override {
+        fPrevShards = SkResourceCache::SetShardCount(fShards);
+        for (int i = 0; i < CACHE_COUNT; ++i) {
+            SkResourceCache::Add(new TestRec(TestKey(i), i));
+        }
+    }
+
+    void onPostDraw(SkCanvas*) override {
+        SkResourceCache::SetShardCount(fPrevShards);
+        SkResourceCache::PurgeAll();
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        SkTaskGroup(*fExecutor).batch(fThreads, [&](int thread) {
+            for (int i = 0; i < loops; ++i) {
+                TestKey key((thread * 31 + i * 7) % CACHE_COUNT);
+                SkResourceCache::Find(key, TestRec::Visitor, nullptr);
+            }
+        });
+    }
+
+private:
+    std::unique_ptr<SkExecutor> fExecutor;
+    SkString                    fName;
+    const int                   fThreads;
+    const int                   fShards;
+    int                         fPrevShards = 1;
+
+    typedef Benchmark INHERITED;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 DEF_BENCH( return new ImageCacheBench(); )
+
+#define IMAGE_CACHE_THREADED_BENCHES(threads)                                   \
+    DEF_BENCH( return new ImageCacheThreadedBench(threads, 1); )                \
+    DEF_BENCH( return new ImageCacheThreadedBench(threads, 16); )
+
+IMAGE_CACHE_THREADED_BENCHES(1)
+IMAGE_CACHE_THREADED_BENCHES(2)
+IMAGE_CACHE_THREADED_BENCHES(4)
+IMAGE_CACHE_THREADED_BENCHES(8)
+IMAGE_CACHE_THREADED_BENCHES(16)
+IMAGE_CACHE_THREADED_BENCHES(32)
@@ -6,6 +6,7 @@
  */
 
 #include "Benchmark.h"
+#include "SkExecutor.h"
 #include "SkPath.h"
 #include "SkPathOps.h"
 #include "SkRandom.h"
@@ -51,9 +52,11 @@ private:
 class PathOpsSimplifyBench : public Benchmark {
     SkString    fName;
     SkPath      fPath;
+    int         fRepeat;
 
 public:
-    PathOpsSimplifyBench(const char suffix[], const SkPath& path) : fPath(path) {
+    PathOpsSimplifyBench(const char suffix[], const SkPath& path, int repeat = 100)
+        : fPath(path), fRepeat(repeat) {
         fName.printf("pathops_simplify_%s", suffix);
     }
 
@@ -68,7 +71,7 @@ protected:
 
     void onDraw(int loops, SkCanvas* canvas) override {
         for (int i = 0; i < loops; i++) {
-            for (int j = 0; j < 100; ++j) {
+            for (int j = 0; j < fRepeat; ++j) {
                 SkPath result;
                 Simplify(fPath, &result);
             }
@@ -96,3 +99,93 @@ static SkPath makerects() {
 }
 
 DEF_BENCH( return new PathOpsSimplifyBench("rects", makerects()); )
+
+// A closed polygon with many edges, like the outline of a country or a lake.
+static SkPath make_outline(SkRandom* rand, int points) {
+    const SkScalar cx = rand->nextRangeScalar(0, 1000);
+    const SkScalar cy = rand->nextRangeScalar(0, 1000);
+    SkPath path;
+    for (int i = 0; i < points; ++i) {
+        const SkScalar angle = i * 2 * SK_ScalarPI / points;
+        const SkScalar radius = 60 * (0.8f + 0.2f * rand->nextUScalar1());
+        const SkPoint pt = {cx + radius * SkScalarCos(angle), cy + radius * SkScalarSin(angle)};
+        if (i) {
+            path.lineTo(pt);
+        } else {
+            path.moveTo(pt);
+        }
+    }
+    path.close();
+    return path;
+}
+
+static SkPath make_outlines(int count, int points) {
+    SkRandom rand;
+    SkPath path;
+    for (int i = 0; i < count; ++i) {
+        path.addPath(make_outline(&rand, points));
+    }
+    return path;
+}
+
+DEF_BENCH( return new PathOpsSimplifyBench("outlines_100x200", make_outlines(100, 200), 1); )
+DEF_BENCH( return new PathOpsSimplifyBench("outlines_20x2000", make_outlines(20, 2000), 1); )
+
+// Unions many outlines with SkOpBuilder, either one at a time, or in a tree of ops, optionally
+// on a thread pool.
+class PathOpsBuilderBench : public Benchmark {
+    SkString                    fName;
+    SkTArray<SkPath>            fPaths;
+    bool                        fTree;
+    int                         fThreads;
+    std::unique_ptr<SkExecutor> fExecutor;
+
+public:
+    PathOpsBuilderBench(bool tree, int threads) : fTree(tree), fThreads(threads) {
+        fName.printf("pathops_builder_outlines%s", tree ? "_tree" : "");
+        if (threads > 0) {
+            fName.appendf("_threads_%d", threads);
+        }
+    }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+
+protected:
+    const char* onGetName() override {
+        return fName.c_str();
+    }
+
+    void onDelayedSetup() override {
+        SkRandom rand;
+        for (int i = 0; i < 100; ++i) {
+            fPaths.push_back(make_outline(&rand, 200));
+        }
+        if (fThreads > 0) {
+            fExecutor = SkExecutor::MakeFIFOThreadPool(fThreads);
+        }
+    }
+
+    void onDraw(int loops, SkCanvas* canvas) override {
+        for (int i = 0; i < loops; i++) {
+            SkOpBuilder builder;
+            for (const SkPath& path : fPaths) {
+                builder.add(path, kUnion_SkPathOp);
+            }
+            SkPath result;
+            if (fTree) {
+                builder.resolve(&result, fExecutor.get());
+            } else {
+                builder.resolve(&result);
+            }
+        }
+    }
+
+private:
+    typedef Benchmark INHERITED;
+};
+
+DEF_BENCH( return new PathOpsBuilderBench(false, 0); )
+DEF_BENCH( return new PathOpsBuilderBench(true, 0); )
+DEF_BENCH( return new PathOpsBuilderBench(true, 4); )
@@ -69,9 +69,11 @@ void RecordingBench::onDraw(int loops, SkCanvas*) {
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 #include "SkSerialProcs.h"
 
-DeserializePictureBench::DeserializePictureBench(const char* name, sk_sp<SkData> data)
+DeserializePictureBench::DeserializePictureBench(const char* name, sk_sp<SkData> data,
+                                                 bool mapped)
     : fName(name)
     , fEncodedPicture(std::move(data))
+    , fMapped(mapped)
 {}
 
 const char* DeserializePictureBench::onGetName() {
@@ -88,6 +90,10 @@ SkIPoint DeserializePictureBench::onGetSize() {
 
 void DeserializePictureBench::onDraw(int loops, SkCanvas*) {
     for (int i = 0; i < loops; ++i) {
-        SkPicture::MakeFromData(fEncodedPicture.get());
+        if (fMapped) {
+            SkPicture::MakeLazyFromData(fEncodedPicture);
+        } else {
+            SkPicture::MakeFromData(fEncodedPicture.get());
+        }
     }
 }
@@ -44,7 +44,9 @@ private:
 
 class DeserializePictureBench : public Benchmark {
 public:
-    DeserializePictureBench(const char* name, sk_sp<SkData> encodedPicture);
+    // If mapped, encodedPicture is from SkPicture::serializeMappable(), and is loaded with
+    // SkPicture::MakeLazyFromData().
+    DeserializePictureBench(const char* name, sk_sp<SkData> encodedPicture, bool mapped = false);
 
 protected:
     const char* onGetName() override;
@@ -55,6 +57,7 @@ protected:
 private:
     SkString      fName;
     sk_sp<SkData> fEncodedPicture;
+    bool          fMapped;
 
     typedef Benchmark INHERITED;
 };
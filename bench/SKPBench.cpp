@@ -7,6 +7,7 @@
 
 #include "SKPBench.h"
 #include "SkCommandLineFlags.h"
+#include "SkExecutor.h"
 #include "SkMultiPictureDraw.h"
 #include "SkSurface.h"
 
@@ -21,17 +22,21 @@ DEFINE_int32(GPUbenchTileW, 1600, "Tile width  used for GPU SKP playback.");
 DEFINE_int32(GPUbenchTileH, 512, "Tile height used for GPU SKP playback.");
 
 SKPBench::SKPBench(const char* name, const SkPicture* pic, const SkIRect& clip, SkScalar scale,
-                   bool useMultiPictureDraw, bool doLooping)
+                   bool useMultiPictureDraw, bool doLooping, int parallelThreads)
     : fPic(SkRef(pic))
     , fClip(clip)
     , fScale(scale)
     , fName(name)
     , fUseMultiPictureDraw(useMultiPictureDraw)
-    , fDoLooping(doLooping) {
+    , fDoLooping(doLooping)
+    , fParallelThreads(parallelThreads) {
     fUniqueName.printf("%s_%.2g", name, scale);  // Scale makes this unqiue for perf.skia.org traces.
     if (useMultiPictureDraw) {
         fUniqueName.append("_mpd");
     }
+    if (parallelThreads > 0) {
+        fUniqueName.appendf("_threads_%d", parallelThreads);
+    }
 }
 
 SKPBench::~SKPBench() {
@@ -65,6 +70,10 @@ void SKPBench::onPerCanvasPreDraw(SkCanvas* canvas) {
     fSurfaces.reserve(xTiles * yTiles);
     fTileRects.setReserve(xTiles * yTiles);
 
+    if (fParallelThreads > 0) {
+        fExecutor = SkExecutor::MakeFIFOThreadPool(fParallelThreads);
+    }
+
     SkImageInfo ii = canvas->imageInfo().makeWH(tileW, tileH);
 
     for (int y = bounds.fTop; y < bounds.fBottom; y += tileH) {
@@ -96,9 +105,13 @@ void SKPBench::onPerCanvasPostDraw(SkCanvas* canvas) {
 
     fSurfaces.reset();
     fTileRects.rewind();
+    fExecutor.reset();
 }
 
 bool SKPBench::isSuitableFor(Backend backend) {
+    if (fParallelThreads > 0) {
+        return backend == kRaster_Backend;
+    }
     return backend != kNonRendering_Backend;
 }
 
@@ -111,6 +124,8 @@ void SKPBench::onDraw(int loops, SkCanvas* canvas) {
     while (1) {
         if (fUseMultiPictureDraw) {
             this->drawMPDPicture();
+        } else if (fParallelThreads > 0) {
+            this->drawParallelPicture();
         } else {
             this->drawPicture();
         }
@@ -150,6 +165,23 @@ void SKPBench::drawPicture() {
     }
 }
 
+void SKPBench::drawParallelPicture() {
+    // The same tiles as drawPicture(), but all at once.
+    for (int j = 0; j < fTileRects.count(); ++j) {
+        SkCanvas* canvas = fSurfaces[j]->getCanvas();
+        canvas->save();
+        canvas->translate(-fTileRects[j].fLeft / fScale, -fTileRects[j].fTop / fScale);
+    }
+
+    fPic->playbackParallel(fTileRects.count(),
+                           [this](int j) { return fSurfaces[j]->getCanvas(); },
+                           fExecutor.get());
+
+    for (int j = 0; j < fTileRects.count(); ++j) {
+        fSurfaces[j]->getCanvas()->restore();
+    }
+}
+
 #include "GrGpu.h"
 static void draw_pic_for_stats(SkCanvas* canvas, GrContext* context, const SkPicture* picture,
                                SkTArray<SkString>* keys, SkTArray<double>* values,
@@ -13,15 +13,18 @@
 #include "SkPicture.h"
 #include "SkTDArray.h"
 
+class SkExecutor;
 class SkSurface;
 
 /**
  * Runs an SkPicture as a benchmark by repeatedly drawing it scaled inside a device clip.
+ * With parallelThreads > 0, the tiles are drawn at once with SkPicture::playbackParallel()
+ * on a pool of that many threads (raster only).
  */
 class SKPBench : public Benchmark {
 public:
     SKPBench(const char* name, const SkPicture*, const SkIRect& devClip, SkScalar scale,
-             bool useMultiPictureDraw, bool doLooping);
+             bool useMultiPictureDraw, bool doLooping, int parallelThreads = 0);
     ~SKPBench() override;
 
     int calculateLoops(int defaultLoops) const override {
@@ -41,6 +44,7 @@ protected:
 
     virtual void drawMPDPicture();
     virtual void drawPicture();
+    void drawParallelPicture();
 
     const SkPicture* picture() const { return fPic.get(); }
     const SkTArray<sk_sp<SkSurface>>& surfaces() const { return fSurfaces; }
@@ -59,6 +63,9 @@ private:
 
     const bool fDoLooping;
 
+    const int fParallelThreads;
+    std::unique_ptr<SkExecutor> fExecutor;
+
     typedef Benchmark INHERITED;
 };
 
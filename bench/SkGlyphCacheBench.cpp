@@ -72,13 +72,17 @@ private:
     SkString fName;
 };
 
+// With shared strikes, the threads drawing the same typeface share each strike's glyphs
+// instead of each making their own copy of the strike.
 class SkGlyphCacheStressTest : public Benchmark {
 public:
-    explicit SkGlyphCacheStressTest(int cacheSize) : fCacheSize(cacheSize) { }
+    explicit SkGlyphCacheStressTest(int cacheSize, bool shared = false)
+        : fCacheSize(cacheSize), fShared(shared) { }
 
 protected:
     const char* onGetName() override {
-        fName.printf("SkGlyphCacheStressTest%dK", (int)(fCacheSize >> 10));
+        fName.printf("SkGlyphCacheStressTest%dK%s", (int)(fCacheSize >> 10),
+                     fShared ? "_shared" : "");
         return fName.c_str();
     }
 
@@ -89,6 +93,7 @@ protected:
     void onDraw(int loops, SkCanvas*) override {
         size_t oldCacheLimitSize = SkGraphics::GetFontCacheLimit();
         SkGraphics::SetFontCacheLimit(fCacheSize);
+        bool oldShared = SkStrikeCache::SetSharedStrikes(fShared);
         sk_sp<SkTypeface> typefaces[] =
             {sk_tool_utils::create_portable_typeface("serif", SkFontStyle::Italic()),
              sk_tool_utils::create_portable_typeface("sans-serif", SkFontStyle::Italic())};
@@ -102,12 +107,14 @@ protected:
                 do_font_stuff(&font);
             });
         }
+        SkStrikeCache::SetSharedStrikes(oldShared);
         SkGraphics::SetFontCacheLimit(oldCacheLimitSize);
     }
 
 private:
     typedef Benchmark INHERITED;
     const size_t fCacheSize;
+    const bool fShared;
     SkString fName;
 };
 
@@ -115,3 +122,5 @@ DEF_BENCH( return new SkGlyphCacheBasic(256 * 1024); )
 DEF_BENCH( return new SkGlyphCacheBasic(32 * 1024 * 1024); )
 DEF_BENCH( return new SkGlyphCacheStressTest(256 * 1024); )
 DEF_BENCH( return new SkGlyphCacheStressTest(32 * 1024 * 1024); )
+DEF_BENCH( return new SkGlyphCacheStressTest(256 * 1024, true); )
+DEF_BENCH( return new SkGlyphCacheStressTest(32 * 1024 * 1024, true); )
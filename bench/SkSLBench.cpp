@@ -0,0 +1,223 @@
+/*
+ * Copyright 2019 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Benchmark.h"
+#include "SkExecutor.h"
+#include "SkRasterPipeline.h"
+#include "SkSLByteCode.h"
+#include "SkSLCompileService.h"
+#include "SkSLCompiler.h"
+#include "SkSLInterpreter.h"
+#include "SkSLUtil.h"
+#include "SkString.h"
+
+static constexpr int kProgramCount = 16;
+
+static SkSL::String make_program(int i) {
+    // Vary the constants so that no two programs are identical.
+    SkString src;
+    src.appendf("uniform half4 color;\n"
+                "in float2 coords;\n"
+                "void main() {\n"
+                "    half4 c = color;\n"
+                "    for (int i = 0; i < %d; ++i) {\n"
+                "        c = clamp(c * half(%d.5) + half4(sin(half(coords.x) + half(i))), 0, 1);\n"
+                "    }\n"
+                "    sk_FragColor = c.a > 0.5 ? c.bgra : mix(c, half4(1), 0.25);\n"
+                "}\n", 2 + i % 5, i);
+    return SkSL::String(src.c_str());
+}
+
+// Constructing a compiler parses the built-in modules; this is the fixed cost every other bench
+// here either pays or avoids.
+class SkSLCompilerCreateBench : public Benchmark {
+protected:
+    const char* onGetName() override { return "sksl_compiler_create"; }
+
+    bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
+
+    void onDraw(int loops, SkCanvas*) override {
+        for (int i = 0; i < loops; i++) {
+            SkSL::Compiler compiler;
+        }
+    }
+};
+
+DEF_BENCH( return new SkSLCompilerCreateBench; )
+
+// Compiles kProgramCount fragment programs to GLSL per loop, either with a fresh compiler for each
+// program or through an SkSL::CompileService running on the given number of threads.
+class SkSLCompileBench : public Benchmark {
+public:
+    explicit SkSLCompileBench(int threads) : fThreads(threads) {
+        if (fThreads) {
+            fName.printf("sksl_compile_service_%d", fThreads);
+        } else {
+            fName = "sksl_compile_fresh_compiler";
+        }
+    }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+
+    bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
+
+    void onDelayedSetup() override {
+        fCaps = SkSL::ShaderCapsFactory::Default();
+        for (int i = 0; i < kProgramCount; ++i) {
+            fJobs[i].fText = make_program(i);
+            fJobs[i].fSettings.fCaps = fCaps.get();
+        }
+        if (fThreads) {
+            if (fThreads > 1) {
+                fExecutor = SkExecutor::MakeFIFOThreadPool(fThreads - 1);
+            }
+            fService.reset(new SkSL::CompileService(fExecutor.get(), fThreads));
+            fService->warmUp(fThreads);
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        for (int i = 0; i < loops; i++) {
+            if (fService) {
+                fService->compile(fJobs, kProgramCount, fResults);
+            } else {
+                for (int j = 0; j < kProgramCount; ++j) {
+                    SkSL::Compiler compiler;
+                    std::unique_ptr<SkSL::Program> program =
+                            compiler.convertProgram(fJobs[j].fKind, fJobs[j].fText,
+                                                    fJobs[j].fSettings);
+                    fResults[j].fSuccess = program &&
+                                           compiler.toGLSL(*program, &fResults[j].fCode);
+                }
+            }
+        }
+        for (const auto& result : fResults) {
+            if (!result.fSuccess) {
+                SkDebugf("!! SkSL compilation failed: %s\n", result.fErrors.c_str());
+                break;
+            }
+        }
+    }
+
+private:
+    int                                   fThreads;
+    SkString                              fName;
+    sk_sp<GrShaderCaps>                   fCaps;
+    SkSL::CompileService::Job             fJobs[kProgramCount];
+    SkSL::CompileService::Result          fResults[kProgramCount];
+    std::unique_ptr<SkExecutor>           fExecutor;
+    std::unique_ptr<SkSL::CompileService> fService;
+
+    typedef Benchmark INHERITED;
+};
+
+DEF_BENCH( return new SkSLCompileBench(0); )
+DEF_BENCH( return new SkSLCompileBench(1); )
+DEF_BENCH( return new SkSLCompileBench(4); )
+
+static constexpr int kPixelCount = 1024;
+
+static const char* kPixelFunction =
+        "void shade(inout float r, inout float g, inout float b, int n) {\n"
+        "    for (; n > 0; n--) {\n"
+        "        r = r * 0.9 + g * 0.1;\n"
+        "        if (r > 0.5) {\n"
+        "            g = g - 0.05;\n"
+        "        } else {\n"
+        "            b = b + 0.01;\n"
+        "        }\n"
+        "    }\n"
+        "}\n";
+
+// Runs kPixelFunction on kPixelCount pixels per loop, either one pixel at a time with
+// SkSL::Interpreter walking the IR, or ByteCode::kVecWidth pixels at a time with SkSL::ByteCode.
+class SkSLInterpreterBench : public Benchmark {
+public:
+    explicit SkSLInterpreterBench(bool byteCode) : fByteCode(byteCode) {}
+
+protected:
+    const char* onGetName() override {
+        return fByteCode ? "sksl_interpret_bytecode" : "sksl_interpret_tree";
+    }
+
+    bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
+
+    void onDelayedSetup() override {
+        for (int i = 0; i < kPixelCount; ++i) {
+            fInputs[0 * kPixelCount + i] = (i % 256) / 255.0f;
+            fInputs[1 * kPixelCount + i] = (i / 4 % 256) / 255.0f;
+            fInputs[2 * kPixelCount + i] = 0.5f;
+            // Vary the trip count so that the bytecode has to mask off finished pixels.
+            int32_t n = 6 + i % 4;
+            memcpy(&fInputs[3 * kPixelCount + i], &n, sizeof(n));
+        }
+        SkSL::Program::Settings settings;
+        std::unique_ptr<SkSL::Program> program =
+                fCompiler.convertProgram(SkSL::Program::kPipelineStage_Kind,
+                                         SkSL::String(kPixelFunction), settings);
+        if (!program) {
+            SkDebugf("!! SkSL compilation failed: %s\n", fCompiler.errorText().c_str());
+            return;
+        }
+        if (fByteCode) {
+            fCode = fCompiler.toByteCode(*program);
+            fFunction = fCode ? fCode->getFunction("shade") : nullptr;
+        } else {
+            for (const auto& e : *program) {
+                if (SkSL::ProgramElement::kFunction_Kind == e.fKind &&
+                    "shade" == ((const SkSL::FunctionDefinition&) e).fDeclaration.fName) {
+                    fDefinition = (const SkSL::FunctionDefinition*) &e;
+                }
+            }
+            fInterpreter.reset(new SkSL::Interpreter(std::move(program), &fPipeline, &fStack));
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        if (!fFunction && !fDefinition) {
+            return;
+        }
+        for (int i = 0; i < loops; i++) {
+            memcpy(fArgs, fInputs, sizeof(fArgs));
+            if (fByteCode) {
+                fCode->run(*fFunction, fArgs, nullptr, kPixelCount);
+                continue;
+            }
+            for (int j = 0; j < kPixelCount; ++j) {
+                fStack.push_back(fArgs[0 * kPixelCount + j]);
+                fStack.push_back(fArgs[1 * kPixelCount + j]);
+                fStack.push_back(fArgs[2 * kPixelCount + j]);
+                int32_t n;
+                memcpy(&n, &fArgs[3 * kPixelCount + j], sizeof(n));
+                fStack.push_back(n);
+                fInterpreter->run(*fDefinition);
+                fInterpreter->pop();
+                fArgs[2 * kPixelCount + j] = fInterpreter->pop().fFloat;
+                fArgs[1 * kPixelCount + j] = fInterpreter->pop().fFloat;
+                fArgs[0 * kPixelCount + j] = fInterpreter->pop().fFloat;
+            }
+        }
+    }
+
+private:
+    bool                                 fByteCode;
+    SkSL::Compiler                       fCompiler;
+    std::unique_ptr<SkSL::ByteCode>      fCode;
+    const SkSL::ByteCode::Function*      fFunction = nullptr;
+    SkRasterPipeline_<256>               fPipeline;
+    std::vector<SkSL::Interpreter::Value> fStack;
+    std::unique_ptr<SkSL::Interpreter>   fInterpreter;
+    const SkSL::FunctionDefinition*      fDefinition = nullptr;
+    float                                fInputs[4 * kPixelCount];
+    float                                fArgs[4 * kPixelCount];
+
+    typedef Benchmark INHERITED;
+};
+
+DEF_BENCH( return new SkSLInterpreterBench(false); )
+DEF_BENCH( return new SkSLInterpreterBench(true); )
@@ -15,6 +15,7 @@
 #include "CodecBench.h"
 #include "CodecBenchPriv.h"
 #include "CrashHandler.h"
+#include "DDLSKPBench.h"
 #include "GMBench.h"
 #include "ProcStats.h"
 #include "RecordingBench.h"
@@ -34,6 +35,7 @@
 #include "SkData.h"
 #include "SkDebugfTracer.h"
 #include "SkEventTracingPriv.h"
+#include "SkExecutor.h"
 #include "SkGraphics.h"
 #include "SkJSONWriter.h"
 #include "SkLeanWindows.h"
@@ -43,6 +45,7 @@
 #include "SkScan.h"
 #include "SkString.h"
 #include "SkSurface.h"
+#include "SkTHash.h"
 #include "SkTaskGroup.h"
 #include "SkTraceEvent.h"
 #include "Stats.h"
@@ -125,7 +128,21 @@ DEFINE_bool(bbh, true, "Build a BBH for SKPs?");
 DEFINE_bool(lite, false, "Use SkLiteRecorder in recording benchmarks?");
 DEFINE_bool(mpd, true, "Use MultiPictureDraw for the SKPs?");
 DEFINE_bool(loopSKP, true, "Loop SKPs like we do for micro benches?");
+DEFINE_string(skpThreads, "", "Space-separated thread counts to also play SKPs back with in "
+                              "parallel, reporting the speedup over drawing the tiles serially.");
+DEFINE_string(ddlThreads, "", "Space-separated thread counts to also record SKPs into DDL tiles "
+                              "with on GPU configs, timing the recording alone and then a whole "
+                              "frame, drawing each tile as soon as it is recorded.");
+DEFINE_int32(ddlTilingWidthHeight, 3, "Number of tiles along one edge for --ddlThreads.");
+DEFINE_string(codecThreads, "", "Space-separated thread counts to also decode images with in "
+                                "parallel, reporting the speedup over decoding serially.");
+DEFINE_bool(areaAverage, false, "Also time AndroidCodec benches decoding to the same sizes with "
+                                "AndroidOptions::fAreaAverage?");
+DEFINE_bool(brdIndex, false, "Give BRD benches a region index made ahead of time, for images "
+                             "that support one?");
 DEFINE_int32(flushEvery, 10, "Flush --outResultsFile every Nth run.");
+DEFINE_int32(rasterThreads, 0, "Threads for the 'threaded' config to rasterize tiles with. "
+                               "0 means one per core.");
 DEFINE_bool(gpuStats, false, "Print GPU stats after each gpu benchmark?");
 DEFINE_bool(gpuStatsDump, false, "Dump GPU states after each benchmark to json");
 DEFINE_bool(keepAlive, false, "Print a message every so often so that we don't time out");
@@ -167,6 +184,25 @@ bool Target::capturePixels(SkBitmap* bmp) {
     return true;
 }
 
+// Draws into a surface made by SkSurface::MakeRasterThreaded().  The canvas->flush() in time()
+// makes sure we count the time spent rasterizing the deferred draws.
+struct ThreadedTarget : public Target {
+    explicit ThreadedTarget(const Config& c) : Target(c) {}
+
+    bool init(SkImageInfo info, Benchmark* bench) override {
+        // The surface must not outlive its executor, which must not outlive us.
+        this->executor = SkExecutor::MakeWorkStealingPool(FLAGS_rasterThreads);
+        this->surface  = SkSurface::MakeRasterThreaded(info, this->executor.get());
+        return this->surface != nullptr;
+    }
+
+    ~ThreadedTarget() override {
+        this->surface.reset();
+    }
+
+    std::unique_ptr<SkExecutor> executor;
+};
+
 struct GPUTarget : public Target {
     explicit GPUTarget(const Config& c) : Target(c) {}
     ContextInfo contextInfo;
@@ -476,6 +512,9 @@ static void create_config(const SkCommandLineConfig* config, SkTArray<Config>* c
     CPU_CONFIG(8888, kRaster_Backend,     kN32_SkColorType, kPremul_SkAlphaType, nullptr)
     CPU_CONFIG(565,  kRaster_Backend, kRGB_565_SkColorType, kOpaque_SkAlphaType, nullptr)
 
+    // Like 8888, but rasterized in parallel tiles by ThreadedTarget.
+    CPU_CONFIG(threaded, kRaster_Backend, kN32_SkColorType, kPremul_SkAlphaType, nullptr)
+
     // 'narrow' has a gamut narrower than sRGB, and different transfer function.
     auto narrow = SkColorSpace::MakeRGB(SkNamedTransferFn::k2Dot2, gNarrow_toXYZD50),
            srgb = SkColorSpace::MakeSRGB(),
@@ -530,6 +569,13 @@ static Target* is_enabled(Benchmark* bench, const Config& config) {
     case Benchmark::kGPU_Backend:
         target = new GPUTarget(config);
         break;
+    case Benchmark::kRaster_Backend:
+        if (config.name.equals("threaded")) {
+            target = new ThreadedTarget(config);
+        } else {
+            target = new Target(config);
+        }
+        break;
     default:
         target = new Target(config);
         break;
@@ -593,10 +639,14 @@ public:
                       , fGMs(skiagm::GMRegistry::Head())
                       , fCurrentRecording(0)
                       , fCurrentDeserialPicture(0)
+                      , fCurrentMappedPicture(0)
                       , fCurrentScale(0)
                       , fCurrentSKP(0)
                       , fCurrentSVG(0)
                       , fCurrentUseMPD(0)
+                      , fCurrentSKPThreads(0)
+                      , fCurrentDDLBench(0)
+                      , fCurrentCodecThreads(0)
                       , fCurrentCodec(0)
                       , fCurrentAndroidCodec(0)
                       , fCurrentBRDImage(0)
@@ -631,6 +681,31 @@ public:
         }
         fUseMPDs.push_back() = false;
 
+        for (int i = 0; i < FLAGS_skpThreads.count(); i++) {
+            if (1 != sscanf(FLAGS_skpThreads[i], "%d", &fSKPThreads.push_back()) ||
+                fSKPThreads.back() < 1) {
+                SkDebugf("Can't parse %s from --skpThreads as a thread count.\n",
+                         FLAGS_skpThreads[i]);
+                exit(1);
+            }
+        }
+        for (int i = 0; i < FLAGS_ddlThreads.count(); i++) {
+            if (1 != sscanf(FLAGS_ddlThreads[i], "%d", &fDDLThreads.push_back()) ||
+                fDDLThreads.back() < 1) {
+                SkDebugf("Can't parse %s from --ddlThreads as a thread count.\n",
+                         FLAGS_ddlThreads[i]);
+                exit(1);
+            }
+        }
+        for (int i = 0; i < FLAGS_codecThreads.count(); i++) {
+            if (1 != sscanf(FLAGS_codecThreads[i], "%d", &fCodecThreads.push_back()) ||
+                fCodecThreads.back() < 1) {
+                SkDebugf("Can't parse %s from --codecThreads as a thread count.\n",
+                         FLAGS_codecThreads[i]);
+                exit(1);
+            }
+        }
+
         // Prepare the images for decoding
         if (!CollectImages(FLAGS_images, &fImages)) {
             exit(1);
@@ -752,6 +827,22 @@ public:
             return new DeserializePictureBench(name.c_str(), std::move(data));
         }
 
+        // And again, converted to the layout that can be loaded in place.
+        while (fCurrentMappedPicture < fSKPs.count()) {
+            const SkString& path = fSKPs[fCurrentMappedPicture++];
+            sk_sp<SkPicture> pic = ReadPicture(path.c_str());
+            if (!pic) {
+                continue;
+            }
+            sk_sp<SkData> data = pic->serializeMappable();
+            SkString name = SkOSPath::Basename(path.c_str());
+            fSourceType = "skp";
+            fBenchType  = "deserial_mapped";
+            fSKPBytes = static_cast<double>(data->size());
+            fSKPOps   = pic->approximateOpCount();
+            return new DeserializePictureBench(name.c_str(), std::move(data), true/*mapped*/);
+        }
+
         // Then once each for each scale as SKPBenches (playback).
         while (fCurrentScale < fScales.count()) {
             while (fCurrentSKP < fSKPs.count()) {
@@ -776,10 +867,36 @@ public:
                     SkString name = SkOSPath::Basename(path.c_str());
                     fSourceType = "skp";
                     fBenchType = "playback";
+                    bool useMPD = fUseMPDs[fCurrentUseMPD++];
+                    auto bench = new SKPBench(name.c_str(), pic.get(), fClip,
+                                              fScales[fCurrentScale], useMPD, FLAGS_loopSKP);
+                    if (!useMPD) {
+                        fSerialName = bench->getUniqueName();
+                    }
+                    return bench;
+                }
+                while (fCurrentSKPThreads < fSKPThreads.count()) {
+                    SkString name = SkOSPath::Basename(path.c_str());
+                    fSourceType = "skp";
+                    fBenchType = "playback_parallel";
                     return new SKPBench(name.c_str(), pic.get(), fClip, fScales[fCurrentScale],
-                                        fUseMPDs[fCurrentUseMPD++], FLAGS_loopSKP);
+                                        false, FLAGS_loopSKP, fSKPThreads[fCurrentSKPThreads++]);
+                }
+                // DDL tiles can't be scaled, so these only run at the first scale.
+                while (0 == fCurrentScale && fCurrentDDLBench < 2 * fDDLThreads.count()) {
+                    SkString name = SkOSPath::Basename(path.c_str());
+                    int threads = fDDLThreads[fCurrentDDLBench / 2];
+                    bool draw = 1 == fCurrentDDLBench++ % 2;
+                    fSourceType = "skp";
+                    fBenchType = draw ? "ddl_record_draw" : "ddl_record";
+                    return new DDLSKPBench(name.c_str(), pic.get(), fClip,
+                                           FLAGS_ddlTilingWidthHeight, threads,
+                                           draw ? DDLSKPBench::Mode::kRecordAndDraw
+                                                : DDLSKPBench::Mode::kRecord);
                 }
                 fCurrentUseMPD = 0;
+                fCurrentSKPThreads = 0;
+                fCurrentDDLBench = 0;
                 fCurrentSKP++;
             }
 
@@ -818,6 +935,18 @@ public:
         }
 
         for (; fCurrentCodec < fImages.count(); fCurrentCodec++) {
+            // Follow each serial decode with the same decode on each of --codecThreads.
+            if (fSerialCodecData && fCurrentCodecThreads < fCodecThreads.count()) {
+                fSourceType = "image";
+                fBenchType = "skcodec_parallel";
+                return new CodecBench(SkOSPath::Basename(fImages[fCurrentCodec].c_str()),
+                                      fSerialCodecData.get(), fSerialCodecColorType,
+                                      fSerialCodecAlphaType,
+                                      fCodecThreads[fCurrentCodecThreads++]);
+            }
+            fSerialCodecData = nullptr;
+            fCurrentCodecThreads = 0;
+
             fSourceType = "image";
             fBenchType = "skcodec";
             const SkString& path = fImages[fCurrentCodec];
@@ -878,9 +1007,17 @@ public:
                         info, storage.get(), rowBytes);
                 switch (result) {
                     case SkCodec::kSuccess:
-                    case SkCodec::kIncompleteInput:
-                        return new CodecBench(SkOSPath::Basename(path.c_str()),
-                                              encoded.get(), colorType, alphaType);
+                    case SkCodec::kIncompleteInput: {
+                        auto bench = new CodecBench(SkOSPath::Basename(path.c_str()),
+                                                    encoded.get(), colorType, alphaType);
+                        if (!fCodecThreads.empty()) {
+                            fSerialCodecData = encoded;
+                            fSerialCodecColorType = colorType;
+                            fSerialCodecAlphaType = alphaType;
+                            fSerialName = bench->getUniqueName();
+                        }
+                        return bench;
+                    }
                     case SkCodec::kInvalidConversion:
                         // This is okay. Not all conversions are valid.
                         break;
@@ -911,8 +1048,10 @@ public:
                 continue;
             }
 
-            while (fCurrentSampleSize < (int) SK_ARRAY_COUNT(sampleSizes)) {
-                int sampleSize = sampleSizes[fCurrentSampleSize];
+            const int benchesPerSampleSize = FLAGS_areaAverage ? 2 : 1;
+            while (fCurrentSampleSize < benchesPerSampleSize * (int) SK_ARRAY_COUNT(sampleSizes)) {
+                int sampleSize = sampleSizes[fCurrentSampleSize / benchesPerSampleSize];
+                const bool areaAverage = 1 == fCurrentSampleSize % benchesPerSampleSize;
                 fCurrentSampleSize++;
                 if (10 * sampleSize > SkTMin(codec->getInfo().width(), codec->getInfo().height())) {
                     // Avoid benchmarking scaled decodes of already small images.
@@ -920,7 +1059,7 @@ public:
                 }
 
                 return new AndroidCodecBench(SkOSPath::Basename(path.c_str()),
-                                             encoded.get(), sampleSize);
+                                             encoded.get(), sampleSize, areaAverage);
             }
             fCurrentSampleSize = 0;
         }
@@ -997,8 +1136,13 @@ public:
                                 SkASSERT(false);
                         }
 
+                        bool useRegionIndex = false;
+                        if (FLAGS_brdIndex) {
+                            std::unique_ptr<SkCodec> codec = SkCodec::MakeFromData(encoded);
+                            useRegionIndex = codec && codec->makeRegionIndex();
+                        }
                         return new BitmapRegionDecoderBench(basename.c_str(), encoded.get(),
-                                colorType, sampleSize, subset);
+                                colorType, sampleSize, subset, useRegionIndex);
                     }
                     fCurrentSubsetType = 0;
                     fCurrentSampleSize++;
@@ -1027,6 +1171,43 @@ public:
                                  fUseMPDs[fCurrentUseMPD-1] ? "true" : "false");
             }
         }
+        if (int threads = this->parallelThreads()) {
+            log.appendString("threads", SkStringPrintf("%d", threads).c_str());
+        } else if (0 == strcmp(fBenchType, "ddl_record")) {
+            log.appendString("threads",
+                             SkStringPrintf("%d", fDDLThreads[(fCurrentDDLBench-1) / 2]).c_str());
+        }
+    }
+
+    // The thread count of the current parallel SKP playback, DDL frame or codec bench, or 0 for
+    // any other bench.
+    int parallelThreads() const {
+        if (0 == strcmp(fBenchType, "playback_parallel")) {
+            return fSKPThreads[fCurrentSKPThreads-1];
+        }
+        if (0 == strcmp(fBenchType, "skcodec_parallel")) {
+            return fCodecThreads[fCurrentCodecThreads-1];
+        }
+        if (0 == strcmp(fBenchType, "ddl_record_draw")) {
+            return fDDLThreads[(fCurrentDDLBench-1) / 2];
+        }
+        return 0;
+    }
+
+    // The unique name of the last serial bench that parallel ones compare to.
+    const SkString& serialName() const { return fSerialName; }
+
+    // Is this a serial bench that parallel ones will compare to?
+    bool isSerial() const {
+        if (0 == strcmp(fBenchType, "playback")) {
+            return fCurrentUseMPD > 0 && !fUseMPDs[fCurrentUseMPD-1];
+        }
+        return 0 == strcmp(fBenchType, "skcodec") && fSerialCodecData;
+    }
+
+    // What parallel benches of this type speed up.
+    const char* parallelWork() const {
+        return 0 == strcmp(fBenchType, "skcodec_parallel") ? "decoding" : "playback";
     }
 
     void fillCurrentMetrics(NanoJSONResultsWriter& log) const {
@@ -1056,6 +1237,13 @@ private:
     SkTArray<SkString> fSKPs;
     SkTArray<SkString> fSVGs;
     SkTArray<bool>     fUseMPDs;
+    SkTArray<int>      fSKPThreads;
+    SkTArray<int>      fDDLThreads;
+    SkTArray<int>      fCodecThreads;
+    SkString           fSerialName;
+    sk_sp<SkData>      fSerialCodecData;  // The serial decode that --codecThreads repeat.
+    SkColorType        fSerialCodecColorType;
+    SkAlphaType        fSerialCodecAlphaType;
     SkTArray<SkString> fImages;
     SkTArray<SkColorType, true> fColorTypes;
     SkScalar           fZoomMax;
@@ -1067,11 +1255,15 @@ private:
     const char* fBenchType;   // How we bench it: micro, recording, playback, ...
     int fCurrentRecording;
     int fCurrentDeserialPicture;
+    int fCurrentMappedPicture;
     int fCurrentScale;
     int fCurrentSKP;
     int fCurrentSVG;
     int fCurrentUseMPD;
+    int fCurrentSKPThreads;
+    int fCurrentDDLBench;
     int fCurrentCodec;
+    int fCurrentCodecThreads;
     int fCurrentAndroidCodec;
     int fCurrentBRDImage;
     int fCurrentColorType;
@@ -1200,6 +1392,7 @@ int main(int argc, char** argv) {
 
     int runs = 0;
     BenchmarkStream benchStream;
+    SkTHashMap<SkString, double> serialMs;  // Keyed by config and bench name.
     log.beginObject("results");
     while (Benchmark* b = benchStream.next()) {
         std::unique_ptr<Benchmark> bench(b);
@@ -1294,6 +1487,16 @@ int main(int argc, char** argv) {
             Stats stats(samples, want_plot);
             log.beginObject(config);
 
+            double speedup = 0;
+            if (benchStream.isSerial()) {
+                serialMs.set(SkStringPrintf("%s %s", config, bench->getUniqueName()), stats.min);
+            } else if (benchStream.parallelThreads() > 0) {
+                SkString key = SkStringPrintf("%s %s", config, benchStream.serialName().c_str());
+                if (double* serial = serialMs.find(key)) {
+                    speedup = *serial / stats.min;
+                }
+            }
+
             log.beginObject("options");
             log.appendString("name", bench->getName());
             benchStream.fillCurrentOptions(log);
@@ -1308,6 +1511,9 @@ int main(int argc, char** argv) {
             }
             log.endArray(); // samples
             benchStream.fillCurrentMetrics(log);
+            if (speedup > 0) {
+                log.appendMetric("speedup", speedup);
+            }
             if (gpuStatsDump) {
                 // dump to json, only SKPBench currently returns valid keys / values
                 SkASSERT(keys.count() == values.count());
@@ -1371,6 +1577,11 @@ int main(int argc, char** argv) {
                         );
             }
 
+            if (speedup > 0 && !FLAGS_quiet && !FLAGS_csv) {
+                SkDebugf("\t%.2fx faster than serial %s on %d threads\n",
+                         speedup, benchStream.parallelWork(), benchStream.parallelThreads());
+            }
+
             if (FLAGS_gpuStats && Benchmark::kGPU_Backend == configs[i].backend) {
                 target->dumpStats();
             }
@@ -1690,6 +1690,37 @@ Error RasterSink::draw(const Src& src, SkBitmap* dst, SkWStream*, SkString*) con
 
 /*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
 
+ThreadedSink::ThreadedSink(SkColorType colorType, sk_sp<SkColorSpace> colorSpace)
+    : RasterSink(colorType, std::move(colorSpace)) {}
+
+Error ThreadedSink::draw(const Src& src, SkBitmap* dst, SkWStream*, SkString*) const {
+    // Tiles run on their own pool, so they can't get stuck behind DM's own tasks.
+    static SkExecutor* gTilePool = SkExecutor::MakeWorkStealingPool().release();
+
+    const SkISize size = src.size();
+    SkAlphaType alphaType = kPremul_SkAlphaType;
+    (void)SkColorTypeValidateAlphaType(fColorType, alphaType, &alphaType);
+    const SkImageInfo info = SkImageInfo::Make(size.width(), size.height(),
+                                               fColorType, alphaType, fColorSpace);
+
+    auto surface = SkSurface::MakeRasterThreaded(info, gTilePool);
+    if (!surface) {
+        return Error::Nonfatal("Could not create a threaded raster surface.");
+    }
+    Error err = src.draw(surface->getCanvas());
+    if (!err.isEmpty()) {
+        return err;
+    }
+
+    dst->allocPixels(info);
+    if (!surface->readPixels(*dst, 0, 0)) {
+        return "Could not read pixels back from the threaded raster surface.";
+    }
+    return "";
+}
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+
 // Handy for front-patching a Src.  Do whatever up-front work you need, then call draw_to_canvas(),
 // passing the Sink draw() arguments, a size, and a function draws into an SkCanvas.
 // Several examples below.
@@ -434,7 +434,7 @@ public:
     const char* fileExtension() const override { return "png"; }
     SinkFlags flags() const override { return SinkFlags{ SinkFlags::kRaster, SinkFlags::kDirect }; }
 
-private:
+protected:
     SkColorType         fColorType;
     sk_sp<SkColorSpace> fColorSpace;
 };
@@ -193,6 +193,7 @@ public:
             : fZeroInitialized(SkCodec::kNo_ZeroInitialized)
             , fSubset(nullptr)
             , fSampleSize(1)
+            , fAreaAverage(false)
         {}
 
         /**
@@ -222,6 +223,18 @@ public:
          *  The default is 1, representing no downscaling.
          */
         int fSampleSize;
+
+        /**
+         *  If true, the info passed to getAndroidPixels() may have any dimensions no larger
+         *  than the image (or fSubset), and fSampleSize is ignored.  Each pixel is decoded as
+         *  the average of the area of the image that it covers, rather than by sampling a
+         *  single pixel, which makes for much better thumbnails.  A jpeg is first scaled as
+         *  far as it can be while it is decoded, and no codec holds the full size image,
+         *  unless it can't decode a row at a time.
+         *
+         *  The default is false.
+         */
+        bool fAreaAverage;
     };
 
     /**
@@ -26,6 +26,7 @@
 
 class SkColorSpace;
 class SkData;
+class SkExecutor;
 class SkFrameHolder;
 class SkPngChunkReader;
 class SkSampler;
@@ -257,6 +258,7 @@ public:
             , fSubset(nullptr)
             , fFrameIndex(0)
             , fPriorFrame(kNoFrame)
+            , fExecutor(nullptr)
         {}
 
         ZeroInitialized            fZeroInitialized;
@@ -300,6 +302,20 @@ public:
          *  If set to kNoFrame, the codec will decode any necessary required frame(s) first.
          */
         int                        fPriorFrame;
+
+        /**
+         *  If not NULL, getPixels may split the decode into horizontal stripes and run them
+         *  on this executor, returning once every stripe is finished.  The result is the same
+         *  as decoding without it.
+         *
+         *  Only some images can be split: baseline JPEGs with restart markers every whole
+         *  number of MCU rows, and PNGs that need swizzling or a color transform (the rows
+         *  are inflated in order, then converted in parallel).  WebP decodes use libwebp's
+         *  own worker thread instead.  Everything else ignores the executor.
+         *
+         *  Ignored by incremental and scanline decodes.
+         */
+        SkExecutor*                fExecutor;
     };
 
     /**
@@ -398,6 +414,24 @@ public:
         return this->onGetYUV8Planes(sizeInfo, planes);
     }
 
+    /**
+     *  Returns an index of the encoded data that lets later subset decodes start near the
+     *  top of the subset, instead of decoding every row above it, or nullptr if this image
+     *  can't be indexed.  Currently that means baseline JPEGs with a restart marker at the
+     *  start of each run of MCU rows, held in memory.
+     *
+     *  The index only depends on the encoded data, so it can be stored next to it and passed
+     *  to setRegionIndex() on any codec made from the same data.
+     */
+    sk_sp<SkData> makeRegionIndex() { return this->onMakeRegionIndex(); }
+
+    /**
+     *  Uses an index from makeRegionIndex() to skip ahead in later scanline decodes, and so in
+     *  SkAndroidCodec subset decodes.  Returns false and leaves the codec unchanged if the index
+     *  doesn't match this image.
+     */
+    bool setRegionIndex(const SkData& index) { return this->onSetRegionIndex(index); }
+
     /**
      *  Prepare for an incremental decode with the specified options.
      *
@@ -733,6 +767,10 @@ protected:
         return kUnimplemented;
     }
 
+    virtual sk_sp<SkData> onMakeRegionIndex() { return nullptr; }
+
+    virtual bool onSetRegionIndex(const SkData&) { return false; }
+
     virtual bool onGetValidSubset(SkIRect* /*desiredSubset*/) const {
         // By default, subsets are not supported.
         return false;
@@ -20,6 +20,12 @@ public:
     static std::unique_ptr<SkExecutor> MakeFIFOThreadPool(int threads = 0);
     static std::unique_ptr<SkExecutor> MakeLIFOThreadPool(int threads = 0);
 
+    // Create a thread pool SkExecutor where each thread owns its own work deque.
+    // Work added from a pool thread goes to that thread's deque and is run LIFO by its owner;
+    // idle threads steal the oldest work from each other.  Work added from other threads is
+    // shared through a FIFO queue.
+    static std::unique_ptr<SkExecutor> MakeWorkStealingPool(int threads = 0);
+
     // There is always a default SkExecutor available by calling SkExecutor::GetDefault().
     static SkExecutor& GetDefault();
     static void SetDefault(SkExecutor*);  // Does not take ownership.  Not thread safe.
@@ -27,6 +33,10 @@ public:
     // Add work to execute.
     virtual void add(std::function<void(void)>) = 0;
 
+    // Add N pieces of work at once, calling fn(i) for each i in [0,N).
+    // By default this just calls add() N times.
+    virtual void batch(int N, std::function<void(int)> fn);
+
     // If it makes sense for this executor, use this thread to execute work for a little while.
     virtual void borrow() {}
 };
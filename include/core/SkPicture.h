@@ -22,9 +22,12 @@
 #include "SkRect.h"
 #include "SkTypes.h"
 
+#include <functional>
+
 class SkCanvas;
 class SkData;
 struct SkDeserialProcs;
+class SkExecutor;
 class SkImage;
 struct SkSerialProcs;
 class SkStream;
@@ -87,6 +90,34 @@ public:
     static sk_sp<SkPicture> MakeFromData(const void* data, size_t size,
                                          const SkDeserialProcs* procs = nullptr);
 
+    /** Recreates SkPicture that was serialized into data, without decoding all of it first.
+        Returns constructed SkPicture if successful; otherwise, returns nullptr.
+
+        The drawing commands are played back straight from data, and SkImage, SkTextBlob
+        and SkVertices are decoded from data the first time a command that draws them is
+        not clipped out, so pictures that are mostly offscreen can be drawn sooner and with
+        less memory. data is shared, not copied, and must not change while the SkPicture
+        exists; SkData::MakeFromFileName provides memory-mapped data that suits.
+
+        Falls back to decoding all of data, as MakeFromData does, for data written by older
+        versions of Skia or by procs->fPictureProc.
+
+        data may also have been written by serializeMappable, which is checked once, up front,
+        and then read where it lies, without parsing the drawing commands or copying anything.
+
+        procs is copied, but its decoders are called whenever the SkPicture is drawn, possibly
+        from several threads at once, so whatever their contexts point to must stay valid
+        until the SkPicture is deleted, including any references to it held elsewhere, such
+        as by other SkPicture.
+
+        @param data   container for serial data
+        @param procs  custom serial data decoders; may be nullptr. Its contexts must outlive
+                      the returned SkPicture
+        @return       SkPicture constructed from data
+    */
+    static sk_sp<SkPicture> MakeLazyFromData(sk_sp<SkData> data,
+                                             const SkDeserialProcs* procs = nullptr);
+
     /** \class SkPicture::AbortCallback
         AbortCallback is an abstract class. An implementation of AbortCallback may
         passed as a parameter to SkPicture::playback, to stop it before all drawing
@@ -133,6 +164,28 @@ public:
     */
     virtual void playback(SkCanvas* canvas, AbortCallback* callback = nullptr) const = 0;
 
+    /** Replays the drawing commands into tileCount canvases at once, running one task per
+        tile on executor. canvasForTile is called once for each tile index, possibly on
+        another thread, and returns the canvas for that tile, already set up with the
+        SkCanvas matrix and SkCanvas clip that select the part of SkPicture the tile shows;
+        or nullptr to skip the tile.
+
+        Each canvas receives only the commands that may draw inside its clip, found with
+        the bounding box hierarchy SkPicture was recorded with. If it was recorded without
+        one, an R-tree is built the first time and kept for later calls. Save, restore and
+        saveLayer commands are replayed with the commands they enclose, so each tile draws
+        as if SkPicture were played back into it alone.
+
+        The canvases must be distinct and safe to draw into from any thread, such as those
+        of raster SkSurface. Returns once every tile has been drawn.
+
+        @param tileCount      number of tiles
+        @param canvasForTile  returns the canvas for a tile index in [0, tileCount)
+        @param executor       runs the tiles; if nullptr, SkExecutor::GetDefault()
+    */
+    void playbackParallel(int tileCount, const std::function<SkCanvas*(int)>& canvasForTile,
+                          SkExecutor* executor = nullptr) const;
+
     /** Returns cull SkRect for this picture, passed in when SkPicture was created.
         Returned SkRect does not specify clipping SkRect for SkPicture; cull is hint
         of SkPicture bounds.
@@ -175,6 +228,20 @@ public:
     */
     void serialize(SkWStream* stream, const SkSerialProcs* procs = nullptr) const;
 
+    /** Returns storage containing SkData describing SkPicture in a layout that
+        MakeLazyFromData can play back in place, such as from a memory-mapped file, so
+        that loading it takes time proportional to the number of paints, paths and other
+        objects SkPicture refers to rather than to its size. Each object is decoded the
+        first time it is drawn.
+
+        The layout is larger than that of serialize, and only MakeLazyFromData reads it.
+        procs->fPictureProc is not called; sub-pictures are written in the same layout.
+
+        @param procs  custom serial data encoders; may be nullptr
+        @return       storage containing serialized SkPicture
+    */
+    sk_sp<SkData> serializeMappable(const SkSerialProcs* procs = nullptr) const;
+
     /** Returns a placeholder SkPicture. Result does not draw, and contains only
         cull SkRect, a hint of its bounds. Result is immutable; it cannot be changed
         later. Result identifier is unique.
@@ -208,12 +275,14 @@ private:
     SkPicture();
     friend class SkBigPicture;
     friend class SkEmptyPicture;
+    friend class SkLazyPicture;
     friend class SkPicturePriv;
     template <typename> friend class SkMiniPicture;
 
     void serialize(SkWStream*, const SkSerialProcs*, class SkRefCntSet* typefaces) const;
+    // If lazySource is not null, stream must be reading it, and the picture is loaded lazily.
     static sk_sp<SkPicture> MakeFromStream(SkStream*, const SkDeserialProcs*,
-                                           class SkTypefacePlayback*);
+                                           class SkTypefacePlayback*, SkData* lazySource);
     friend class SkPictureData;
 
     /** Return true if the SkStream/Buffer represents a serialized picture, and
@@ -231,6 +300,9 @@ private:
     // Returns NULL if this is not an SkBigPicture.
     virtual const class SkBigPicture* asSkBigPicture() const { return nullptr; }
 
+    // Returns NULL if this is not an SkLazyPicture.
+    virtual const class SkLazyPicture* asSkLazyPicture() const { return nullptr; }
+
     friend struct SkPathCounter;
 
     // V35: Store SkRect (rather then width & height) in header
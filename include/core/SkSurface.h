@@ -30,6 +30,7 @@
 
 class SkCanvas;
 class SkDeferredDisplayList;
+class SkExecutor;
 class SkPaint;
 class SkSurfaceCharacterization;
 class GrBackendRenderTarget;
@@ -149,6 +150,32 @@ public:
         return MakeRaster(imageInfo, 0, props);
     }
 
+    /** Allocates raster SkSurface whose SkCanvas defers drawing, then rasterizes the deferred
+        draws in parallel tiles on executor. Draws are rasterized when the pixels are read,
+        when a snapshot is made, or when SkCanvas::flush() is called. The result matches
+        a surface returned by MakeRaster() with the same parameters, except that the
+        anti-aliased edges of curves and lines may differ slightly where they cross tiles.
+
+        Allocates and zeroes pixel memory. Pixel memory size is imageInfo.height() times
+        imageInfo.minRowBytes(). Pixel memory is deleted when SkSurface is deleted.
+
+        SkSurface is returned if all parameters are valid.
+        Valid parameters include:
+        info dimensions are greater than zero;
+        info contains SkColorType and SkAlphaType supported by raster surface.
+
+        @param imageInfo  width, height, SkColorType, SkAlphaType, SkColorSpace,
+                          of raster surface; width and height must be greater than zero
+        @param executor   runs the tiles; must outlive SkSurface. If nullptr,
+                          SkExecutor::GetDefault() is used
+        @param props      LCD striping orientation and setting for device independent fonts;
+                          may be nullptr
+        @return           SkSurface if all parameters are valid; otherwise, nullptr
+    */
+    static sk_sp<SkSurface> MakeRasterThreaded(const SkImageInfo& imageInfo,
+                                               SkExecutor* executor,
+                                               const SkSurfaceProps* props = nullptr);
+
     /** Allocates raster SkSurface. SkCanvas returned by SkSurface draws directly into pixels.
         Allocates and zeroes pixel memory. Pixel memory size is height times width times
         four. Pixel memory is deleted when SkSurface is deleted.
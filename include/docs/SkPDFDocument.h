@@ -9,7 +9,11 @@
 #include "SkString.h"
 #include "SkTime.h"
 
+#include <memory>
+
 class SkExecutor;
+class SkPDFDocument;
+class SkPDFResourceCache;
 
 namespace SkPDF {
 
@@ -79,6 +83,38 @@ struct StructureElementNode {
     DocumentStructureType fType;
 };
 
+/** Encoded images and subset fonts, which documents drawing the same images
+    with the same typefaces can share instead of each encoding and subsetting
+    their own.  Images are keyed by their unique ID, and fonts by their
+    typeface and the glyphs used from it.
+
+    One cache may be used by many documents at once, on different threads.
+*/
+class SK_API ResourceCache {
+public:
+    /** Creates an empty cache.  Once it holds more than byteBudget bytes, the
+        least recently used entries are dropped.
+    */
+    explicit ResourceCache(size_t byteBudget);
+    ~ResourceCache();
+
+    /** Returns the number of bytes the cache holds.
+    */
+    size_t bytesUsed() const;
+
+    /** Drops every entry.
+    */
+    void purgeAll();
+
+private:
+    std::unique_ptr<SkPDFResourceCache> fCache;
+
+    friend class ::SkPDFDocument;
+
+    ResourceCache(const ResourceCache&) = delete;
+    ResourceCache& operator=(const ResourceCache&) = delete;
+};
+
 /** Optional metadata to be passed into the PDF factory function.
 */
 struct Metadata {
@@ -151,14 +187,22 @@ struct Metadata {
     /** Executor to handle threaded work within PDF Backend. If this is nullptr,
         then all work will be done serially on the main thread. To have worker
         threads assist with various tasks, set this to a valid SkExecutor
-        instance. Currently used for executing Deflate algorithm in parallel.
+        instance. Currently used for compressing streams, encoding images,
+        and subsetting fonts in parallel.
 
-        If set, the PDF output will be non-reproducible in the order and
-        internal numbering of objects, but should render the same.
+        Objects are written in the same order, with the same numbering, as
+        they would be without an executor, so the output is the same.
 
         Experimental.
     */
     SkExecutor* fExecutor = nullptr;
+
+    /** Cache of encoded images and subset fonts to share with other
+        documents.  If this is nullptr, the document encodes and subsets
+        everything itself.  The caller should retain ownership, and keep the
+        cache alive until the document is closed.
+    */
+    ResourceCache* fResourceCache = nullptr;
 };
 
 /** Associate a node ID with subsequent drawing commands in an
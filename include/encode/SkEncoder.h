@@ -22,11 +22,24 @@ public:
      */
     bool encodeRows(int numRows);
 
+    /**
+     *  Encode the rows in |rows|, which are the next |rows|.height() rows of the image.  This
+     *  lets the image be produced and encoded a band at a time, without ever holding all of
+     *  it.  Rows past the bottom of the image are ignored.
+     *
+     *  |rows| must have the width, color type and alpha type of the encoder's src.  The
+     *  encoder does not keep |rows| after this returns.
+     */
+    bool encodeRows(const SkPixmap& rows);
+
     virtual ~SkEncoder() {}
 
 protected:
 
-    virtual bool onEncodeRows(int numRows) = 0;
+    /**
+     *  Encode |rows|, which are rows [fCurrRow, fCurrRow + |rows|.height()) of the image.
+     */
+    virtual bool onEncodeRows(const SkPixmap& rows) = 0;
 
     SkEncoder(const SkPixmap& src, size_t storageBytes)
         : fSrc(src)
@@ -34,7 +47,9 @@ protected:
         , fStorage(storageBytes)
     {}
 
-    const SkPixmap&        fSrc;
+    // Describes the whole image.  Its pixels may be null, if rows will only be passed to
+    // encodeRows(const SkPixmap&).
+    const SkPixmap         fSrc;
     int                    fCurrRow;
     SkAutoTMalloc<uint8_t> fStorage;
 };
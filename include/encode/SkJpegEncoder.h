@@ -82,14 +82,28 @@ public:
     static std::unique_ptr<SkEncoder> Make(SkWStream* dst, const SkPixmap& src,
                                            const Options& options);
 
+    /**
+     *  Create a jpeg encoder for an image described by |info|, without its pixels.  Pass the
+     *  rows to encodeRows(const SkPixmap&) as they are produced.
+     *
+     *  |dst| is unowned but must remain valid for the lifetime of the object.
+     *
+     *  This returns nullptr on an invalid or unsupported |info|.
+     */
+    static std::unique_ptr<SkEncoder> Make(SkWStream* dst, const SkImageInfo& info,
+                                           const Options& options);
+
     ~SkJpegEncoder() override;
 
 protected:
-    bool onEncodeRows(int numRows) override;
+    bool onEncodeRows(const SkPixmap& rows) override;
 
 private:
     SkJpegEncoder(std::unique_ptr<SkJpegEncoderMgr>, const SkPixmap& src);
 
+    static std::unique_ptr<SkEncoder> MakeEncoder(SkWStream* dst, const SkPixmap& src,
+                                                  const Options& options);
+
     std::unique_ptr<SkJpegEncoderMgr> fEncoderMgr;
     typedef SkEncoder INHERITED;
 };
@@ -11,6 +11,7 @@
 #include "SkEncoder.h"
 #include "SkDataTable.h"
 
+class SkExecutor;
 class SkPngEncoderMgr;
 class SkWStream;
 
@@ -59,6 +60,14 @@ public:
          *  and the (2i + 1)-th entry is the text for the i-th comment.
          */
         sk_sp<SkDataTable> fComments;
+
+        /**
+         *  If not null, rows are filtered as they are encoded, then compressed in chunks on
+         *  this executor, in parallel with each other and with the caller producing more rows.
+         *  Each chunk is primed with the data before it, so the png is about the same size as
+         *  without an executor, but it is not byte-for-byte the same.
+         */
+        SkExecutor* fExecutor = nullptr;
     };
 
     /**
@@ -80,15 +89,30 @@ public:
     static std::unique_ptr<SkEncoder> Make(SkWStream* dst, const SkPixmap& src,
                                            const Options& options);
 
+    /**
+     *  Create a png encoder for an image described by |info|, without its pixels.  Pass the
+     *  rows to encodeRows(const SkPixmap&) as they are produced.
+     *
+     *  |dst| is unowned but must remain valid for the lifetime of the object.
+     *
+     *  This returns nullptr on an invalid or unsupported |info|.
+     */
+    static std::unique_ptr<SkEncoder> Make(SkWStream* dst, const SkImageInfo& info,
+                                           const Options& options);
+
     ~SkPngEncoder() override;
 
 protected:
-    bool onEncodeRows(int numRows) override;
+    bool onEncodeRows(const SkPixmap& rows) override;
 
     SkPngEncoder(std::unique_ptr<SkPngEncoderMgr>, const SkPixmap& src);
 
     std::unique_ptr<SkPngEncoderMgr> fEncoderMgr;
     typedef SkEncoder INHERITED;
+
+private:
+    static std::unique_ptr<SkEncoder> MakeEncoder(SkWStream* dst, const SkPixmap& src,
+                                                  const Options& options);
 };
 
 static inline SkPngEncoder::FilterFlag operator|(SkPngEncoder::FilterFlag x,
@@ -308,6 +308,21 @@ public:
 
     void storeVkPipelineCacheData();
 
+    /**
+     * Returns the program keys and SkSL of every program built by this context, if it was created
+     * with GrContextOptions::fRecordProgramsForPrecompile. Returns null if nothing was recorded or
+     * the backend does not support precompiling.
+     */
+    sk_sp<SkData> dumpRecordedPrograms() const;
+
+    /**
+     * Takes the output of dumpRecordedPrograms() from an earlier run and compiles those programs'
+     * SkSL on a background thread (GrContextOptions::fExecutor if set), so that their first use
+     * does not stall on shader compilation. Returns false if the data is not understood by this
+     * backend.
+     */
+    bool precompile(const SkData&);
+
 protected:
     GrContext(GrBackendApi, const GrContextOptions&, int32_t contextID = SK_InvalidGenID);
 
@@ -191,6 +191,13 @@ struct SK_API GrContextOptions {
      */
      bool fDisallowGLSLBinaryCaching = false;
 
+    /**
+     * If true, the context remembers the SkSL it generates for each program it builds so that
+     * GrContext::dumpRecordedPrograms() can hand it to GrContext::precompile() in a later run.
+     * Currently only supported by the GL backend.
+     */
+    bool fRecordProgramsForPrecompile = false;
+
 #if GR_TEST_UTILS
     /**
      * Private options that are only meant for testing within Skia's tools.
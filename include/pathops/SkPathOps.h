@@ -11,6 +11,7 @@
 #include "../private/SkTDArray.h"
 #include "SkPreConfig.h"
 
+class SkExecutor;
 class SkPath;
 struct SkRect;
 
@@ -101,6 +102,17 @@ public:
       */
     bool resolve(SkPath* result);
 
+    /** Computes the sum of all paths and operands like resolve(). If every path is unioned,
+        they are combined pairwise in a balanced tree of ops rather than one at a time, and
+        the ops on each level of the tree run on executor, if it is not nullptr. The result
+        covers the same area as resolve(), though its contours may be ordered differently.
+
+        @param result   The product of the operands.
+        @param executor Runs the ops on each level of the tree; may be nullptr.
+        @return True if the operation succeeded.
+      */
+    bool resolve(SkPath* result, SkExecutor* executor);
+
 private:
     SkTArray<SkPath> fPathRefs;
     SkTDArray<SkPathOp> fOps;
@@ -24,6 +24,15 @@ public:
         SkDEBUGCODE(fOwner = SkGetThreadID();)
     }
 
+    // Acquires the mutex and returns true if no other thread holds it, otherwise returns false.
+    bool tryAcquire() {
+        if (!fSemaphore.try_wait()) {
+            return false;
+        }
+        SkDEBUGCODE(fOwner = SkGetThreadID();)
+        return true;
+    }
+
     void release() {
         this->assertHeld();
         SkDEBUGCODE(fOwner = kIllegalThreadID;)
@@ -10,11 +10,24 @@
 
 #include "SkCodec.h"
 
+class SkExecutor;
 class SkImage;
 
 class SkAnimCodecPlayer {
 public:
     SkAnimCodecPlayer(std::unique_ptr<SkCodec> codec);
+
+    /**
+     *  Plays the animation in data, keeping decoded frames up to roughly cacheBytes.
+     *
+     *  Frames that don't depend on an earlier frame (getRequiredFrame() is kNoFrame) are
+     *  keyframes. When executor is not null, the keyframes after the current frame are decoded
+     *  ahead on it in parallel, each with its own codec. When the cache is full, other frames
+     *  are evicted before keyframes, so seeking costs at most a replay from the nearest
+     *  earlier keyframe. The executor must outlive the player.
+     */
+    SkAnimCodecPlayer(sk_sp<SkData> data, SkExecutor* executor, size_t cacheBytes);
+
     ~SkAnimCodecPlayer();
 
     /**
@@ -46,6 +59,8 @@ public:
 
 
 private:
+    struct Prefetcher;
+
     std::unique_ptr<SkCodec>        fCodec;
     SkImageInfo                     fImageInfo;
     std::vector<SkCodec::FrameInfo> fFrameInfos;
@@ -53,7 +68,21 @@ private:
     int                             fCurrIndex = 0;
     uint32_t                        fTotalDuration;
 
+    // The cache, for animations.
+    size_t                          fCacheBytes = SIZE_MAX;
+    size_t                          fCachedBytes = 0;
+    std::vector<uint64_t>           fLastUse;
+    uint64_t                        fUseCount = 0;
+
+    std::unique_ptr<Prefetcher>     fPrefetcher;
+
+    void init();
     sk_sp<SkImage> getFrameAt(int index);
+    bool decodeFrame(int index);
+    void cacheFrame(int index, sk_sp<SkImage>);
+    bool makeRoom(bool evictKeyframes, int keep);
+    void collectPrefetched(bool wait);
+    void prefetch();
 };
 
 #endif
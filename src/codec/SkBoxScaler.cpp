@@ -0,0 +1,185 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBoxScaler.h"
+
+#include "SkHalf.h"
+#include "SkNx.h"
+
+#include <string.h>
+
+std::unique_ptr<SkBoxScaler> SkBoxScaler::Make(int srcWidth, int srcHeight,
+                                               const SkPixmap& dst) {
+    if (!dst.addr() || dst.width() <= 0 || dst.height() <= 0 ||
+            dst.width() > srcWidth || dst.height() > srcHeight) {
+        return nullptr;
+    }
+
+    switch (dst.colorType()) {
+        case kRGBA_8888_SkColorType:
+        case kBGRA_8888_SkColorType:
+            return std::unique_ptr<SkBoxScaler>(
+                    new SkBoxScaler(srcWidth, srcHeight, dst, 4, false));
+        case kGray_8_SkColorType:
+        case kAlpha_8_SkColorType:
+            return std::unique_ptr<SkBoxScaler>(
+                    new SkBoxScaler(srcWidth, srcHeight, dst, 1, false));
+        case kRGBA_F16_SkColorType:
+            return std::unique_ptr<SkBoxScaler>(
+                    new SkBoxScaler(srcWidth, srcHeight, dst, 4, true));
+        default:
+            return nullptr;
+    }
+}
+
+SkBoxScaler::SkBoxScaler(int srcWidth, int srcHeight, const SkPixmap& dst, int channels,
+                         bool isHalf)
+    : fSrcWidth(srcWidth)
+    , fSrcHeight(srcHeight)
+    , fDst(dst)
+    , fChannels(channels)
+    , fIsHalf(isHalf)
+    , fFiltered(dst.width() * channels)
+    , fWritten(dst.height())
+{
+    // Work in units of 1 / (srcWidth * dstWidth) of the image width, so that the edges of
+    // both source and destination pixels are whole numbers: source pixel i covers
+    // [i * dstWidth, (i + 1) * dstWidth), and destination pixel x covers
+    // [x * srcWidth, (x + 1) * srcWidth).
+    const int64_t dstWidth = dst.width();
+    const float scale = 1.0f / srcWidth;
+    fFirsts.setReserve(dst.width());
+    fCounts.setReserve(dst.width());
+    fWeights.setReserve(srcWidth + dst.width());
+    for (int64_t x = 0; x < dstWidth; x++) {
+        const int64_t left = x * srcWidth;
+        const int64_t right = left + srcWidth;
+        const int first = (int) (left / dstWidth);
+        const int last = (int) ((right - 1) / dstWidth);
+        *fFirsts.append() = first;
+        *fCounts.append() = last - first + 1;
+        for (int64_t i = first; i <= last; i++) {
+            const int64_t overlap = SkTMin(right, (i + 1) * dstWidth) -
+                                    SkTMax(left, i * dstWidth);
+            *fWeights.append() = overlap * scale;
+        }
+    }
+
+    for (int i = 0; i < 2; i++) {
+        fAccums[i].reset(dst.width() * channels);
+        fSlotRows[i] = -1;
+        fCoverage[i] = 0;
+    }
+    memset(fWritten.get(), 0, dst.height() * sizeof(bool));
+}
+
+void SkBoxScaler::filterRow(const void* row) {
+    const float* weight = fWeights.begin();
+    float* out = fFiltered.get();
+    if (4 == fChannels) {
+        for (int x = 0; x < fDst.width(); x++) {
+            Sk4f sum(0.0f);
+            const int first = fFirsts[x];
+            const int count = fCounts[x];
+            if (fIsHalf) {
+                const uint64_t* src = (const uint64_t*) row + first;
+                for (int i = 0; i < count; i++) {
+                    sum = sum + SkHalfToFloat_finite_ftz(src[i]) * weight[i];
+                }
+            } else {
+                const uint32_t* src = (const uint32_t*) row + first;
+                for (int i = 0; i < count; i++) {
+                    sum = sum + SkNx_cast<float>(Sk4b::Load(src + i)) * weight[i];
+                }
+            }
+            sum.store(out + 4 * x);
+            weight += count;
+        }
+    } else {
+        const uint8_t* src = (const uint8_t*) row;
+        for (int x = 0; x < fDst.width(); x++) {
+            float sum = 0.0f;
+            const int first = fFirsts[x];
+            const int count = fCounts[x];
+            for (int i = 0; i < count; i++) {
+                sum += src[first + i] * weight[i];
+            }
+            out[x] = sum;
+            weight += count;
+        }
+    }
+}
+
+void SkBoxScaler::accumulate(int dstY, int64_t coverage) {
+    const int slot = dstY & 1;
+    if (fSlotRows[slot] != dstY) {
+        SkASSERT(-1 == fSlotRows[slot]);
+        fSlotRows[slot] = dstY;
+        fCoverage[slot] = 0;
+        memset(fAccums[slot].get(), 0, fDst.width() * fChannels * sizeof(float));
+    }
+
+    const float weight = (float) coverage / fSrcHeight;
+    float* accum = fAccums[slot].get();
+    const float* filtered = fFiltered.get();
+    const int count = fDst.width() * fChannels;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        (Sk4f::Load(accum + i) + Sk4f::Load(filtered + i) * weight).store(accum + i);
+    }
+    for (; i < count; i++) {
+        accum[i] += filtered[i] * weight;
+    }
+
+    fCoverage[slot] += coverage;
+    if (fCoverage[slot] == fSrcHeight) {
+        this->writeRow(slot, dstY);
+        fSlotRows[slot] = -1;
+    }
+}
+
+void SkBoxScaler::writeRow(int slot, int dstY) {
+    const float* accum = fAccums[slot].get();
+    void* dst = fDst.writable_addr(0, dstY);
+    if (fIsHalf) {
+        uint64_t* out = (uint64_t*) dst;
+        for (int x = 0; x < fDst.width(); x++) {
+            SkFloatToHalf_finite_ftz(Sk4f::Load(accum + 4 * x)).store(out + x);
+        }
+    } else if (4 == fChannels) {
+        uint32_t* out = (uint32_t*) dst;
+        for (int x = 0; x < fDst.width(); x++) {
+            const Sk4f rounded = Sk4f::Min(Sk4f::Load(accum + 4 * x) + 0.5f, 255.0f);
+            SkNx_cast<uint8_t>(rounded).store(out + x);
+        }
+    } else {
+        uint8_t* out = (uint8_t*) dst;
+        for (int x = 0; x < fDst.width(); x++) {
+            out[x] = (uint8_t) SkTMin(accum[x] + 0.5f, 255.0f);
+        }
+    }
+    fWritten[dstY] = true;
+}
+
+void SkBoxScaler::addRow(int srcY, const void* row) {
+    SkASSERT(0 <= srcY && srcY < fSrcHeight);
+    this->filterRow(row);
+
+    // In units of 1 / (srcHeight * dstHeight) of the image height, source row srcY covers
+    // [srcY * dstHeight, (srcY + 1) * dstHeight), and destination row y covers
+    // [y * srcHeight, (y + 1) * srcHeight).  The destination is no taller than the source,
+    // so a source row covers at most two destination rows.
+    const int64_t dstHeight = fDst.height();
+    const int64_t top = srcY * dstHeight;
+    const int64_t bottom = top + dstHeight;
+    const int dstY = (int) (top / fSrcHeight);
+    const int64_t split = SkTMin(bottom, (dstY + 1) * (int64_t) fSrcHeight);
+    this->accumulate(dstY, split - top);
+    if (split < bottom) {
+        this->accumulate(dstY + 1, bottom - split);
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkBoxScaler_DEFINED
+#define SkBoxScaler_DEFINED
+
+#include "SkImageInfo.h"
+#include "SkNoncopyable.h"
+#include "SkPixmap.h"
+#include "SkTDArray.h"
+#include "SkTemplates.h"
+
+#include <memory>
+
+/*
+ * Scales an image down to the size of a destination pixmap, setting each destination pixel
+ * to the average of the area of the image it covers.  Each source row is folded into the
+ * destination row(s) it covers as it is added, so only a couple of rows of accumulators are
+ * held at once, and never the whole source image.
+ */
+class SkBoxScaler : SkNoncopyable {
+public:
+    /*
+     * Returns null unless dst is no larger than srcWidth x srcHeight, and has a color type this
+     * can average: kRGBA_8888, kBGRA_8888, kGray_8, kAlpha_8 or kRGBA_F16.  Source rows have the
+     * same color type.
+     */
+    static std::unique_ptr<SkBoxScaler> Make(int srcWidth, int srcHeight, const SkPixmap& dst);
+
+    /*
+     * Adds source row srcY, which has srcWidth pixels.  Rows must be added in order, either
+     * from the top down or from the bottom up.  A destination row is written as soon as all
+     * of the rows it covers have been added.
+     */
+    void addRow(int srcY, const void* row);
+
+    bool isRowWritten(int dstY) const { return fWritten[dstY]; }
+
+private:
+    SkBoxScaler(int srcWidth, int srcHeight, const SkPixmap& dst, int channels, bool isHalf);
+
+    void filterRow(const void* row);
+    void accumulate(int dstY, int64_t coverage);
+    void writeRow(int slot, int dstY);
+
+    const int               fSrcWidth;
+    const int               fSrcHeight;
+    const SkPixmap          fDst;
+    const int               fChannels;      // 4 or 1.
+    const bool              fIsHalf;
+
+    // Destination pixel x is the weighted sum of fCounts[x] source pixels starting at
+    // fFirsts[x].  The weights of all of them are packed into fWeights.
+    SkTDArray<int>          fFirsts;
+    SkTDArray<int>          fCounts;
+    SkTDArray<float>        fWeights;
+
+    SkAutoTMalloc<float>    fFiltered;      // The last source row added, filtered horizontally.
+
+    // A source row covers at most two destination rows, so two rows of accumulators are
+    // enough.  fSlotRows[i] is the destination row in fAccums[i], or -1.  fCoverage[i] is how
+    // much of that row has been added so far, in units of 1 / dst.height() source rows.
+    SkAutoTMalloc<float>    fAccums[2];
+    int                     fSlotRows[2];
+    int64_t                 fCoverage[2];
+
+    SkAutoTMalloc<bool>     fWritten;
+};
+
+#endif
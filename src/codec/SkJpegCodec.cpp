@@ -12,7 +12,9 @@
 #include "SkColorData.h"
 #include "SkJpegDecoderMgr.h"
 #include "SkJpegInfo.h"
+#include "SkJpegRestartIndex.h"
 #include "SkStream.h"
+#include "SkTaskGroup.h"
 #include "SkTemplates.h"
 #include "SkTo.h"
 #include "SkTypes.h"
@@ -21,6 +23,8 @@
 #include <stdio.h>
 #include "SkJpegUtility.h"
 
+#include <atomic>
+
 // This warning triggers false postives way too often in here.
 #if defined(__GNUC__) && !defined(__clang__)
     #pragma GCC diagnostic ignored "-Wclobbered"
@@ -306,6 +310,7 @@ SkJpegCodec::SkJpegCodec(SkEncodedInfo&& info, std::unique_ptr<SkStream> stream,
     , fSwizzleSrcRow(nullptr)
     , fColorXformSrcRow(nullptr)
     , fSwizzlerSubset(SkIRect::MakeEmpty())
+    , fTriedRestartIndex(false)
 {}
 
 /*
@@ -376,6 +381,7 @@ bool SkJpegCodec::onRewind() {
     }
     SkASSERT(nullptr != decoderMgr);
     fDecoderMgr.reset(decoderMgr);
+    fIntervalStream.reset();
 
     fSwizzler.reset(nullptr);
     fSwizzleSrcRow = nullptr;
@@ -569,6 +575,135 @@ static inline bool needs_swizzler_to_convert_from_cmyk(J_COLOR_SPACE jpegColorTy
     return !hasCMYKColorSpace || !hasColorSpaceXform;
 }
 
+SkJpegRestartIndex* SkJpegCodec::restartIndex() {
+    if (!fRestartIndex && !fTriedRestartIndex) {
+        fTriedRestartIndex = true;
+        SkStream* stream = this->stream();
+        if (stream->getMemoryBase() && stream->hasLength()) {
+            fRestartIndex = SkJpegRestartIndex::Make(
+                    *fDecoderMgr->dinfo(), this->dimensions().height(),
+                    (const uint8_t*) stream->getMemoryBase(), stream->getLength());
+        }
+    }
+    return fRestartIndex.get();
+}
+
+sk_sp<SkData> SkJpegCodec::onMakeRegionIndex() {
+    SkJpegRestartIndex* index = this->restartIndex();
+    return index ? index->serialize() : nullptr;
+}
+
+bool SkJpegCodec::onSetRegionIndex(const SkData& serialized) {
+    SkStream* stream = this->stream();
+    if (!stream->getMemoryBase() || !stream->hasLength()) {
+        return false;
+    }
+    auto index = SkJpegRestartIndex::MakeFromData(serialized, *fDecoderMgr->dinfo(),
+                                                  this->dimensions().height(),
+                                                  (const uint8_t*) stream->getMemoryBase(),
+                                                  stream->getLength());
+    if (!index) {
+        return false;
+    }
+    fRestartIndex = std::move(index);
+    return true;
+}
+
+bool SkJpegCodec::decodeStripes(const SkImageInfo& dstInfo, void* dst, size_t rowBytes,
+                                SkExecutor* executor) {
+    // Below this many rows per stripe, the extra intervals each stripe decodes cost more
+    // than running in parallel saves.
+    constexpr int kMinStripeRows = 128;
+    constexpr int kMaxStripes = 32;
+
+    jpeg_decompress_struct* dinfo = fDecoderMgr->dinfo();
+    const int height = dstInfo.height();
+    if (dinfo->scale_num != dinfo->scale_denom || dstInfo.dimensions() != this->dimensions() ||
+            needs_swizzler_to_convert_from_cmyk(dinfo->out_color_space,
+                                                this->getEncodedInfo().profile(),
+                                                this->colorXform())) {
+        return false;
+    }
+
+    SkJpegRestartIndex* index = this->restartIndex();
+    if (!index) {
+        return false;
+    }
+    const int rowsPerInterval = index->rowsPerInterval();
+    const int intervalCount = index->intervalCount();
+    const int stripes = SkTMin(intervalCount, SkTMin(kMaxStripes, height / kMinStripeRows));
+    if (stripes < 2) {
+        return false;
+    }
+
+    const uint8_t* data = (const uint8_t*) this->stream()->getMemoryBase();
+    const bool needsXformRow = this->colorXform() &&
+                               sizeof(uint32_t) != dstInfo.bytesPerPixel();
+    std::atomic<bool> success{true};
+    SkTaskGroup(*executor).batch(stripes, [&](int stripe) {
+        // Decode an extra interval on either side, so that fancy upsampling sees the same
+        // neighboring rows that it would in a serial decode.
+        const int first = stripe * intervalCount / stripes;
+        const int end = (stripe + 1) * intervalCount / stripes;
+        const int decodeFirst = SkTMax(first - 1, 0);
+        const int decodeEnd = SkTMin(end + 1, intervalCount);
+
+        SkMemoryStream stripeStream(index->makeIntervals(data, decodeFirst, decodeEnd));
+        const int firstRow = first * rowsPerInterval;
+        const int rowCount = SkTMin(end * rowsPerInterval, height) - firstRow;
+        if (!this->decodeStripe(&stripeStream, (first - decodeFirst) * rowsPerInterval,
+                                rowCount, SkTAddOffset<void>(dst, firstRow * rowBytes),
+                                rowBytes, needsXformRow)) {
+            success = false;
+        }
+    });
+    return success;
+}
+
+bool SkJpegCodec::decodeStripe(SkStream* stripe, int skipRows, int rowCount, void* dst,
+                               size_t rowBytes, bool needsXformRow) {
+    JpegDecoderMgr decoderMgr(stripe);
+    SkAutoTMalloc<JSAMPLE> storage;
+
+    skjpeg_error_mgr::AutoPushJmpBuf jmp(decoderMgr.errorMgr());
+    if (setjmp(jmp)) {
+        return false;
+    }
+
+    decoderMgr.init();
+    jpeg_decompress_struct* dinfo = decoderMgr.dinfo();
+    if (JPEG_HEADER_OK != jpeg_read_header(dinfo, true)) {
+        return false;
+    }
+    const jpeg_decompress_struct* settings = fDecoderMgr->dinfo();
+    dinfo->out_color_space = settings->out_color_space;
+    dinfo->dither_mode = settings->dither_mode;
+    dinfo->dct_method = settings->dct_method;
+    dinfo->do_fancy_upsampling = settings->do_fancy_upsampling;
+    if (!jpeg_start_decompress(dinfo)) {
+        return false;
+    }
+
+    storage.reset(get_row_bytes(dinfo));
+    JSAMPLE* row = storage.get();
+    for (int y = 0; y < skipRows; y++) {
+        if (1 != jpeg_read_scanlines(dinfo, &row, 1)) {
+            return false;
+        }
+    }
+    for (int y = 0; y < rowCount; y++) {
+        row = needsXformRow ? storage.get() : (JSAMPLE*) dst;
+        if (1 != jpeg_read_scanlines(dinfo, &row, 1)) {
+            return false;
+        }
+        if (this->colorXform()) {
+            this->applyColorXform(dst, row, dinfo->output_width);
+        }
+        dst = SkTAddOffset<void>(dst, rowBytes);
+    }
+    return true;
+}
+
 /*
  * Performs the jpeg decode
  */
@@ -581,6 +716,10 @@ SkCodec::Result SkJpegCodec::onGetPixels(const SkImageInfo& dstInfo,
         return kUnimplemented;
     }
 
+    if (options.fExecutor && this->decodeStripes(dstInfo, dst, dstRowBytes, options.fExecutor)) {
+        return kSuccess;
+    }
+
     // Get a pointer to the decompress info since we will use it quite frequently
     jpeg_decompress_struct* dinfo = fDecoderMgr->dinfo();
 
@@ -774,7 +913,66 @@ int SkJpegCodec::onGetScanlines(void* dst, int count, size_t dstRowBytes) {
     return rows;
 }
 
+int SkJpegCodec::skipIntervals(int rows) {
+    jpeg_decompress_struct* dinfo = fDecoderMgr->dinfo();
+    const int scaledRowsPerInterval = fRestartIndex->rowsPerInterval() * dinfo->scale_num;
+    if (0 != scaledRowsPerInterval % dinfo->scale_denom) {
+        return rows;
+    }
+    const int rowsPerInterval = scaledRowsPerInterval / dinfo->scale_denom;
+
+    // Start an interval early, so that fancy upsampling sees the same rows above the first
+    // one we need that it would have when decoding from the top.
+    const int first = rows / rowsPerInterval - 1;
+    if (first <= 0) {
+        return rows;
+    }
+
+    const uint8_t* data = (const uint8_t*) this->stream()->getMemoryBase();
+    std::unique_ptr<SkStream> stream(new SkMemoryStream(
+            fRestartIndex->makeIntervals(data, first, fRestartIndex->intervalCount())));
+    std::unique_ptr<JpegDecoderMgr> decoderMgr(new JpegDecoderMgr(stream.get()));
+    {
+        skjpeg_error_mgr::AutoPushJmpBuf jmp(decoderMgr->errorMgr());
+        if (setjmp(jmp)) {
+            return rows;
+        }
+
+        decoderMgr->init();
+        jpeg_decompress_struct* intervalInfo = decoderMgr->dinfo();
+        if (JPEG_HEADER_OK != jpeg_read_header(intervalInfo, true)) {
+            return rows;
+        }
+        intervalInfo->out_color_space = dinfo->out_color_space;
+        intervalInfo->dither_mode = dinfo->dither_mode;
+        intervalInfo->dct_method = dinfo->dct_method;
+        intervalInfo->do_fancy_upsampling = dinfo->do_fancy_upsampling;
+        intervalInfo->scale_num = dinfo->scale_num;
+        intervalInfo->scale_denom = dinfo->scale_denom;
+        if (!jpeg_start_decompress(intervalInfo)) {
+            return rows;
+        }
+        if (const SkIRect* subset = this->options().fSubset) {
+            // Crop the same way onStartScanlineDecode() did.
+            uint32_t startX = subset->x();
+            uint32_t width = subset->width();
+            jpeg_crop_scanline(intervalInfo, &startX, &width);
+        }
+        if (intervalInfo->output_width != dinfo->output_width) {
+            return rows;
+        }
+    }
+
+    fDecoderMgr = std::move(decoderMgr);
+    fIntervalStream = std::move(stream);
+    return rows - first * rowsPerInterval;
+}
+
 bool SkJpegCodec::onSkipScanlines(int count) {
+    if (fRestartIndex && 0 == fDecoderMgr->dinfo()->output_scanline) {
+        count = this->skipIntervals(count);
+    }
+
     // Set the jump location for libjpeg errors
     skjpeg_error_mgr::AutoPushJmpBuf jmp(fDecoderMgr->errorMgr());
     if (setjmp(jmp)) {
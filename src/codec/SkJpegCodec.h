@@ -15,6 +15,7 @@
 #include "SkTemplates.h"
 
 class JpegDecoderMgr;
+class SkJpegRestartIndex;
 
 /*
  *
@@ -57,6 +58,10 @@ protected:
 
     bool onDimensionsSupported(const SkISize&) override;
 
+    sk_sp<SkData> onMakeRegionIndex() override;
+
+    bool onSetRegionIndex(const SkData&) override;
+
     bool conversionSupported(const SkImageInfo&, bool, bool) override;
 
 private:
@@ -109,6 +114,33 @@ private:
     void allocateStorage(const SkImageInfo& dstInfo);
     int readRows(const SkImageInfo& dstInfo, void* dst, size_t rowBytes, int count, const Options&);
 
+    // Returns the index of this image's restart markers, scanning for them the first time.
+    SkJpegRestartIndex* restartIndex();
+
+    /*
+     * Called at the start of a scanline decode that skips the given number of rows.  Uses the
+     * restart index to replace fDecoderMgr with one that starts decoding as close to the
+     * first row needed as it can.  Returns the number of rows that are left to skip.
+     */
+    int skipIntervals(int rows);
+
+    /*
+     * Decodes the whole image as horizontal stripes on the executor.  This only works for
+     * single-scan images with restart markers at the start of MCU rows, since each stripe
+     * decodes its own run of restart intervals.
+     *
+     * Returns false if the image can't be split or a stripe failed, in which case nothing
+     * has been consumed and the caller should decode serially.
+     */
+    bool decodeStripes(const SkImageInfo& dstInfo, void* dst, size_t rowBytes, SkExecutor*);
+
+    /*
+     * Decodes rows [skipRows, skipRows + rowCount) of a stripe, a jpeg made of some of this
+     * image's restart intervals, into dst, using the same output settings as fDecoderMgr.
+     */
+    bool decodeStripe(SkStream* stripe, int skipRows, int rowCount, void* dst, size_t rowBytes,
+                      bool needsXformRow);
+
     /*
      * Scanline decoding.
      */
@@ -118,6 +150,9 @@ private:
     int onGetScanlines(void* dst, int count, size_t rowBytes) override;
     bool onSkipScanlines(int count) override;
 
+    // When skipIntervals() starts partway down the image, fDecoderMgr reads this stream, made
+    // of some of the image's restart intervals.
+    std::unique_ptr<SkStream>          fIntervalStream;
     std::unique_ptr<JpegDecoderMgr>    fDecoderMgr;
 
     // We will save the state of the decompress struct after reading the header.
@@ -136,6 +171,9 @@ private:
 
     std::unique_ptr<SkSwizzler>        fSwizzler;
 
+    std::unique_ptr<SkJpegRestartIndex> fRestartIndex;
+    bool                               fTriedRestartIndex;
+
     friend class SkRawCodec;
 
     typedef SkCodec INHERITED;
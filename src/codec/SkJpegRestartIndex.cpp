@@ -0,0 +1,249 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkJpegRestartIndex.h"
+
+#include "SkStream.h"
+#include "SkTo.h"
+
+#include <string.h>
+
+static constexpr char     kMagic[4] = { 'j', 'r', 's', 't' };
+static constexpr uint32_t kVersion  = 1;
+
+static uint16_t get_big_endian_short(const uint8_t* data) {
+    return (data[0] << 8) | data[1];
+}
+
+/*
+ * Works out how many rows each restart interval covers, and how many intervals there are.
+ * Returns false unless the image has a single Huffman-coded scan, and each restart interval
+ * is a whole number of MCU rows.
+ */
+static bool interval_geometry(const jpeg_decompress_struct& dinfo, int height,
+                              int* rowsPerInterval, int* intervalCount) {
+    if (dinfo.progressive_mode || dinfo.arith_code || 8 != dinfo.data_precision ||
+            0 == dinfo.restart_interval || dinfo.comps_in_scan != dinfo.num_components) {
+        return false;
+    }
+
+    // A single component scan isn't interleaved, and has 8x8 MCUs.
+    int mcuWidth = 8;
+    int mcuHeight = 8;
+    if (dinfo.num_components > 1) {
+        for (int i = 0; i < dinfo.num_components; i++) {
+            mcuWidth = SkTMax(mcuWidth, dinfo.comp_info[i].h_samp_factor * 8);
+            mcuHeight = SkTMax(mcuHeight, dinfo.comp_info[i].v_samp_factor * 8);
+        }
+    }
+    const int mcusPerRow = (dinfo.image_width + mcuWidth - 1) / mcuWidth;
+    const int mcuRows = (height + mcuHeight - 1) / mcuHeight;
+    if (0 == mcusPerRow || 0 != dinfo.restart_interval % mcusPerRow) {
+        return false;
+    }
+    const int mcuRowsPerInterval = dinfo.restart_interval / mcusPerRow;
+    *rowsPerInterval = mcuRowsPerInterval * mcuHeight;
+    *intervalCount = (mcuRows + mcuRowsPerInterval - 1) / mcuRowsPerInterval;
+    return true;
+}
+
+/*
+ * Walks the header segments to find the frame height, and where the scan data starts.
+ * Returns false unless the frame is sequential and Huffman-coded.
+ */
+static bool parse_header(const uint8_t* data, size_t length, uint32_t* heightOffset,
+                         uint32_t* scanStart) {
+    *heightOffset = 0;
+    size_t offset = 2;
+    for (;;) {
+        if (offset + 4 > length || 0xFF != data[offset]) {
+            return false;
+        }
+        const uint8_t marker = data[offset + 1];
+        if (0xFF == marker) {
+            // Fill byte.
+            offset++;
+            continue;
+        }
+        const size_t segmentEnd = offset + 2 + get_big_endian_short(data + offset + 2);
+        if (segmentEnd > length) {
+            return false;
+        }
+        if (0xC0 == marker || 0xC1 == marker) {
+            // Baseline or extended sequential DCT, Huffman coding.
+            if (*heightOffset || segmentEnd < offset + 7) {
+                return false;
+            }
+            *heightOffset = SkToU32(offset + 5);
+        } else if (0xC2 <= marker && marker <= 0xCF && 0xC4 != marker && 0xC8 != marker &&
+                   0xCC != marker) {
+            return false;
+        }
+        offset = segmentEnd;
+        if (0xDA == marker) {
+            *scanStart = SkToU32(offset);
+            return *heightOffset != 0;
+        }
+    }
+}
+
+std::unique_ptr<SkJpegRestartIndex> SkJpegRestartIndex::Make(const jpeg_decompress_struct& dinfo,
+                                                             int height, const uint8_t* data,
+                                                             size_t length) {
+    int rowsPerInterval, intervalCount;
+    if (!data || length > UINT32_MAX ||
+            !interval_geometry(dinfo, height, &rowsPerInterval, &intervalCount)) {
+        return nullptr;
+    }
+
+    std::unique_ptr<SkJpegRestartIndex> index(new SkJpegRestartIndex);
+    if (!parse_header(data, length, &index->fHeightOffset, &index->fScanStart)) {
+        return nullptr;
+    }
+    index->fLength = SkToU32(length);
+    index->fHeight = height;
+    index->fRowsPerInterval = rowsPerInterval;
+    index->fMarkers.setReserve(intervalCount - 1);
+
+    size_t offset = index->fScanStart;
+    while (offset + 1 < length) {
+        const uint8_t* next = (const uint8_t*) memchr(data + offset, 0xFF, length - offset - 1);
+        if (!next) {
+            return nullptr;
+        }
+        offset = next - data;
+        const uint8_t marker = data[offset + 1];
+        if (0x00 == marker) {
+            // A stuffed 0xFF data byte.
+            offset += 2;
+        } else if (0xFF == marker) {
+            // Fill byte.
+            offset++;
+        } else if (0xD0 <= marker && marker <= 0xD7) {
+            if (index->fMarkers.count() == intervalCount - 1 ||
+                    marker - 0xD0 != (index->fMarkers.count() & 7)) {
+                return nullptr;
+            }
+            *index->fMarkers.append() = SkToU32(offset);
+            offset += 2;
+        } else if (0xD9 == marker) {
+            index->fScanEnd = SkToU32(offset);
+            if (index->fMarkers.count() != intervalCount - 1) {
+                return nullptr;
+            }
+            return index;
+        } else {
+            // Another scan, a DNL, or something we don't expect inside the scan.
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+sk_sp<SkData> SkJpegRestartIndex::serialize() const {
+    SkDynamicMemoryWStream stream;
+    stream.write(kMagic, sizeof(kMagic));
+    stream.write32(kVersion);
+    stream.write32(fLength);
+    stream.write32(fHeight);
+    stream.write32(fRowsPerInterval);
+    stream.write32(fHeightOffset);
+    stream.write32(fScanStart);
+    stream.write32(fScanEnd);
+    stream.write32(fMarkers.count());
+    stream.write(fMarkers.begin(), fMarkers.bytes());
+    return stream.detachAsData();
+}
+
+std::unique_ptr<SkJpegRestartIndex> SkJpegRestartIndex::MakeFromData(
+        const SkData& serialized, const jpeg_decompress_struct& dinfo, int height,
+        const uint8_t* data, size_t length) {
+    int rowsPerInterval, intervalCount;
+    if (!data || !interval_geometry(dinfo, height, &rowsPerInterval, &intervalCount)) {
+        return nullptr;
+    }
+
+    SkMemoryStream stream(serialized.data(), serialized.size(), false);
+    char magic[sizeof(kMagic)];
+    uint32_t version, markerCount;
+    std::unique_ptr<SkJpegRestartIndex> index(new SkJpegRestartIndex);
+    if (sizeof(magic) != stream.read(magic, sizeof(magic)) ||
+            0 != memcmp(magic, kMagic, sizeof(kMagic)) ||
+            !stream.readU32(&version) || kVersion != version ||
+            !stream.readU32(&index->fLength) ||
+            !stream.readU32(&index->fHeight) ||
+            !stream.readU32(&index->fRowsPerInterval) ||
+            !stream.readU32(&index->fHeightOffset) ||
+            !stream.readU32(&index->fScanStart) ||
+            !stream.readU32(&index->fScanEnd) ||
+            !stream.readU32(&markerCount)) {
+        return nullptr;
+    }
+
+    // The index must describe this image...
+    uint32_t heightOffset, scanStart;
+    if (index->fLength != length || index->fHeight != SkToU32(height) ||
+            index->fRowsPerInterval != SkToU32(rowsPerInterval) ||
+            markerCount != SkToU32(intervalCount - 1) ||
+            stream.getLength() - stream.getPosition() != markerCount * sizeof(uint32_t) ||
+            !parse_header(data, length, &heightOffset, &scanStart) ||
+            index->fHeightOffset != heightOffset || index->fScanStart != scanStart) {
+        return nullptr;
+    }
+    index->fMarkers.setCount(markerCount);
+    if (index->fMarkers.bytes() != stream.read(index->fMarkers.begin(),
+                                               index->fMarkers.bytes())) {
+        return nullptr;
+    }
+
+    // ... and its markers must be where it says.
+    size_t previous = index->fScanStart;
+    for (int i = 0; i < index->fMarkers.count(); i++) {
+        const size_t marker = index->fMarkers[i];
+        if (marker < previous || marker + 2 > length || 0xFF != data[marker] ||
+                0xD0 + (i & 7) != data[marker + 1]) {
+            return nullptr;
+        }
+        previous = marker + 2;
+    }
+    if (index->fScanEnd < previous || SkToSizeT(index->fScanEnd) + 2 > length ||
+            0xFF != data[index->fScanEnd] || 0xD9 != data[index->fScanEnd + 1]) {
+        return nullptr;
+    }
+    return index;
+}
+
+sk_sp<SkData> SkJpegRestartIndex::makeIntervals(const uint8_t* data, int first, int end) const {
+    SkASSERT(0 <= first && first < end && end <= this->intervalCount());
+
+    size_t size = fScanStart + 2;
+    for (int i = first; i < end; i++) {
+        size += this->end(i) - this->start(i) + (i > first ? 2 : 0);
+    }
+    sk_sp<SkData> jpeg = SkData::MakeUninitialized(size);
+    uint8_t* out = (uint8_t*) jpeg->writable_data();
+
+    memcpy(out, data, fScanStart);
+    const uint32_t height = SkTMin(end * fRowsPerInterval, fHeight) - first * fRowsPerInterval;
+    out[fHeightOffset]     = (uint8_t) (height >> 8);
+    out[fHeightOffset + 1] = (uint8_t) height;
+    out += fScanStart;
+
+    for (int i = first; i < end; i++) {
+        if (i > first) {
+            // Restart markers count up from RST0 again.
+            *out++ = 0xFF;
+            *out++ = (uint8_t) (0xD0 + ((i - first - 1) & 7));
+        }
+        memcpy(out, data + this->start(i), this->end(i) - this->start(i));
+        out += this->end(i) - this->start(i);
+    }
+    *out++ = 0xFF;
+    *out++ = 0xD9;
+    SkASSERT(out == jpeg->bytes() + size);
+    return jpeg;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkJpegRestartIndex_DEFINED
+#define SkJpegRestartIndex_DEFINED
+
+#include "SkData.h"
+#include "SkRefCnt.h"
+#include "SkTDArray.h"
+
+#include <memory>
+
+// stdio is needed for jpeglib
+#include <stdio.h>
+
+extern "C" {
+    #include "jpeglib.h"
+}
+
+/*
+ * Where the entropy-coded data of a single-scan, Huffman-coded jpeg can be split, when it has
+ * restart markers at the start of every run of MCU rows.  The DC predictions reset at each
+ * restart marker, so any run of restart intervals can be decoded on its own, as a jpeg with
+ * the same header and a shorter height.  That lets a region near the bottom of the image be
+ * decoded without decoding every row above it, and lets stripes be decoded in parallel.
+ *
+ * An index only depends on the encoded data, so it can be serialized and kept next to it.
+ */
+class SkJpegRestartIndex {
+public:
+    /*
+     * Scans the jpeg in data, which is height rows tall.  dinfo has read the header of that
+     * jpeg, or of one made by makeIntervals(), which differs only in its height.  Returns null
+     * if the jpeg can't be split.
+     */
+    static std::unique_ptr<SkJpegRestartIndex> Make(const jpeg_decompress_struct& dinfo,
+                                                    int height, const uint8_t* data,
+                                                    size_t length);
+
+    /*
+     * Reads back an index from serialize().  Returns null unless it describes this jpeg and
+     * its restart markers are where it says they are.
+     */
+    static std::unique_ptr<SkJpegRestartIndex> MakeFromData(const SkData& index,
+                                                            const jpeg_decompress_struct& dinfo,
+                                                            int height, const uint8_t* data,
+                                                            size_t length);
+
+    sk_sp<SkData> serialize() const;
+
+    // Rows of the unscaled image in each restart interval.  The last may have fewer.
+    int rowsPerInterval() const { return fRowsPerInterval; }
+    int intervalCount() const { return fMarkers.count() + 1; }
+
+    /*
+     * Makes a jpeg of intervals [first, end) of the image in data, with the same header, whose
+     * height is the number of rows in those intervals.
+     */
+    sk_sp<SkData> makeIntervals(const uint8_t* data, int first, int end) const;
+
+private:
+    SkJpegRestartIndex() = default;
+
+    // The entropy-coded data of one restart interval, without its markers.
+    size_t start(int interval) const {
+        return 0 == interval ? fScanStart : fMarkers[interval - 1] + 2;
+    }
+    size_t end(int interval) const {
+        return interval == fMarkers.count() ? fScanEnd : fMarkers[interval];
+    }
+
+    uint32_t            fLength;          // The size of the encoded data.
+    uint32_t            fHeight;          // The height of the image.
+    uint32_t            fRowsPerInterval;
+    uint32_t            fHeightOffset;    // The image height in the SOF segment.
+    uint32_t            fScanStart;       // The first byte after the SOS segment.
+    uint32_t            fScanEnd;         // The EOI marker.
+    SkTDArray<uint32_t> fMarkers;         // The RSTn markers, in order.
+};
+
+#endif
@@ -16,9 +16,11 @@
 #include "SkPngCodec.h"
 #include "SkPngPriv.h"
 #include "SkPoint3.h"
+#include "SkSemaphore.h"
 #include "SkSize.h"
 #include "SkStream.h"
 #include "SkSwizzler.h"
+#include "SkTaskGroup.h"
 #include "SkTemplates.h"
 #include "SkUtils.h"
 
@@ -438,20 +440,22 @@ void SkPngCodec::allocateStorage(const SkImageInfo& dstInfo) {
             // Intentional fall through.  A swizzler hasn't been created yet, but one will
             // be created later if we are sampling.  We'll go ahead and allocate
             // enough memory to swizzle if necessary.
-        case kSwizzleColor_XformMode: {
-            const int bitsPerPixel = this->getEncodedInfo().bitsPerPixel();
-
-            // If we have more than 8-bits (per component) of precision, we will keep that
-            // extra precision.  Otherwise, we will swizzle to RGBA_8888 before transforming.
-            const size_t bytesPerPixel = (bitsPerPixel > 32) ? bitsPerPixel / 8 : 4;
-            const size_t colorXformBytes = dstInfo.width() * bytesPerPixel;
-            fStorage.reset(colorXformBytes);
+        case kSwizzleColor_XformMode:
+            fStorage.reset(this->colorXformSrcRowBytes(dstInfo));
             fColorXformSrcRow = fStorage.get();
             break;
-        }
     }
 }
 
+size_t SkPngCodec::colorXformSrcRowBytes(const SkImageInfo& dstInfo) const {
+    const int bitsPerPixel = this->getEncodedInfo().bitsPerPixel();
+
+    // If we have more than 8-bits (per component) of precision, we will keep that
+    // extra precision.  Otherwise, we will swizzle to RGBA_8888 before transforming.
+    const size_t bytesPerPixel = (bitsPerPixel > 32) ? bitsPerPixel / 8 : 4;
+    return dstInfo.width() * bytesPerPixel;
+}
+
 static skcms_PixelFormat png_select_xform_format(const SkEncodedInfo& info) {
     // We use kRGB and kRGBA formats because color PNGs are always RGB or RGBA.
     if (16 == info.bitsPerComponent()) {
@@ -460,6 +464,8 @@ static skcms_PixelFormat png_select_xform_format(const SkEncodedInfo& info) {
         } else if (SkEncodedInfo::kRGB_Color == info.color()) {
             return skcms_PixelFormat_RGB_161616BE;
         }
+    } else if (SkEncodedInfo::kRGB_Color == info.color()) {
+        return skcms_PixelFormat_RGB_888;
     } else if (SkEncodedInfo::kGray_Color == info.color()) {
         return skcms_PixelFormat_G_8;
     }
@@ -467,7 +473,7 @@ static skcms_PixelFormat png_select_xform_format(const SkEncodedInfo& info) {
     return skcms_PixelFormat_RGBA_8888;
 }
 
-void SkPngCodec::applyXformRow(void* dst, const void* src) {
+void SkPngCodec::applyXformRow(void* dst, const void* src, void* xformSrcRow) {
     switch (fXformMode) {
         case kSwizzleOnly_XformMode:
             fSwizzler->swizzle(dst, (const uint8_t*) src);
@@ -476,8 +482,8 @@ void SkPngCodec::applyXformRow(void* dst, const void* src) {
             this->applyColorXform(dst, src, fXformWidth);
             break;
         case kSwizzleColor_XformMode:
-            fSwizzler->swizzle(fColorXformSrcRow, (const uint8_t*) src);
-            this->applyColorXform(dst, fColorXformSrcRow, fXformWidth);
+            fSwizzler->swizzle(xformSrcRow, (const uint8_t*) src);
+            this->applyColorXform(dst, xformSrcRow, fXformWidth);
             break;
     }
 }
@@ -498,6 +504,7 @@ public:
         , fRowsWrittenToOutput(0)
         , fDst(nullptr)
         , fRowBytes(0)
+        , fParallelRows(nullptr)
         , fFirstRow(0)
         , fLastRow(0)
     {}
@@ -511,9 +518,94 @@ public:
     }
 
 private:
+    // When decodeAllRows() has an executor, libpng inflates rows on the calling thread, which
+    // copies them into batches.  Each full batch is swizzled and color transformed on the
+    // executor while libpng carries on inflating.  A batch is only refilled once its task has
+    // finished with it, which bounds how far libpng can get ahead.
+    class ParallelRows {
+    public:
+        ParallelRows(SkPngNormalDecoder* codec, SkExecutor* executor, size_t dstRowBytes)
+            : fCodec(codec)
+            , fTaskGroup(*executor)
+            , fSrcRowBytes(png_get_rowbytes(codec->png_ptr(), codec->info_ptr()))
+            , fDstRowBytes(dstRowBytes)
+            , fRowsPerBatch(SkTMax(1, SkToInt(kBatchBytes / SkTMax<size_t>(fSrcRowBytes, 1))))
+            , fCurrent(0)
+            , fCount(0)
+        {
+            const size_t xformSrcRowBytes = codec->colorXformSrcRowBytes(codec->dstInfo());
+            for (RowBatch& batch : fBatches) {
+                batch.fRows.reset(fRowsPerBatch * fSrcRowBytes);
+                batch.fXformSrcRow.reset(xformSrcRowBytes);
+            }
+        }
+
+        ~ParallelRows() { this->finish(); }
+
+        void addRow(void* dst, const void* src) {
+            RowBatch* batch = &fBatches[fCurrent];
+            if (0 == fCount) {
+                batch->fFree.wait();
+                batch->fDst = dst;
+            }
+            memcpy(batch->fRows.get() + fCount * fSrcRowBytes, src, fSrcRowBytes);
+            if (++fCount == fRowsPerBatch) {
+                this->flush();
+            }
+        }
+
+        // Transforms any rows still waiting, and returns once they are all in the dst.
+        void finish() {
+            this->flush();
+            fTaskGroup.wait();
+        }
+
+    private:
+        static constexpr size_t kBatchBytes = 256 * 1024;
+        static constexpr int    kBatchCount = 8;
+
+        struct RowBatch {
+            SkAutoTMalloc<uint8_t> fRows;
+            SkAutoTMalloc<uint8_t> fXformSrcRow;
+            SkSemaphore            fFree{1};
+            void*                  fDst;
+            int                    fCount;
+        };
+
+        void flush() {
+            if (0 == fCount) {
+                return;
+            }
+            RowBatch* batch = &fBatches[fCurrent];
+            batch->fCount = fCount;
+            fTaskGroup.add([this, batch] {
+                void* dst = batch->fDst;
+                const uint8_t* src = batch->fRows.get();
+                for (int i = 0; i < batch->fCount; i++) {
+                    fCodec->applyXformRow(dst, src, batch->fXformSrcRow.get());
+                    dst = SkTAddOffset<void>(dst, fDstRowBytes);
+                    src += fSrcRowBytes;
+                }
+                batch->fFree.signal();
+            });
+            fCurrent = (fCurrent + 1) % kBatchCount;
+            fCount = 0;
+        }
+
+        SkPngNormalDecoder* fCodec;
+        SkTaskGroup         fTaskGroup;
+        const size_t        fSrcRowBytes;
+        const size_t        fDstRowBytes;
+        const int           fRowsPerBatch;
+        RowBatch            fBatches[kBatchCount];
+        int                 fCurrent;  // The batch being filled.
+        int                 fCount;    // Rows in the batch being filled.
+    };
+
     int                         fRowsWrittenToOutput;
     void*                       fDst;
     size_t                      fRowBytes;
+    ParallelRows*               fParallelRows;
 
     // Variables for partial decode
     int                         fFirstRow;  // FIXME: Move to baseclass?
@@ -536,7 +628,16 @@ private:
         fFirstRow = 0;
         fLastRow = height - 1;
 
-        const bool success = this->processData();
+        bool success;
+        if (SkExecutor* executor = this->options().fExecutor) {
+            ParallelRows parallelRows(this, executor, rowBytes);
+            fParallelRows = &parallelRows;
+            success = this->processData();
+            parallelRows.finish();
+            fParallelRows = nullptr;
+        } else {
+            success = this->processData();
+        }
         if (success && fRowsWrittenToOutput == height) {
             return kSuccess;
         }
@@ -551,7 +652,11 @@ private:
     void allRowsCallback(png_bytep row, int rowNum) {
         SkASSERT(rowNum == fRowsWrittenToOutput);
         fRowsWrittenToOutput++;
-        this->applyXformRow(fDst, row);
+        if (fParallelRows) {
+            fParallelRows->addRow(fDst, row);
+        } else {
+            this->applyXformRow(fDst, row);
+        }
         fDst = SkTAddOffset<void>(fDst, fRowBytes);
     }
 
@@ -685,10 +790,27 @@ private:
         const bool success = this->processData();
         png_bytep srcRow = fInterlaceBuffer.get();
         // FIXME: When resuming, this may rewrite rows that did not change.
-        for (int rowNum = 0; rowNum < fLinesDecoded; rowNum++) {
-            this->applyXformRow(dst, srcRow);
-            dst = SkTAddOffset<void>(dst, rowBytes);
-            srcRow = SkTAddOffset<png_byte>(srcRow, fPng_rowbytes);
+        if (SkExecutor* executor = this->options().fExecutor) {
+            // Every pass is done, so the rows can be transformed in any order.
+            constexpr int kRowsPerStripe = 64;
+            const int stripes = (fLinesDecoded + kRowsPerStripe - 1) / kRowsPerStripe;
+            const size_t xformSrcRowBytes = this->colorXformSrcRowBytes(this->dstInfo());
+            SkTaskGroup(*executor).batch(stripes, [&](int stripe) {
+                SkAutoTMalloc<uint8_t> xformSrcRow(xformSrcRowBytes);
+                const int first = stripe * kRowsPerStripe;
+                const int last = SkTMin(first + kRowsPerStripe, fLinesDecoded);
+                for (int rowNum = first; rowNum < last; rowNum++) {
+                    this->applyXformRow(SkTAddOffset<void>(dst, rowNum * rowBytes),
+                                        SkTAddOffset<png_byte>(srcRow, rowNum * fPng_rowbytes),
+                                        xformSrcRow.get());
+                }
+            });
+        } else {
+            for (int rowNum = 0; rowNum < fLinesDecoded; rowNum++) {
+                this->applyXformRow(dst, srcRow);
+                dst = SkTAddOffset<void>(dst, rowBytes);
+                srcRow = SkTAddOffset<png_byte>(srcRow, fPng_rowbytes);
+            }
         }
         if (success && fInterlacedComplete) {
             return kSuccess;
@@ -1028,15 +1150,11 @@ SkCodec::Result SkPngCodec::initializeXforms(const SkImageInfo& dstInfo, const O
     fSwizzler.reset(nullptr);
 
     // If skcms directly supports the encoded PNG format, we should skip format
-    // conversion in the swizzler (or skip swizzling altogether).
+    // conversion in the swizzler (or skip swizzling altogether), and let skcms unpack,
+    // premultiply and transform each row in a single pass.
     bool skipFormatConversion = false;
     switch (this->getEncodedInfo().color()) {
         case SkEncodedInfo::kRGB_Color:
-            if (this->getEncodedInfo().bitsPerComponent() != 16) {
-                break;
-            }
-
-            // Fall through
         case SkEncodedInfo::kRGBA_Color:
         case SkEncodedInfo::kGray_Color:
             skipFormatConversion = this->colorXform();
@@ -1101,8 +1219,7 @@ void SkPngCodec::initializeSwizzler(const SkImageInfo& dstInfo, const Options& o
         int srcBPP = 0;
         switch (this->getEncodedInfo().color()) {
             case SkEncodedInfo::kRGB_Color:
-                SkASSERT(this->getEncodedInfo().bitsPerComponent() == 16);
-                srcBPP = 6;
+                srcBPP = this->getEncodedInfo().bitsPerComponent() * 3 / 8;
                 break;
             case SkEncodedInfo::kRGBA_Color:
                 srcBPP = this->getEncodedInfo().bitsPerComponent() / 2;
@@ -53,7 +53,14 @@ protected:
     bool onRewind() override;
 
     SkSampler* getSampler(bool createIfNecessary) override;
-    void applyXformRow(void* dst, const void* src);
+    void applyXformRow(void* dst, const void* src) {
+        this->applyXformRow(dst, src, fColorXformSrcRow);
+    }
+
+    // Like applyXformRow(), but swizzles into xformSrcRow (colorXformSrcRowBytes() long) before
+    // any color xform, so that several threads can transform rows at once.
+    void applyXformRow(void* dst, const void* src, void* xformSrcRow);
+    size_t colorXformSrcRowBytes(const SkImageInfo& dstInfo) const;
 
     voidp png_ptr() { return fPng_ptr; }
     voidp info_ptr() { return fInfo_ptr; }
@@ -5,6 +5,8 @@
  * found in the LICENSE file.
  */
 
+#include "SkBitmap.h"
+#include "SkBoxScaler.h"
 #include "SkCodec.h"
 #include "SkCodecPriv.h"
 #include "SkMath.h"
@@ -74,6 +76,15 @@ SkISize SkSampledCodec::onGetSampledDimensions(int sampleSize) const {
 SkCodec::Result SkSampledCodec::onGetAndroidPixels(const SkImageInfo& info, void* pixels,
         size_t rowBytes, const AndroidOptions& options) {
     // Create an Options struct for the codec.
+    if (options.fAreaAverage) {
+        const SkISize size = options.fSubset ? options.fSubset->size()
+                                             : this->codec()->dimensions();
+        if (info.dimensions() != size) {
+            return this->areaAverageDecode(info, pixels, rowBytes, options);
+        }
+        // There is nothing to scale.
+    }
+
     SkCodec::Options codecOptions;
     codecOptions.fZeroInitialized = options.fZeroInitialized;
 
@@ -350,3 +361,153 @@ SkCodec::Result SkSampledCodec::sampledDecode(const SkImageInfo& info, void* pix
             return SkCodec::kUnimplemented;
     }
 }
+
+SkCodec::Result SkSampledCodec::areaAverageDecode(const SkImageInfo& info, void* pixels,
+        size_t rowBytes, const AndroidOptions& options) {
+    const SkIRect srcRect = options.fSubset ? *options.fSubset
+                                            : SkIRect::MakeSize(this->codec()->dimensions());
+    if (info.isEmpty() || info.width() > srcRect.width() || info.height() > srcRect.height()) {
+        return SkCodec::kInvalidScale;
+    }
+
+    // Let libjpeg do as much of the scaling as it can with its DCT, which is much cheaper
+    // than decoding every pixel and averaging them.
+    SkISize nativeSize = this->codec()->dimensions();
+    SkIRect nativeRect = srcRect;
+    if (this->codec()->getEncodedFormat() == SkEncodedImageFormat::kJPEG) {
+        for (int sampleSize : { 8, 4, 2 }) {
+            const SkISize size = this->codec()->getScaledDimensions(
+                    get_scale_from_sample_size(sampleSize));
+            const SkIRect rect = SkIRect::MakeLTRB(
+                    srcRect.fLeft / sampleSize, srcRect.fTop / sampleSize,
+                    SkTMin(size.width(), (srcRect.fRight + sampleSize - 1) / sampleSize),
+                    SkTMin(size.height(), (srcRect.fBottom + sampleSize - 1) / sampleSize));
+            if (rect.width() >= info.width() && rect.height() >= info.height() &&
+                    this->codec()->dimensionsSupported(size)) {
+                nativeSize = size;
+                nativeRect = rect;
+                break;
+            }
+        }
+    }
+
+    // Average in a color type that SkBoxScaler supports, and convert afterwards if need be.
+    SkColorType workColorType;
+    switch (info.colorType()) {
+        case kRGBA_8888_SkColorType:
+        case kBGRA_8888_SkColorType:
+        case kGray_8_SkColorType:
+        case kAlpha_8_SkColorType:
+        case kRGBA_F16_SkColorType:
+            workColorType = info.colorType();
+            break;
+        case kRGBA_F16Norm_SkColorType:
+        case kRGBA_F32_SkColorType:
+            workColorType = kRGBA_F16_SkColorType;
+            break;
+        default:
+            workColorType = kN32_SkColorType;
+            break;
+    }
+    const SkPixmap dst(info, pixels, rowBytes);
+    SkPixmap workDst = dst;
+    SkBitmap workBitmap;
+    if (workColorType != info.colorType()) {
+        if (!workBitmap.tryAllocPixels(info.makeColorType(workColorType))) {
+            return SkCodec::kInternalError;
+        }
+        workDst = workBitmap.pixmap();
+    }
+
+    std::unique_ptr<SkBoxScaler> scaler = SkBoxScaler::Make(nativeRect.width(),
+                                                            nativeRect.height(), workDst);
+    if (!scaler) {
+        return SkCodec::kInvalidScale;
+    }
+
+    const SkImageInfo nativeInfo = workDst.info().makeWH(nativeSize.width(),
+                                                         nativeSize.height());
+    SkCodec::Options codecOptions;
+    SkIRect scanlineSubset = SkIRect::MakeLTRB(nativeRect.fLeft, 0, nativeRect.fRight,
+                                               nativeSize.height());
+    if (scanlineSubset.width() != nativeSize.width()) {
+        codecOptions.fSubset = &scanlineSubset;
+    }
+
+    SkCodec::Result result = this->codec()->startScanlineDecode(nativeInfo, &codecOptions);
+    if (SkCodec::kSuccess == result) {
+        const size_t rowSize = nativeRect.width() * nativeInfo.bytesPerPixel();
+        SkAutoTMalloc<uint8_t> row(rowSize);
+        switch (this->codec()->getScanlineOrder()) {
+            case SkCodec::kTopDown_SkScanlineOrder:
+                if (!this->codec()->skipScanlines(nativeRect.fTop)) {
+                    result = SkCodec::kIncompleteInput;
+                    break;
+                }
+                for (int y = 0; y < nativeRect.height(); y++) {
+                    if (1 != this->codec()->getScanlines(row.get(), 1, rowSize)) {
+                        result = SkCodec::kIncompleteInput;
+                        break;
+                    }
+                    scaler->addRow(y, row.get());
+                }
+                break;
+            case SkCodec::kBottomUp_SkScanlineOrder:
+                for (int y = 0; y < nativeSize.height(); y++) {
+                    const int srcY = this->codec()->nextScanline();
+                    if (srcY < nativeRect.fTop || srcY >= nativeRect.fBottom) {
+                        if (!this->codec()->skipScanlines(1)) {
+                            result = SkCodec::kIncompleteInput;
+                            break;
+                        }
+                        continue;
+                    }
+                    if (1 != this->codec()->getScanlines(row.get(), 1, rowSize)) {
+                        result = SkCodec::kIncompleteInput;
+                        break;
+                    }
+                    scaler->addRow(srcY - nativeRect.fTop, row.get());
+                }
+                break;
+            default:
+                SkASSERT(false);
+                return SkCodec::kUnimplemented;
+        }
+    } else if (SkCodec::kUnimplemented == result) {
+        // This codec can't decode a row at a time, so decode all of it, and average that.
+        SkBitmap nativeBitmap;
+        if (!nativeBitmap.tryAllocPixels(nativeInfo)) {
+            return SkCodec::kInternalError;
+        }
+        result = this->codec()->getPixels(nativeInfo, nativeBitmap.getPixels(),
+                                          nativeBitmap.rowBytes());
+        if (SkCodec::kSuccess != result && SkCodec::kIncompleteInput != result &&
+                SkCodec::kErrorInInput != result) {
+            return result;
+        }
+        // The codec filled in any rows it couldn't decode.
+        for (int y = 0; y < nativeRect.height(); y++) {
+            scaler->addRow(y, nativeBitmap.getAddr(nativeRect.fLeft, nativeRect.fTop + y));
+        }
+    } else if (SkCodec::kIncompleteInput == result || SkCodec::kErrorInInput == result) {
+        return SkCodec::kInvalidInput;
+    } else {
+        return result;
+    }
+
+    if (workDst.addr() != dst.addr()) {
+        SkAssertResult(workBitmap.readPixels(dst));
+    }
+
+    if (SkCodec::kSuccess != result) {
+        // Fill in the rows that were never finished.
+        const SkImageInfo fillInfo = info.makeWH(info.width(), 1);
+        for (int y = 0; y < info.height(); y++) {
+            if (!scaler->isRowWritten(y)) {
+                SkSampler::Fill(fillInfo, dst.writable_addr(0, y), rowBytes,
+                                options.fZeroInitialized);
+            }
+        }
+    }
+    return result;
+}
@@ -54,6 +54,17 @@ private:
     SkCodec::Result sampledDecode(const SkImageInfo& info, void* pixels, size_t rowBytes,
             const AndroidOptions& options);
 
+    /**
+     *  This fulfills the same contract as onGetAndroidPixels(), for
+     *  options.fAreaAverage.
+     *
+     *  Lets fCodec scale a jpeg by the largest factor that leaves it at least
+     *  as large as info, and then averages the decoded rows down to info's
+     *  size as they are decoded.
+     */
+    SkCodec::Result areaAverageDecode(const SkImageInfo& info, void* pixels, size_t rowBytes,
+            const AndroidOptions& options);
+
     typedef SkAndroidCodec INHERITED;
 };
 #endif // SkSampledCodec_DEFINED
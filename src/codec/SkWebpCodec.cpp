@@ -16,6 +16,7 @@
 #include "SkRasterPipeline.h"
 #include "SkSampler.h"
 #include "SkStreamPriv.h"
+#include "SkTaskGroup.h"
 #include "SkTemplates.h"
 #include "SkTo.h"
 
@@ -501,6 +502,12 @@ SkCodec::Result SkWebpCodec::onGetPixels(const SkImageInfo& dstInfo, void* dst,
     config.output.u.RGBA.stride = static_cast<int>(webpDst.rowBytes());
     config.output.u.RGBA.size = webpDst.computeByteSize();
 
+    if (options.fExecutor) {
+        // libwebp can't use our executor, but it can run lossy filtering on its own worker
+        // thread, one macroblock row behind the decode.
+        config.options.use_threads = 1;
+    }
+
     SkAutoTCallVProc<WebPIDecoder, WebPIDelete> idec(WebPIDecode(nullptr, 0, &config));
     if (!idec) {
         return kInvalidInput;
@@ -530,7 +537,19 @@ SkCodec::Result SkWebpCodec::onGetPixels(const SkImageInfo& dstInfo, void* dst,
     const size_t srcRowBytes = config.output.u.RGBA.stride;
 
     const auto dstCT = dstInfo.colorType();
-    if (this->colorXform()) {
+    if (this->colorXform() && !blendWithPrevFrame && options.fExecutor) {
+        // Every row is decoded, so they can be transformed in any order.
+        constexpr int kRowsPerStripe = 64;
+        const uint8_t* xformSrc = config.output.u.RGBA.rgba;
+        const int stripes = (rowsDecoded + kRowsPerStripe - 1) / kRowsPerStripe;
+        SkTaskGroup(*options.fExecutor).batch(stripes, [&](int stripe) {
+            const int last = SkTMin((stripe + 1) * kRowsPerStripe, rowsDecoded);
+            for (int y = stripe * kRowsPerStripe; y < last; y++) {
+                this->applyColorXform(SkTAddOffset<void>(dst, y * rowBytes),
+                                      xformSrc + y * srcRowBytes, scaledWidth);
+            }
+        });
+    } else if (this->colorXform()) {
         uint32_t* xformSrc = (uint32_t*) config.output.u.RGBA.rgba;
         SkBitmap tmp;
         void* xformDst;
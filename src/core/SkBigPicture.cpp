@@ -10,6 +10,7 @@
 #include "SkPictureCommon.h"
 #include "SkRecord.h"
 #include "SkRecordDraw.h"
+#include "SkRTree.h"
 #include "SkTraceEvent.h"
 
 SkBigPicture::SkBigPicture(const SkRect& cull,
@@ -39,6 +40,36 @@ void SkBigPicture::playback(SkCanvas* canvas, AbortCallback* callback) const {
                  callback);
 }
 
+const SkBBoxHierarchy* SkBigPicture::tileBBH() const {
+    if (fBBH) {
+        return fBBH.get();
+    }
+    fTileBBHOnce([this] {
+        SkScalar aspectRatio = fCullRect.height() > 0 ? fCullRect.width() / fCullRect.height()
+                                                      : SK_Scalar1;
+        sk_sp<SkRTree> rtree = sk_make_sp<SkRTree>(aspectRatio);
+        SkAutoTMalloc<SkRect> bounds(fRecord->count());
+        SkRecordFillBounds(fCullRect, *fRecord, bounds);
+        rtree->insert(bounds, fRecord->count());
+        fTileBBH = std::move(rtree);
+    });
+    return fTileBBH.get();
+}
+
+void SkBigPicture::tilePlayback(SkCanvas* canvas) const {
+    SkASSERT(canvas);
+
+    const bool useBBH = !canvas->getLocalClipBounds().contains(this->cullRect());
+
+    SkRecordDraw(*fRecord,
+                 canvas,
+                 this->drawablePicts(),
+                 nullptr,
+                 this->drawableCount(),
+                 useBBH ? this->tileBBH() : nullptr,
+                 nullptr);
+}
+
 void SkBigPicture::partialPlayback(SkCanvas* canvas,
                                    int start,
                                    int stop,
@@ -53,6 +53,9 @@ public:
                          int start,
                          int stop,
                          const SkMatrix& initialCTM) const;
+// Used by SkPicture::playbackParallel.  Like playback(), but always culls with a BBH, building
+// an SkRTree the first time if the picture was recorded without one.
+    void tilePlayback(SkCanvas*) const;
 // Used by GrRecordReplaceDraw
     const SkBBoxHierarchy* bbh() const { return fBBH.get(); }
     const SkRecord*     record() const { return fRecord.get(); }
@@ -60,12 +63,16 @@ public:
 private:
     int drawableCount() const;
     SkPicture const* const* drawablePicts() const;
+    const SkBBoxHierarchy* tileBBH() const;
 
     const SkRect                         fCullRect;
     const size_t                         fApproxBytesUsedBySubPictures;
     sk_sp<const SkRecord>                fRecord;
     std::unique_ptr<const SnapshotArray> fDrawablePicts;
     sk_sp<const SkBBoxHierarchy>         fBBH;
+
+    mutable SkOnce                       fTileBBHOnce;
+    mutable sk_sp<const SkBBoxHierarchy> fTileBBH;  // Only built if fBBH is null.
 };
 
 #endif//SkBigPicture_DEFINED
@@ -143,6 +143,7 @@ private:
     friend class SkDrawIter;
     friend class SkDrawTiler;
     friend class SkSurface_Raster;
+    friend class SkThreadedBitmapDevice;
 
     class BDDraw;
 
@@ -334,6 +334,7 @@ private:
     friend class SkDraw;
     friend class SkDrawIter;
     friend class SkSurface_Raster;
+    friend class SkThreadedBitmapDevice;
     friend class DeviceTestingAccess;
 
     // Temporarily friend the SkGlyphRunBuilder until drawPosText is gone.
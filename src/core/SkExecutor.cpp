@@ -11,6 +11,7 @@
 #include "SkSemaphore.h"
 #include "SkSpinlock.h"
 #include "SkTArray.h"
+#include <atomic>
 #include <deque>
 #include <thread>
 
@@ -30,6 +31,12 @@
 
 SkExecutor::~SkExecutor() {}
 
+void SkExecutor::batch(int N, std::function<void(int)> fn) {
+    for (int i = 0; i < N; i++) {
+        this->add([=] { fn(i); });
+    }
+}
+
 // The default default SkExecutor is an SkTrivialExecutor, which just runs the work right away.
 class SkTrivialExecutor final : public SkExecutor {
     void add(std::function<void(void)> work) override {
@@ -131,6 +138,248 @@ private:
     SkSemaphore           fWorkAvailable;
 };
 
+// SkWorkStealingDeque is a Chase-Lev work-stealing deque of Work pointers.
+// Only its owner thread may push() and pop(), which work on the bottom of the deque.
+// Any thread may steal(), which takes from the top.  See "Correct and Efficient Work-Stealing
+// for Weak Memory Models" (Le, Pop, Cohen, Zappa Nardelli, 2013) for the memory orders used here.
+template <typename Work>
+class SkWorkStealingDeque {
+public:
+    SkWorkStealingDeque() : fTop(0), fBottom(0) {
+        fRetired.push_back(std::unique_ptr<Ring>(new Ring(kInitialCapacity)));
+        fRing.store(fRetired.back().get(), std::memory_order_relaxed);
+    }
+
+    void push(Work* work) {
+        int64_t b = fBottom.load(std::memory_order_relaxed),
+                t = fTop   .load(std::memory_order_acquire);
+        Ring* ring = fRing.load(std::memory_order_relaxed);
+        if (b - t > ring->fMask) {
+            ring = this->grow(ring, t, b);
+        }
+        ring->slot(b).store(work, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        fBottom.store(b+1, std::memory_order_relaxed);
+    }
+
+    // Returns nullptr if the deque is empty.
+    Work* pop() {
+        int64_t b = fBottom.load(std::memory_order_relaxed) - 1;
+        Ring* ring = fRing.load(std::memory_order_relaxed);
+        fBottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = fTop.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            // Empty.
+            fBottom.store(b+1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        Work* work = ring->slot(b).load(std::memory_order_relaxed);
+        if (t == b) {
+            // This is the last item, so we race any thieves for it.
+            if (!fTop.compare_exchange_strong(t, t+1, std::memory_order_seq_cst,
+                                                      std::memory_order_relaxed)) {
+                work = nullptr;
+            }
+            fBottom.store(b+1, std::memory_order_relaxed);
+        }
+        return work;
+    }
+
+    // Returns nullptr if the deque is empty or we lost a race with another thread.
+    Work* steal() {
+        int64_t t = fTop.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = fBottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return nullptr;
+        }
+        Ring* ring = fRing.load(std::memory_order_acquire);
+        Work* work = ring->slot(t).load(std::memory_order_relaxed);
+        if (!fTop.compare_exchange_strong(t, t+1, std::memory_order_seq_cst,
+                                                  std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return work;
+    }
+
+private:
+    enum { kInitialCapacity = 64 };  // Must be a power of 2.
+
+    struct Ring {
+        explicit Ring(int capacity)
+            : fMask(capacity - 1)
+            , fSlots(new std::atomic<Work*>[capacity]) {}
+
+        std::atomic<Work*>& slot(int64_t i) { return fSlots[i & fMask]; }
+
+        const int64_t                          fMask;
+        std::unique_ptr<std::atomic<Work*>[]>  fSlots;
+    };
+
+    Ring* grow(Ring* ring, int64_t t, int64_t b) {
+        // Thieves may still be reading from the old ring, so we keep it alive until we're gone.
+        fRetired.push_back(skstd::make_unique<Ring>(2 * (ring->fMask + 1)));
+        Ring* bigger = fRetired.back().get();
+        for (int64_t i = t; i < b; i++) {
+            bigger->slot(i).store(ring->slot(i).load(std::memory_order_relaxed),
+                                  std::memory_order_relaxed);
+        }
+        fRing.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+    std::atomic<int64_t>          fTop,
+                                  fBottom;
+    std::atomic<Ring*>            fRing;
+    SkTArray<std::unique_ptr<Ring>> fRetired;  // Includes the current ring.
+};
+
+// An SkWorkStealingPool runs work on a fixed pool of OS threads, each with its own deque.
+// Like SkThreadPool, fWorkAvailable counts pending work, so a thread that has successfully
+// waited on it knows that some work exists somewhere; it just has to go find it.
+class SkWorkStealingPool final : public SkExecutor {
+public:
+    explicit SkWorkStealingPool(int threads)
+        : fDeques(new SkWorkStealingDeque<Work>[threads])
+        , fDequeCount(threads) {
+        for (int i = 0; i < threads; i++) {
+            fThreads.emplace_back(&Loop, this, i);
+        }
+        for (int i = 0; i < threads; i++) {
+            fThreadIDs.push_back(fThreads[i].get_id());
+        }
+    }
+
+    ~SkWorkStealingPool() override {
+        // Signal each thread that it's time to shut down.
+        for (int i = 0; i < fThreads.count(); i++) {
+            this->add(nullptr);
+        }
+        // Wait for each thread to shut down.
+        for (int i = 0; i < fThreads.count(); i++) {
+            fThreads[i].join();
+        }
+        // Clean up any work that was never run.
+        while (Work* work = this->find_work(-1)) {
+            delete work;
+        }
+    }
+
+    void add(std::function<void(void)> work) override {
+        // Null work is Loop()'s signal to shut down, and never goes onto a deque.
+        int me = work ? this->current_thread_index() : -1;
+        if (me >= 0) {
+            fDeques[me].push(new Work(std::move(work)));
+        } else {
+            SkAutoExclusive lock(fSharedLock);
+            fShared.emplace_back(new Work(std::move(work)));
+        }
+        fWorkAvailable.signal(1);
+    }
+
+    void batch(int N, std::function<void(int)> fn) override {
+        if (N <= 0) {
+            return;
+        }
+        int me = this->current_thread_index();
+        if (me >= 0) {
+            // Push in reverse so that our own LIFO pop()s run fn(0) first,
+            // while thieves steal from the far end.
+            for (int i = N; i --> 0; ) {
+                fDeques[me].push(new Work([=] { fn(i); }));
+            }
+        } else {
+            SkAutoExclusive lock(fSharedLock);
+            for (int i = 0; i < N; i++) {
+                fShared.emplace_back(new Work([=] { fn(i); }));
+            }
+        }
+        fWorkAvailable.signal(N);
+    }
+
+    void borrow() override {
+        // If there is work waiting, do it.
+        if (fWorkAvailable.try_wait()) {
+            SkAssertResult(this->do_work(this->current_thread_index()));
+        }
+    }
+
+private:
+    using Work = std::function<void(void)>;
+
+    // Returns our index into fDeques if called from one of our threads, otherwise -1.
+    int current_thread_index() const {
+        std::thread::id id = std::this_thread::get_id();
+        for (int i = 0; i < fThreadIDs.count(); i++) {
+            if (fThreadIDs[i] == id) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    // Look for work in our own deque, then the shared queue, then try to steal from others.
+    // Returns nullptr if no work was found this time around.
+    Work* find_work(int me) {
+        if (me >= 0) {
+            if (Work* work = fDeques[me].pop()) {
+                return work;
+            }
+        }
+        {
+            SkAutoExclusive lock(fSharedLock);
+            if (!fShared.empty()) {
+                Work* work = fShared.front();
+                fShared.pop_front();
+                return work;
+            }
+        }
+        const int N = fDequeCount;
+        for (int i = 1; i <= N; i++) {
+            int victim = (me + i) % N;
+            if (victim != me) {
+                if (Work* work = fDeques[victim].steal()) {
+                    return work;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    // This method should be called only when fWorkAvailable indicates there's work to do.
+    bool do_work(int me) {
+        Work* work = nullptr;
+        while (!(work = this->find_work(me))) {
+            // Someone has pushed work we've not yet seen, or we lost a race to steal it.
+            std::this_thread::yield();
+        }
+
+        std::unique_ptr<Work> owned(work);
+        if (!*owned) {
+            return false;  // This is Loop()'s signal to shut down.
+        }
+
+        (*owned)();
+        return true;
+    }
+
+    static void Loop(SkWorkStealingPool* pool, int me) {
+        do {
+            pool->fWorkAvailable.wait();
+        } while (pool->do_work(me));
+    }
+
+    SkTArray<std::thread>                          fThreads;
+    SkTArray<std::thread::id>                      fThreadIDs;
+    std::unique_ptr<SkWorkStealingDeque<Work>[]>   fDeques;
+    const int                                      fDequeCount;
+    std::deque<Work*>                              fShared;
+    SkSpinlock                                     fSharedLock;
+    SkSemaphore                                    fWorkAvailable;
+};
+
 std::unique_ptr<SkExecutor> SkExecutor::MakeFIFOThreadPool(int threads) {
     using WorkList = std::deque<std::function<void(void)>>;
     return skstd::make_unique<SkThreadPool<WorkList>>(threads > 0 ? threads : num_cores());
@@ -139,3 +388,6 @@ std::unique_ptr<SkExecutor> SkExecutor::MakeLIFOThreadPool(int threads) {
     using WorkList = SkTArray<std::function<void(void)>>;
     return skstd::make_unique<SkThreadPool<WorkList>>(threads > 0 ? threads : num_cores());
 }
+std::unique_ptr<SkExecutor> SkExecutor::MakeWorkStealingPool(int threads) {
+    return skstd::make_unique<SkWorkStealingPool>(threads > 0 ? threads : num_cores());
+}
@@ -0,0 +1,415 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkGlyphDiskCache.h"
+
+#include "SkFontDescriptor.h"
+#include "SkGlyphSerialization.h"
+#include "SkOSPath.h"
+#include "SkOpts.h"
+#include "SkPath.h"
+#include "SkScalerContext.h"
+#include "SkStream.h"
+#include "SkTime.h"
+#include "SkTypeface.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+constexpr uint32_t kMagic   = SkSetFourByteTag('s', 'k', 'g', 'c');
+constexpr uint32_t kVersion = 2;
+
+// How much of the start of a font's data goes into its hash.
+constexpr size_t kFontHeadLength = 4096;
+
+// Records start on this alignment, so everything inside them is aligned the same way whether
+// it's read in place or copied into another file.
+constexpr size_t kRecordAlignment = 8;
+
+enum PathState : uint8_t {
+    kUnknownPath,  // The path was never asked for.
+    kNoPath,
+    kHasPath,
+};
+
+struct Header {
+    uint32_t      fMagic;
+    uint32_t      fVersion;
+    uint64_t      fFontHash;
+    uint64_t      fEngineID;  // SkScalerContext::getEngineID() of the scaler that made the glyphs.
+    SkFontMetrics fFontMetrics;
+    uint32_t      fGlyphCount;
+};
+
+bool valid_mask_format(uint8_t format) {
+    return format < SkMask::kCountMaskFormats;
+}
+
+// Reads the record's glyph, checking that it's the one we expect and that its metrics are sane.
+bool read_record_glyph(Deserializer* record, SkPackedGlyphID packedID,
+                       SkTLazy<SkGlyph>* glyph) {
+    return readGlyph(*glyph, record) &&
+           (*glyph)->getPackedID() == packedID &&
+           valid_mask_format((*glyph)->fMaskFormat);
+}
+
+}  // namespace
+
+SkGlyphDiskCache::SkGlyphDiskCache(const char directory[]) : fDirectory{directory} {}
+
+bool SkGlyphDiskCache::fontHash(const SkTypeface& typeface, uint64_t* hash) {
+    {
+        SkAutoMutexAcquire lock(fMutex);
+        if (uint64_t* found = fFontHashes.find(typeface.uniqueID())) {
+            *hash = *found;
+            return true;
+        }
+    }
+
+    std::unique_ptr<SkFontData> fontData = typeface.makeFontData();
+    if (fontData == nullptr || !fontData->hasStream()) {
+        return false;
+    }
+
+    // Hashing whole fonts would make every cold start pay for reading them.  Instead hash the
+    // length and the start of the data: an sfnt's table directory lists a checksum for every
+    // table, so it changes whenever any of the font does.
+    SkStreamAsset* stream = fontData->getStream();
+    size_t length = stream->getLength();
+    size_t headLength = std::min(length, kFontHeadLength);
+    const void* head = stream->getMemoryBase();
+    char buffer[kFontHeadLength];
+    if (head == nullptr) {
+        if (!stream->rewind() || stream->read(buffer, headLength) != headLength) {
+            return false;
+        }
+        head = buffer;
+    }
+
+    // The collection index and variation axes pick out a face within the data.
+    uint32_t seed = SkOpts::hash(fontData->getAxis(),
+                                 fontData->getAxisCount() * sizeof(SkFixed),
+                                 fontData->getIndex());
+    seed = SkOpts::hash(&length, sizeof(length), seed);
+    uint64_t fontHash = (uint64_t)SkOpts::hash(head, headLength, seed) << 32 |
+                                  SkOpts::hash(head, headLength, ~seed);
+
+    SkAutoMutexAcquire lock(fMutex);
+    fFontHashes.set(typeface.uniqueID(), fontHash);
+    *hash = fontHash;
+    return true;
+}
+
+std::unique_ptr<SkGlyphDiskCache::StrikeFile> SkGlyphDiskCache::openStrike(
+        const SkDescriptor& desc, const SkScalerContext& scaler) {
+    uint64_t engineID = scaler.getEngineID();
+    if (engineID == 0) {
+        return nullptr;
+    }
+
+    uint32_t recLength;
+    const void* recPtr = desc.findEntry(kRec_SkDescriptorTag, &recLength);
+    if (recPtr == nullptr || recLength != sizeof(SkScalerContextRec)) {
+        return nullptr;
+    }
+
+    uint64_t fontHash;
+    if (!this->fontHash(*scaler.getTypeface(), &fontHash)) {
+        return nullptr;
+    }
+
+    // Font IDs are only unique within a process, so the key leaves it out; the font hash in the
+    // file name identifies the font instead.
+    SkAutoDescriptor key{desc};
+    SkScalerContextRec rec;
+    memcpy(&rec, recPtr, sizeof(rec));
+    rec.fFontID = 0;
+    memcpy(const_cast<void*>(key.getDesc()->findEntry(kRec_SkDescriptorTag, &recLength)),
+           &rec, sizeof(rec));
+    key.getDesc()->computeChecksum();
+
+    SkString name = SkStringPrintf("%016llx_%08x.glyphs", (unsigned long long)fontHash,
+                                   key.getDesc()->getChecksum());
+    std::unique_ptr<StrikeFile> file{new StrikeFile{
+            SkOSPath::Join(fDirectory.c_str(), name.c_str()), *key.getDesc(), fontHash,
+            engineID}};
+    file->load();
+    return file;
+}
+
+SkGlyphDiskCache::StrikeFile::StrikeFile(SkString path, const SkDescriptor& key, uint64_t fontHash,
+                                         uint64_t engineID)
+        : fPath{std::move(path)}
+        , fKey{key}
+        , fFontHash{fontHash}
+        , fEngineID{engineID} {}
+
+void SkGlyphDiskCache::StrikeFile::load() {
+    sk_sp<SkData> data = SkData::MakeFromFileName(fPath.c_str());
+    if (data == nullptr) {
+        return;
+    }
+
+    Deserializer deserializer(static_cast<const volatile char*>(data->data()), data->size());
+    Header header;
+    if (!deserializer.read<Header>(&header) ||
+        header.fMagic != kMagic || header.fVersion != kVersion ||
+        header.fFontHash != fFontHash || header.fEngineID != fEngineID) {
+        return;
+    }
+
+    // The file name only holds the key's checksum, so make sure it's really our strike.
+    const SkDescriptor& key = *fKey.getDesc();
+    uint32_t keyLength;
+    if (!deserializer.read<uint32_t>(&keyLength) || keyLength != key.getLength()) {
+        return;
+    }
+    auto* keyBytes = deserializer.read(keyLength, alignof(SkDescriptor));
+    if (keyBytes == nullptr || memcmp(const_cast<const void*>(keyBytes), &key, keyLength) != 0) {
+        return;
+    }
+
+    if (header.fGlyphCount > data->size() / sizeof(IndexEntry)) {
+        return;
+    }
+    auto* index = deserializer.read(header.fGlyphCount * sizeof(IndexEntry), alignof(IndexEntry));
+    if (index == nullptr) {
+        return;
+    }
+
+    fIndex.push_back_n(header.fGlyphCount);
+    memcpy(fIndex.begin(), const_cast<const void*>(index),
+           header.fGlyphCount * sizeof(IndexEntry));
+    fFontMetrics = header.fFontMetrics;
+    fHasFontMetrics = true;
+    fData = std::move(data);
+}
+
+const volatile char* SkGlyphDiskCache::StrikeFile::findRecord(uint32_t packedID,
+                                                              size_t* size) const {
+    auto entry = std::lower_bound(fIndex.begin(), fIndex.end(), packedID,
+                                  [](const IndexEntry& e, uint32_t id) {
+                                      return e.fPackedID < id;
+                                  });
+    if (entry == fIndex.end() || entry->fPackedID != packedID) {
+        return nullptr;
+    }
+    if (entry->fOffset % kRecordAlignment != 0 ||
+        entry->fOffset > fData->size() || entry->fSize > fData->size() - entry->fOffset) {
+        return nullptr;
+    }
+    *size = entry->fSize;
+    return static_cast<const volatile char*>(fData->data()) + entry->fOffset;
+}
+
+bool SkGlyphDiskCache::StrikeFile::findMetrics(SkGlyph* glyph) const {
+    size_t size;
+    const volatile char* memory = this->findRecord(glyph->getPackedID().value(), &size);
+    if (memory == nullptr) {
+        return false;
+    }
+
+    Deserializer record(memory, size);
+    SkTLazy<SkGlyph> stored;
+    if (!read_record_glyph(&record, glyph->getPackedID(), &stored)) {
+        return false;
+    }
+    glyph->fAdvanceX   = stored->fAdvanceX;
+    glyph->fAdvanceY   = stored->fAdvanceY;
+    glyph->fWidth      = stored->fWidth;
+    glyph->fHeight     = stored->fHeight;
+    glyph->fTop        = stored->fTop;
+    glyph->fLeft       = stored->fLeft;
+    glyph->fForceBW    = stored->fForceBW;
+    glyph->fMaskFormat = stored->fMaskFormat;
+    return true;
+}
+
+const volatile void* SkGlyphDiskCache::StrikeFile::findImage(const SkGlyph& glyph,
+                                                             size_t* size) const {
+    size_t recordSize;
+    const volatile char* memory = this->findRecord(glyph.getPackedID().value(), &recordSize);
+    if (memory == nullptr) {
+        return nullptr;
+    }
+
+    Deserializer record(memory, recordSize);
+    SkTLazy<SkGlyph> stored;
+    uint32_t imageSize;
+    if (!read_record_glyph(&record, glyph.getPackedID(), &stored) ||
+        !record.read<uint32_t>(&imageSize) ||
+        imageSize == 0 || imageSize != glyph.computeImageSize()) {
+        return nullptr;
+    }
+    *size = imageSize;
+    return record.read(imageSize, stored->formatAlignment());
+}
+
+bool SkGlyphDiskCache::StrikeFile::findPath(SkPackedGlyphID packedID,
+                                            SkPath* path, bool* hasPath) const {
+    size_t recordSize;
+    const volatile char* memory = this->findRecord(packedID.value(), &recordSize);
+    if (memory == nullptr) {
+        return false;
+    }
+
+    Deserializer record(memory, recordSize);
+    SkTLazy<SkGlyph> stored;
+    uint32_t imageSize;
+    uint8_t pathState;
+    if (!read_record_glyph(&record, packedID, &stored) ||
+        !record.read<uint32_t>(&imageSize) ||
+        (imageSize > 0 && !record.read(imageSize, stored->formatAlignment())) ||
+        !record.read<uint8_t>(&pathState)) {
+        return false;
+    }
+
+    switch (pathState) {
+        case kNoPath:
+            *hasPath = false;
+            return true;
+        case kHasPath: {
+            uint64_t pathSize;
+            if (!record.read<uint64_t>(&pathSize)) {
+                return false;
+            }
+            auto* pathData = record.read(pathSize, kPathAlignment);
+            if (pathData == nullptr ||
+                path->readFromMemory(const_cast<const void*>(pathData), pathSize) == 0) {
+                return false;
+            }
+            path->updateBoundsCache();
+            *hasPath = true;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+bool SkGlyphDiskCache::StrikeFile::save(const SkFontMetrics& fontMetrics,
+                                        const SkTArray<const SkGlyph*>& glyphs) const {
+    // Keep every glyph already in the file that the strike doesn't have.
+    struct Record {
+        uint32_t       fPackedID;
+        const SkGlyph* fGlyph;  // If null, copy the record from the file as is.
+    };
+    SkTArray<Record> records;
+    SkTHashSet<uint32_t> saving;
+    for (const SkGlyph* glyph : glyphs) {
+        SkASSERT(glyph->isFullMetrics());
+        records.push_back({glyph->getPackedID().value(), glyph});
+        saving.add(glyph->getPackedID().value());
+    }
+    for (const IndexEntry& entry : fIndex) {
+        if (!saving.contains(entry.fPackedID)) {
+            records.push_back({entry.fPackedID, nullptr});
+        }
+    }
+    std::sort(records.begin(), records.end(), [](const Record& a, const Record& b) {
+        return a.fPackedID < b.fPackedID;
+    });
+
+    std::vector<uint8_t> buffer;
+    Serializer serializer(&buffer);
+    // The header is written as raw bytes, so zero its padding rather than leak whatever was there.
+    Header header;
+    sk_bzero(&header, sizeof(header));
+    header.fMagic       = kMagic;
+    header.fVersion     = kVersion;
+    header.fFontHash    = fFontHash;
+    header.fEngineID    = fEngineID;
+    header.fFontMetrics = fontMetrics;
+    header.fGlyphCount  = records.count();
+    memcpy(serializer.allocate(sizeof(header), alignof(Header)), &header, sizeof(header));
+    serializer.writeDescriptor(*fKey.getDesc());
+    serializer.allocate(records.count() * sizeof(IndexEntry), alignof(IndexEntry));
+    size_t indexOffset = buffer.size() - records.count() * sizeof(IndexEntry);
+
+    int written = 0;
+    for (const Record& r : records) {
+        size_t start = pad(buffer.size(), kRecordAlignment);
+        serializer.allocate(0, kRecordAlignment);
+
+        if (r.fGlyph == nullptr) {
+            size_t size;
+            const volatile char* memory = this->findRecord(r.fPackedID, &size);
+            if (memory == nullptr) {
+                continue;
+            }
+            memcpy(serializer.allocate(size, 1), const_cast<const char*>(memory), size);
+        } else {
+            const SkGlyph& glyph = *r.fGlyph;
+            writeGlyph(&glyph, &serializer);
+
+            // Fill in anything the strike didn't make this time from the old record.
+            size_t imageSize = glyph.computeImageSize();
+            const volatile void* image = glyph.fImage;
+            if (image == nullptr && fData != nullptr) {
+                image = this->findImage(glyph, &imageSize);
+            }
+            if (image != nullptr && imageSize > 0) {
+                serializer.write<uint32_t>(imageSize);
+                memcpy(serializer.allocate(imageSize, glyph.formatAlignment()),
+                       const_cast<const void*>(image), imageSize);
+            } else {
+                serializer.write<uint32_t>(0u);
+            }
+
+            SkPath storedPath;
+            const SkPath* path = glyph.path();
+            bool knowPath = glyph.fPathData != nullptr;
+            if (!knowPath && fData != nullptr) {
+                bool hasPath;
+                knowPath = this->findPath(glyph.getPackedID(), &storedPath, &hasPath);
+                path = hasPath ? &storedPath : nullptr;
+            }
+            if (!knowPath) {
+                serializer.write<uint8_t>(kUnknownPath);
+            } else if (path == nullptr) {
+                serializer.write<uint8_t>(kNoPath);
+            } else {
+                serializer.write<uint8_t>(kHasPath);
+                size_t pathSize = path->writeToMemory(nullptr);
+                serializer.write<uint64_t>(pathSize);
+                path->writeToMemory(serializer.allocate(pathSize, kPathAlignment));
+            }
+        }
+
+        IndexEntry entry{r.fPackedID, (uint32_t)start, (uint32_t)(buffer.size() - start)};
+        memcpy(&buffer[indexOffset + written++ * sizeof(IndexEntry)], &entry, sizeof(entry));
+    }
+    if (written != records.count()) {
+        // We dropped a damaged record; shrink the index to match.
+        header.fGlyphCount = written;
+        memcpy(buffer.data(), &header, sizeof(header));
+    }
+
+    // Write a temporary file and rename it over the old one, so readers in other processes
+    // only ever map a complete file.
+    SkString temp = SkStringPrintf("%s.%llx.tmp", fPath.c_str(),
+                                   (unsigned long long)SkTime::GetNSecs() ^
+                                   (unsigned long long)(uintptr_t)this);
+    {
+        SkFILEWStream out(temp.c_str());
+        if (!out.isValid() || !out.write(buffer.data(), buffer.size())) {
+            std::remove(temp.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temp.c_str(), fPath.c_str()) != 0) {
+        // Some platforms won't rename over an existing file.
+        std::remove(fPath.c_str());
+        if (std::rename(temp.c_str(), fPath.c_str()) != 0) {
+            std::remove(temp.c_str());
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkGlyphDiskCache_DEFINED
+#define SkGlyphDiskCache_DEFINED
+
+#include "SkData.h"
+#include "SkDescriptor.h"
+#include "SkFontMetrics.h"
+#include "SkFontTypes.h"
+#include "SkGlyph.h"
+#include "SkMutex.h"
+#include "SkRefCnt.h"
+#include "SkString.h"
+#include "SkTArray.h"
+#include "SkTHash.h"
+
+#include <memory>
+
+class SkPath;
+class SkScalerContext;
+class SkTypeface;
+
+/**
+ * SkGlyphDiskCache keeps the glyph metrics, images and paths made by scaler contexts in a
+ * directory, so a later process can read them instead of asking the font host again.
+ *
+ * Each strike has its own file, named for a hash of the font's data and the checksum of the
+ * strike's descriptor with the process-specific font ID removed.  Only the font's length and the
+ * start of its data (for sfnt fonts, the table directory with its checksums) are hashed, so a
+ * cold start doesn't read whole fonts.  Changing the font file changes its hash, so stale files
+ * are simply never opened again.  Files are memory mapped and read lazily, one glyph at a time,
+ * and are rewritten whole (to a temporary file that is then renamed) when a strike has made
+ * glyphs that the file didn't have.
+ *
+ * Files are only trusted as far as their header: a file with the wrong magic, version, font
+ * hash, engine ID (see SkScalerContext::getEngineID()) or descriptor is ignored, and any glyph
+ * record that doesn't parse is treated as missing.
+ */
+class SkGlyphDiskCache : public SkRefCnt {
+public:
+    explicit SkGlyphDiskCache(const char directory[]);
+
+    const SkString& directory() const { return fDirectory; }
+
+    /** The glyphs stored for one strike. */
+    class StrikeFile {
+    public:
+        const SkFontMetrics* fontMetrics() const {
+            return fHasFontMetrics ? &fFontMetrics : nullptr;
+        }
+
+        int glyphCount() const { return fIndex.count(); }
+
+        /** If the file has the glyph, fills in all of its metrics and returns true. */
+        bool findMetrics(SkGlyph*) const;
+
+        /** Returns the glyph's image, or null if the file doesn't have one of the right size. */
+        const volatile void* findImage(const SkGlyph&, size_t* size) const;
+
+        /**
+         *  Returns true if the file knows whether the glyph has a path.  If so, sets hasPath, and
+         *  if that's true, sets path.
+         */
+        bool findPath(SkPackedGlyphID, SkPath* path, bool* hasPath) const;
+
+        /**
+         *  Rewrites the file with the given glyphs, which must all have full metrics, merged with
+         *  the glyphs already in the file.  Returns false if the file couldn't be written.
+         */
+        bool save(const SkFontMetrics&, const SkTArray<const SkGlyph*>& glyphs) const;
+
+    private:
+        struct IndexEntry {
+            uint32_t fPackedID;
+            uint32_t fOffset;
+            uint32_t fSize;
+        };
+
+        StrikeFile(SkString path, const SkDescriptor& key, uint64_t fontHash, uint64_t engineID);
+
+        void load();
+
+        // Returns the glyph's record, or null if the file doesn't have it.
+        const volatile char* findRecord(uint32_t packedID, size_t* size) const;
+
+        const SkString         fPath;
+        const SkAutoDescriptor fKey;
+        const uint64_t         fFontHash;
+        const uint64_t         fEngineID;
+        sk_sp<SkData>          fData;
+        SkTArray<IndexEntry>   fIndex;  // Sorted by fPackedID.
+        SkFontMetrics          fFontMetrics;
+        bool                   fHasFontMetrics{false};
+
+        friend class SkGlyphDiskCache;
+    };
+
+    /**
+     *  Returns the file for this strike, creating nothing on disk until it's saved.  Returns null
+     *  if the scaler context has no engine ID, or its typeface has no font data to identify it by.
+     */
+    std::unique_ptr<StrikeFile> openStrike(const SkDescriptor&, const SkScalerContext&);
+
+private:
+    bool fontHash(const SkTypeface&, uint64_t* hash);
+
+    const SkString                 fDirectory;
+    SkMutex                        fMutex;
+    SkTHashMap<SkFontID, uint64_t> fFontHashes;  // Guarded by fMutex.
+};
+
+#endif  // SkGlyphDiskCache_DEFINED
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkCanvas.h"
+#include "SkImage.h"
+#include "SkLazyPicture.h"
+#include "SkPictureData.h"
+#include "SkPicturePlayback.h"
+#include "SkTextBlob.h"
+#include "SkVertices.h"
+
+sk_sp<SkPicture> SkLazyPicture::Make(const SkRect& cull,
+                                     std::unique_ptr<const SkPictureData> data) {
+    if (!data || !data->opData()) {
+        return nullptr;
+    }
+    int opCount = SkPicturePlayback::CountOps(*data->opData());
+    if (opCount < 0) {
+        return nullptr;
+    }
+    return sk_sp<SkPicture>(new SkLazyPicture(cull, std::move(data), opCount));
+}
+
+SkLazyPicture::SkLazyPicture(const SkRect& cull, std::unique_ptr<const SkPictureData> data,
+                             int opCount)
+    : fCullRect(cull)
+    , fData(std::move(data))
+    , fOpCount(opCount) {}
+
+void SkLazyPicture::playback(SkCanvas* canvas, AbortCallback* callback) const {
+    SkASSERT(canvas);
+    SkPicturePlayback playback(fData.get(), true/*cull lazy payloads*/);
+    playback.draw(canvas, callback, nullptr);
+}
+
+void SkLazyPicture::playbackUnculled(SkCanvas* canvas) const {
+    SkASSERT(canvas);
+    SkPicturePlayback playback(fData.get());
+    playback.draw(canvas, nullptr, nullptr);
+}
+
+size_t SkLazyPicture::approximateBytesUsed() const {
+    // Images, text blobs and vertices that haven't been decoded aren't counted.
+    return sizeof(*this) + sizeof(SkPictureData) + fData->opData()->size();
+}
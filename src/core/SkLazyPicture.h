@@ -0,0 +1,46 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkLazyPicture_DEFINED
+#define SkLazyPicture_DEFINED
+
+#include "SkPicture.h"
+#include "SkRect.h"
+
+#include <memory>
+
+class SkPictureData;
+
+// An SkPicture made by SkPicture::MakeLazyFromData().  Rather than converting its serialized ops
+// to an SkRecord, it plays them back with SkPicturePlayback straight from its SkPictureData,
+// which decodes images, text blobs and vertices the first time a draw that uses them isn't
+// culled.
+class SkLazyPicture final : public SkPicture {
+public:
+    // Returns null if data is null or has no ops.
+    static sk_sp<SkPicture> Make(const SkRect& cull, std::unique_ptr<const SkPictureData> data);
+
+// SkPicture overrides
+    void playback(SkCanvas*, AbortCallback*) const override;
+    SkRect cullRect() const override { return fCullRect; }
+    int approximateOpCount() const override { return fOpCount; }
+    size_t approximateBytesUsed() const override;
+    const SkLazyPicture* asSkLazyPicture() const override { return this; }
+
+// Used by SkPicture::backport.  Like playback(), but decodes everything rather than culling
+// draws against the canvas's clip.
+    void playbackUnculled(SkCanvas*) const;
+
+private:
+    SkLazyPicture(const SkRect& cull, std::unique_ptr<const SkPictureData>, int opCount);
+
+    const SkRect                               fCullRect;
+    const std::unique_ptr<const SkPictureData> fData;
+    const int                                  fOpCount;
+};
+
+#endif//SkLazyPicture_DEFINED
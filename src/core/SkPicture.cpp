@@ -7,7 +7,10 @@
 
 #include "SkPicture.h"
 
+#include "SkBigPicture.h"
+#include "SkExecutor.h"
 #include "SkImageGenerator.h"
+#include "SkLazyPicture.h"
 #include "SkMathPriv.h"
 #include "SkPictureCommon.h"
 #include "SkPictureData.h"
@@ -15,7 +18,9 @@
 #include "SkPicturePriv.h"
 #include "SkPictureRecord.h"
 #include "SkPictureRecorder.h"
+#include "SkReadBuffer.h"
 #include "SkSerialProcs.h"
+#include "SkTaskGroup.h"
 #include "SkTo.h"
 #include <atomic>
 
@@ -132,7 +137,7 @@ sk_sp<SkPicture> SkPicture::Forwardport(const SkPictInfo& info,
 }
 
 sk_sp<SkPicture> SkPicture::MakeFromStream(SkStream* stream, const SkDeserialProcs* procs) {
-    return MakeFromStream(stream, procs, nullptr);
+    return MakeFromStream(stream, procs, nullptr, nullptr);
 }
 
 sk_sp<SkPicture> SkPicture::MakeFromData(const void* data, size_t size,
@@ -141,7 +146,7 @@ sk_sp<SkPicture> SkPicture::MakeFromData(const void* data, size_t size,
         return nullptr;
     }
     SkMemoryStream stream(data, size);
-    return MakeFromStream(&stream, procs, nullptr);
+    return MakeFromStream(&stream, procs, nullptr, nullptr);
 }
 
 sk_sp<SkPicture> SkPicture::MakeFromData(const SkData* data, const SkDeserialProcs* procs) {
@@ -149,11 +154,32 @@ sk_sp<SkPicture> SkPicture::MakeFromData(const SkData* data, const SkDeserialPro
         return nullptr;
     }
     SkMemoryStream stream(data->data(), data->size());
-    return MakeFromStream(&stream, procs, nullptr);
+    return MakeFromStream(&stream, procs, nullptr, nullptr);
+}
+
+sk_sp<SkPicture> SkPicture::MakeLazyFromData(sk_sp<SkData> data, const SkDeserialProcs* procs) {
+    if (!data) {
+        return nullptr;
+    }
+    if (SkPictureData::IsMapped(data->data(), data->size())) {
+        if (!SkIsAlign4(reinterpret_cast<uintptr_t>(data->data()))) {
+            data = SkData::MakeWithCopy(data->data(), data->size());
+        }
+        const size_t size = data->size();
+        std::unique_ptr<SkPictureData> pictureData(SkPictureData::CreateFromMapped(
+                std::move(data), 0, size, procs ? *procs : SkDeserialProcs()));
+        if (!pictureData) {
+            return nullptr;
+        }
+        const SkRect cull = pictureData->info().fCullRect;
+        return SkLazyPicture::Make(cull, std::move(pictureData));
+    }
+    SkMemoryStream stream(data);
+    return MakeFromStream(&stream, procs, nullptr, data.get());
 }
 
 sk_sp<SkPicture> SkPicture::MakeFromStream(SkStream* stream, const SkDeserialProcs* procsPtr,
-                                           SkTypefacePlayback* typefaces) {
+                                           SkTypefacePlayback* typefaces, SkData* lazySource) {
     SkPictInfo info;
     if (!StreamIsSKP(stream, &info)) {
         return nullptr;
@@ -168,6 +194,12 @@ sk_sp<SkPicture> SkPicture::MakeFromStream(SkStream* stream, const SkDeserialPro
     if (!stream->readU8(&trailingStreamByteAfterPictInfo)) { return nullptr; }
     switch (trailingStreamByteAfterPictInfo) {
         case kPictureData_TrailingStreamByteAfterPictInfo: {
+            // Lazy loading skips over flattened objects, so needs them in their current format.
+            if (lazySource && info.getVersion() >= SkReadBuffer::kSerializeFonts_Version) {
+                std::unique_ptr<SkPictureData> data(SkPictureData::CreateLazyFromStream(
+                        stream, sk_ref_sp(lazySource), info, procs, typefaces));
+                return SkLazyPicture::Make(info.fCullRect, std::move(data));
+            }
             std::unique_ptr<SkPictureData> data(
                     SkPictureData::CreateFromStream(stream, info, procs, typefaces));
             return Forwardport(info, data.get(), nullptr);
@@ -217,11 +249,34 @@ SkPictureData* SkPicture::backport() const {
     SkPictInfo info = this->createHeader();
     SkPictureRecord rec(SkISize::Make(info.fCullRect.width(), info.fCullRect.height()), 0/*flags*/);
     rec.beginRecording();
-        this->playback(&rec);
+        if (const SkLazyPicture* lazy = this->asSkLazyPicture()) {
+            // Culling against rec's bounds could drop ops inside our cull rect.
+            lazy->playbackUnculled(&rec);
+        } else {
+            this->playback(&rec);
+        }
     rec.endRecording();
     return new SkPictureData(rec, info);
 }
 
+void SkPicture::playbackParallel(int tileCount,
+                                 const std::function<SkCanvas*(int)>& canvasForTile,
+                                 SkExecutor* executor) const {
+    const SkBigPicture* big = this->asSkBigPicture();
+
+    SkTaskGroup tiles(executor ? *executor : SkExecutor::GetDefault());
+    tiles.batch(tileCount, [&](int i) {
+        if (SkCanvas* canvas = canvasForTile(i)) {
+            if (big) {
+                big->tilePlayback(canvas);
+            } else {
+                this->playback(canvas);
+            }
+        }
+    });
+    tiles.wait();
+}
+
 void SkPicture::serialize(SkWStream* stream, const SkSerialProcs* procs) const {
     this->serialize(stream, procs, nullptr);
 }
@@ -232,6 +287,13 @@ sk_sp<SkData> SkPicture::serialize(const SkSerialProcs* procs) const {
     return stream.detachAsData();
 }
 
+sk_sp<SkData> SkPicture::serializeMappable(const SkSerialProcs* procs) const {
+    std::unique_ptr<SkPictureData> data(this->backport());
+    SkDynamicMemoryWStream stream;
+    data->serializeMapped(&stream, procs ? *procs : SkSerialProcs());
+    return stream.detachAsData();
+}
+
 static sk_sp<SkData> custom_serialize(const SkPicture* picture, const SkSerialProcs& procs) {
     if (procs.fPictureProc) {
         auto data = procs.fPictureProc(const_cast<SkPicture*>(picture), procs.fPictureCtx);
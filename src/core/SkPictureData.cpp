@@ -9,6 +9,7 @@
 
 #include "SkAutoMalloc.h"
 #include "SkImageGenerator.h"
+#include "SkLazyPicture.h"
 #include "SkMakeUnique.h"
 #include "SkPictureRecord.h"
 #include "SkPicturePriv.h"
@@ -18,7 +19,9 @@
 #include "SkWriteBuffer.h"
 #include "SkTo.h"
 
+#include <algorithm>
 #include <new>
+#include <type_traits>
 
 #if SK_SUPPORT_GPU
 #include "GrContext.h"
@@ -277,6 +280,13 @@ void SkPictureData::flatten(SkWriteBuffer& buffer) const {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// Whether a lazy picture's stream is at a 4-byte aligned address in its source, so that
+// SkReadBuffer can read from there without copying.
+static bool is_aligned_in_source(const SkData* source, SkStream* stream) {
+    SkASSERT(stream->getMemoryBase() == source->data());
+    return SkIsAlign4(reinterpret_cast<uintptr_t>(source->bytes() + stream->getPosition()));
+}
+
 bool SkPictureData::parseStreamTag(SkStream* stream,
                                    uint32_t tag,
                                    uint32_t size,
@@ -285,7 +295,16 @@ bool SkPictureData::parseStreamTag(SkStream* stream,
     switch (tag) {
         case SK_PICT_READER_TAG:
             SkASSERT(nullptr == fOpData);
-            fOpData = SkData::MakeFromStream(stream, size);
+            if (fSource && is_aligned_in_source(fSource.get(), stream)) {
+                // Play the ops back straight from the source.
+                const size_t offset = stream->getPosition();
+                if (stream->skip(size) != size) {
+                    return false;
+                }
+                fOpData = SkData::MakeSubset(fSource.get(), offset, size);
+            } else {
+                fOpData = SkData::MakeFromStream(stream, size);
+            }
             if (!fOpData) {
                 return false;
             }
@@ -321,7 +340,8 @@ bool SkPictureData::parseStreamTag(SkStream* stream,
             fPictures.reserve(SkToInt(size));
 
             for (uint32_t i = 0; i < size; i++) {
-                auto pic = SkPicture::MakeFromStream(stream, &procs, topLevelTFPlayback);
+                auto pic = SkPicture::MakeFromStream(stream, &procs, topLevelTFPlayback,
+                                                     fSource.get());
                 if (!pic) {
                     return false;
                 }
@@ -329,12 +349,24 @@ bool SkPictureData::parseStreamTag(SkStream* stream,
             }
         } break;
         case SK_PICT_BUFFER_SIZE_TAG: {
-            SkAutoMalloc storage(size);
-            if (stream->read(storage.get(), size) != size) {
-                return false;
+            // Lazy picture data indexes the buffer in place if it can, but either way it
+            // remembers where the buffer's payloads are in the source, not in any copy.
+            const size_t sourceOffset = fSource ? stream->getPosition() : 0;
+            SkAutoMalloc storage;
+            const void* memory;
+            if (fSource && is_aligned_in_source(fSource.get(), stream)) {
+                if (stream->skip(size) != size) {
+                    return false;
+                }
+                memory = fSource->bytes() + sourceOffset;
+            } else {
+                memory = storage.reset(size);
+                if (stream->read(storage.get(), size) != size) {
+                    return false;
+                }
             }
 
-            SkReadBuffer buffer(storage.get(), size);
+            SkReadBuffer buffer(memory, size);
             buffer.setVersion(fInfo.getVersion());
 
             if (!fFactoryPlayback) {
@@ -354,7 +386,7 @@ bool SkPictureData::parseStreamTag(SkStream* stream,
             while (!buffer.eof() && buffer.isValid()) {
                 tag = buffer.readUInt();
                 size = buffer.readUInt();
-                this->parseBufferTag(buffer, tag, size);
+                this->parseBufferTag(buffer, tag, size, sourceOffset);
             }
             if (!buffer.isValid()) {
                 return false;
@@ -401,7 +433,103 @@ bool new_array_from_buffer(SkReadBuffer& buffer, uint32_t inCount,
     return true;
 }
 
-void SkPictureData::parseBufferTag(SkReadBuffer& buffer, uint32_t tag, uint32_t size) {
+// Lazily loaded images, text blobs and vertices are indexed with these, which step over one
+// flattened object and return the bounds to cull it with, or false if it's malformed.
+
+static bool skip_text_blob(SkReadBuffer& buffer, SkRect* bounds) {
+    return SkTextBlobPriv::SkipFromBuffer(buffer, bounds);
+}
+
+static bool skip_vertices(SkReadBuffer& buffer, SkRect* bounds) {
+    const uint32_t size = buffer.readUInt();
+    const char* data = static_cast<const char*>(buffer.skip(size));
+    if (!data) {
+        return false;
+    }
+    // SkVertices::encode() writes the mode, vertex count and index count, then the positions.
+    // Bounds stay empty (so the vertices are never culled) if they look wrong; Decode() will
+    // decide whether the vertices are valid.
+    if (size >= 3 * sizeof(int32_t)) {
+        int32_t vertexCount;
+        memcpy(&vertexCount, data + sizeof(int32_t), sizeof(int32_t));
+        if (vertexCount > 0 &&
+            (size - 3 * sizeof(int32_t)) / sizeof(SkPoint) >= (size_t)vertexCount &&
+            !bounds->setBoundsCheck(reinterpret_cast<const SkPoint*>(data + 3 * sizeof(int32_t)),
+                                    vertexCount)) {
+            bounds->setEmpty();
+        }
+    }
+    return true;
+}
+
+static bool skip_image(SkReadBuffer& buffer, SkRect* bounds) {
+    // See SkReadBuffer::readImage().
+    SkIRect imageBounds;
+    buffer.readIRect(&imageBounds);
+    const int32_t size = buffer.read32();
+    if (!buffer.validate(!imageBounds.isEmpty() && size != SK_NaN32) ||
+        !buffer.skip(SkAbs32(size))) {
+        return false;
+    }
+    *bounds = SkRect::Make(SkISize::Make(imageBounds.width(), imageBounds.height()));
+    return true;
+}
+
+template <typename T>
+bool new_lazy_array_from_buffer(SkReadBuffer& buffer, uint32_t inCount, size_t sourceOffset,
+                                SkPictureData::LazyArray<T>* array,
+                                bool (*skip)(SkReadBuffer&, SkRect* bounds)) {
+    // Every flattened object takes at least one int, so check the count before allocating.
+    if (!buffer.validate(array->fCount == 0 && SkTFitsIn<int>(inCount)) ||
+        !buffer.validateCanReadN<int32_t>(inCount)) {
+        return false;
+    }
+    if (0 == inCount) {
+        return true;
+    }
+
+    array->fEntries.reset(new SkPictureData::LazyEntry<T>[inCount]);
+    for (uint32_t i = 0; i < inCount; ++i) {
+        SkPictureData::LazyEntry<T>& entry = array->fEntries[i];
+        const size_t start = buffer.offset();
+        if (!buffer.validate(skip(buffer, &entry.fBounds))) {
+            array->fEntries.reset();
+            return false;
+        }
+        entry.fOffset = sourceOffset + start;
+        entry.fSize = buffer.offset() - start;
+    }
+    array->fCount = SkToInt(inCount);
+    return true;
+}
+
+void SkPictureData::parseLazyBufferTag(SkReadBuffer& buffer, uint32_t tag, uint32_t size,
+                                       size_t sourceOffset) {
+    switch (tag) {
+        case SK_PICT_TEXTBLOB_BUFFER_TAG:
+            new_lazy_array_from_buffer(buffer, size, sourceOffset, &fLazyTextBlobs,
+                                       skip_text_blob);
+            break;
+        case SK_PICT_VERTICES_BUFFER_TAG:
+            new_lazy_array_from_buffer(buffer, size, sourceOffset, &fLazyVertices, skip_vertices);
+            break;
+        case SK_PICT_IMAGE_BUFFER_TAG:
+            new_lazy_array_from_buffer(buffer, size, sourceOffset, &fLazyImages, skip_image);
+            break;
+        default:
+            this->parseBufferTag(buffer, tag, size, sourceOffset);
+            break;
+    }
+}
+
+void SkPictureData::parseBufferTag(SkReadBuffer& buffer, uint32_t tag, uint32_t size,
+                                   size_t sourceOffset) {
+    if (fSource && (tag == SK_PICT_TEXTBLOB_BUFFER_TAG ||
+                    tag == SK_PICT_VERTICES_BUFFER_TAG ||
+                    tag == SK_PICT_IMAGE_BUFFER_TAG)) {
+        this->parseLazyBufferTag(buffer, tag, size, sourceOffset);
+        return;
+    }
     switch (tag) {
         case SK_PICT_PAINT_BUFFER_TAG: {
             if (!buffer.validate(SkTFitsIn<int>(size))) {
@@ -479,6 +607,35 @@ SkPictureData* SkPictureData::CreateFromStream(SkStream* stream,
     return data.release();
 }
 
+SkPictureData* SkPictureData::CreateLazyFromStream(SkStream* stream,
+                                                   sk_sp<SkData> source,
+                                                   const SkPictInfo& info,
+                                                   const SkDeserialProcs& procs,
+                                                   SkTypefacePlayback* topLevelTFPlayback) {
+    SkASSERT(source && stream->getMemoryBase() == source->data());
+    std::unique_ptr<SkPictureData> data(new SkPictureData(info));
+    data->fSource = std::move(source);
+    // Used for every later decode, so MakeLazyFromData() requires procs' contexts to outlive us.
+    data->fProcs = procs;
+    if (!topLevelTFPlayback) {
+        topLevelTFPlayback = &data->fTFPlayback;
+    }
+
+    if (!data->parseStream(stream, procs, topLevelTFPlayback)) {
+        return nullptr;
+    }
+
+    // Our text blobs may be decoded long after the top-level picture is gone, so keep our own
+    // refs on its typefaces.
+    if (data->fTFPlayback.count() == 0 && topLevelTFPlayback != &data->fTFPlayback) {
+        data->fTFPlayback.setCount(topLevelTFPlayback->count());
+        for (size_t i = 0; i < topLevelTFPlayback->count(); i++) {
+            data->fTFPlayback[i] = (*topLevelTFPlayback)[i];
+        }
+    }
+    return data.release();
+}
+
 SkPictureData* SkPictureData::CreateFromBuffer(SkReadBuffer& buffer,
                                                const SkPictInfo& info) {
     std::unique_ptr<SkPictureData> data(new SkPictureData(info));
@@ -515,7 +672,7 @@ bool SkPictureData::parseBuffer(SkReadBuffer& buffer) {
         if (SK_PICT_EOF_TAG == tag) {
             break;
         }
-        this->parseBufferTag(buffer, tag, buffer.readUInt());
+        this->parseBufferTag(buffer, tag, buffer.readUInt(), 0);
     }
 
     // Check that we encountered required tags
@@ -526,3 +683,505 @@ bool SkPictureData::parseBuffer(SkReadBuffer& buffer) {
     }
     return true;
 }
+
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename Entry, typename Fn>
+void SkPictureData::decodeLazy(const Entry& entry, Fn&& fn) const {
+    const void* bytes = fSource->bytes() + entry.fOffset;
+    SkAutoMalloc storage;
+    if (!SkIsAlign4(reinterpret_cast<uintptr_t>(bytes))) {
+        bytes = memcpy(storage.reset(entry.fSize), bytes, entry.fSize);
+    }
+
+    SkReadBuffer buffer(bytes, entry.fSize);
+    buffer.setVersion(fInfo.getVersion());
+    buffer.setDeserialProcs(fProcs);
+    fTFPlayback.setupBuffer(buffer);
+    if (fFactoryPlayback) {
+        fFactoryPlayback->setupBuffer(buffer);
+    }
+    fn(buffer);
+}
+
+const SkImage* SkPictureData::decodeImage(int index) const {
+    const LazyEntry<const SkImage>& entry = fLazyImages.fEntries[index];
+    entry.fOnce([&] {
+        // Like SkReadBuffer::readImage(), but shares the encoded data with fSource rather than
+        // copying it.  The image is flattened as its bounds, the encoded size, then the data.
+        SkIRect bounds;
+        int32_t size;
+        const uint8_t* record = fSource->bytes() + entry.fOffset;
+        memcpy(&bounds, record, sizeof(bounds));
+        memcpy(&size, record + sizeof(bounds), sizeof(size));
+        size = SkAbs32(size);
+
+        sk_sp<SkImage> image;
+        if (size > 1) {
+            const size_t offset = entry.fOffset + sizeof(bounds) + sizeof(size);
+            sk_sp<SkData> encoded = SkData::MakeSubset(fSource.get(), offset, size);
+            if (encoded && fProcs.fImageProc) {
+                image = fProcs.fImageProc(encoded->data(), encoded->size(), fProcs.fImageCtx);
+            }
+            if (encoded && !image) {
+                image = SkImage::MakeFromEncoded(std::move(encoded));
+            }
+            if (image && (bounds.x() || bounds.y() ||
+                          bounds.width() < image->width() || bounds.height() < image->height())) {
+                image = image->makeSubset(bounds);
+            }
+        }
+        if (image) {
+            entry.fObject = std::move(image);
+        } else {
+            // Let SkReadBuffer make its placeholder for images it can't decode.
+            this->decodeLazy(entry, [&](SkReadBuffer& buffer) {
+                entry.fObject = buffer.readImage();
+            });
+        }
+    });
+    return entry.fObject.get();
+}
+
+const SkTextBlob* SkPictureData::decodeTextBlob(int index) const {
+    const LazyEntry<const SkTextBlob>& entry = fLazyTextBlobs.fEntries[index];
+    entry.fOnce([&] {
+        this->decodeLazy(entry, [&](SkReadBuffer& buffer) {
+            entry.fObject = SkTextBlobPriv::MakeFromBuffer(buffer);
+        });
+    });
+    return entry.fObject.get();
+}
+
+const SkVertices* SkPictureData::decodeVertices(int index) const {
+    const LazyEntry<const SkVertices>& entry = fLazyVertices.fEntries[index];
+    entry.fOnce([&] {
+        this->decodeLazy(entry, [&](SkReadBuffer& buffer) {
+            const uint32_t size = buffer.readUInt();
+            if (const void* data = buffer.skip(size)) {
+                entry.fObject = SkVertices::Decode(data, size);
+            }
+        });
+    });
+    return entry.fObject.get();
+}
+
+const SkPaint* SkPictureData::decodePaint(int index, SkReadBuffer* reader) const {
+    const LazyValue<SkPaint>& entry = fLazyPaints.fEntries[index];
+    entry.fOnce([&] {
+        this->decodeLazy(entry, [&](SkReadBuffer& buffer) {
+            entry.fValid = buffer.readPaint(&entry.fValue, nullptr) && buffer.isValid();
+        });
+    });
+    return reader->validate(entry.fValid) ? &entry.fValue : nullptr;
+}
+
+const SkPath& SkPictureData::decodePath(int index, SkReadBuffer* reader) const {
+    const LazyValue<SkPath>& entry = fLazyPaths.fEntries[index];
+    entry.fOnce([&] {
+        this->decodeLazy(entry, [&](SkReadBuffer& buffer) {
+            buffer.readPath(&entry.fValue);
+            entry.fValid = buffer.isValid();
+            // Like initForPlayback(), so that threads can share the path.
+            entry.fValue.updateBoundsCache();
+        });
+    });
+    return reader->validate(entry.fValid) ? entry.fValue : fEmptyPath;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// The mapped layout written by serializeMapped() is a MappedHeader, then a MappedSection for
+// each of the sections below, in this order, then the sections themselves, each starting 8-byte
+// aligned.  Offsets are from the start of the header.
+//
+//   kOps          the ops, played back in place
+//   kFactories    the factories, tagged as in the stream format
+//   kTypefaces    the typefaces, tagged as in the stream format
+//   kObjects      the flattened paints, paths, text blobs, vertices and images
+//   kPictures     the sub-pictures, each a mapped picture of its own
+//   k*Table       a MappedEntry for each paint, path, etc. in kObjects, or sub-picture
+//
+// The ops refer to these by index as usual, so loading is only a matter of checking the header,
+// sections and tables, and then copying each table's offsets and bounds.
+
+static const char kMappedMagic[] = { 's', 'k', 'i', 'a', 'm', 'a', 'p', 'p' };
+static const uint32_t kMappedVersion = 2;
+
+// Mapped pictures are read in place.  Everything in them is a 32-bit integer or float, so the
+// writer's byte order is the only part of its ABI that a reader has to share.  This tag is
+// written in native byte order, so it only reads back as itself on a build that does.
+static const uint32_t kMappedByteOrder = 0x01020304;
+
+enum MappedSectionIndex {
+    kOps,
+    kFactories,
+    kTypefaces,
+    kObjects,
+    kPictures,
+    kPaintTable,
+    kPathTable,
+    kTextBlobTable,
+    kVerticesTable,
+    kImageTable,
+    kPictureTable,
+
+    kMappedSectionCount
+};
+
+static const uint32_t kMappedSectionTags[kMappedSectionCount] = {
+    SK_PICT_READER_TAG,
+    SK_PICT_FACTORY_TAG,
+    SK_PICT_TYPEFACE_TAG,
+    SK_PICT_BUFFER_SIZE_TAG,
+    SkSetFourByteTag('p', 'i', 'c', 's'),
+    SK_PICT_PAINT_BUFFER_TAG,
+    SK_PICT_PATH_BUFFER_TAG,
+    SK_PICT_TEXTBLOB_BUFFER_TAG,
+    SK_PICT_VERTICES_BUFFER_TAG,
+    SK_PICT_IMAGE_BUFFER_TAG,
+    SK_PICT_PICTURE_TAG,
+};
+
+struct MappedHeader {
+    char     fMagic[8];
+    uint32_t fVersion;          // kMappedVersion
+    uint32_t fPictureVersion;   // The version the objects were flattened with.
+    SkRect   fCullRect;
+    uint32_t fSectionCount;
+    uint32_t fByteOrder;        // kMappedByteOrder
+};
+
+struct MappedSection {
+    uint32_t fTag;
+    uint32_t fCount;
+    uint32_t fOffset;
+    uint32_t fSize;
+};
+
+struct MappedEntry {
+    uint32_t fOffset;
+    uint32_t fSize;
+    SkRect   fBounds;           // To cull the ops that draw it with; empty if never culled.
+};
+
+bool SkPictureData::IsMapped(const void* data, size_t size) {
+    return size >= sizeof(MappedHeader) && 0 == memcmp(data, kMappedMagic, sizeof(kMappedMagic));
+}
+
+static void write_zeros(SkWStream* stream, size_t count) {
+    static const char kZeros[8] = {0};
+    SkASSERT(count <= sizeof(kZeros));
+    stream->write(kZeros, count);
+}
+
+void SkPictureData::serializeMapped(SkWStream* stream, const SkSerialProcs& procs) const {
+    // As in serialize(), flatten the objects first to find the factories and typefaces.
+    SkFactorySet factSet;  // buffer refs factSet, so factSet must come first.
+    SkRefCntSet typefaceSet;
+    SkBinaryWriteBuffer buffer;
+    buffer.setFactoryRecorder(sk_ref_sp(&factSet));
+    buffer.setSerialProcs(skip_typeface_proc(procs));
+    buffer.setTypefaceRecorder(sk_ref_sp(&typefaceSet));
+
+    // Entries are offsets into buffer until we know where it goes.
+    SkTArray<MappedEntry> tables[kMappedSectionCount];
+    auto add = [&](int table, size_t start, const SkRect& bounds) {
+        tables[table].push_back({ SkToU32(start), SkToU32(buffer.bytesWritten() - start),
+                                  bounds });
+    };
+    for (const SkPaint& paint : fPaints) {
+        const size_t start = buffer.bytesWritten();
+        buffer.writePaint(paint);
+        add(kPaintTable, start, SkRect::MakeEmpty());
+    }
+    for (const SkPath& path : fPaths) {
+        const size_t start = buffer.bytesWritten();
+        buffer.writePath(path);
+        add(kPathTable, start, SkRect::MakeEmpty());
+    }
+    for (const auto& blob : fTextBlobs) {
+        const size_t start = buffer.bytesWritten();
+        SkTextBlobPriv::Flatten(*blob, buffer);
+        add(kTextBlobTable, start, blob->bounds());
+    }
+    for (const auto& vert : fVertices) {
+        const size_t start = buffer.bytesWritten();
+        buffer.writeDataAsByteArray(vert->encode().get());
+        add(kVerticesTable, start, vert->bounds());
+    }
+    for (const auto& img : fImages) {
+        const size_t start = buffer.bytesWritten();
+        buffer.writeImage(img.get());
+        add(kImageTable, start, SkRect::Make(img->bounds()));
+    }
+
+    // Sub-pictures are self-contained, typefaces and all.
+    SkTArray<sk_sp<SkData>> subPictures;
+    for (const auto& pic : fPictures) {
+        subPictures.push_back(pic->serializeMappable(&procs));
+    }
+
+    sk_sp<SkData> data[kMappedSectionCount];
+    data[kOps] = fOpData;
+    SkDynamicMemoryWStream factories, typefaces;
+    WriteFactories(&factories, factSet);
+    data[kFactories] = factories.detachAsData();
+    WriteTypefaces(&typefaces, typefaceSet, procs);
+    data[kTypefaces] = typefaces.detachAsData();
+    data[kObjects] = SkData::MakeUninitialized(buffer.bytesWritten());
+    buffer.writeToMemory(data[kObjects]->writable_data());
+
+    MappedSection sections[kMappedSectionCount];
+    size_t offset = sizeof(MappedHeader) + sizeof(sections);
+    for (int i = 0; i < kMappedSectionCount; i++) {
+        size_t count = tables[i].count();
+        if (i == kFactories) {
+            count = factSet.count();
+        } else if (i == kTypefaces) {
+            count = typefaceSet.count();
+        } else if (i == kPictureTable) {
+            count = subPictures.count();
+        }
+        size_t size = 0;
+        if (data[i]) {
+            size = data[i]->size();
+        } else if (i == kPictures) {
+            for (const auto& pic : subPictures) {
+                size = SkAlign8(size) + pic->size();
+            }
+        } else {
+            size = count * sizeof(MappedEntry);
+        }
+        offset = SkAlign8(offset);
+        sections[i] = { kMappedSectionTags[i], SkToU32(count), SkToU32(offset), SkToU32(size) };
+        offset += size;
+    }
+
+    // Now that we know where the objects and sub-pictures land, point the tables at them.
+    for (int i = kPaintTable; i < kPictureTable; i++) {
+        for (MappedEntry& entry : tables[i]) {
+            entry.fOffset += sections[kObjects].fOffset;
+        }
+    }
+    offset = sections[kPictures].fOffset;
+    for (const auto& pic : subPictures) {
+        offset = SkAlign8(offset);
+        tables[kPictureTable].push_back({ SkToU32(offset), SkToU32(pic->size()),
+                                          SkRect::MakeEmpty() });
+        offset += pic->size();
+    }
+
+    MappedHeader header;
+    memcpy(header.fMagic, kMappedMagic, sizeof(kMappedMagic));
+    header.fVersion = kMappedVersion;
+    header.fPictureVersion = SkPicture::CURRENT_PICTURE_VERSION;
+    header.fCullRect = fInfo.fCullRect;
+    header.fSectionCount = kMappedSectionCount;
+    header.fByteOrder = kMappedByteOrder;
+    stream->write(&header, sizeof(header));
+    stream->write(sections, sizeof(sections));
+
+    size_t written = sizeof(header) + sizeof(sections);
+    for (int i = 0; i < kMappedSectionCount; i++) {
+        write_zeros(stream, sections[i].fOffset - written);
+        written = sections[i].fOffset;
+        if (data[i]) {
+            stream->write(data[i]->data(), data[i]->size());
+            written += data[i]->size();
+        } else if (i == kPictures) {
+            for (const auto& pic : subPictures) {
+                write_zeros(stream, SkAlign8(written) - written);
+                written = SkAlign8(written);
+                stream->write(pic->data(), pic->size());
+                written += pic->size();
+            }
+        } else {
+            stream->write(tables[i].begin(), tables[i].count() * sizeof(MappedEntry));
+            written += tables[i].count() * sizeof(MappedEntry);
+        }
+    }
+}
+
+// Checks that a table's entries lie in the section holding them, 4-byte aligned, and copies
+// them into array with offsets into the source.  If disjoint, the entries must also be in order
+// and may not overlap, which serializeMapped() guarantees for sub-pictures: those are checked
+// recursively, so sharing bytes would let a small source ask for exponentially many checks.
+template <typename Array>
+static bool read_mapped_table(const MappedSection& table, const MappedSection& holder,
+                              const char* base, size_t sourceOffset, Array* array,
+                              bool disjoint = false) {
+    if (table.fCount == 0) {
+        return true;
+    }
+    if (!SkTFitsIn<int>(table.fCount) || table.fSize != table.fCount * sizeof(MappedEntry)) {
+        return false;
+    }
+    const auto* entries = reinterpret_cast<const MappedEntry*>(base + table.fOffset);
+    const size_t end = holder.fOffset + holder.fSize;
+    size_t previousEnd = holder.fOffset;
+    for (uint32_t i = 0; i < table.fCount; i++) {
+        const MappedEntry& entry = entries[i];
+        if (!SkIsAlign4(entry.fOffset) || !SkIsAlign4(entry.fSize) || entry.fSize == 0 ||
+            entry.fOffset < holder.fOffset || entry.fOffset > end ||
+            entry.fSize > end - entry.fOffset || !entry.fBounds.isFinite()) {
+            return false;
+        }
+        if (disjoint) {
+            if (entry.fOffset < previousEnd) {
+                return false;
+            }
+            previousEnd = entry.fOffset + entry.fSize;
+        }
+    }
+
+    using Entry = typename std::remove_reference<decltype(array->fEntries[0])>::type;
+    array->fEntries.reset(new Entry[table.fCount]);
+    for (uint32_t i = 0; i < table.fCount; i++) {
+        array->fEntries[i].fOffset = sourceOffset + entries[i].fOffset;
+        array->fEntries[i].fSize = entries[i].fSize;
+    }
+    array->fCount = SkToInt(table.fCount);
+    return true;
+}
+
+template <typename T>
+static void read_mapped_bounds(const MappedSection& table, const char* base,
+                               SkPictureData::LazyArray<T>* array) {
+    const auto* entries = reinterpret_cast<const MappedEntry*>(base + table.fOffset);
+    for (int i = 0; i < array->fCount; i++) {
+        array->fEntries[i].fBounds = entries[i].fBounds;
+    }
+}
+
+SkPictureData* SkPictureData::CreateFromMapped(sk_sp<SkData> source, size_t offset, size_t size,
+                                               const SkDeserialProcs& procs, int depth) {
+    if (depth > kMaxMappedDepth || !source ||
+        offset > source->size() || size > source->size() - offset ||
+        !SkIsAlign4(reinterpret_cast<uintptr_t>(source->bytes() + offset)) ||
+        !IsMapped(source->bytes() + offset, size)) {
+        return nullptr;
+    }
+    const char* base = static_cast<const char*>(source->data()) + offset;
+
+    MappedHeader header;
+    memcpy(&header, base, sizeof(header));
+    // Lazy decoding needs the objects flattened in their current format.
+    if (header.fByteOrder != kMappedByteOrder ||
+        header.fVersion != kMappedVersion ||
+        header.fPictureVersion < SkReadBuffer::kSerializeFonts_Version ||
+        header.fPictureVersion > SkPicture::CURRENT_PICTURE_VERSION ||
+        !header.fCullRect.isFinite() ||
+        header.fSectionCount > kMappedSectionCount ||
+        sizeof(header) + header.fSectionCount * sizeof(MappedSection) > size) {
+        return nullptr;
+    }
+    const size_t sectionsEnd = sizeof(header) + header.fSectionCount * sizeof(MappedSection);
+
+    // Find each section, making sure it's where it could be and that there's only one of it.
+    // Sections that are missing are empty.
+    MappedSection sections[kMappedSectionCount];
+    sk_bzero(sections, sizeof(sections));
+    bool found[kMappedSectionCount] = { false };
+    for (uint32_t i = 0; i < header.fSectionCount; i++) {
+        MappedSection section;
+        memcpy(&section, base + sizeof(header) + i * sizeof(MappedSection), sizeof(section));
+        const uint32_t* tag = std::find(kMappedSectionTags,
+                                        kMappedSectionTags + kMappedSectionCount, section.fTag);
+        const int index = SkToInt(tag - kMappedSectionTags);
+        if (index == kMappedSectionCount || found[index] ||
+            !SkIsAlign4(section.fOffset) || section.fOffset < sectionsEnd ||
+            section.fOffset > size || section.fSize > size - section.fOffset) {
+            return nullptr;
+        }
+        sections[index] = section;
+        found[index] = true;
+    }
+    if (!found[kOps]) {
+        return nullptr;
+    }
+
+    SkPictInfo info;
+    memcpy(info.fMagic, kMappedMagic, sizeof(kMappedMagic));
+    info.setVersion(header.fPictureVersion);
+    info.fCullRect = header.fCullRect;
+
+    std::unique_ptr<SkPictureData> data(new SkPictureData(info));
+    data->fSource = source;
+    // As with CreateLazyFromStream(), the caller keeps procs' contexts alive for later decodes.
+    data->fProcs = procs;
+    data->fMapped = true;
+    data->fOpData = SkData::MakeSubset(source.get(), offset + sections[kOps].fOffset,
+                                       sections[kOps].fSize);
+    if (!data->fOpData) {
+        return nullptr;
+    }
+
+    // Factories and typefaces are tagged as in the stream format, so we can parse them the same
+    // way, once we know that each of the section's count of them takes at least a byte.
+    for (int i : { kFactories, kTypefaces }) {
+        const MappedSection& section = sections[i];
+        if (!found[i]) {
+            continue;
+        }
+        SkMemoryStream stream(base + section.fOffset, section.fSize);
+        uint32_t tag, size, count;
+        if (!stream.readU32(&tag) || tag != kMappedSectionTags[i] || !stream.readU32(&size)) {
+            return nullptr;
+        }
+        // The factories' count follows their size; the typefaces' count is their size.
+        count = size;
+        if (i == kFactories && stream.peek(&count, sizeof(count)) != sizeof(count)) {
+            return nullptr;
+        }
+        if (count != section.fCount || section.fCount > section.fSize ||
+            !data->parseStreamTag(&stream, tag, size, procs, &data->fTFPlayback)) {
+            return nullptr;
+        }
+    }
+
+    const MappedSection& objects = sections[kObjects];
+    LazyArray<const SkPicture> pictures;
+    if (!read_mapped_table(sections[kPaintTable],    objects, base, offset, &data->fLazyPaints) ||
+        !read_mapped_table(sections[kPathTable],     objects, base, offset, &data->fLazyPaths) ||
+        !read_mapped_table(sections[kTextBlobTable], objects, base, offset,
+                           &data->fLazyTextBlobs) ||
+        !read_mapped_table(sections[kVerticesTable], objects, base, offset,
+                           &data->fLazyVertices) ||
+        !read_mapped_table(sections[kImageTable],    objects, base, offset, &data->fLazyImages) ||
+        !read_mapped_table(sections[kPictureTable],  sections[kPictures], base, offset,
+                           &pictures, /*disjoint=*/true)) {
+        return nullptr;
+    }
+    read_mapped_bounds(sections[kTextBlobTable], base, &data->fLazyTextBlobs);
+    read_mapped_bounds(sections[kVerticesTable], base, &data->fLazyVertices);
+    read_mapped_bounds(sections[kImageTable],    base, &data->fLazyImages);
+
+    // decodeImage() reads an image's header straight from the source, so check those now.
+    for (int i = 0; i < data->fLazyImages.fCount; i++) {
+        const LazyEntry<const SkImage>& entry = data->fLazyImages.fEntries[i];
+        SkReadBuffer buffer(source->bytes() + entry.fOffset, entry.fSize);
+        SkRect bounds;
+        if (!skip_image(buffer, &bounds) || !buffer.isValid() || buffer.offset() != entry.fSize) {
+            return nullptr;
+        }
+    }
+
+    // Sub-pictures are mapped too, so checking them now costs little more than the tables.
+    data->fPictures.reserve(pictures.fCount);
+    for (int i = 0; i < pictures.fCount; i++) {
+        const LazyEntry<const SkPicture>& entry = pictures.fEntries[i];
+        std::unique_ptr<const SkPictureData> picture(
+                CreateFromMapped(source, entry.fOffset, entry.fSize, procs, depth + 1));
+        if (!picture) {
+            return nullptr;
+        }
+        const SkRect cull = picture->info().fCullRect;
+        sk_sp<SkPicture> lazy = SkLazyPicture::Make(cull, std::move(picture));
+        if (!lazy) {
+            return nullptr;
+        }
+        data->fPictures.push_back(std::move(lazy));
+    }
+    return data.release();
+}
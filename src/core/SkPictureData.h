@@ -10,8 +10,10 @@
 
 #include "SkBitmap.h"
 #include "SkDrawable.h"
+#include "SkOnce.h"
 #include "SkPicture.h"
 #include "SkPictureFlat.h"
+#include "SkSerialProcs.h"
 #include "SkTArray.h"
 
 #include <memory>
@@ -83,11 +85,39 @@ public:
                                            const SkDeserialProcs&,
                                            SkTypefacePlayback*);
     static SkPictureData* CreateFromBuffer(SkReadBuffer&, const SkPictInfo&);
+    // Like CreateFromStream(), but the stream must be reading source, which the picture data
+    // refs.  Ops, paints and paths are loaded as usual (ops without a copy when they're aligned),
+    // but images, text blobs and vertices are only indexed: each is decoded from source the
+    // first time an op asks for it.  Sub-pictures are loaded lazily too.  The procs are kept for
+    // those decodes, so their contexts must outlive the picture data.
+    static SkPictureData* CreateLazyFromStream(SkStream*,
+                                               sk_sp<SkData> source,
+                                               const SkPictInfo&,
+                                               const SkDeserialProcs&,
+                                               SkTypefacePlayback*);
+
+    // Returns true if data starts like the output of serializeMapped().
+    static bool IsMapped(const void* data, size_t size);
+    // Loads the picture data that serializeMapped() wrote to size bytes at offset in source,
+    // which must be 4-byte aligned.  Every section and table is bounds-checked here, but nothing
+    // is copied or decoded: ops are played back from source, and paints, paths, text blobs,
+    // vertices and images are decoded from it the first time an op asks for them, using procs,
+    // whose contexts must outlive the picture data.  Sub-pictures are loaded the same way, and
+    // must each have their own, disjoint range of source.  depth counts the pictures this one is
+    // nested in; loading fails if sub-pictures nest more than kMaxMappedDepth deep.
+    static SkPictureData* CreateFromMapped(sk_sp<SkData> source, size_t offset, size_t size,
+                                           const SkDeserialProcs&, int depth = 0);
+    static constexpr int kMaxMappedDepth = 64;
 
     void serialize(SkWStream*, const SkSerialProcs&, SkRefCntSet*) const;
     void flatten(SkWriteBuffer&) const;
+    // Writes a self-contained layout that CreateFromMapped() can use in place.
+    void serializeMapped(SkWStream*, const SkSerialProcs&) const;
 
     const sk_sp<SkData>& opData() const { return fOpData; }
+    const SkPictInfo& info() const { return fInfo; }
+
+    bool isLazy() const { return fSource != nullptr; }
 
 protected:
     explicit SkPictureData(const SkPictInfo& info);
@@ -98,12 +128,29 @@ protected:
 
 public:
     const SkImage* getImage(SkReadBuffer* reader) const {
+        return this->image(this->readImageIndex(reader));
+    }
+
+    // Reads an image index, returning -1 (and invalidating reader) if it's out of range.
+    int readImageIndex(SkReadBuffer* reader) const {
         // images are written base-0, unlike paths, pictures, drawables, etc.
         const int index = reader->readInt();
-        return reader->validateIndex(index, fImages.count()) ? fImages[index].get() : nullptr;
+        const int count = fSource ? fLazyImages.fCount : fImages.count();
+        return reader->validateIndex(index, count) ? index : -1;
+    }
+
+    const SkImage* image(int index) const {
+        if (index < 0) {
+            return nullptr;
+        }
+        return fSource ? this->decodeImage(index) : fImages[index].get();
     }
 
     const SkPath& getPath(SkReadBuffer* reader) const {
+        if (fMapped) {
+            const int index = read_index_base_1(reader, fLazyPaths.fCount);
+            return index < 0 ? fEmptyPath : this->decodePath(index, reader);
+        }
         int index = reader->readInt();
         return reader->validate(index > 0 && index <= fPaths.count()) ?
                 fPaths[index - 1] : fEmptyPath;
@@ -122,24 +169,124 @@ public:
         if (index == 0) {
             return nullptr; // recorder wrote a zero for no paint (likely drawimage)
         }
+        if (fMapped) {
+            return reader->validate(index > 0 && index <= fLazyPaints.fCount) ?
+                    this->decodePaint(index - 1, reader) : nullptr;
+        }
         return reader->validate(index > 0 && index <= fPaints.count()) ?
                 &fPaints[index - 1] : nullptr;
     }
 
     const SkTextBlob* getTextBlob(SkReadBuffer* reader) const {
-        return read_index_base_1_or_null(reader, fTextBlobs);
+        return this->textBlob(this->readTextBlobIndex(reader));
+    }
+
+    // Reads a text blob index, returning it base-0, or -1 if it's out of range.
+    int readTextBlobIndex(SkReadBuffer* reader) const {
+        return read_index_base_1(reader, fSource ? fLazyTextBlobs.fCount : fTextBlobs.count());
+    }
+
+    const SkTextBlob* textBlob(int index) const {
+        if (index < 0) {
+            return nullptr;
+        }
+        return fSource ? this->decodeTextBlob(index) : fTextBlobs[index].get();
     }
 
     const SkVertices* getVertices(SkReadBuffer* reader) const {
-        return read_index_base_1_or_null(reader, fVertices);
+        return this->vertices(this->readVerticesIndex(reader));
+    }
+
+    // Reads a vertices index, returning it base-0, or -1 if it's out of range.
+    int readVerticesIndex(SkReadBuffer* reader) const {
+        return read_index_base_1(reader, fSource ? fLazyVertices.fCount : fVertices.count());
     }
 
+    const SkVertices* vertices(int index) const {
+        if (index < 0) {
+            return nullptr;
+        }
+        return fSource ? this->decodeVertices(index) : fVertices[index].get();
+    }
+
+    // For lazily loaded picture data, these return true and the bounds of an image (its
+    // dimensions), text blob or vertices without decoding it.  The bounds may be empty if unknown.
+    bool lazyImageBounds(int index, SkRect* bounds) const {
+        return get_lazy_bounds(fLazyImages, index, bounds);
+    }
+    bool lazyTextBlobBounds(int index, SkRect* bounds) const {
+        return get_lazy_bounds(fLazyTextBlobs, index, bounds);
+    }
+    bool lazyVerticesBounds(int index, SkRect* bounds) const {
+        return get_lazy_bounds(fLazyVertices, index, bounds);
+    }
+
+    // Where a lazily loaded image, text blob or vertices is flattened in fSource, and the bounds
+    // to cull the ops that draw it with.  The object is decoded the first time it's asked for.
+    template <typename T>
+    struct LazyEntry {
+        size_t           fOffset = 0;
+        size_t           fSize = 0;
+        SkRect           fBounds = SkRect::MakeEmpty();
+        mutable SkOnce   fOnce;
+        mutable sk_sp<T> fObject;
+    };
+
+    template <typename T>
+    struct LazyArray {
+        std::unique_ptr<LazyEntry<T>[]> fEntries;
+        int                             fCount = 0;
+    };
+
+    // Where a paint or path of mapped picture data is flattened in fSource.  Like LazyEntry, it's
+    // decoded the first time it's asked for; fValid records whether that worked.
+    template <typename T>
+    struct LazyValue {
+        size_t          fOffset = 0;
+        size_t          fSize = 0;
+        mutable SkOnce  fOnce;
+        mutable T       fValue;
+        mutable bool    fValid = false;
+    };
+
+    template <typename T>
+    struct LazyValues {
+        std::unique_ptr<LazyValue<T>[]> fEntries;
+        int                             fCount = 0;
+    };
+
 private:
+    static int read_index_base_1(SkReadBuffer* reader, int count) {
+        int index = reader->readInt();
+        return reader->validate(index > 0 && index <= count) ? index - 1 : -1;
+    }
+
+    template <typename T>
+    static bool get_lazy_bounds(const LazyArray<T>& array, int index, SkRect* bounds) {
+        if (index < 0 || index >= array.fCount) {
+            return false;
+        }
+        *bounds = array.fEntries[index].fBounds;
+        return true;
+    }
+
     // these help us with reading/writing
     // Does not affect ownership of SkStream.
     bool parseStreamTag(SkStream*, uint32_t tag, uint32_t size,
                         const SkDeserialProcs&, SkTypefacePlayback*);
-    void parseBufferTag(SkReadBuffer&, uint32_t tag, uint32_t size);
+    // For lazy picture data, sourceOffset is where the buffer's memory starts in fSource.
+    void parseBufferTag(SkReadBuffer&, uint32_t tag, uint32_t size, size_t sourceOffset);
+    void parseLazyBufferTag(SkReadBuffer&, uint32_t tag, uint32_t size, size_t sourceOffset);
+
+    // Runs fn with a buffer over the lazily loaded bytes of entry, set up to decode them.
+    template <typename Entry, typename Fn>
+    void decodeLazy(const Entry&, Fn&&) const;
+    // These invalidate reader if the paint or path doesn't decode.
+    const SkPaint* decodePaint(int index, SkReadBuffer* reader) const;
+    const SkPath& decodePath(int index, SkReadBuffer* reader) const;
+    const SkImage* decodeImage(int index) const;
+    const SkTextBlob* decodeTextBlob(int index) const;
+    const SkVertices* decodeVertices(int index) const;
     void flattenToBuffer(SkWriteBuffer&) const;
 
     SkTArray<SkPaint>  fPaints;
@@ -156,6 +303,18 @@ private:
     SkTArray<sk_sp<const SkVertices>>  fVertices;
     SkTArray<sk_sp<const SkImage>>     fImages;
 
+    // Only set for lazy picture data, which fills the lazy arrays instead of the ones above.
+    sk_sp<SkData>                      fSource;
+    SkDeserialProcs                    fProcs;  // The caller keeps their contexts alive.
+    LazyArray<const SkTextBlob>        fLazyTextBlobs;
+    LazyArray<const SkVertices>        fLazyVertices;
+    LazyArray<const SkImage>           fLazyImages;
+
+    // Only set for mapped picture data, which fills these instead of fPaints and fPaths too.
+    bool                               fMapped = false;
+    LazyValues<SkPaint>                fLazyPaints;
+    LazyValues<SkPath>                 fLazyPaths;
+
     SkTypefacePlayback                 fTFPlayback;
     std::unique_ptr<SkFactoryPlayback> fFactoryPlayback;
 
@@ -59,6 +59,33 @@ DrawType SkPicturePlayback::ReadOpAndSize(SkReadBuffer* reader, uint32_t* size)
 }
 
 
+int SkPicturePlayback::CountOps(const SkData& opData) {
+    SkReadBuffer reader(opData.data(), opData.size());
+    int count = 0;
+    while (!reader.eof()) {
+        const size_t start = reader.offset();
+        uint32_t size;
+        DrawType op = ReadOpAndSize(&reader, &size);
+        if (!reader.validate(op > UNUSED && op <= LAST_DRAWTYPE_ENUM &&
+                             size >= reader.offset() - start) ||
+            !reader.skip(size - (reader.offset() - start))) {
+            return -1;
+        }
+        count++;
+    }
+    return count;
+}
+
+bool SkPicturePlayback::cullLazy(SkCanvas* canvas, const SkRect& bounds,
+                                 const SkPaint* paint) const {
+    // This is how SkCanvas rejects draws, but it would only get to once the payload is decoded.
+    if (!fCullLazyPayloads || bounds.isEmpty() || (paint && !paint->canComputeFastBounds())) {
+        return false;
+    }
+    SkRect storage;
+    return canvas->quickReject(paint ? paint->computeFastBounds(bounds, &storage) : bounds);
+}
+
 static const SkRect* get_rect_ptr(SkReadBuffer* reader, SkRect* storage) {
     if (reader->readBool()) {
         reader->readRect(storage);
@@ -286,37 +313,48 @@ void SkPicturePlayback::handleOp(SkReadBuffer* reader,
         } break;
         case DRAW_IMAGE: {
             const SkPaint* paint = fPictureData->getPaint(reader);
-            const SkImage* image = fPictureData->getImage(reader);
+            const int image = fPictureData->readImageIndex(reader);
             SkPoint loc;
             reader->readPoint(&loc);
             BREAK_ON_READ_ERROR(reader);
 
-            canvas->drawImage(image, loc.fX, loc.fY, paint);
+            SkRect bounds;
+            if (fPictureData->lazyImageBounds(image, &bounds) &&
+                this->cullLazy(canvas, bounds.makeOffset(loc.fX, loc.fY), paint)) {
+                break;
+            }
+            canvas->drawImage(fPictureData->image(image), loc.fX, loc.fY, paint);
         } break;
         case DRAW_IMAGE_LATTICE: {
             const SkPaint* paint = fPictureData->getPaint(reader);
-            const SkImage* image = fPictureData->getImage(reader);
+            const int image = fPictureData->readImageIndex(reader);
             SkCanvas::Lattice lattice;
             (void)SkCanvasPriv::ReadLattice(*reader, &lattice);
             const SkRect* dst = reader->skipT<SkRect>();
             BREAK_ON_READ_ERROR(reader);
 
-            canvas->drawImageLattice(image, lattice, *dst, paint);
+            if (fPictureData->isLazy() && this->cullLazy(canvas, *dst, paint)) {
+                break;
+            }
+            canvas->drawImageLattice(fPictureData->image(image), lattice, *dst, paint);
         } break;
         case DRAW_IMAGE_NINE: {
             const SkPaint* paint = fPictureData->getPaint(reader);
-            const SkImage* image = fPictureData->getImage(reader);
+            const int image = fPictureData->readImageIndex(reader);
             SkIRect center;
             reader->readIRect(&center);
             SkRect dst;
             reader->readRect(&dst);
             BREAK_ON_READ_ERROR(reader);
 
-            canvas->drawImageNine(image, center, dst, paint);
+            if (fPictureData->isLazy() && this->cullLazy(canvas, dst, paint)) {
+                break;
+            }
+            canvas->drawImageNine(fPictureData->image(image), center, dst, paint);
         } break;
         case DRAW_IMAGE_RECT: {
             const SkPaint* paint = fPictureData->getPaint(reader);
-            const SkImage* image = fPictureData->getImage(reader);
+            const int imageIndex = fPictureData->readImageIndex(reader);
             SkRect storage;
             const SkRect* src = get_rect_ptr(reader, &storage);   // may be null
             SkRect dst;
@@ -329,6 +367,10 @@ void SkPicturePlayback::handleOp(SkReadBuffer* reader,
             }
             BREAK_ON_READ_ERROR(reader);
 
+            if (fPictureData->isLazy() && this->cullLazy(canvas, dst, paint)) {
+                break;
+            }
+            const SkImage* image = fPictureData->image(imageIndex);
             canvas->legacy_drawImageRect(image, src, dst, paint, constraint);
         } break;
         case DRAW_IMAGE_SET: {
@@ -492,18 +534,20 @@ void SkPicturePlayback::handleOp(SkReadBuffer* reader,
         } break;
         case DRAW_TEXT_BLOB: {
             const SkPaint* paint = fPictureData->getPaint(reader);
-            const SkTextBlob* blob = fPictureData->getTextBlob(reader);
+            const int blob = fPictureData->readTextBlobIndex(reader);
             SkScalar x = reader->readScalar();
             SkScalar y = reader->readScalar();
             BREAK_ON_READ_ERROR(reader);
 
-            if (paint) {
-                canvas->drawTextBlob(blob, x, y, *paint);
+            SkRect bounds;
+            if (paint && !(fPictureData->lazyTextBlobBounds(blob, &bounds) &&
+                           this->cullLazy(canvas, bounds.makeOffset(x, y), paint))) {
+                canvas->drawTextBlob(fPictureData->textBlob(blob), x, y, *paint);
             }
         } break;
         case DRAW_VERTICES_OBJECT: {
             const SkPaint* paint = fPictureData->getPaint(reader);
-            const SkVertices* vertices = fPictureData->getVertices(reader);
+            const int verticesIndex = fPictureData->readVerticesIndex(reader);
             const int boneCount = reader->readInt();
             const SkVertices::Bone* bones = boneCount ?
                     (const SkVertices::Bone*) reader->skip(boneCount, sizeof(SkVertices::Bone)) :
@@ -511,7 +555,14 @@ void SkPicturePlayback::handleOp(SkReadBuffer* reader,
             SkBlendMode bmode = reader->read32LE(SkBlendMode::kLastMode);
             BREAK_ON_READ_ERROR(reader);
 
-            if (paint && vertices) {
+            // Bones move the vertices, so only unboned vertices can be culled by their bounds.
+            SkRect bounds;
+            if (!paint || (boneCount == 0 &&
+                           fPictureData->lazyVerticesBounds(verticesIndex, &bounds) &&
+                           this->cullLazy(canvas, bounds, paint))) {
+                break;
+            }
+            if (const SkVertices* vertices = fPictureData->vertices(verticesIndex)) {
                 canvas->drawVertices(vertices, bones, boneCount, bmode, *paint);
             }
         } break;
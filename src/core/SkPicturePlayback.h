@@ -14,17 +14,24 @@ class SkBitmap;
 class SkCanvas;
 class SkPaint;
 class SkPictureData;
+struct SkRect;
 
 // The basic picture playback class replays the provided picture into a canvas.
 class SkPicturePlayback final : SkNoncopyable {
 public:
-    SkPicturePlayback(const SkPictureData* data)
+    // If cullLazyPayloads is true, draws of images, text blobs and vertices that data hasn't
+    // decoded yet are skipped, without decoding them, when the canvas would reject them.
+    SkPicturePlayback(const SkPictureData* data, bool cullLazyPayloads = false)
         : fPictureData(data)
-        , fCurOffset(0) {
+        , fCurOffset(0)
+        , fCullLazyPayloads(cullLazyPayloads) {
     }
 
     void draw(SkCanvas* canvas, SkPicture::AbortCallback*, SkReadBuffer* buffer);
 
+    // Returns the number of ops in opData, or -1 if they're invalid or don't record their sizes.
+    static int CountOps(const SkData& opData);
+
     // TODO: remove the curOp calls after cleaning up GrGatherDevice
     // Return the ID of the operation currently being executed when playing
     // back. 0 indicates no call is active.
@@ -45,6 +52,9 @@ protected:
 
     static DrawType ReadOpAndSize(SkReadBuffer* reader, uint32_t* size);
 
+    // Returns true if a lazy payload's draw into bounds (empty if unknown) can be skipped.
+    bool cullLazy(SkCanvas*, const SkRect& bounds, const SkPaint*) const;
+
     class AutoResetOpID {
     public:
         AutoResetOpID(SkPicturePlayback* playback) : fPlayback(playback) { }
@@ -59,6 +69,8 @@ protected:
     };
 
 private:
+    const bool fCullLazyPayloads;
+
     typedef SkNoncopyable INHERITED;
 };
 
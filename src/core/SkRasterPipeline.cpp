@@ -8,6 +8,44 @@
 #include "SkRasterPipeline.h"
 #include "SkOpts.h"
 #include <algorithm>
+#include <atomic>
+
+#if !defined(SK_RASTER_PIPELINE_COUNT_LOWP_FALLBACKS)
+    #if defined(SK_DEBUG)
+        #define SK_RASTER_PIPELINE_COUNT_LOWP_FALLBACKS 1
+    #else
+        #define SK_RASTER_PIPELINE_COUNT_LOWP_FALLBACKS 0
+    #endif
+#endif
+
+#if SK_RASTER_PIPELINE_COUNT_LOWP_FALLBACKS
+    static std::atomic<int> gLowpFallbacks[SkRasterPipeline::kNumStockStages];
+    static std::atomic<int> gLowpRawFallbacks{0};
+#endif
+
+SkRasterPipeline::LowpFallbacks SkRasterPipeline::GetLowpFallbacks() {
+    LowpFallbacks counts = {};
+#if SK_RASTER_PIPELINE_COUNT_LOWP_FALLBACKS
+    for (int i = 0; i < kNumStockStages; i++) {
+        counts.stages[i] = gLowpFallbacks[i].load(std::memory_order_relaxed);
+    }
+    counts.rawFunctions = gLowpRawFallbacks.load(std::memory_order_relaxed);
+#endif
+    return counts;
+}
+
+void SkRasterPipeline::ResetLowpFallbacks() {
+#if SK_RASTER_PIPELINE_COUNT_LOWP_FALLBACKS
+    for (auto& count : gLowpFallbacks) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    gLowpRawFallbacks.store(0, std::memory_order_relaxed);
+#endif
+}
+
+bool SkRasterPipeline::CountsLowpFallbacks() {
+    return SK_RASTER_PIPELINE_COUNT_LOWP_FALLBACKS;
+}
 
 SkRasterPipeline::SkRasterPipeline(SkArenaAlloc* alloc) : fAlloc(alloc) {
     this->reset();
@@ -273,6 +311,13 @@ SkRasterPipeline::StartPipelineFn SkRasterPipeline::build_pipeline(void** ip) co
             }
             *--ip = (void*)fn;
         } else {
+        #if SK_RASTER_PIPELINE_COUNT_LOWP_FALLBACKS
+            if (st->rawFunction) {
+                gLowpRawFallbacks.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                gLowpFallbacks[st->stage].fetch_add(1, std::memory_order_relaxed);
+            }
+        #endif
             ip = reset_point;
             break;
         }
@@ -295,6 +340,37 @@ SkRasterPipeline::StartPipelineFn SkRasterPipeline::build_pipeline(void** ip) co
     return SkOpts::start_pipeline_highp;
 }
 
+sk_sp<SkRasterPipelineJIT::Program> SkRasterPipeline::jit(void*** ctxs) const {
+    if (fNumStages > SkRasterPipelineJIT::kMaxStages) {
+        return nullptr;
+    }
+
+    // Like build_pipeline(), we walk fStages back to front.
+    uint32_t ops[SkRasterPipelineJIT::kMaxStages];
+    int op = fNumStages,
+        numCtxs = 0;
+    for (const StageList* st = fStages; st; st = st->prev) {
+        if (st->rawFunction) {
+            return nullptr;
+        }
+        ops[--op] = (uint32_t)(st->stage << 1) | (st->ctx ? 1 : 0);
+        numCtxs += st->ctx ? 1 : 0;
+    }
+
+    auto program = SkRasterPipelineJIT::Find(ops, fNumStages);
+    if (!program) {
+        return nullptr;
+    }
+    // compile() can't free what it allocates from fAlloc, so only allocate for a hit.
+    *ctxs = fAlloc->makeArray<void*>(numCtxs);
+    for (const StageList* st = fStages; st; st = st->prev) {
+        if (st->ctx) {
+            (*ctxs)[--numCtxs] = st->ctx;
+        }
+    }
+    return program;
+}
+
 void SkRasterPipeline::run(size_t x, size_t y, size_t w, size_t h) const {
     if (this->empty()) {
         return;
@@ -312,6 +388,15 @@ std::function<void(size_t, size_t, size_t, size_t)> SkRasterPipeline::compile()
         return [](size_t, size_t, size_t, size_t) {};
     }
 
+    if (SkRasterPipelineJIT::Enabled()) {
+        void** ctxs;
+        if (auto program = this->jit(&ctxs)) {
+            return [=](size_t x, size_t y, size_t w, size_t h) {
+                program->run(x,y,x+w,y+h, ctxs);
+            };
+        }
+    }
+
     void** program = fAlloc->makeArray<void*>(fSlotsNeeded);
 
     auto start_pipeline = this->build_pipeline(program + fSlotsNeeded);
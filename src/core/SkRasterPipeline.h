@@ -12,6 +12,7 @@
 #include "SkColor.h"
 #include "SkImageInfo.h"
 #include "SkNx.h"
+#include "SkRasterPipelineJIT.h"
 #include "SkTArray.h" // TODO: unused
 #include "SkTypes.h"
 #include <functional>
@@ -98,6 +99,10 @@
 // The largest number of pixels we handle at a time.
 static const int SkRasterPipeline_kMaxStride = 16;
 
+// Lowp handles up to 32 pixels at a time with AVX-512, so only the contexts that lowp stages
+// keep per-pixel state in are sized for that.
+static const int SkRasterPipeline_kMaxLowpStride = 32;
+
 // Structs representing the arguments to some common stages.
 
 struct SkRasterPipeline_MemoryCtx {
@@ -114,12 +119,14 @@ struct SkRasterPipeline_GatherCtx {
 
 // State shared by save_xy, accumulate, and bilinear_* / bicubic_*.
 struct SkRasterPipeline_SamplerCtx {
-    float      x[SkRasterPipeline_kMaxStride];
-    float      y[SkRasterPipeline_kMaxStride];
-    float     fx[SkRasterPipeline_kMaxStride];
-    float     fy[SkRasterPipeline_kMaxStride];
-    float scalex[SkRasterPipeline_kMaxStride];
-    float scaley[SkRasterPipeline_kMaxStride];
+    float      x[SkRasterPipeline_kMaxLowpStride];
+    float      y[SkRasterPipeline_kMaxLowpStride];
+    float     fx[SkRasterPipeline_kMaxLowpStride];
+    float     fy[SkRasterPipeline_kMaxLowpStride];
+    float scalex[SkRasterPipeline_kMaxLowpStride];
+    float scaley[SkRasterPipeline_kMaxLowpStride];
+
+    uint16_t lowp_sums[4][SkRasterPipeline_kMaxLowpStride];  // Only used by lowp accumulate.
 };
 
 struct SkRasterPipeline_TileCtx {
@@ -128,7 +135,7 @@ struct SkRasterPipeline_TileCtx {
 };
 
 struct SkRasterPipeline_DecalTileCtx {
-    uint32_t mask[SkRasterPipeline_kMaxStride];
+    uint32_t mask[SkRasterPipeline_kMaxLowpStride];
     float    limit_x;
     float    limit_y;
 };
@@ -191,6 +198,10 @@ public:
         SK_RASTER_PIPELINE_STAGES(M)
     #undef M
     };
+    static constexpr int kNumStockStages = 0
+    #define M(stage) + 1
+        SK_RASTER_PIPELINE_STAGES(M);
+    #undef M
     void append(StockStage, void* = nullptr);
     void append(StockStage stage, const void* ctx) { this->append(stage, const_cast<void*>(ctx)); }
     // For raw functions (i.e. from a JIT).  Don't use this unless you know exactly what fn needs to
@@ -208,6 +219,20 @@ public:
 
     void dump() const;
 
+    // Pipelines run in lowp when every stage has a lowp implementation, and otherwise fall back
+    // to highp.  These counters record, per stage, how often that stage forced the fallback
+    // since the last reset.  Raw functions are always highp, so they are counted separately.
+    // Counting costs an atomic increment per fallback, so it is only compiled into debug builds,
+    // or builds defining SK_RASTER_PIPELINE_COUNT_LOWP_FALLBACKS=1; otherwise the counts stay 0.
+    struct LowpFallbacks {
+        int stages[kNumStockStages];
+        int rawFunctions;
+    };
+    static LowpFallbacks GetLowpFallbacks();
+    static void ResetLowpFallbacks();
+    // Whether this build counts fallbacks at all.
+    static bool CountsLowpFallbacks();
+
     // Appends a stage for the specified matrix.
     // Tries to optimize the stage by analyzing the type of matrix.
     void append_matrix(SkArenaAlloc*, const SkMatrix&);
@@ -247,6 +272,10 @@ private:
     using StartPipelineFn = void(*)(size_t,size_t,size_t,size_t, void** program);
     StartPipelineFn build_pipeline(void**) const;
 
+    // Looks up a fused program for this pipeline.  If there is one, allocates an array of its
+    // stage contexts from fAlloc and points ctxs at it.
+    sk_sp<SkRasterPipelineJIT::Program> jit(void*** ctxs) const;
+
     void unchecked_append(StockStage, void*);
 
     // Used by old single-program void** style execution.
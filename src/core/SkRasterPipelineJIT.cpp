@@ -0,0 +1,747 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkRasterPipelineJIT.h"
+
+#include "SkLRUCache.h"
+#include "SkMutex.h"
+#include "SkOpts.h"
+#include "SkTArray.h"
+
+#include <atomic>
+
+#ifdef SK_LLVM_AVAILABLE
+
+#include "SkCpu.h"
+#include "SkRasterPipeline.h"
+
+#include "llvm-c/Analysis.h"
+#include "llvm-c/Core.h"
+#include "llvm-c/ExecutionEngine.h"
+#include "llvm-c/OrcBindings.h"
+#include "llvm-c/Support.h"
+#include "llvm-c/Target.h"
+#include "llvm-c/Transforms/PassManagerBuilder.h"
+
+#include <stddef.h>
+
+#endif//SK_LLVM_AVAILABLE
+
+namespace {
+
+// One-off pipelines aren't worth the compile, so we only compile a stage list once we've seen
+// it this many times.  Until then (and forever, if it can't be fused) it runs through SkOpts.
+static constexpr int kCompileAfter = 8;
+
+struct Key {
+    SkSTArray<16, uint32_t, true> fOps;
+
+    bool operator==(const Key& that) const {
+        return fOps.count() == that.fOps.count()
+            && 0 == memcmp(fOps.begin(), that.fOps.begin(), fOps.count() * sizeof(uint32_t));
+    }
+};
+
+struct KeyHash {
+    uint32_t operator()(const Key& key) const {
+        return SkOpts::hash_fn(key.fOps.begin(), key.fOps.count() * sizeof(uint32_t), 0);
+    }
+};
+
+struct CacheEntry {
+    int                                  fSeen = 0;
+    bool                                 fUnsupported = false;
+    sk_sp<SkRasterPipelineJIT::Program>  fProgram;
+};
+
+#ifdef SK_LLVM_AVAILABLE
+
+struct Compiled {
+    SkRasterPipelineJIT::Fn fFn;
+    uint64_t                fHandle;
+};
+
+// Generates IR for one pipeline.  The function runs the pipeline over a rect, fWidth pixels at
+// a time with LLVM vectors, then one pixel at a time for the rest of each row.
+class PipelineBuilder {
+public:
+    PipelineBuilder(LLVMContextRef context, LLVMModuleRef module, int width)
+        : fContext(context)
+        , fModule(module)
+        , fWidth(width)
+        , fBuilder(LLVMCreateBuilderInContext(context)) {
+        fVoidType  = LLVMVoidTypeInContext(context);
+        fInt8Type  = LLVMInt8TypeInContext(context);
+        fInt32Type = LLVMInt32TypeInContext(context);
+        fInt64Type = LLVMInt64TypeInContext(context);
+        fFloatType = LLVMFloatTypeInContext(context);
+        fInt8PtrType = LLVMPointerType(fInt8Type, 0);
+    }
+
+    ~PipelineBuilder() { LLVMDisposeBuilder(fBuilder); }
+
+    static bool CanFuse(uint32_t op);
+
+    bool build(const uint32_t ops[], int count, const char* name);
+
+private:
+    // The pipeline's registers for the pixels we're working on, at the current width.
+    struct Registers {
+        LLVMValueRef r, g, b, a, dr, dg, db, da;
+    };
+
+    LLVMTypeRef floatType() const {
+        return fLanes == 1 ? fFloatType : LLVMVectorType(fFloatType, fLanes);
+    }
+    LLVMTypeRef intType(LLVMTypeRef scalar) const {
+        return fLanes == 1 ? scalar : LLVMVectorType(scalar, fLanes);
+    }
+
+    LLVMValueRef splat(LLVMValueRef scalar) {
+        if (fLanes == 1) {
+            return scalar;
+        }
+        LLVMTypeRef vecType = LLVMVectorType(LLVMTypeOf(scalar), fLanes);
+        LLVMValueRef v = LLVMBuildInsertElement(fBuilder, LLVMGetUndef(vecType), scalar,
+                                                LLVMConstInt(fInt32Type, 0, false), "");
+        LLVMValueRef zeros = LLVMConstNull(LLVMVectorType(fInt32Type, fLanes));
+        return LLVMBuildShuffleVector(fBuilder, v, LLVMGetUndef(vecType), zeros, "");
+    }
+    LLVMValueRef constF(float f) {
+        LLVMValueRef c = LLVMConstReal(fFloatType, f);
+        if (fLanes == 1) {
+            return c;
+        }
+        SkSTArray<16, LLVMValueRef, true> lanes;
+        for (int i = 0; i < fLanes; i++) {
+            lanes.push_back(c);
+        }
+        return LLVMConstVector(lanes.begin(), fLanes);
+    }
+    LLVMValueRef constI(LLVMTypeRef scalar, uint64_t v) {
+        LLVMValueRef c = LLVMConstInt(scalar, v, false);
+        if (fLanes == 1) {
+            return c;
+        }
+        SkSTArray<16, LLVMValueRef, true> lanes;
+        for (int i = 0; i < fLanes; i++) {
+            lanes.push_back(c);
+        }
+        return LLVMConstVector(lanes.begin(), fLanes);
+    }
+
+    LLVMValueRef add(LLVMValueRef x, LLVMValueRef y) { return LLVMBuildFAdd(fBuilder, x, y, ""); }
+    LLVMValueRef sub(LLVMValueRef x, LLVMValueRef y) { return LLVMBuildFSub(fBuilder, x, y, ""); }
+    LLVMValueRef mul(LLVMValueRef x, LLVMValueRef y) { return LLVMBuildFMul(fBuilder, x, y, ""); }
+    LLVMValueRef inv(LLVMValueRef x) { return this->sub(this->constF(1), x); }
+    // Like the SkOpts stages, these return the second argument when the first is NaN.
+    LLVMValueRef min(LLVMValueRef x, LLVMValueRef y) {
+        return LLVMBuildSelect(fBuilder, LLVMBuildFCmp(fBuilder, LLVMRealOLT, x, y, ""), x, y, "");
+    }
+    LLVMValueRef max(LLVMValueRef x, LLVMValueRef y) {
+        return LLVMBuildSelect(fBuilder, LLVMBuildFCmp(fBuilder, LLVMRealOGT, x, y, ""), x, y, "");
+    }
+    LLVMValueRef lerp(LLVMValueRef from, LLVMValueRef to, LLVMValueRef t) {
+        return this->add(this->mul(this->sub(to, from), t), from);
+    }
+
+    LLVMValueRef loadScalar(LLVMValueRef ctx, size_t offset, LLVMTypeRef type) {
+        LLVMValueRef index = LLVMConstInt(fInt64Type, offset, false);
+        LLVMValueRef ptr = LLVMBuildGEP(fBuilder, ctx, &index, 1, "");
+        ptr = LLVMBuildBitCast(fBuilder, ptr, LLVMPointerType(type, 0), "");
+        return LLVMBuildLoad(fBuilder, ptr, "");
+    }
+
+    // Address of pixel (x,y) in an SkRasterPipeline_MemoryCtx of bpp-byte pixels.
+    LLVMValueRef pixelAddress(LLVMValueRef ctx, int bpp) {
+        LLVMValueRef pixels = this->loadScalar(ctx, offsetof(SkRasterPipeline_MemoryCtx, pixels),
+                                               fInt8PtrType);
+        LLVMValueRef stride = this->loadScalar(ctx, offsetof(SkRasterPipeline_MemoryCtx, stride),
+                                               fInt32Type);
+        stride = LLVMBuildSExt(fBuilder, stride, fInt64Type, "");
+        LLVMValueRef index = LLVMBuildAdd(fBuilder,
+                                          LLVMBuildMul(fBuilder, fY, stride, ""), fX, "");
+        index = LLVMBuildMul(fBuilder, index, LLVMConstInt(fInt64Type, bpp, false), "");
+        return LLVMBuildGEP(fBuilder, pixels, &index, 1, "");
+    }
+    LLVMValueRef loadPixels(LLVMValueRef ctx, LLVMTypeRef scalar, int bpp) {
+        LLVMValueRef ptr = LLVMBuildBitCast(fBuilder, this->pixelAddress(ctx, bpp),
+                                            LLVMPointerType(this->intType(scalar), 0), "");
+        LLVMValueRef load = LLVMBuildLoad(fBuilder, ptr, "");
+        LLVMSetAlignment(load, bpp);
+        return load;
+    }
+    void storePixels(LLVMValueRef ctx, LLVMValueRef px, int bpp) {
+        LLVMValueRef ptr = LLVMBuildBitCast(fBuilder, this->pixelAddress(ctx, bpp),
+                                            LLVMPointerType(LLVMTypeOf(px), 0), "");
+        LLVMSetAlignment(LLVMBuildStore(fBuilder, px, ptr), bpp);
+    }
+
+    LLVMValueRef fromByte(LLVMValueRef bytes) {
+        LLVMValueRef f = LLVMBuildUIToFP(fBuilder, bytes, this->floatType(), "");
+        return this->mul(f, this->constF(1/255.0f));
+    }
+    LLVMValueRef channel8888(LLVMValueRef px, int shift) {
+        px = LLVMBuildLShr(fBuilder, px, this->constI(fInt32Type, shift), "");
+        px = LLVMBuildAnd(fBuilder, px, this->constI(fInt32Type, 0xff), "");
+        return this->fromByte(px);
+    }
+    // Matches to_unorm(v, 255) in the portable SkOpts stages.
+    LLVMValueRef toUnorm(LLVMValueRef v) {
+        v = this->min(this->max(v, this->constF(0)), this->constF(1));
+        v = this->add(this->mul(v, this->constF(255)), this->constF(0.5f));
+        return LLVMBuildFPToUI(fBuilder, v, this->intType(fInt32Type), "");
+    }
+
+    void blend(uint32_t stage, Registers* regs);
+    void emitStage(uint32_t stage, LLVMValueRef ctx, Registers* regs);
+    void emitPixels(int lanes, const uint32_t ops[], int count, LLVMValueRef ctxs[]);
+
+    LLVMContextRef fContext;
+    LLVMModuleRef  fModule;
+    int            fWidth;
+    int            fLanes = 1;
+    LLVMBuilderRef fBuilder;
+    LLVMValueRef   fX = nullptr;
+    LLVMValueRef   fY = nullptr;
+
+    LLVMTypeRef fVoidType;
+    LLVMTypeRef fInt8Type;
+    LLVMTypeRef fInt32Type;
+    LLVMTypeRef fInt64Type;
+    LLVMTypeRef fFloatType;
+    LLVMTypeRef fInt8PtrType;
+};
+
+#define SK_JIT_BLEND_STAGES(M) \
+    M(clear) M(srcatop) M(dstatop) M(srcin) M(dstin) M(srcout) M(dstout) M(srcover) \
+    M(dstover) M(modulate) M(multiply) M(plus_) M(screen) M(xor_)
+
+#define SK_JIT_STAGES(M) \
+    M(seed_shader) M(uniform_color) M(black_color) M(white_color) \
+    M(load_8888) M(load_8888_dst) M(store_8888) M(load_a8) M(load_a8_dst) M(store_a8) \
+    M(scale_1_float) M(scale_u8) M(lerp_1_float) M(lerp_u8) \
+    M(clamp_0) M(clamp_1) M(clamp_a) M(clamp_a_dst) M(swap_rb) \
+    M(move_src_dst) M(move_dst_src) M(premul) M(premul_dst) \
+    SK_JIT_BLEND_STAGES(M)
+
+bool PipelineBuilder::CanFuse(uint32_t stage) {
+    switch (stage) {
+    #define M(st) case SkRasterPipeline::st:
+        SK_JIT_STAGES(M)
+    #undef M
+            return true;
+        default:
+            return false;
+    }
+}
+
+void PipelineBuilder::blend(uint32_t stage, Registers* regs) {
+    // Each channel blends against the source and destination alpha from before the blend.
+    const LLVMValueRef sa = regs->a,
+                       da = regs->da;
+    auto channel = [&](LLVMValueRef s, LLVMValueRef d) -> LLVMValueRef {
+        switch (stage) {
+            case SkRasterPipeline::clear:    return this->constF(0);
+            case SkRasterPipeline::srcatop:  return this->add(this->mul(s, da),
+                                                              this->mul(d, this->inv(sa)));
+            case SkRasterPipeline::dstatop:  return this->add(this->mul(d, sa),
+                                                              this->mul(s, this->inv(da)));
+            case SkRasterPipeline::srcin:    return this->mul(s, da);
+            case SkRasterPipeline::dstin:    return this->mul(d, sa);
+            case SkRasterPipeline::srcout:   return this->mul(s, this->inv(da));
+            case SkRasterPipeline::dstout:   return this->mul(d, this->inv(sa));
+            case SkRasterPipeline::srcover:  return this->add(this->mul(d, this->inv(sa)), s);
+            case SkRasterPipeline::dstover:  return this->add(this->mul(s, this->inv(da)), d);
+            case SkRasterPipeline::modulate: return this->mul(s, d);
+            case SkRasterPipeline::multiply: return this->add(
+                                                    this->add(this->mul(s, this->inv(da)),
+                                                              this->mul(d, this->inv(sa))),
+                                                    this->mul(s, d));
+            case SkRasterPipeline::plus_:    return this->min(this->add(s, d), this->constF(1));
+            case SkRasterPipeline::screen:   return this->sub(this->add(s, d), this->mul(s, d));
+            case SkRasterPipeline::xor_:     return this->add(this->mul(s, this->inv(da)),
+                                                              this->mul(d, this->inv(sa)));
+        }
+        SkASSERT(false);
+        return s;
+    };
+    regs->r = channel(regs->r, regs->dr);
+    regs->g = channel(regs->g, regs->dg);
+    regs->b = channel(regs->b, regs->db);
+    regs->a = channel(regs->a, regs->da);
+}
+
+void PipelineBuilder::emitStage(uint32_t stage, LLVMValueRef ctx, Registers* regs) {
+    using Uniform = SkRasterPipeline_UniformColorCtx;
+
+    switch (stage) {
+        case SkRasterPipeline::seed_shader: {
+            LLVMValueRef x = LLVMBuildUIToFP(fBuilder, fX, fFloatType, ""),
+                         y = LLVMBuildUIToFP(fBuilder, fY, fFloatType, "");
+            LLVMValueRef iota = this->constF(0.5f);
+            if (fLanes > 1) {
+                SkSTArray<16, LLVMValueRef, true> lanes;
+                for (int i = 0; i < fLanes; i++) {
+                    lanes.push_back(LLVMConstReal(fFloatType, i + 0.5f));
+                }
+                iota = LLVMConstVector(lanes.begin(), fLanes);
+            }
+            regs->r = this->add(this->splat(x), iota);
+            regs->g = this->add(this->splat(y), this->constF(0.5f));
+            regs->b = this->constF(1);
+            regs->a = regs->dr = regs->dg = regs->db = regs->da = this->constF(0);
+        } break;
+
+        case SkRasterPipeline::uniform_color:
+            regs->r = this->splat(this->loadScalar(ctx, offsetof(Uniform, r), fFloatType));
+            regs->g = this->splat(this->loadScalar(ctx, offsetof(Uniform, g), fFloatType));
+            regs->b = this->splat(this->loadScalar(ctx, offsetof(Uniform, b), fFloatType));
+            regs->a = this->splat(this->loadScalar(ctx, offsetof(Uniform, a), fFloatType));
+            break;
+        case SkRasterPipeline::black_color:
+            regs->r = regs->g = regs->b = this->constF(0);
+            regs->a = this->constF(1);
+            break;
+        case SkRasterPipeline::white_color:
+            regs->r = regs->g = regs->b = regs->a = this->constF(1);
+            break;
+
+        case SkRasterPipeline::load_8888:
+        case SkRasterPipeline::load_8888_dst: {
+            LLVMValueRef px = this->loadPixels(ctx, fInt32Type, 4);
+            LLVMValueRef r = this->channel8888(px,  0),
+                         g = this->channel8888(px,  8),
+                         b = this->channel8888(px, 16),
+                         a = this->channel8888(px, 24);
+            if (stage == SkRasterPipeline::load_8888) {
+                regs->r = r; regs->g = g; regs->b = b; regs->a = a;
+            } else {
+                regs->dr = r; regs->dg = g; regs->db = b; regs->da = a;
+            }
+        } break;
+        case SkRasterPipeline::store_8888: {
+            auto shl = [&](LLVMValueRef v, int shift) {
+                return LLVMBuildShl(fBuilder, v, this->constI(fInt32Type, shift), "");
+            };
+            LLVMValueRef px = this->toUnorm(regs->r);
+            px = LLVMBuildOr(fBuilder, px, shl(this->toUnorm(regs->g),  8), "");
+            px = LLVMBuildOr(fBuilder, px, shl(this->toUnorm(regs->b), 16), "");
+            px = LLVMBuildOr(fBuilder, px, shl(this->toUnorm(regs->a), 24), "");
+            this->storePixels(ctx, px, 4);
+        } break;
+
+        case SkRasterPipeline::load_a8:
+        case SkRasterPipeline::load_a8_dst: {
+            LLVMValueRef a = this->fromByte(this->loadPixels(ctx, fInt8Type, 1));
+            if (stage == SkRasterPipeline::load_a8) {
+                regs->r = regs->g = regs->b = this->constF(0);
+                regs->a = a;
+            } else {
+                regs->dr = regs->dg = regs->db = this->constF(0);
+                regs->da = a;
+            }
+        } break;
+        case SkRasterPipeline::store_a8:
+            this->storePixels(ctx, LLVMBuildTrunc(fBuilder, this->toUnorm(regs->a),
+                                                  this->intType(fInt8Type), ""), 1);
+            break;
+
+        case SkRasterPipeline::scale_1_float:
+        case SkRasterPipeline::scale_u8: {
+            LLVMValueRef c = stage == SkRasterPipeline::scale_1_float
+                           ? this->splat(this->loadScalar(ctx, 0, fFloatType))
+                           : this->fromByte(this->loadPixels(ctx, fInt8Type, 1));
+            regs->r = this->mul(regs->r, c);
+            regs->g = this->mul(regs->g, c);
+            regs->b = this->mul(regs->b, c);
+            regs->a = this->mul(regs->a, c);
+        } break;
+        case SkRasterPipeline::lerp_1_float:
+        case SkRasterPipeline::lerp_u8: {
+            LLVMValueRef c = stage == SkRasterPipeline::lerp_1_float
+                           ? this->splat(this->loadScalar(ctx, 0, fFloatType))
+                           : this->fromByte(this->loadPixels(ctx, fInt8Type, 1));
+            regs->r = this->lerp(regs->dr, regs->r, c);
+            regs->g = this->lerp(regs->dg, regs->g, c);
+            regs->b = this->lerp(regs->db, regs->b, c);
+            regs->a = this->lerp(regs->da, regs->a, c);
+        } break;
+
+        case SkRasterPipeline::clamp_0:
+            regs->r = this->max(regs->r, this->constF(0));
+            regs->g = this->max(regs->g, this->constF(0));
+            regs->b = this->max(regs->b, this->constF(0));
+            regs->a = this->max(regs->a, this->constF(0));
+            break;
+        case SkRasterPipeline::clamp_1:
+            regs->r = this->min(regs->r, this->constF(1));
+            regs->g = this->min(regs->g, this->constF(1));
+            regs->b = this->min(regs->b, this->constF(1));
+            regs->a = this->min(regs->a, this->constF(1));
+            break;
+        case SkRasterPipeline::clamp_a:
+            regs->a = this->min(regs->a, this->constF(1));
+            regs->r = this->min(regs->r, regs->a);
+            regs->g = this->min(regs->g, regs->a);
+            regs->b = this->min(regs->b, regs->a);
+            break;
+        case SkRasterPipeline::clamp_a_dst:
+            regs->da = this->min(regs->da, this->constF(1));
+            regs->dr = this->min(regs->dr, regs->da);
+            regs->dg = this->min(regs->dg, regs->da);
+            regs->db = this->min(regs->db, regs->da);
+            break;
+
+        case SkRasterPipeline::swap_rb:
+            std::swap(regs->r, regs->b);
+            break;
+        case SkRasterPipeline::move_src_dst:
+            regs->dr = regs->r; regs->dg = regs->g; regs->db = regs->b; regs->da = regs->a;
+            break;
+        case SkRasterPipeline::move_dst_src:
+            regs->r = regs->dr; regs->g = regs->dg; regs->b = regs->db; regs->a = regs->da;
+            break;
+        case SkRasterPipeline::premul:
+            regs->r = this->mul(regs->r, regs->a);
+            regs->g = this->mul(regs->g, regs->a);
+            regs->b = this->mul(regs->b, regs->a);
+            break;
+        case SkRasterPipeline::premul_dst:
+            regs->dr = this->mul(regs->dr, regs->da);
+            regs->dg = this->mul(regs->dg, regs->da);
+            regs->db = this->mul(regs->db, regs->da);
+            break;
+
+    #define M(st) case SkRasterPipeline::st:
+        SK_JIT_BLEND_STAGES(M)
+    #undef M
+            this->blend(stage, regs);
+            break;
+
+        default:
+            SkASSERT(false);  // CanFuse() should have rejected this pipeline.
+            break;
+    }
+}
+
+void PipelineBuilder::emitPixels(int lanes, const uint32_t ops[], int count,
+                                 LLVMValueRef ctxs[]) {
+    fLanes = lanes;
+    // Like start_pipeline(), all registers start at zero.
+    Registers regs;
+    regs.r = regs.g = regs.b = regs.a = regs.dr = regs.dg = regs.db = regs.da = this->constF(0);
+    for (int i = 0; i < count; i++) {
+        this->emitStage(ops[i] >> 1, ctxs[i], &regs);
+    }
+}
+
+bool PipelineBuilder::build(const uint32_t ops[], int count, const char* name) {
+    for (int i = 0; i < count; i++) {
+        if (!CanFuse(ops[i] >> 1)) {
+            return false;
+        }
+    }
+
+    LLVMTypeRef params[] = {
+        fInt64Type, fInt64Type, fInt64Type, fInt64Type, LLVMPointerType(fInt8PtrType, 0),
+    };
+    LLVMValueRef fn = LLVMAddFunction(fModule, name,
+                                      LLVMFunctionType(fVoidType, params, 5, false));
+    LLVMValueRef x0 = LLVMGetParam(fn, 0),
+                 y0 = LLVMGetParam(fn, 1),
+                 x1 = LLVMGetParam(fn, 2),
+                 y1 = LLVMGetParam(fn, 3),
+                 ctxArg = LLVMGetParam(fn, 4);
+
+    auto block = [&](const char* blockName) {
+        return LLVMAppendBasicBlockInContext(fContext, fn, blockName);
+    };
+    LLVMBasicBlockRef entry    = block("entry"),
+                      rowLoop  = block("row"),
+                      rowStart = block("row_start"),
+                      vecLoop  = block("vec"),
+                      vecBody  = block("vec_body"),
+                      tailLoop = block("tail"),
+                      tailBody = block("tail_body"),
+                      rowNext  = block("row_next"),
+                      done     = block("done");
+
+    // Load every stage's context up front; the program passes them packed, in order.
+    LLVMPositionBuilderAtEnd(fBuilder, entry);
+    SkSTArray<16, LLVMValueRef, true> ctxs;
+    int ctxIndex = 0;
+    for (int i = 0; i < count; i++) {
+        LLVMValueRef ctx = nullptr;
+        if (ops[i] & 1) {
+            LLVMValueRef index = LLVMConstInt(fInt64Type, ctxIndex++, false);
+            ctx = LLVMBuildLoad(fBuilder, LLVMBuildGEP(fBuilder, ctxArg, &index, 1, ""), "");
+        }
+        ctxs.push_back(ctx);
+    }
+    LLVMValueRef xVar = LLVMBuildAlloca(fBuilder, fInt64Type, "x"),
+                 yVar = LLVMBuildAlloca(fBuilder, fInt64Type, "y");
+    LLVMBuildStore(fBuilder, y0, yVar);
+    LLVMBuildBr(fBuilder, rowLoop);
+
+    // for (y = y0; y < y1; y++)
+    LLVMPositionBuilderAtEnd(fBuilder, rowLoop);
+    fY = LLVMBuildLoad(fBuilder, yVar, "");
+    LLVMBuildCondBr(fBuilder, LLVMBuildICmp(fBuilder, LLVMIntULT, fY, y1, ""), rowStart, done);
+
+    LLVMPositionBuilderAtEnd(fBuilder, rowStart);
+    LLVMBuildStore(fBuilder, x0, xVar);
+    LLVMBuildBr(fBuilder, vecLoop);
+
+    // while (x + fWidth <= x1) { ...fWidth pixels...; x += fWidth; }
+    LLVMPositionBuilderAtEnd(fBuilder, vecLoop);
+    fX = LLVMBuildLoad(fBuilder, xVar, "");
+    LLVMValueRef end = LLVMBuildAdd(fBuilder, fX, LLVMConstInt(fInt64Type, fWidth, false), "");
+    LLVMBuildCondBr(fBuilder, LLVMBuildICmp(fBuilder, LLVMIntULE, end, x1, ""),
+                    vecBody, tailLoop);
+
+    LLVMPositionBuilderAtEnd(fBuilder, vecBody);
+    fY = LLVMBuildLoad(fBuilder, yVar, "");
+    this->emitPixels(fWidth, ops, count, ctxs.begin());
+    LLVMBuildStore(fBuilder, end, xVar);
+    LLVMBuildBr(fBuilder, vecLoop);
+
+    // while (x < x1) { ...1 pixel...; x += 1; }
+    LLVMPositionBuilderAtEnd(fBuilder, tailLoop);
+    fX = LLVMBuildLoad(fBuilder, xVar, "");
+    LLVMBuildCondBr(fBuilder, LLVMBuildICmp(fBuilder, LLVMIntULT, fX, x1, ""), tailBody, rowNext);
+
+    LLVMPositionBuilderAtEnd(fBuilder, tailBody);
+    fY = LLVMBuildLoad(fBuilder, yVar, "");
+    this->emitPixels(1, ops, count, ctxs.begin());
+    LLVMBuildStore(fBuilder, LLVMBuildAdd(fBuilder, fX, LLVMConstInt(fInt64Type, 1, false), ""),
+                   xVar);
+    LLVMBuildBr(fBuilder, tailLoop);
+
+    LLVMPositionBuilderAtEnd(fBuilder, rowNext);
+    LLVMBuildStore(fBuilder, LLVMBuildAdd(fBuilder, LLVMBuildLoad(fBuilder, yVar, ""),
+                                          LLVMConstInt(fInt64Type, 1, false), ""),
+                   yVar);
+    LLVMBuildBr(fBuilder, rowLoop);
+
+    LLVMPositionBuilderAtEnd(fBuilder, done);
+    LLVMBuildRetVoid(fBuilder);
+
+    return !LLVMVerifyFunction(fn, LLVMReturnStatusAction);
+}
+
+// Owns the ORC stack that every program's code lives in.
+class Engine {
+public:
+    Engine() {
+        LLVMInitializeNativeTarget();
+        LLVMInitializeNativeAsmPrinter();
+        LLVMLinkInMCJIT();
+        if (SkCpu::Supports(SkCpu::SKX)) {
+            fWidth = 16;
+            fCPU = "skylake-avx512";
+        } else if (SkCpu::Supports(SkCpu::HSW)) {
+            fWidth = 8;
+            fCPU = "haswell";
+        } else if (SkCpu::Supports(SkCpu::AVX)) {
+            fWidth = 8;
+            fCPU = "ivybridge";
+        }
+        fContext = LLVMContextCreate();
+
+        char* triple = LLVMGetDefaultTargetTriple();
+        char* error = nullptr;
+        LLVMTargetRef target;
+        if (LLVMLoadLibraryPermanently(nullptr) ||
+            LLVMGetTargetFromTriple(triple, &target, &error) ||
+            !LLVMTargetHasJIT(target)) {
+            SkDebugf("SkRasterPipelineJIT: no JIT for %s. %s\n", triple, error ? error : "");
+            LLVMDisposeMessage(error);
+            LLVMDisposeMessage(triple);
+            return;
+        }
+        // The stack takes ownership of the target machine.
+        LLVMTargetMachineRef machine = LLVMCreateTargetMachine(target, triple, fCPU, nullptr,
+                                                               LLVMCodeGenLevelAggressive,
+                                                               LLVMRelocDefault,
+                                                               LLVMCodeModelJITDefault);
+        LLVMDisposeMessage(triple);
+        fDataLayout = LLVMCreateTargetDataLayout(machine);
+        fStack = LLVMOrcCreateInstance(machine);
+    }
+
+    // Returns a null fFn if the stage list can't be fused or compilation fails.
+    Compiled compile(const uint32_t ops[], int count) {
+        SkAutoExclusive lock(fMutex);
+        Compiled result = { nullptr, 0 };
+        if (!fStack) {
+            return result;
+        }
+
+        char name[32];
+        snprintf(name, sizeof(name), "sk_rp_%d", fNextID++);
+        LLVMModuleRef module = LLVMModuleCreateWithNameInContext(name, fContext);
+        LLVMSetModuleDataLayout(module, fDataLayout);
+        if (!PipelineBuilder(fContext, module, fWidth).build(ops, count, name)) {
+            LLVMDisposeModule(module);
+            return result;
+        }
+        this->optimize(module);
+
+        LLVMSharedModuleRef shared = LLVMOrcMakeSharedModule(module);
+        LLVMOrcModuleHandle handle;
+        LLVMOrcErrorCode err = LLVMOrcAddEagerlyCompiledIR(fStack, &handle, shared,
+                                                           &Engine::ResolveSymbol, nullptr);
+        LLVMOrcDisposeSharedModuleRef(shared);
+        if (err != LLVMOrcErrSuccess) {
+            return result;
+        }
+
+        char* mangled;
+        LLVMOrcGetMangledSymbol(fStack, &mangled, name);
+        LLVMOrcTargetAddress address = 0;
+        err = LLVMOrcGetSymbolAddress(fStack, &address, mangled);
+        LLVMOrcDisposeMangledSymbol(mangled);
+        if (err != LLVMOrcErrSuccess || !address) {
+            LLVMOrcRemoveModule(fStack, handle);
+            return result;
+        }
+        result.fFn = (SkRasterPipelineJIT::Fn)address;
+        result.fHandle = handle;
+        return result;
+    }
+
+    void release(uint64_t handle) {
+        SkAutoExclusive lock(fMutex);
+        LLVMOrcRemoveModule(fStack, handle);
+    }
+
+private:
+    // Our programs call nothing outside themselves.
+    static uint64_t ResolveSymbol(const char*, void*) { return 0; }
+
+    void optimize(LLVMModuleRef module) {
+        LLVMPassManagerBuilderRef pmb = LLVMPassManagerBuilderCreate();
+        LLVMPassManagerBuilderSetOptLevel(pmb, 3);
+        LLVMPassManagerRef functionPM = LLVMCreateFunctionPassManagerForModule(module);
+        LLVMPassManagerBuilderPopulateFunctionPassManager(pmb, functionPM);
+        LLVMPassManagerRef modulePM = LLVMCreatePassManager();
+        LLVMPassManagerBuilderPopulateModulePassManager(pmb, modulePM);
+
+        LLVMInitializeFunctionPassManager(functionPM);
+        for (LLVMValueRef fn = LLVMGetFirstFunction(module); fn; fn = LLVMGetNextFunction(fn)) {
+            LLVMRunFunctionPassManager(functionPM, fn);
+        }
+        LLVMFinalizeFunctionPassManager(functionPM);
+        LLVMRunPassManager(modulePM, module);
+
+        LLVMDisposePassManager(functionPM);
+        LLVMDisposePassManager(modulePM);
+        LLVMPassManagerBuilderDispose(pmb);
+    }
+
+    SkMutex            fMutex;  // Guards everything below, none of which is thread safe.
+    const char*        fCPU = nullptr;
+    int                fWidth = 4;
+    int                fNextID = 0;
+    LLVMContextRef     fContext;
+    LLVMTargetDataRef  fDataLayout = nullptr;
+    LLVMOrcJITStackRef fStack = nullptr;
+};
+
+static Engine* engine() {
+    static Engine* gEngine = new Engine;  // Never freed: programs may outlive static teardown.
+    return gEngine;
+}
+
+static bool can_fuse(uint32_t stage) { return PipelineBuilder::CanFuse(stage); }
+
+#else
+
+// Without LLVM nothing is fused: every stage list is a miss, and runs through SkOpts.
+static bool can_fuse(uint32_t) { return false; }
+
+#endif//SK_LLVM_AVAILABLE
+
+static std::atomic<bool> gEnabled{false};
+
+SK_DECLARE_STATIC_MUTEX(gCacheMutex);
+static SkLRUCache<Key, CacheEntry, KeyHash>* cache() {
+    static auto* gCache =
+            new SkLRUCache<Key, CacheEntry, KeyHash>(SkRasterPipelineJIT::kMaxPrograms);
+    return gCache;
+}
+
+}  // namespace
+
+#ifdef SK_LLVM_AVAILABLE
+SkRasterPipelineJIT::Program::~Program() {
+    engine()->release(fHandle);
+}
+#else
+SkRasterPipelineJIT::Program::~Program() {}
+#endif
+
+sk_sp<SkRasterPipelineJIT::Program> SkRasterPipelineJIT::Find(const uint32_t ops[], int count) {
+    if (!gEnabled.load(std::memory_order_relaxed) || count > kMaxStages) {
+        return nullptr;
+    }
+
+    Key key;
+    key.fOps.push_back_n(count, ops);
+
+    SkAutoExclusive lock(gCacheMutex);
+    CacheEntry* entry = cache()->find(key);
+    if (!entry) {
+        entry = cache()->insert(key, CacheEntry());
+        for (int i = 0; i < count; i++) {
+            if (!can_fuse(ops[i] >> 1)) {
+                entry->fUnsupported = true;
+                break;
+            }
+        }
+    }
+    if (entry->fSeen < kCompileAfter) {
+        entry->fSeen++;
+    }
+    if (entry->fProgram || entry->fUnsupported || entry->fSeen < kCompileAfter) {
+        return entry->fProgram;
+    }
+
+#ifdef SK_LLVM_AVAILABLE
+    // Compiling holds up other lookups, but it happens once per hot stage list.
+    Compiled compiled = engine()->compile(ops, count);
+    if (compiled.fFn) {
+        entry->fProgram.reset(new Program(compiled.fFn, compiled.fHandle));
+        return entry->fProgram;
+    }
+#endif
+    entry->fUnsupported = true;
+    return nullptr;
+}
+
+void SkRasterPipelineJIT::SetEnabled(bool enabled) {
+    gEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool SkRasterPipelineJIT::Enabled() {
+    return gEnabled.load(std::memory_order_relaxed);
+}
+
+void SkRasterPipelineJIT::PurgeAll() {
+    SkAutoExclusive lock(gCacheMutex);
+    cache()->reset();
+}
+
+int SkRasterPipelineJIT::SeenCount(const uint32_t ops[], int count) {
+    Key key;
+    key.fOps.push_back_n(count, ops);
+
+    SkAutoExclusive lock(gCacheMutex);
+    CacheEntry* entry = cache()->find(key);
+    return entry ? entry->fSeen : 0;
+}
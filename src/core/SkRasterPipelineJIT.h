@@ -0,0 +1,75 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkRasterPipelineJIT_DEFINED
+#define SkRasterPipelineJIT_DEFINED
+
+#include "SkRefCnt.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * SkRasterPipelineJIT fuses a whole SkRasterPipeline into a single loop of machine code with
+ * LLVM, removing the tail call between every stage.  It only fuses anything when the
+ * skia_llvm_path gn arg is set; otherwise stage lists are still counted and cached the same
+ * way, but every one is a miss and Find() always returns null.
+ *
+ * Programs are cached in an LRU keyed by the pipeline's stage list (each stage and whether it
+ * has a context).  The contexts themselves are passed in when the program runs, so every
+ * pipeline with the same stages shares one program.  A stage list is compiled only after it
+ * has been seen a few times, and any list containing a stage the JIT can't fuse (or a raw
+ * function) is remembered as a miss, leaving it to the SkOpts stages.
+ *
+ * The JIT is off until SetEnabled(true).  Fused programs work in floats like the highp stages,
+ * so their results may differ by one from pipelines SkOpts would run in lowp.  Only
+ * SkRasterPipeline::compile() consults it, once per compiled pipeline; run() never does.
+ */
+class SkRasterPipelineJIT {
+public:
+    // Runs the fused pipeline from (x,y) inclusive to (xlimit,ylimit) exclusive.  ctxs holds
+    // the context pointer for each stage that has one, in pipeline order.
+    using Fn = void(*)(size_t x, size_t y, size_t xlimit, size_t ylimit, void** ctxs);
+
+    class Program : public SkRefCnt {
+    public:
+        ~Program() override;
+
+        void run(size_t x, size_t y, size_t xlimit, size_t ylimit, void** ctxs) const {
+            fFn(x, y, xlimit, ylimit, ctxs);
+        }
+
+    private:
+        Program(Fn fn, uint64_t handle) : fFn(fn), fHandle(handle) {}
+
+        Fn       fFn;
+        uint64_t fHandle;  // Owned by the JIT; released when the last ref goes away.
+
+        friend class SkRasterPipelineJIT;
+    };
+
+    /**
+     * ops lists the pipeline's stages front to back, each encoded as (stage << 1 | hasCtx).
+     * Returns a program if one has been compiled, or null to run the pipeline normally.
+     */
+    static sk_sp<Program> Find(const uint32_t ops[], int count);
+
+    // Both are safe to call from any thread.
+    static void SetEnabled(bool);
+    static bool Enabled();
+
+    // Drops every cached program.  Programs still referenced stay alive until released.
+    static void PurgeAll();
+
+    // For tests: how many times (up to when it's compiled) Find() has looked up this stage list
+    // since it entered the cache, or 0 if it isn't cached.  This counts as a use of the entry.
+    static int SeenCount(const uint32_t ops[], int count);
+
+    static constexpr int kMaxStages   = 64;
+    static constexpr int kMaxPrograms = 256;  // How many stage lists the cache remembers.
+};
+
+#endif
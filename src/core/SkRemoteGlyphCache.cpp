@@ -16,6 +16,7 @@
 #include "SkDevice.h"
 #include "SkDraw.h"
 #include "SkGlyphRun.h"
+#include "SkGlyphSerialization.h"
 #include "SkRemoteGlyphCacheImpl.h"
 #include "SkStrike.h"
 #include "SkStrikeCache.h"
@@ -65,101 +66,6 @@ static const SkDescriptor* create_descriptor(
     return SkScalerContext::AutoDescriptorGivenRecAndEffects(rec, *effects, ad);
 }
 
-// -- Serializer ----------------------------------------------------------------------------------
-
-size_t pad(size_t size, size_t alignment) { return (size + (alignment - 1)) & ~(alignment - 1); }
-
-class Serializer {
-public:
-    Serializer(std::vector<uint8_t>* buffer) : fBuffer{buffer} { }
-
-    template <typename T, typename... Args>
-    T* emplace(Args&&... args) {
-        auto result = allocate(sizeof(T), alignof(T));
-        return new (result) T{std::forward<Args>(args)...};
-    }
-
-    template <typename T>
-    void write(const T& data) {
-        T* result = (T*)allocate(sizeof(T), alignof(T));
-        memcpy(result, &data, sizeof(T));
-    }
-
-    template <typename T>
-    T* allocate() {
-        T* result = (T*)allocate(sizeof(T), alignof(T));
-        return result;
-    }
-
-    void writeDescriptor(const SkDescriptor& desc) {
-        write(desc.getLength());
-        auto result = allocate(desc.getLength(), alignof(SkDescriptor));
-        memcpy(result, &desc, desc.getLength());
-    }
-
-    void* allocate(size_t size, size_t alignment) {
-        size_t aligned = pad(fBuffer->size(), alignment);
-        fBuffer->resize(aligned + size);
-        return &(*fBuffer)[aligned];
-    }
-
-private:
-    std::vector<uint8_t>* fBuffer;
-};
-
-// -- Deserializer -------------------------------------------------------------------------------
-// Note that the Deserializer is reading untrusted data, we need to guard against invalid data.
-class Deserializer {
-public:
-    Deserializer(const volatile char* memory, size_t memorySize)
-            : fMemory(memory), fMemorySize(memorySize) {}
-
-    template <typename T>
-    bool read(T* val) {
-        auto* result = this->ensureAtLeast(sizeof(T), alignof(T));
-        if (!result) return false;
-
-        memcpy(val, const_cast<const char*>(result), sizeof(T));
-        return true;
-    }
-
-    bool readDescriptor(SkAutoDescriptor* ad) {
-        uint32_t desc_length = 0u;
-        if (!read<uint32_t>(&desc_length)) return false;
-
-        auto* result = this->ensureAtLeast(desc_length, alignof(SkDescriptor));
-        if (!result) return false;
-
-        ad->reset(desc_length);
-        memcpy(ad->getDesc(), const_cast<const char*>(result), desc_length);
-        return true;
-    }
-
-    const volatile void* read(size_t size, size_t alignment) {
-      return this->ensureAtLeast(size, alignment);
-    }
-
-private:
-    const volatile char* ensureAtLeast(size_t size, size_t alignment) {
-        size_t padded = pad(fBytesRead, alignment);
-
-        // Not enough data
-        if (padded + size > fMemorySize) return nullptr;
-
-        auto* result = fMemory + padded;
-        fBytesRead = padded + size;
-        return result;
-    }
-
-    // Note that we read each piece of memory only once to guard against TOCTOU violations.
-    const volatile char* fMemory;
-    size_t fMemorySize;
-    size_t fBytesRead = 0u;
-};
-
-// Paths use a SkWriter32 which requires 4 byte alignment.
-static const size_t kPathAlignment  = 4u;
-
 bool read_path(Deserializer* deserializer, SkGlyph* glyph, SkStrike* cache) {
     uint64_t pathSize = 0u;
     if (!deserializer->read<uint64_t>(&pathSize)) return false;
@@ -446,18 +352,6 @@ void SkStrikeServer::SkGlyphCacheState::addGlyph(SkPackedGlyphID glyph, bool asP
     pending->push_back(glyph);
 }
 
-static void writeGlyph(SkGlyph* glyph, Serializer* serializer) {
-    serializer->write<SkPackedGlyphID>(glyph->getPackedID());
-    serializer->write<float>(glyph->fAdvanceX);
-    serializer->write<float>(glyph->fAdvanceY);
-    serializer->write<uint16_t>(glyph->fWidth);
-    serializer->write<uint16_t>(glyph->fHeight);
-    serializer->write<int16_t>(glyph->fTop);
-    serializer->write<int16_t>(glyph->fLeft);
-    serializer->write<int8_t>(glyph->fForceBW);
-    serializer->write<uint8_t>(glyph->fMaskFormat);
-}
-
 void SkStrikeServer::SkGlyphCacheState::writePendingGlyphs(Serializer* serializer) {
     // TODO(khushalsagar): Write a strike only if it has any pending glyphs.
     serializer->emplace<bool>(this->hasPendingGlyphs());
@@ -655,7 +549,11 @@ SkStrikeClient::SkStrikeClient(sk_sp<DiscardableHandleManager> discardableManage
         , fStrikeCache{strikeCache ? strikeCache : SkStrikeCache::GlobalStrikeCache()}
         , fIsLogging{isLogging} {}
 
-SkStrikeClient::~SkStrikeClient() = default;
+SkStrikeClient::~SkStrikeClient() {
+    fRemoteFontIdToTypeface.foreach([this](SkFontID, sk_sp<SkTypeface>* typeface) {
+        fStrikeCache->removeClientTypeface((*typeface)->uniqueID());
+    });
+}
 
 #define READ_FAILURE                      \
     {                                     \
@@ -663,21 +561,6 @@ SkStrikeClient::~SkStrikeClient() = default;
         return false;                     \
     }
 
-static bool readGlyph(SkTLazy<SkGlyph>& glyph, Deserializer* deserializer) {
-    SkPackedGlyphID glyphID;
-    if (!deserializer->read<SkPackedGlyphID>(&glyphID)) return false;
-    glyph.init(glyphID);
-    if (!deserializer->read<float>(&glyph->fAdvanceX)) return false;
-    if (!deserializer->read<float>(&glyph->fAdvanceY)) return false;
-    if (!deserializer->read<uint16_t>(&glyph->fWidth)) return false;
-    if (!deserializer->read<uint16_t>(&glyph->fHeight)) return false;
-    if (!deserializer->read<int16_t>(&glyph->fTop)) return false;
-    if (!deserializer->read<int16_t>(&glyph->fLeft)) return false;
-    if (!deserializer->read<int8_t>(&glyph->fForceBW)) return false;
-    if (!deserializer->read<uint8_t>(&glyph->fMaskFormat)) return false;
-    return true;
-}
-
 bool SkStrikeClient::readStrikeData(const volatile void* memory, size_t memorySize) {
     SkASSERT(memorySize != 0u);
     Deserializer deserializer(static_cast<const volatile char*>(memory), memorySize);
@@ -800,6 +683,9 @@ sk_sp<SkTypeface> SkStrikeClient::addTypeface(const WireTypeface& wire) {
     auto newTypeface = sk_make_sp<SkTypefaceProxy>(
             wire.typefaceID, wire.glyphCount, wire.style, wire.isFixed,
             fDiscardableHandleManager, fIsLogging);
+    // The strikes we fill in for it are exclusive, so the cache must look for those, not shared
+    // ones.
+    fStrikeCache->addClientTypeface(newTypeface->uniqueID());
     fRemoteFontIdToTypeface.set(wire.typefaceID, newTypeface);
     return std::move(newTypeface);
 }
@@ -15,6 +15,7 @@
 #include "SkTo.h"
 #include "SkTraceMemoryDump.h"
 
+#include <atomic>
 #include <stddef.h>
 #include <stdlib.h>
 
@@ -38,6 +39,10 @@ static inline bool SkShouldPostMessageToBus(
     #define SK_DEFAULT_IMAGE_CACHE_LIMIT     (32 * 1024 * 1024)
 #endif
 
+#ifndef SK_DEFAULT_RESOURCE_CACHE_SHARDS
+    #define SK_DEFAULT_RESOURCE_CACHE_SHARDS 1
+#endif
+
 void SkResourceCache::Key::init(void* nameSpace, uint64_t sharedID, size_t dataSize) {
     SkASSERT(SkAlign4(dataSize) == dataSize);
 
@@ -84,6 +89,7 @@ void SkResourceCache::init() {
     fTotalBytesUsed = 0;
     fCount = 0;
     fSingleAllocationByteLimit = 0;
+    fDiscardableCountLimit = SK_DISCARDABLEMEMORY_SCALEDIMAGECACHE_COUNT_LIMIT;
 
     // One of these should be explicit set by the caller after we return.
     fTotalByteLimit = 0;
@@ -203,7 +209,7 @@ void SkResourceCache::purgeAsNeeded(bool forcePurge) {
     int    countLimit;
 
     if (fDiscardableFactory) {
-        countLimit = SK_DISCARDABLEMEMORY_SCALEDIMAGECACHE_COUNT_LIMIT;
+        countLimit = fDiscardableCountLimit;
         byteLimit = UINT32_MAX;  // no limit based on bytes
     } else {
         countLimit = SK_MaxS32; // no limit based on count
@@ -289,17 +295,29 @@ size_t SkResourceCache::setTotalByteLimit(size_t newLimit) {
     return prevLimit;
 }
 
-SkCachedData* SkResourceCache::newCachedData(size_t bytes) {
-    this->checkMessages();
+int SkResourceCache::setDiscardableCountLimit(int newLimit) {
+    int prevLimit = fDiscardableCountLimit;
+    fDiscardableCountLimit = newLimit;
+    if (newLimit < prevLimit) {
+        this->purgeAsNeeded();
+    }
+    return prevLimit;
+}
 
-    if (fDiscardableFactory) {
-        SkDiscardableMemory* dm = fDiscardableFactory(bytes);
+static SkCachedData* new_cached_data(SkResourceCache::DiscardableFactory factory, size_t bytes) {
+    if (factory) {
+        SkDiscardableMemory* dm = factory(bytes);
         return dm ? new SkCachedData(bytes, dm) : nullptr;
     } else {
         return new SkCachedData(sk_malloc_throw(bytes), bytes);
     }
 }
 
+SkCachedData* SkResourceCache::newCachedData(size_t bytes) {
+    this->checkMessages();
+    return new_cached_data(fDiscardableFactory, bytes);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 void SkResourceCache::release(Rec* rec) {
@@ -449,86 +467,238 @@ void SkResourceCache::checkMessages() {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// The global cache is split into shards, each an ordinary SkResourceCache behind its own mutex.
+// Keys pick their shard by hash, so threads working with different keys mostly take different
+// locks.  gMutex serializes changes to the shard count and limits; it's never held while
+// finding or adding, and is always taken before any shard's mutex.
+namespace {
+    struct alignas(64) Shard {  // Keep each shard's mutex on its own cache line.
+        SkBaseMutex      fMutex;
+        SkResourceCache* fCache = nullptr;  // Created on first use.
+        uint64_t         fLockCount = 0;
+        uint64_t         fContendedLockCount = 0;
+    };
+
+    void lock_shard(Shard* shard) {
+        if (!shard->fMutex.tryAcquire()) {
+            shard->fMutex.acquire();
+            shard->fContendedLockCount++;
+        }
+        shard->fLockCount++;
+    }
+
+    class AutoShardLock {
+    public:
+        AutoShardLock(Shard* shard) : fShard(shard) { lock_shard(shard); }
+        ~AutoShardLock() { fShard->fMutex.release(); }
+
+    private:
+        Shard* fShard;
+    };
+    #define AutoShardLock(...) SK_REQUIRE_LOCAL_VAR(AutoShardLock)
+}
+
 SK_DECLARE_STATIC_MUTEX(gMutex);
-static SkResourceCache* gResourceCache = nullptr;
+static Shard gShards[SkResourceCache::kMaxShards];
 
-/** Must hold gMutex when calling. */
-static SkResourceCache* get_cache() {
-    // gMutex is always held when this is called, so we don't need to be fancy in here.
-    gMutex.assertHeld();
-    if (nullptr == gResourceCache) {
+static_assert(1 <= SK_DEFAULT_RESOURCE_CACHE_SHARDS &&
+                   SK_DEFAULT_RESOURCE_CACHE_SHARDS <= SkResourceCache::kMaxShards,
+              "SK_DEFAULT_RESOURCE_CACHE_SHARDS must be in [1, kMaxShards]");
+static std::atomic<int> gShardCount{SK_DEFAULT_RESOURCE_CACHE_SHARDS};
+// These are only changed while holding gMutex, but may be read without it.
+static std::atomic<size_t> gTotalByteLimit{SK_DEFAULT_IMAGE_CACHE_LIMIT};
+static std::atomic<size_t> gSingleAllocationByteLimit{0};
+
+static SkResourceCache::DiscardableFactory global_discardable_factory() {
 #ifdef SK_USE_DISCARDABLE_SCALEDIMAGECACHE
-        gResourceCache = new SkResourceCache(SkDiscardableMemory::Create);
+    return SkDiscardableMemory::Create;
 #else
-        gResourceCache = new SkResourceCache(SK_DEFAULT_IMAGE_CACHE_LIMIT);
+    return nullptr;
 #endif
+}
+
+static size_t shard_byte_limit(size_t totalByteLimit, int shardCount) {
+    return totalByteLimit / shardCount;
+}
+
+static int shard_count_limit(int shardCount) {
+    return SkTMax(1, SK_DISCARDABLEMEMORY_SCALEDIMAGECACHE_COUNT_LIMIT / shardCount);
+}
+
+namespace {
+    // Locks the shard for a key with this hash.  SetShardCount() may change the count between
+    // our picking a shard and locking it, so we check the count again once the lock is held and
+    // start over if it changed.  Otherwise a rec could land in a shard that SetShardCount() has
+    // already purged, and stay there where no Find() would look.  Once we hold the lock, that
+    // can't happen: SetShardCount() changes the count before locking each shard to purge it.
+    class AutoKeyShardLock {
+    public:
+        AutoKeyShardLock(uint32_t hash) {
+            for (;;) {
+                int shardCount = gShardCount.load(std::memory_order_relaxed);
+                // The hash tables inside each shard index with the low bits, so we pick with
+                // the high bits.
+                fShard = &gShards[((uint64_t)hash * shardCount) >> 32];
+                lock_shard(fShard);
+                if (shardCount == gShardCount.load(std::memory_order_relaxed)) {
+                    return;
+                }
+                fShard->fMutex.release();
+            }
+        }
+        ~AutoKeyShardLock() { fShard->fMutex.release(); }
+
+        Shard* shard() const { return fShard; }
+
+    private:
+        Shard* fShard;
+    };
+    #define AutoKeyShardLock(...) SK_REQUIRE_LOCAL_VAR(AutoKeyShardLock)
+}
+
+/** Must hold shard->fMutex when calling. */
+static SkResourceCache* get_cache(Shard* shard) {
+    shard->fMutex.assertHeld();
+    if (nullptr == shard->fCache) {
+        int shardCount = gShardCount.load(std::memory_order_relaxed);
+        if (auto factory = global_discardable_factory()) {
+            shard->fCache = new SkResourceCache(factory);
+            shard->fCache->setDiscardableCountLimit(shard_count_limit(shardCount));
+        } else {
+            // If the limits change while we're here, update_shard_limits() will fix us up.
+            shard->fCache = new SkResourceCache(shard_byte_limit(
+                    gTotalByteLimit.load(std::memory_order_relaxed), shardCount));
+        }
+        shard->fCache->setSingleAllocationByteLimit(
+                gSingleAllocationByteLimit.load(std::memory_order_relaxed));
     }
-    return gResourceCache;
+    return shard->fCache;
 }
 
-size_t SkResourceCache::GetTotalBytesUsed() {
+/** Must hold gMutex when calling.  Pushes the current shard count and limits to each shard. */
+static void update_shard_limits() {
+    gMutex.assertHeld();
+    int shardCount = gShardCount.load(std::memory_order_relaxed);
+    for (int i = 0; i < SkResourceCache::kMaxShards; i++) {
+        AutoShardLock lock(&gShards[i]);
+        if (SkResourceCache* cache = gShards[i].fCache) {
+            // Shards past the count are no longer found by any key, so give them no budget.
+            bool active = i < shardCount;
+            cache->setTotalByteLimit(
+                    active ? shard_byte_limit(gTotalByteLimit.load(std::memory_order_relaxed),
+                                              shardCount)
+                           : 0);
+            cache->setDiscardableCountLimit(active ? shard_count_limit(shardCount) : 0);
+            cache->setSingleAllocationByteLimit(
+                    gSingleAllocationByteLimit.load(std::memory_order_relaxed));
+        }
+    }
+}
+
+// Calls fn(cache) for each shard that has been used, holding that shard's mutex.
+template <typename Fn>
+static void for_each_cache(Fn&& fn) {
+    for (Shard& shard : gShards) {
+        AutoShardLock lock(&shard);
+        if (shard.fCache) {
+            fn(shard.fCache);
+        }
+    }
+}
+
+int SkResourceCache::SetShardCount(int shardCount) {
+    shardCount = SkTMin(SkTMax(shardCount, 1), (int)kMaxShards);
     SkAutoMutexAcquire am(gMutex);
-    return get_cache()->getTotalBytesUsed();
+    int prevCount = gShardCount.exchange(shardCount, std::memory_order_relaxed);
+    if (prevCount != shardCount) {
+        // Recs now live in the wrong shard for their keys, so start over.
+        update_shard_limits();
+        for_each_cache([](SkResourceCache* cache) { cache->purgeAll(); });
+    }
+    return prevCount;
+}
+
+int SkResourceCache::GetShardCount() {
+    return gShardCount.load(std::memory_order_relaxed);
+}
+
+size_t SkResourceCache::GetTotalBytesUsed() {
+    size_t used = 0;
+    for_each_cache([&](SkResourceCache* cache) { used += cache->getTotalBytesUsed(); });
+    return used;
 }
 
 size_t SkResourceCache::GetTotalByteLimit() {
-    SkAutoMutexAcquire am(gMutex);
-    return get_cache()->getTotalByteLimit();
+    if (global_discardable_factory()) {
+        return 0;  // Discardable caches have no byte budget.
+    }
+    return gTotalByteLimit.load(std::memory_order_relaxed);
 }
 
 size_t SkResourceCache::SetTotalByteLimit(size_t newLimit) {
+    if (global_discardable_factory()) {
+        return 0;
+    }
     SkAutoMutexAcquire am(gMutex);
-    return get_cache()->setTotalByteLimit(newLimit);
+    size_t prevLimit = gTotalByteLimit.exchange(newLimit, std::memory_order_relaxed);
+    update_shard_limits();
+    return prevLimit;
 }
 
 SkResourceCache::DiscardableFactory SkResourceCache::GetDiscardableFactory() {
-    SkAutoMutexAcquire am(gMutex);
-    return get_cache()->discardableFactory();
+    return global_discardable_factory();
 }
 
 SkCachedData* SkResourceCache::NewCachedData(size_t bytes) {
-    SkAutoMutexAcquire am(gMutex);
-    return get_cache()->newCachedData(bytes);
+    // This only depends on the factory, which every shard shares, so there's no need to lock.
+    return new_cached_data(global_discardable_factory(), bytes);
 }
 
 void SkResourceCache::Dump() {
-    SkAutoMutexAcquire am(gMutex);
-    get_cache()->dump();
+    for (int i = 0; i < kMaxShards; i++) {
+        AutoShardLock lock(&gShards[i]);
+        if (gShards[i].fCache) {
+            SkDebugf("shard %d: locked %llu times, %llu contended\n", i,
+                     (unsigned long long)gShards[i].fLockCount,
+                     (unsigned long long)gShards[i].fContendedLockCount);
+            gShards[i].fCache->dump();
+        }
+    }
 }
 
 size_t SkResourceCache::SetSingleAllocationByteLimit(size_t size) {
     SkAutoMutexAcquire am(gMutex);
-    return get_cache()->setSingleAllocationByteLimit(size);
+    size_t prevLimit = gSingleAllocationByteLimit.exchange(size, std::memory_order_relaxed);
+    update_shard_limits();
+    return prevLimit;
 }
 
 size_t SkResourceCache::GetSingleAllocationByteLimit() {
-    SkAutoMutexAcquire am(gMutex);
-    return get_cache()->getSingleAllocationByteLimit();
+    return gSingleAllocationByteLimit.load(std::memory_order_relaxed);
 }
 
 size_t SkResourceCache::GetEffectiveSingleAllocationByteLimit() {
-    SkAutoMutexAcquire am(gMutex);
-    return get_cache()->getEffectiveSingleAllocationByteLimit();
+    // Every active shard has the same limits, and shard 0 is always active.
+    AutoShardLock lock(&gShards[0]);
+    return get_cache(&gShards[0])->getEffectiveSingleAllocationByteLimit();
 }
 
 void SkResourceCache::PurgeAll() {
-    SkAutoMutexAcquire am(gMutex);
-    return get_cache()->purgeAll();
+    for_each_cache([](SkResourceCache* cache) { cache->purgeAll(); });
 }
 
 bool SkResourceCache::Find(const Key& key, FindVisitor visitor, void* context) {
-    SkAutoMutexAcquire am(gMutex);
-    return get_cache()->find(key, visitor, context);
+    AutoKeyShardLock lock(key.hash());
+    return get_cache(lock.shard())->find(key, visitor, context);
 }
 
 void SkResourceCache::Add(Rec* rec, void* payload) {
-    SkAutoMutexAcquire am(gMutex);
-    get_cache()->add(rec, payload);
+    AutoKeyShardLock lock(rec->getHash());
+    get_cache(lock.shard())->add(rec, payload);
 }
 
 void SkResourceCache::VisitAll(Visitor visitor, void* context) {
-    SkAutoMutexAcquire am(gMutex);
-    get_cache()->visitAll(visitor, context);
+    for_each_cache([&](SkResourceCache* cache) { cache->visitAll(visitor, context); });
 }
 
 void SkResourceCache::PostPurgeSharedID(uint64_t sharedID) {
@@ -598,4 +768,15 @@ void SkResourceCache::DumpMemoryStatistics(SkTraceMemoryDump* dump) {
     // Since resource could be backed by malloc or discardable, the cache always dumps detailed
     // stats to be accurate.
     VisitAll(sk_trace_dump_visitor, dump);
+
+    for (int i = 0; i < kMaxShards; i++) {
+        AutoShardLock lock(&gShards[i]);
+        if (gShards[i].fCache) {
+            SkString dumpName = SkStringPrintf("skia/sk_resource_cache/shard_%d", i);
+            dump->dumpNumericValue(dumpName.c_str(), "lock_count", "count",
+                                   gShards[i].fLockCount);
+            dump->dumpNumericValue(dumpName.c_str(), "contended_lock_count", "count",
+                                   gShards[i].fContendedLockCount);
+        }
+    }
 }
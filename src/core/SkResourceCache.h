@@ -25,6 +25,8 @@ class SkTraceMemoryDump;
  *
  *  As a convenience, a global instance is also defined, which can be safely
  *  access across threads via the static methods (e.g. FindAndLock, etc.).
+ *  The global instance may be split into shards to reduce lock contention;
+ *  see SetShardCount().
  */
 class SkResourceCache {
 public:
@@ -166,10 +168,27 @@ public:
 
     static void PurgeAll();
 
+    static constexpr int kMaxShards = 32;
+
+    /**
+     *  Splits the global cache into this many shards (clamped to [1, kMaxShards]), each an
+     *  independent cache with its own lock, its own LRU, and an equal share of the total byte
+     *  limit (or of the discardable count limit).  Recs are assigned to a shard by key hash,
+     *  so threads looking up different keys rarely wait on each other, while eviction stays
+     *  approximately LRU across the whole cache.
+     *
+     *  A Rec larger than one shard's budget can't stay cached, so the effective single
+     *  allocation limit shrinks along with the shards.  Changing the count purges the cache.
+     *  Returns the previous count.  Defaults to SK_DEFAULT_RESOURCE_CACHE_SHARDS, or 1.
+     */
+    static int SetShardCount(int);
+    static int GetShardCount();
+
     static void TestDumpMemoryStatistics();
 
     /** Dump memory usage statistics of every Rec in the cache using the
-        SkTraceMemoryDump interface.
+        SkTraceMemoryDump interface, along with how often each shard's lock was taken
+        and how often a thread had to wait for it.
      */
     static void DumpMemoryStatistics(SkTraceMemoryDump* dump);
 
@@ -241,6 +260,12 @@ public:
      */
     size_t setTotalByteLimit(size_t newLimit);
 
+    /**
+     *  When backed by discardable memory, the cache ignores the byte limit and instead
+     *  holds at most this many Recs, purging as needed.  Returns the previous limit.
+     */
+    int setDiscardableCountLimit(int newLimit);
+
     void purgeSharedID(uint64_t sharedID);
 
     void purgeAll() {
@@ -268,6 +293,7 @@ private:
     size_t  fTotalBytesUsed;
     size_t  fTotalByteLimit;
     size_t  fSingleAllocationByteLimit;
+    int     fDiscardableCountLimit;
     int     fCount;
 
     SkMessageBus<PurgeSharedIDMessage>::Inbox fPurgeSharedIDInbox;
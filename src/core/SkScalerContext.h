@@ -282,6 +282,13 @@ public:
     bool SK_WARN_UNUSED_RESULT getPath(SkPackedGlyphID, SkPath*);
     void        getFontMetrics(SkFontMetrics*);
 
+    /** Returns an ID for the engine that makes this context's glyphs: which kind of scaler
+        context it is, and the version of any font library behind it.  Glyphs that one engine
+        saved to disk are never read back by another.  Returns 0 if the glyphs shouldn't be saved
+        to disk at all, which is the default.
+     */
+    virtual uint64_t getEngineID() const { return 0; }
+
     /** Return the size in bytes of the associated gamma lookup table
      */
     static size_t GetGammaLUTSize(SkScalar contrast, SkScalar paintGamma, SkScalar deviceGamma,
@@ -25,15 +25,17 @@ size_t compute_path_size(const SkPath& path) {
 SkStrike::SkStrike(
     const SkDescriptor& desc,
     std::unique_ptr<SkScalerContext> scaler,
-    const SkFontMetrics& fontMetrics)
+    const SkFontMetrics& fontMetrics,
+    Mode mode)
     : fDesc{desc}
     , fScalerContext{std::move(scaler)}
     , fFontMetrics{fontMetrics}
+    , fMemoryUsed{sizeof(*this)}
+    , fMode{mode}
     , fIsSubpixel{fScalerContext->isSubpixel()}
     , fAxisAlignment{fScalerContext->computeAxisAlignmentForHText()}
 {
     SkASSERT(fScalerContext != nullptr);
-    fMemoryUsed = sizeof(*this);
 }
 
 const SkDescriptor& SkStrike::getDescriptor() const {
@@ -51,15 +53,21 @@ unsigned SkStrike::getGlyphCount() const {
 }
 
 int SkStrike::countCachedGlyphs() const {
+    SkAutoMutexAcquire lock(this->isShared() ? &fMutex : nullptr);
     return fGlyphMap.count();
 }
 
 bool SkStrike::isGlyphCached(SkGlyphID glyphID, SkFixed x, SkFixed y) const {
     SkPackedGlyphID packedGlyphID{glyphID, x, y};
+    if (this->isShared()) {
+        return this->findSharedSlot(packedGlyphID) != nullptr;
+    }
     return fGlyphMap.find(packedGlyphID) != nullptr;
 }
 
 SkGlyph* SkStrike::getRawGlyphByID(SkPackedGlyphID id) {
+    // Raw glyphs are filled in by their caller, which we can't allow once they're shared.
+    SkASSERT(!this->isShared());
     return lookupByPackedGlyphID(id, kNothing_MetricsType);
 }
 
@@ -83,18 +91,105 @@ const SkGlyph& SkStrike::getGlyphIDMetrics(uint16_t glyphID, SkFixed x, SkFixed
 
 void SkStrike::getAdvances(SkSpan<const SkGlyphID> glyphIDs, SkPoint advances[]) {
     for (auto glyphID : glyphIDs) {
-        auto glyph = this->getGlyphIDAdvance(glyphID);
+        const SkGlyph& glyph = this->getGlyphIDAdvance(glyphID);
         *advances++ = SkPoint::Make(glyph.fAdvanceX, glyph.fAdvanceY);
     }
 }
 
+SkStrike::SharedSlot* SkStrike::findSharedSlot(SkPackedGlyphID packedGlyphID) const {
+    const SharedTable* table = fSharedTable.load(std::memory_order_acquire);
+    if (table == nullptr) {
+        return nullptr;
+    }
+    const uint32_t mask = table->fCapacity - 1;
+    for (uint32_t index = packedGlyphID.hash() & mask; ; index = (index + 1) & mask) {
+        SkGlyph* glyph = table->fSlots[index].fGlyph.load(std::memory_order_acquire);
+        if (glyph == nullptr) {
+            return nullptr;  // Tables are never full, so every probe ends at an empty slot.
+        }
+        if (glyph->getPackedID() == packedGlyphID) {
+            return &table->fSlots[index];
+        }
+    }
+}
+
+bool SkStrike::isSharedReady(const SkGlyph& glyph, uint8_t bit) const {
+    const SharedSlot* slot = this->findSharedSlot(glyph.getPackedID());
+    return slot != nullptr && (slot->fReady.load(std::memory_order_acquire) & bit);
+}
+
+void SkStrike::publishShared(SkGlyph* glyph) {
+    fMutex.assertHeld();
+    auto insert = [](SharedTable* table, SkGlyph* glyph, uint8_t ready) {
+        const uint32_t mask = table->fCapacity - 1;
+        uint32_t index = glyph->getPackedID().hash() & mask;
+        while (table->fSlots[index].fGlyph.load(std::memory_order_relaxed) != nullptr) {
+            index = (index + 1) & mask;
+        }
+        // Readers may see the glyph as soon as it's stored, so its ready bits go first.
+        table->fSlots[index].fReady.store(ready, std::memory_order_relaxed);
+        table->fSlots[index].fGlyph.store(glyph, std::memory_order_release);
+    };
+
+    // fGlyphMap already holds the new glyph.
+    SharedTable* table = fSharedTable.load(std::memory_order_relaxed);
+    if (table == nullptr || fGlyphMap.count() * 2 > table->fCapacity) {
+        int capacity = table ? table->fCapacity * 2 : 64;
+        SharedTable* grown = fAlloc.make<SharedTable>();
+        grown->fSlots = fAlloc.makeArray<SharedSlot>(capacity);
+        grown->fCapacity = capacity;
+        addMemoryUsed(capacity * sizeof(SharedSlot));
+        if (table != nullptr) {
+            for (int i = 0; i < table->fCapacity; i++) {
+                if (SkGlyph* old = table->fSlots[i].fGlyph.load(std::memory_order_relaxed)) {
+                    insert(grown, old, table->fSlots[i].fReady.load(std::memory_order_relaxed));
+                }
+            }
+        }
+        insert(grown, glyph, 0);
+        fSharedTable.store(grown, std::memory_order_release);
+    } else {
+        insert(table, glyph, 0);
+    }
+}
+
+void SkStrike::markSharedReady(const SkGlyph& glyph, uint8_t bit) {
+    fMutex.assertHeld();
+    SharedSlot* slot = this->findSharedSlot(glyph.getPackedID());
+    SkASSERT(slot != nullptr);
+    slot->fReady.store(slot->fReady.load(std::memory_order_relaxed) | bit,
+                       std::memory_order_release);
+}
+
+SkGlyph* SkStrike::lookupSharedGlyph(SkPackedGlyphID packedGlyphID) {
+    if (SharedSlot* slot = this->findSharedSlot(packedGlyphID)) {
+        return slot->fGlyph.load(std::memory_order_relaxed);  // Already acquired.
+    }
+
+    SkAutoMutexAcquire lock(fMutex);
+    SkGlyph* glyphPtr = fGlyphMap.findOrNull(packedGlyphID);
+    if (glyphPtr == nullptr) {
+        // Shared glyphs can't change once published, so we always get full metrics.
+        addMemoryUsed(sizeof(SkGlyph));
+        glyphPtr = fAlloc.make<SkGlyph>(packedGlyphID);
+        this->makeMetrics(glyphPtr);
+        fGlyphMap.set(glyphPtr);
+        this->publishShared(glyphPtr);
+    }
+    return glyphPtr;
+}
+
 SkGlyph* SkStrike::lookupByPackedGlyphID(SkPackedGlyphID packedGlyphID, MetricsType type) {
+    if (this->isShared()) {
+        return this->lookupSharedGlyph(packedGlyphID);
+    }
+
     SkGlyph* glyphPtr = fGlyphMap.findOrNull(packedGlyphID);
 
     if (glyphPtr == nullptr) {
         // Glyph is not present in the stirke. Make a new glyph and fill it in.
 
-        fMemoryUsed += sizeof(SkGlyph);
+        addMemoryUsed(sizeof(SkGlyph));
         glyphPtr = fAlloc.make<SkGlyph>(packedGlyphID);
         fGlyphMap.set(glyphPtr);
 
@@ -104,36 +199,117 @@ SkGlyph* SkStrike::lookupByPackedGlyphID(SkPackedGlyphID packedGlyphID, MetricsT
             case kNothing_MetricsType:
                 break;
             case kJustAdvance_MetricsType:
-                fScalerContext->getAdvance(glyphPtr);
+                // The glyph file has full metrics, which are cheaper than asking for an advance.
+                if (fGlyphFile == nullptr || !fGlyphFile->findMetrics(glyphPtr)) {
+                    fScalerContext->getAdvance(glyphPtr);
+                }
                 break;
             case kFull_MetricsType:
-                fScalerContext->getMetrics(glyphPtr);
+                this->makeMetrics(glyphPtr);
                 break;
         }
     } else {
         // Glyph is present in strike. Make sure the glyph has the right data.
 
         if (type == kFull_MetricsType && glyphPtr->isJustAdvance()) {
-            fScalerContext->getMetrics(glyphPtr);
+            this->makeMetrics(glyphPtr);
         }
     }
 
     return glyphPtr;
 }
 
+void SkStrike::makeMetrics(SkGlyph* glyph) {
+    if (fGlyphFile == nullptr || !fGlyphFile->findMetrics(glyph)) {
+        fScalerContext->getMetrics(glyph);
+        fGlyphFileDirty = true;
+    }
+}
+
+void SkStrike::makeImage(const SkGlyph& glyph) {
+    size_t size;
+    const volatile void* image = fGlyphFile ? fGlyphFile->findImage(glyph, &size) : nullptr;
+    if (image != nullptr) {
+        memcpy(glyph.fImage, const_cast<const void*>(image), size);
+    } else {
+        fScalerContext->getImage(glyph);
+        fGlyphFileDirty = true;
+    }
+}
+
+void SkStrike::makePath(SkGlyph* glyph) {
+    SkPath path;
+    bool hasPath;
+    if (!glyph->isEmpty() && glyph->fPathData == nullptr &&
+        fGlyphFile != nullptr && fGlyphFile->findPath(glyph->getPackedID(), &path, &hasPath)) {
+        glyph->fPathData = fAlloc.make<SkGlyph::PathData>();
+        if (hasPath) {
+            glyph->fPathData->fPath = path;
+            glyph->fPathData->fPath.getGenerationID();
+            glyph->fPathData->fHasPath = true;
+        }
+        return;
+    }
+    glyph->addPath(fScalerContext.get(), &fAlloc);
+    fGlyphFileDirty = true;
+}
+
+void SkStrike::setGlyphFile(std::unique_ptr<SkGlyphDiskCache::StrikeFile> file) {
+    SkASSERT(fGlyphMap.count() == 0);
+    fGlyphFile = std::move(file);
+}
+
+bool SkStrike::saveGlyphFile() {
+    SkAutoMutexAcquire lock(this->isShared() ? &fMutex : nullptr);
+    if (fGlyphFile == nullptr || !fGlyphFileDirty) {
+        return false;
+    }
+
+    // Glyphs with just an advance aren't worth keeping; they're cheap to make.
+    SkTArray<const SkGlyph*> glyphs;
+    fGlyphMap.foreach([&glyphs](SkGlyph* const* glyph) {
+        if ((*glyph)->isFullMetrics()) {
+            glyphs.push_back(*glyph);
+        }
+    });
+    if (!fGlyphFile->save(fFontMetrics, glyphs)) {
+        return false;
+    }
+    fGlyphFileDirty = false;
+    return true;
+}
+
 const void* SkStrike::findImage(const SkGlyph& glyph) {
+    if (this->isShared() && glyph.fWidth > 0 && glyph.fWidth < kMaxGlyphWidth) {
+        if (this->isSharedReady(glyph, kImageReady)) {
+            return glyph.fImage;
+        }
+        SkAutoMutexAcquire lock(fMutex);
+        if (nullptr == glyph.fImage) {
+            size_t size = const_cast<SkGlyph&>(glyph).allocImage(&fAlloc);
+            if (glyph.fImage) {
+                this->makeImage(glyph);
+                addMemoryUsed(size);
+            }
+        }
+        if (glyph.fImage) {
+            this->markSharedReady(glyph, kImageReady);
+        }
+        return glyph.fImage;
+    }
+
     if (glyph.fWidth > 0 && glyph.fWidth < kMaxGlyphWidth) {
         if (nullptr == glyph.fImage) {
             SkDEBUGCODE(SkMask::Format oldFormat = (SkMask::Format)glyph.fMaskFormat);
             size_t  size = const_cast<SkGlyph&>(glyph).allocImage(&fAlloc);
             // check that alloc() actually succeeded
             if (glyph.fImage) {
-                fScalerContext->getImage(glyph);
+                this->makeImage(glyph);
                 // TODO: the scaler may have changed the maskformat during
                 // getImage (e.g. from AA or LCD to BW) which means we may have
                 // overallocated the buffer. Check if the new computedImageSize
                 // is smaller, and if so, strink the alloc size in fImageAlloc.
-                fMemoryUsed += size;
+                addMemoryUsed(size);
             }
             SkASSERT(oldFormat == glyph.fMaskFormat);
         }
@@ -145,6 +321,7 @@ void SkStrike::initializeImage(const volatile void* data, size_t size, SkGlyph*
     // Don't overwrite the image if we already have one. We could have used a fallback if the
     // glyph was missing earlier.
     if (glyph->fImage) return;
+    SkASSERT(!this->isShared());
 
     if (glyph->fWidth > 0 && glyph->fWidth < kMaxGlyphWidth) {
         size_t allocSize = glyph->allocImage(&fAlloc);
@@ -152,12 +329,28 @@ void SkStrike::initializeImage(const volatile void* data, size_t size, SkGlyph*
         if (glyph->fImage) {
             SkASSERT(size == allocSize);
             memcpy(glyph->fImage, const_cast<const void*>(data), allocSize);
-            fMemoryUsed += size;
+            addMemoryUsed(size);
         }
     }
 }
 
 const SkPath* SkStrike::findPath(const SkGlyph& glyph) {
+    if (this->isShared() && !glyph.isEmpty()) {
+        if (this->isSharedReady(glyph, kPathReady)) {
+            return glyph.path();
+        }
+        SkAutoMutexAcquire lock(fMutex);
+        if (glyph.fPathData == nullptr) {
+            this->makePath(const_cast<SkGlyph*>(&glyph));
+            if (glyph.fPathData != nullptr) {
+                addMemoryUsed(compute_path_size(glyph.fPathData->fPath));
+            }
+        }
+        if (glyph.fPathData != nullptr) {
+            this->markSharedReady(glyph, kPathReady);
+        }
+        return glyph.path();
+    }
 
     if (!glyph.isEmpty()) {
         // If the path already exists, return it.
@@ -168,9 +361,9 @@ const SkPath* SkStrike::findPath(const SkGlyph& glyph) {
             return nullptr;
         }
 
-        const_cast<SkGlyph&>(glyph).addPath(fScalerContext.get(), &fAlloc);
+        this->makePath(const_cast<SkGlyph*>(&glyph));
         if (glyph.fPathData != nullptr) {
-            fMemoryUsed += compute_path_size(glyph.fPathData->fPath);
+            addMemoryUsed(compute_path_size(glyph.fPathData->fPath));
         }
 
         return glyph.path();
@@ -183,6 +376,7 @@ bool SkStrike::initializePath(SkGlyph* glyph, const volatile void* data, size_t
     // Don't overwrite the path if we already have one. We could have used a fallback if the
     // glyph was missing earlier.
     if (glyph->fPathData) return true;
+    SkASSERT(!this->isShared());
 
     if (glyph->fWidth) {
         SkGlyph::PathData* pathData = fAlloc.make<SkGlyph::PathData>();
@@ -191,7 +385,7 @@ bool SkStrike::initializePath(SkGlyph* glyph, const volatile void* data, size_t
         if (!pathData->fPath.readFromMemory(const_cast<const void*>(data), size)) {
             return false;
         }
-        fMemoryUsed += compute_path_size(glyph->fPathData->fPath);
+        addMemoryUsed(compute_path_size(glyph->fPathData->fPath));
         pathData->fHasPath = true;
     }
 
@@ -199,11 +393,13 @@ bool SkStrike::initializePath(SkGlyph* glyph, const volatile void* data, size_t
 }
 
 bool SkStrike::belongsToCache(const SkGlyph* glyph) const {
+    SkAutoMutexAcquire lock(this->isShared() ? &fMutex : nullptr);
     return glyph && fGlyphMap.findOrNull(glyph->getPackedID()) == glyph;
 }
 
 const SkGlyph* SkStrike::getCachedGlyphAnySubPix(SkGlyphID glyphID,
                                                      SkPackedGlyphID vetoID) const {
+    SkAutoMutexAcquire lock(this->isShared() ? &fMutex : nullptr);
     for (SkFixed subY = 0; subY < SK_Fixed1; subY += SK_FixedQuarter) {
         for (SkFixed subX = 0; subX < SK_Fixed1; subX += SK_FixedQuarter) {
             SkPackedGlyphID packedGlyphID{glyphID, subX, subY};
@@ -218,7 +414,8 @@ const SkGlyph* SkStrike::getCachedGlyphAnySubPix(SkGlyphID glyphID,
 }
 
 void SkStrike::initializeGlyphFromFallback(SkGlyph* glyph, const SkGlyph& fallback) {
-    fMemoryUsed += glyph->copyImageData(fallback, &fAlloc);
+    SkASSERT(!this->isShared());
+    addMemoryUsed(glyph->copyImageData(fallback, &fAlloc));
 }
 
 SkVector SkStrike::rounding() const {
@@ -357,6 +554,8 @@ const SkGlyph::Intercept* SkStrike::MatchBounds(const SkGlyph* glyph,
 
 void SkStrike::findIntercepts(const SkScalar bounds[2], SkScalar scale, SkScalar xPos,
         bool yAxis, SkGlyph* glyph, SkScalar* array, int* count) {
+    // Intercepts are cached in a list on each glyph's path data, so shared strikes lock.
+    SkAutoMutexAcquire lock(this->isShared() ? &fMutex : nullptr);
     const SkGlyph::Intercept* match = MatchBounds(glyph, bounds);
 
     if (match) {
@@ -425,6 +624,7 @@ void SkStrike::findIntercepts(const SkScalar bounds[2], SkScalar scale, SkScalar
 }
 
 void SkStrike::dump() const {
+    SkAutoMutexAcquire lock(this->isShared() ? &fMutex : nullptr);
     const SkTypeface* face = fScalerContext->getTypeface();
     const SkScalerContextRec& rec = fScalerContext->getRec();
     SkMatrix matrix;
@@ -449,7 +649,12 @@ void SkStrike::onAboutToExitScope() { }
 
 #ifdef SK_DEBUG
 void SkStrike::forceValidate() const {
+    SkAutoMutexAcquire lock(this->isShared() ? &fMutex : nullptr);
     size_t memoryUsed = sizeof(*this);
+    if (const SharedTable* table = fSharedTable.load(std::memory_order_relaxed)) {
+        // Every table so far, from 64 slots up to this one, doubling each time.
+        memoryUsed += (2 * table->fCapacity - 64) * sizeof(SharedSlot);
+    }
     fGlyphMap.foreach ([&memoryUsed](const SkGlyph* glyphPtr) {
         memoryUsed += sizeof(SkGlyph);
         if (glyphPtr->fImage) {
@@ -12,12 +12,15 @@
 #include "SkFontMetrics.h"
 #include "SkFontTypes.h"
 #include "SkGlyph.h"
+#include "SkGlyphDiskCache.h"
 #include "SkGlyphRunPainter.h"
+#include "SkMutex.h"
 #include "SkPaint.h"
 #include "SkTHash.h"
 #include "SkScalerContext.h"
 #include "SkStrikeInterface.h"
 #include "SkTemplates.h"
+#include <atomic>
 #include <memory>
 
 /** \class SkGlyphCache
@@ -32,12 +35,36 @@
 
     The Find*Exclusive() method returns SkExclusiveStrikePtr, which releases exclusive ownership
     when they go out of scope.
+
+    A shared strike may be used by many threads at once.  Its glyphs always have full metrics,
+    and are published through a lock-free table once they are complete, so finding a glyph that
+    already exists never locks.  Images and paths are made on demand under a per-strike mutex
+    and published per glyph; once findImage() or findPath() has returned for a glyph, its fImage
+    or path() may be read freely.  Only creating a glyph, image, path or intercept locks.
 */
 class SkStrike final : public SkStrikeInterface {
 public:
+    enum class Mode {
+        kExclusive,
+        kShared,
+    };
+
     SkStrike(const SkDescriptor& desc,
              std::unique_ptr<SkScalerContext> scaler,
-             const SkFontMetrics&);
+             const SkFontMetrics&,
+             Mode mode = Mode::kExclusive);
+
+    bool isShared() const { return fMode == Mode::kShared; }
+
+    /** Read glyphs from this file, when it has them, instead of making them with the scaler
+        context.  Call this before the strike is used.
+    */
+    void setGlyphFile(std::unique_ptr<SkGlyphDiskCache::StrikeFile>);
+
+    /** If the strike has made glyphs that its glyph file doesn't have, rewrite the file with them.
+        Returns true if the file was written.
+    */
+    bool saveGlyphFile();
 
     /** Return true if glyph is cached. */
     bool isGlyphCached(SkGlyphID glyphID, SkFixed x, SkFixed y) const;
@@ -141,7 +168,7 @@ public:
     void onAboutToExitScope() override;
 
     /** Return the approx RAM usage for this cache. */
-    size_t getMemoryUsed() const { return fMemoryUsed; }
+    size_t getMemoryUsed() const { return fMemoryUsed.load(std::memory_order_relaxed); }
 
     void dump() const;
 
@@ -190,6 +217,19 @@ private:
     // combined glyph/x/y id generated by MakeID. If it is just a glyph id
     // then x and y are assumed to be zero. Limit the amount of work using type.
     SkGlyph* lookupByPackedGlyphID(SkPackedGlyphID packedGlyphID, MetricsType type);
+    SkGlyph* lookupSharedGlyph(SkPackedGlyphID packedGlyphID);
+
+    // Fill in the glyph's metrics, image or path from fGlyphFile, or failing that from
+    // fScalerContext.  The image must already be allocated.
+    void makeMetrics(SkGlyph*);
+    void makeImage(const SkGlyph&);
+    void makePath(SkGlyph*);
+
+    // Only called by whoever owns the strike, or with fMutex held for shared strikes.
+    void addMemoryUsed(size_t bytes) {
+        fMemoryUsed.store(fMemoryUsed.load(std::memory_order_relaxed) + bytes,
+                          std::memory_order_relaxed);
+    }
 
     static void OffsetResults(const SkGlyph::Intercept* intercept, SkScalar scale,
                               SkScalar xPos, SkScalar* array, int* count);
@@ -232,7 +272,38 @@ private:
     SkArenaAlloc            fAlloc {kMinAllocAmount};
 
     // used to track (approx) how much ram is tied-up in this cache
-    size_t                  fMemoryUsed;
+    std::atomic<size_t>     fMemoryUsed;
+
+    // Shared strikes publish each complete glyph in this open-addressed table, along with
+    // whether its image and path are ready.  Writers hold fMutex and store with release; readers
+    // load with acquire and need no lock.  A full table is replaced by one twice the size, but
+    // the old one stays in fAlloc for readers that already hold it.  It may miss glyphs or ready
+    // bits published since, which only sends the reader to fMutex and fGlyphMap.
+    enum ReadyBits : uint8_t {
+        kImageReady = 1 << 0,
+        kPathReady  = 1 << 1,
+    };
+    struct SharedSlot {
+        std::atomic<SkGlyph*> fGlyph{nullptr};
+        std::atomic<uint8_t>  fReady{0};
+    };
+    struct SharedTable {
+        SharedSlot* fSlots;
+        int         fCapacity;  // A power of two, at least twice the glyph count.
+    };
+
+    SharedSlot* findSharedSlot(SkPackedGlyphID) const;
+    bool isSharedReady(const SkGlyph&, uint8_t bit) const;
+    void publishShared(SkGlyph*);           // Must hold fMutex.
+    void markSharedReady(const SkGlyph&, uint8_t bit);  // Must hold fMutex.
+
+    const Mode                 fMode;
+    mutable SkMutex            fMutex;
+    std::atomic<SharedTable*>  fSharedTable{nullptr};
+
+    std::unique_ptr<SkGlyphDiskCache::StrikeFile> fGlyphFile;
+    // Set when we make a glyph, image or path with the scaler context.
+    bool                    fGlyphFileDirty{false};
 
     const bool              fIsSubpixel;
     const SkAxisAlignment   fAxisAlignment;
@@ -23,9 +23,10 @@ public:
          const SkDescriptor& desc,
          std::unique_ptr<SkScalerContext> scaler,
          const SkFontMetrics& metrics,
-         std::unique_ptr<SkStrikePinner> pinner)
+         std::unique_ptr<SkStrikePinner> pinner,
+         SkStrike::Mode mode = SkStrike::Mode::kExclusive)
             : fStrikeCache{strikeCache}
-            , fStrike{desc, std::move(scaler), metrics}
+            , fStrike{desc, std::move(scaler), metrics, mode}
             , fPinner{std::move(pinner)} {}
 
     SkVector rounding() const override {
@@ -63,6 +64,10 @@ public:
     Node*                           fPrev{nullptr};
     SkStrike                        fStrike;
     std::unique_ptr<SkStrikePinner> fPinner;
+    // These are guarded by the cache's lock.  A shared strike keeps growing while it's in the
+    // cache, so we remember how much of its memory the cache has counted so far.
+    int                             fSharedRefs{0};
+    size_t                          fMemoryCounted{0};
 };
 
 SkStrikeCache* SkStrikeCache::GlobalStrikeCache() {
@@ -168,13 +173,64 @@ SkExclusiveStrikePtr SkStrikeCache::findOrCreateStrikeExclusive(
     return SkExclusiveStrikePtr(this->findOrCreateStrike(desc, effects, typeface));
 }
 
+// Opens the strike's glyph file, if there's a disk cache, and fills in the font metrics from it,
+// or failing that from the scaler context.
+static std::unique_ptr<SkGlyphDiskCache::StrikeFile> open_glyph_file(
+        SkGlyphDiskCache* diskCache, const SkDescriptor& desc,
+        SkScalerContext* scaler, SkFontMetrics* fontMetrics) {
+    std::unique_ptr<SkGlyphDiskCache::StrikeFile> file;
+    if (diskCache != nullptr) {
+        file = diskCache->openStrike(desc, *scaler);
+    }
+    if (file != nullptr && file->fontMetrics() != nullptr) {
+        *fontMetrics = *file->fontMetrics();
+    } else {
+        scaler->getFontMetrics(fontMetrics);
+    }
+    return file;
+}
+
 auto SkStrikeCache::findOrCreateStrike(const SkDescriptor& desc,
                                        const SkScalerContextEffects& effects,
                                        const SkTypeface& typeface) -> Node* {
+    bool shared;
+    sk_sp<SkGlyphDiskCache> diskCache;
+    {
+        SkAutoExclusive ac(fLock);
+        shared = fSharedStrikes && !fClientTypefaces.contains(typeface.uniqueID());
+        diskCache = fDiskCache;
+    }
+
+    if (shared) {
+        if (Node* node = this->findAndRefSharedStrike(desc)) {
+            return node;
+        }
+
+        // Make the strike without holding fLock, then add it unless another thread beat us.
+        auto scaler = CreateScalerContext(desc, effects, typeface);
+        SkFontMetrics fontMetrics;
+        auto file = open_glyph_file(diskCache.get(), desc, scaler.get(), &fontMetrics);
+        std::unique_ptr<Node> made{new Node{this, desc, std::move(scaler), fontMetrics, nullptr,
+                                            SkStrike::Mode::kShared}};
+        made->fStrike.setGlyphFile(std::move(file));
+        SkAutoExclusive ac(fLock);
+        if (Node* node = this->internalFindAndRefShared(desc)) {
+            return node;
+        }
+        Node* node = made.release();
+        node->fSharedRefs = 1;
+        this->internalAttachToHead(node);
+        this->internalPurge();
+        return node;
+    }
+
     Node* node = this->findAndDetachStrike(desc);
     if (node == nullptr) {
         auto scaler = CreateScalerContext(desc, effects, typeface);
-        node = this->createStrike(desc, std::move(scaler));
+        SkFontMetrics fontMetrics;
+        auto file = open_glyph_file(diskCache.get(), desc, scaler.get(), &fontMetrics);
+        node = this->createStrike(desc, std::move(scaler), &fontMetrics);
+        node->fStrike.setGlyphFile(std::move(file));
     }
     return node;
 }
@@ -182,12 +238,7 @@ auto SkStrikeCache::findOrCreateStrike(const SkDescriptor& desc,
 SkScopedStrike SkStrikeCache::findOrCreateScopedStrike(const SkDescriptor& desc,
                                                        const SkScalerContextEffects& effects,
                                                        const SkTypeface& typeface) {
-    Node* node = this->findAndDetachStrike(desc);
-    if (node == nullptr) {
-        auto scaler = CreateScalerContext(desc, effects, typeface);
-        node = this->createStrike(desc, std::move(scaler));
-    }
-    return SkScopedStrike{node};
+    return SkScopedStrike{this->findOrCreateStrike(desc, effects, typeface)};
 }
 
 SkExclusiveStrikePtr SkStrikeCache::FindOrCreateStrikeExclusive(
@@ -239,6 +290,74 @@ void SkStrikeCache::PurgeAll() {
     GlobalStrikeCache()->purgeAll();
 }
 
+bool SkStrikeCache::SetSharedStrikes(bool shared) {
+    return GlobalStrikeCache()->setSharedStrikes(shared);
+}
+
+bool SkStrikeCache::setSharedStrikes(bool shared) {
+    SkAutoExclusive ac(fLock);
+    bool prev = fSharedStrikes;
+    fSharedStrikes = shared;
+    return prev;
+}
+
+void SkStrikeCache::addClientTypeface(SkFontID typefaceID) {
+    SkAutoExclusive ac(fLock);
+    fClientTypefaces.add(typefaceID);
+}
+
+void SkStrikeCache::removeClientTypeface(SkFontID typefaceID) {
+    SkAutoExclusive ac(fLock);
+    SkASSERT(fClientTypefaces.contains(typefaceID));
+    fClientTypefaces.remove(typefaceID);
+}
+
+void SkStrikeCache::SetDiskCacheDirectory(const char directory[]) {
+    GlobalStrikeCache()->setDiskCacheDirectory(directory);
+}
+
+void SkStrikeCache::setDiskCacheDirectory(const char directory[]) {
+    sk_sp<SkGlyphDiskCache> diskCache;
+    if (directory != nullptr) {
+        diskCache = sk_make_sp<SkGlyphDiskCache>(directory);
+    }
+    SkAutoExclusive ac(fLock);
+    fDiskCache = std::move(diskCache);
+}
+
+int SkStrikeCache::SaveDiskCache() {
+    return GlobalStrikeCache()->saveDiskCache();
+}
+
+int SkStrikeCache::saveDiskCache() {
+    // Check out every strike as if to use it, so the files are written without holding fLock.
+    // Strikes already in use are left for the next save.
+    std::vector<Node*> nodes;
+    {
+        SkAutoExclusive ac(fLock);
+        for (Node* node = internalGetHead(); node != nullptr; node = node->fNext) {
+            nodes.push_back(node);
+        }
+        for (Node* node : nodes) {
+            if (node->fStrike.isShared()) {
+                node->fSharedRefs += 1;
+            } else {
+                this->internalDetachCache(node);
+            }
+        }
+    }
+
+    // Going from the tail back puts the strikes back in the same LRU order.
+    int saved = 0;
+    for (auto node = nodes.rbegin(); node != nodes.rend(); ++node) {
+        if ((*node)->fStrike.saveGlyphFile()) {
+            saved++;
+        }
+        this->attachNode(*node);
+    }
+    return saved;
+}
+
 void SkStrikeCache::Dump() {
     SkDebugf("GlyphCache [     used    budget ]\n");
     SkDebugf("    bytes  [ %8zu  %8zu ]\n",
@@ -308,6 +427,10 @@ void SkStrikeCache::attachNode(Node* node) {
     if (node == nullptr) {
         return;
     }
+    if (node->fStrike.isShared()) {
+        this->releaseSharedStrike(node);
+        return;
+    }
     SkAutoExclusive ac(fLock);
 
     this->validate();
@@ -325,7 +448,7 @@ auto SkStrikeCache::findAndDetachStrike(const SkDescriptor& desc) -> Node* {
     SkAutoExclusive ac(fLock);
 
     for (Node* node = internalGetHead(); node != nullptr; node = node->fNext) {
-        if (node->fStrike.getDescriptor() == desc) {
+        if (!node->fStrike.isShared() && node->fStrike.getDescriptor() == desc) {
             this->internalDetachCache(node);
             return node;
         }
@@ -334,6 +457,39 @@ auto SkStrikeCache::findAndDetachStrike(const SkDescriptor& desc) -> Node* {
     return nullptr;
 }
 
+auto SkStrikeCache::findAndRefSharedStrike(const SkDescriptor& desc) -> Node* {
+    SkAutoExclusive ac(fLock);
+    return this->internalFindAndRefShared(desc);
+}
+
+auto SkStrikeCache::internalFindAndRefShared(const SkDescriptor& desc) -> Node* {
+    for (Node* node = internalGetHead(); node != nullptr; node = node->fNext) {
+        if (node->fStrike.isShared() && node->fStrike.getDescriptor() == desc) {
+            node->fSharedRefs += 1;
+            if (node != fHead) {
+                // Keep the LRU order, without disturbing the strike itself.
+                this->internalDetachCache(node);
+                this->internalAttachToHead(node);
+            }
+            return node;
+        }
+    }
+
+    return nullptr;
+}
+
+void SkStrikeCache::releaseSharedStrike(Node* node) {
+    SkAutoExclusive ac(fLock);
+    SkASSERT(node->fSharedRefs > 0);
+    node->fSharedRefs -= 1;
+
+    // Catch up on whatever the strike has grown by while it was in use.
+    size_t used = node->fStrike.getMemoryUsed();
+    fTotalMemoryUsed += used - node->fMemoryCounted;
+    node->fMemoryCounted = used;
+
+    this->internalPurge();
+}
 
 static bool loose_compare(const SkDescriptor& lhs, const SkDescriptor& rhs) {
     uint32_t size;
@@ -370,7 +526,8 @@ bool SkStrikeCache::desperationSearchForImage(const SkDescriptor& desc, SkGlyph*
             targetSubY = glyph->getSubYFixed();
 
     for (Node* node = internalGetHead(); node != nullptr; node = node->fNext) {
-        if (loose_compare(node->fStrike.getDescriptor(), desc)) {
+        // Shared strikes may be in use, so their glyphs may be changing under us.
+        if (!node->fStrike.isShared() && loose_compare(node->fStrike.getDescriptor(), desc)) {
             auto targetGlyphID = SkPackedGlyphID(glyphID, targetSubX, targetSubY);
             if (node->fStrike.isGlyphCached(glyphID, targetSubX, targetSubY)) {
                 SkGlyph* fallback = node->fStrike.getRawGlyphByID(targetGlyphID);
@@ -403,7 +560,7 @@ bool SkStrikeCache::desperationSearchForPath(
     // This will have to search the sub-pixel positions too.
     // There is also a problem with accounting for cache size with shared path data.
     for (Node* node = internalGetHead(); node != nullptr; node = node->fNext) {
-        if (loose_compare(node->fStrike.getDescriptor(), desc)) {
+        if (!node->fStrike.isShared() && loose_compare(node->fStrike.getDescriptor(), desc)) {
             if (node->fStrike.isGlyphCached(glyphID, 0, 0)) {
                 SkGlyph* from = node->fStrike.getRawGlyphByID(SkPackedGlyphID(glyphID));
                 if (from->fPathData != nullptr) {
@@ -566,9 +723,9 @@ size_t SkStrikeCache::internalPurge(size_t minBytesNeeded) {
     while (node != nullptr && (bytesFreed < bytesNeeded || countFreed < countNeeded)) {
         Node* prev = node->fPrev;
 
-        // Only delete if the strike is not pinned.
-        if (node->fPinner == nullptr || node->fPinner->canDelete()) {
-            bytesFreed += node->fStrike.getMemoryUsed();
+        // Only delete if the strike is not pinned, or in use by some thread.
+        if ((node->fPinner == nullptr || node->fPinner->canDelete()) && node->fSharedRefs == 0) {
+            bytesFreed += node->fMemoryCounted;
             countFreed += 1;
             this->internalDetachCache(node);
             delete node;
@@ -601,13 +758,14 @@ void SkStrikeCache::internalAttachToHead(Node* node) {
     }
 
     fCacheCount += 1;
-    fTotalMemoryUsed += node->fStrike.getMemoryUsed();
+    node->fMemoryCounted = node->fStrike.getMemoryUsed();
+    fTotalMemoryUsed += node->fMemoryCounted;
 }
 
 void SkStrikeCache::internalDetachCache(Node* node) {
     SkASSERT(fCacheCount > 0);
     fCacheCount -= 1;
-    fTotalMemoryUsed -= node->fStrike.getMemoryUsed();
+    fTotalMemoryUsed -= node->fMemoryCounted;
 
     if (node->fPrev) {
         node->fPrev->fNext = node->fNext;
@@ -643,7 +801,7 @@ void SkStrikeCache::validate() const {
 
     const Node* node = fHead;
     while (node != nullptr) {
-        computedBytes += node->fStrike.getMemoryUsed();
+        computedBytes += node->fMemoryCounted;
         computedCount += 1;
         node = node->fNext;
     }
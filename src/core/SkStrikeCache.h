@@ -12,8 +12,10 @@
 #include <unordered_set>
 
 #include "SkDescriptor.h"
+#include "SkGlyphDiskCache.h"
 #include "SkStrike.h"
 #include "SkSpinlock.h"
+#include "SkTHash.h"
 #include "SkTemplates.h"
 
 class SkStrike;
@@ -141,6 +143,30 @@ public:
     static std::unique_ptr<SkScalerContext> CreateScalerContext(
             const SkDescriptor&, const SkScalerContextEffects&, const SkTypeface&);
 
+    // In shared-strike mode, FindOrCreateStrike*() hands every caller asking for the same
+    // descriptor the same SkStrike, which stays in the cache while in use instead of being
+    // detached for one thread.  Those strikes are SkStrike::Mode::kShared, so glyphs that exist
+    // are found without locking and each glyph is only ever made once.  Strikes made with
+    // CreateStrike*() are always exclusive.  Returns the previous mode.
+    //
+    // Strikes for typefaces made by an SkStrikeClient stay exclusive in either mode: the client
+    // fills in the glyphs of exclusive strikes, which shared lookups would never find.
+    static bool SetSharedStrikes(bool);
+    bool setSharedStrikes(bool);
+
+    // Called by SkStrikeClient for each typeface it makes, and again when it goes away.
+    void addClientTypeface(SkFontID);
+    void removeClientTypeface(SkFontID);
+
+    // Keep the glyphs made by FindOrCreateStrike*() in files in this directory (see
+    // SkGlyphDiskCache), and read glyphs from them before asking the font host.  Pass null to
+    // stop.  New glyphs are only written by SaveDiskCache(), which saves every strike that isn't
+    // in use and returns how many files it wrote.
+    static void SetDiskCacheDirectory(const char directory[]);
+    void setDiskCacheDirectory(const char directory[]);
+    static int SaveDiskCache();
+    int saveDiskCache();
+
     static void PurgeAll();
     static void ValidateGlyphCacheDataSize();
     static void Dump();
@@ -182,6 +208,7 @@ private:
     Node* internalGetTail() const { return fTail; }
     void internalDetachCache(Node*);
     void internalAttachToHead(Node*);
+    Node* internalFindAndRefShared(const SkDescriptor&);
 
     // Checkout budgets, modulated by the specified min-bytes-needed-to-purge,
     // and attempt to purge caches to match.
@@ -190,6 +217,9 @@ private:
 
     void forEachStrike(std::function<void(const SkStrike&)> visitor) const;
 
+    Node* findAndRefSharedStrike(const SkDescriptor&);
+    void releaseSharedStrike(Node*);
+
     mutable SkSpinlock fLock;
     Node*              fHead{nullptr};
     Node*              fTail{nullptr};
@@ -198,6 +228,9 @@ private:
     int32_t            fCacheCountLimit{SK_DEFAULT_FONT_CACHE_COUNT_LIMIT};
     int32_t            fCacheCount{0};
     int32_t            fPointSizeLimit{SK_DEFAULT_FONT_CACHE_POINT_SIZE_LIMIT};
+    bool               fSharedStrikes{false};
+    SkTHashSet<SkFontID> fClientTypefaces;
+    sk_sp<SkGlyphDiskCache> fDiskCache;
 };
 
 using SkExclusiveStrikePtr = SkStrikeCache::ExclusiveStrikePtr;
@@ -818,6 +818,63 @@ sk_sp<SkTextBlob> SkTextBlobPriv::MakeFromBuffer(SkReadBuffer& reader) {
     return blobBuilder.make();
 }
 
+static bool skip_byte_array(SkReadBuffer& reader, size_t size) {
+    return reader.validate(reader.readUInt() == size) && reader.skip(size) != nullptr;
+}
+
+bool SkTextBlobPriv::SkipFromBuffer(SkReadBuffer& reader, SkRect* bounds) {
+    reader.readRect(bounds);
+
+    SkSafeMath safe;
+    for (;;) {
+        int glyphCount = reader.read32();
+        if (glyphCount == 0) {
+            // End-of-runs marker.
+            break;
+        }
+
+        PositioningAndExtended pe;
+        pe.intValue = reader.read32();
+        const auto pos = SkTo<SkTextBlob::GlyphPositioning>(pe.positioning);
+        if (glyphCount <= 0 || pos > SkTextBlob::kRSXform_Positioning) {
+            return false;
+        }
+        int textSize = pe.extended ? reader.read32() : 0;
+        if (textSize < 0) {
+            return false;
+        }
+
+        SkPoint offset;
+        reader.readPoint(&offset);
+        SkFont font;
+        if (reader.isVersionLT(SkReadBuffer::kSerializeFonts_Version)) {
+            SkPaint paint;
+            reader.readPaint(&paint, &font);
+        } else {
+            SkFontPriv::Unflatten(&font, reader);
+        }
+
+        const size_t glyphSize = safe.mul(glyphCount, sizeof(uint16_t)),
+                     posSize =
+                             safe.mul(glyphCount, safe.mul(sizeof(SkScalar),
+                             SkTextBlob::ScalarsPerGlyph(pos))),
+                     clusterSize = pe.extended ? safe.mul(glyphCount, sizeof(uint32_t)) : 0;
+        if (!reader.isValid() || !safe ||
+            !skip_byte_array(reader, glyphSize) ||
+            !skip_byte_array(reader, posSize)) {
+            return false;
+        }
+        if (pe.extended) {
+            if (!skip_byte_array(reader, clusterSize) ||
+                !skip_byte_array(reader, textSize)) {
+                return false;
+            }
+        }
+    }
+
+    return reader.isValid();
+}
+
 sk_sp<SkTextBlob> SkTextBlob::MakeFromText(const void* text, size_t byteLength, const SkFont& font,
                                            SkTextEncoding encoding) {
     // Note: we deliberately promote this to fully positioned blobs, since we'd have to pay the
@@ -38,6 +38,12 @@ public:
      *          invalid.
      */
     static sk_sp<SkTextBlob> MakeFromBuffer(SkReadBuffer&);
+
+    /**
+     *  Step over a blob serialized into a buffer without recreating it, reading just its bounds.
+     *  Returns false if the buffer is invalid.
+     */
+    static bool SkipFromBuffer(SkReadBuffer&, SkRect* bounds);
 };
 
 class SkTextBlobBuilderPriv {
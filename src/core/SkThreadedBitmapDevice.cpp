@@ -0,0 +1,427 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkThreadedBitmapDevice.h"
+
+#include "SkDraw.h"
+#include "SkExecutor.h"
+#include "SkGlyphRun.h"
+#include "SkRRect.h"
+#include "SkRTree.h"
+#include "SkSpecialImage.h"
+#include "SkStrikeCache.h"
+#include "SkTSort.h"
+#include "SkTaskGroup.h"
+#include "SkTextBlob.h"
+#include "SkVertices.h"
+#include <memory>
+#include <vector>
+
+// Draws are rasterized in square tiles of this size.
+static constexpr int kTileSize = 256;
+
+// We flush once this many draws are pending, to bound the memory used by the queue.
+static constexpr int kMaxQueuedDraws = 4096;
+
+// Like SkDrawTiler::kMaxDim.  Devices bigger than this draw serially through SkDrawTiler.
+static constexpr int kMaxDim = 8192 - 1;
+
+SkThreadedBitmapDevice::SkThreadedBitmapDevice(const SkBitmap& bitmap,
+                                               const SkSurfaceProps& props,
+                                               SkExecutor* executor)
+    : INHERITED(bitmap, props, nullptr, nullptr)
+    , fExecutor(executor) {
+    SkASSERT(fExecutor);
+    fSerial = bitmap.width() > kMaxDim || bitmap.height() > kMaxDim;
+}
+
+SkThreadedBitmapDevice::~SkThreadedBitmapDevice() {
+    this->flush();
+}
+
+SkBaseDevice* SkThreadedBitmapDevice::onCreateDevice(const CreateInfo& cinfo,
+                                                     const SkPaint* paint) {
+    if (cinfo.fTrackCoverage || cinfo.fAllocator) {
+        return INHERITED::onCreateDevice(cinfo, paint);
+    }
+
+    SkAlphaType alphaType = cinfo.fInfo.alphaType();
+    if (SkColorTypeIsAlwaysOpaque(cinfo.fInfo.colorType())) {
+        alphaType = kOpaque_SkAlphaType;
+    }
+    const SkImageInfo info = cinfo.fInfo.makeAlphaType(alphaType);
+
+    SkBitmap bitmap;
+    if (kUnknown_SkColorType == info.colorType()) {
+        return INHERITED::onCreateDevice(cinfo, paint);
+    }
+    if (info.isOpaque() ? !bitmap.tryAllocPixels(info)
+                        : !bitmap.tryAllocPixelsFlags(info, SkBitmap::kZeroPixels_AllocFlag)) {
+        return nullptr;
+    }
+
+    const SkSurfaceProps props(this->surfaceProps().flags(), cinfo.fPixelGeometry);
+    return new SkThreadedBitmapDevice(bitmap, props, fExecutor);
+}
+
+// Draw serially while in scope.  Any pending draws must be flushed first.
+class SkThreadedBitmapDevice::AutoSerial {
+public:
+    explicit AutoSerial(SkThreadedBitmapDevice* device)
+        : fDevice(device)
+        , fWasSerial(device->fSerial) {
+        fDevice->flush();
+        fDevice->fSerial = true;
+    }
+    ~AutoSerial() { fDevice->fSerial = fWasSerial; }
+
+private:
+    SkThreadedBitmapDevice* fDevice;
+    bool                    fWasSerial;
+};
+
+void SkThreadedBitmapDevice::defer(const SkRect* localBounds, const SkPaint& paint, DrawFn fn) {
+    SkIRect devBounds = fRCStack.rc().getBounds();
+    if (localBounds && paint.canComputeFastBounds()) {
+        SkRect storage;
+        const SkRect& bounds = paint.computeFastBounds(*localBounds, &storage);
+        // Outset by a pixel to cover antialiasing and hairlines.
+        SkIRect drawBounds = this->ctm().mapRect(bounds).roundOut().makeOutset(1, 1);
+        if (!devBounds.intersect(drawBounds)) {
+            return;
+        }
+    }
+    this->deferDevice(devBounds, std::move(fn));
+}
+
+void SkThreadedBitmapDevice::deferDevice(const SkIRect& devBounds, DrawFn fn) {
+    SkIRect bounds = devBounds;
+    if (!bounds.intersect(fRCStack.rc().getBounds())) {
+        return;
+    }
+
+    DrawElement* element = &fQueue.push_back();
+    element->fBounds = bounds;
+    element->fMatrix = this->ctm();
+    (void)element->fMatrix.getType();  // getType() isn't thread safe unless we precache it.
+    element->fRC     = fRCStack.rc();
+    element->fDraw   = std::move(fn);
+
+    if (fQueue.count() >= kMaxQueuedDraws) {
+        this->flush();
+    }
+}
+
+void SkThreadedBitmapDevice::flush() {
+    if (fQueue.empty()) {
+        return;
+    }
+
+    // Not this->accessPixels(), which would flush() again.
+    SkPixmap dst;
+    if (!fBitmap.peekPixels(&dst)) {
+        fQueue.reset();
+        return;
+    }
+    fBitmap.notifyPixelsChanged();
+
+    const int N = fQueue.count();
+    std::unique_ptr<SkRect[]> bounds(new SkRect[N]);
+    for (int i = 0; i < N; i++) {
+        bounds[i] = SkRect::Make(fQueue[i].fBounds);
+    }
+    SkRTree rtree;
+    rtree.insert(bounds.get(), N);
+
+    const int cols = (this->width()  + kTileSize - 1) / kTileSize,
+              rows = (this->height() + kTileSize - 1) / kTileSize;
+
+    SkTaskGroup tiles(*fExecutor);
+    tiles.batch(cols * rows, [&](int i) {
+        const SkIRect tile = SkIRect::MakeXYWH((i % cols) * kTileSize,
+                                               (i / cols) * kTileSize,
+                                               kTileSize, kTileSize);
+        SkTDArray<int> ops;
+        rtree.search(SkRect::Make(tile), &ops);
+        if (ops.isEmpty()) {
+            return;
+        }
+        // Draw in the order the draws were made.
+        SkTQSort(ops.begin(), ops.end() - 1);
+
+        SkGlyphRunListPainter glyphPainter(this->surfaceProps(),
+                                           dst.colorType(),
+                                           dst.colorSpace(),
+                                           SkStrikeCache::GlobalStrikeCache());
+        for (int op : ops) {
+            const DrawElement& element = fQueue[op];
+
+            // Like SkDrawTiler, we clip each draw to the tile.  This keeps tiles from writing
+            // each other's pixels, and lets scan conversion skip all that lies outside the tile;
+            // with only the device clip, a large path would be rasterized in full once for every
+            // tile it touches.  The edges of curves and lines that cross the tile's bounds may
+            // come out a little differently than SkBitmapDevice would draw them, just as they do
+            // across SkDrawTiler's tiles.
+            SkRasterClip tileRC(element.fRC);
+            if (!tileRC.op(tile, SkRegion::kIntersect_Op)) {
+                continue;
+            }
+
+            SkDraw draw;
+            draw.fDst    = dst;
+            draw.fMatrix = &element.fMatrix;
+            draw.fRC     = &tileRC;
+            element.fDraw(draw, &glyphPainter);
+        }
+    });
+    tiles.wait();
+
+    fQueue.reset();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void SkThreadedBitmapDevice::drawPaint(const SkPaint& paint) {
+    if (fSerial) {
+        return INHERITED::drawPaint(paint);
+    }
+    this->defer(nullptr, paint, [paint](const SkDraw& draw, SkGlyphRunListPainter*) {
+        draw.drawPaint(paint);
+    });
+}
+
+void SkThreadedBitmapDevice::drawPoints(SkCanvas::PointMode mode, size_t count,
+                                        const SkPoint pts[], const SkPaint& paint) {
+    if (fSerial) {
+        return INHERITED::drawPoints(mode, count, pts, paint);
+    }
+    auto points = std::make_shared<std::vector<SkPoint>>(pts, pts + count);
+    this->defer(nullptr, paint, [=](const SkDraw& draw, SkGlyphRunListPainter*) {
+        draw.drawPoints(mode, points->size(), points->data(), paint, nullptr);
+    });
+}
+
+void SkThreadedBitmapDevice::drawRect(const SkRect& r, const SkPaint& paint) {
+    if (fSerial) {
+        return INHERITED::drawRect(r, paint);
+    }
+    this->defer(&r, paint, [=](const SkDraw& draw, SkGlyphRunListPainter*) {
+        draw.drawRect(r, paint);
+    });
+}
+
+void SkThreadedBitmapDevice::drawRRect(const SkRRect& rrect, const SkPaint& paint) {
+    if (fSerial) {
+        return INHERITED::drawRRect(rrect, paint);
+    }
+    this->defer(&rrect.getBounds(), paint, [=](const SkDraw& draw, SkGlyphRunListPainter*) {
+        draw.drawRRect(rrect, paint);
+    });
+}
+
+void SkThreadedBitmapDevice::drawPath(const SkPath& path, const SkPaint& paint,
+                                      bool pathIsMutable) {
+    if (fSerial) {
+        return INHERITED::drawPath(path, paint, pathIsMutable);
+    }
+    // Like SkRecords::PreCachedPath, make sure the lazily computed parts of the path are
+    // computed here on one thread, not raced on later by many.
+    SkPath copy(path);
+    copy.updateBoundsCache();
+    (void)copy.getGenerationID();
+
+    const SkRect* bounds = copy.isInverseFillType() ? nullptr : &copy.getBounds();
+    this->defer(bounds, paint, [copy, paint](const SkDraw& draw, SkGlyphRunListPainter*) {
+        draw.drawPath(copy, paint, nullptr, false);
+    });
+}
+
+void SkThreadedBitmapDevice::drawSprite(const SkBitmap& bitmap, int x, int y,
+                                        const SkPaint& paint) {
+    // A mutable bitmap may change before we'd get around to drawing it.
+    if (fSerial || !bitmap.isImmutable()) {
+        this->flush();
+        return INHERITED::drawSprite(bitmap, x, y, paint);
+    }
+    this->deferDevice(SkIRect::MakeXYWH(x, y, bitmap.width(), bitmap.height()),
+                      [=](const SkDraw& draw, SkGlyphRunListPainter*) {
+        draw.drawSprite(bitmap, x, y, paint);
+    });
+}
+
+void SkThreadedBitmapDevice::drawBitmapRect(const SkBitmap& bitmap,
+                                            const SkRect* src, const SkRect& dst,
+                                            const SkPaint& paint,
+                                            SkCanvas::SrcRectConstraint constraint) {
+    // SkBitmapDevice turns this into calls to drawBitmap() or drawRect() with a bitmap shader.
+    // The shader doesn't copy the bitmap, so mutable bitmaps need to be drawn right away.
+    if (fSerial || !bitmap.isImmutable()) {
+        AutoSerial serial(this);  // Don't defer the drawBitmap() or drawRect().
+        return INHERITED::drawBitmapRect(bitmap, src, dst, paint, constraint);
+    }
+    INHERITED::drawBitmapRect(bitmap, src, dst, paint, constraint);
+}
+
+void SkThreadedBitmapDevice::drawBitmap(const SkBitmap& bitmap, const SkMatrix& matrix,
+                                        const SkRect* dstOrNull, const SkPaint& paint) {
+    if (fSerial || !bitmap.isImmutable()) {
+        this->flush();
+        return INHERITED::drawBitmap(bitmap, matrix, dstOrNull, paint);
+    }
+
+    SkRect bounds = dstOrNull ? *dstOrNull
+                              : matrix.mapRect(SkRect::MakeIWH(bitmap.width(), bitmap.height()));
+    bool hasDst = dstOrNull != nullptr;
+    SkMatrix bitmapMatrix = matrix;
+    (void)bitmapMatrix.getType();
+    this->defer(&bounds, paint, [=](const SkDraw& draw, SkGlyphRunListPainter*) {
+        draw.drawBitmap(bitmap, bitmapMatrix, hasDst ? &bounds : nullptr, paint);
+    });
+}
+
+namespace {
+
+// A deep copy of an SkGlyphRunList, which otherwise points into short-lived buffers.
+class GlyphRunListCopy {
+public:
+    explicit GlyphRunListCopy(const SkGlyphRunList& list)
+        : fPaint(list.paint())
+        , fOrigin(list.origin()) {
+        size_t glyphs = list.totalGlyphCount();
+        fGlyphIDs .reserve(glyphs);
+        fPositions.reserve(glyphs);
+        fRuns     .reserve(list.runCount());
+
+        for (const SkGlyphRun& run : list) {
+            size_t start = fGlyphIDs.size();
+            fGlyphIDs .insert(fGlyphIDs .end(), run.glyphsIDs().begin(), run.glyphsIDs().end());
+            fPositions.insert(fPositions.end(), run.positions().begin(), run.positions().end());
+            fRuns.emplace_back(run.font(),
+                               SkSpan<const SkPoint>{fPositions.data() + start, run.runSize()},
+                               SkSpan<const SkGlyphID>{fGlyphIDs.data() + start, run.runSize()},
+                               SkSpan<const char>{},
+                               SkSpan<const uint32_t>{});
+        }
+    }
+
+    SkGlyphRunList list() const {
+        return SkGlyphRunList(fPaint, nullptr, fOrigin,
+                              SkSpan<const SkGlyphRun>{fRuns.data(), fRuns.size()});
+    }
+
+private:
+    SkPaint                 fPaint;
+    SkPoint                 fOrigin;
+    std::vector<SkGlyphID>  fGlyphIDs;
+    std::vector<SkPoint>    fPositions;
+    std::vector<SkGlyphRun> fRuns;
+};
+
+}  // namespace
+
+void SkThreadedBitmapDevice::drawGlyphRunList(const SkGlyphRunList& glyphRunList) {
+    if (fSerial) {
+        return INHERITED::drawGlyphRunList(glyphRunList);
+    }
+
+    // Text blobs know their bounds.  Other text could land anywhere in the clip.
+    SkRect storage;
+    const SkRect* bounds = nullptr;
+    if (const SkTextBlob* blob = glyphRunList.blob()) {
+        storage = blob->bounds().makeOffset(glyphRunList.origin().x(),
+                                            glyphRunList.origin().y());
+        bounds = &storage;
+    }
+
+    auto copy = std::make_shared<GlyphRunListCopy>(glyphRunList);
+    this->defer(bounds, glyphRunList.paint(),
+                [copy](const SkDraw& draw, SkGlyphRunListPainter* glyphPainter) {
+        draw.drawGlyphRunList(copy->list(), glyphPainter);
+    });
+}
+
+void SkThreadedBitmapDevice::drawVertices(const SkVertices* vertices,
+                                          const SkVertices::Bone bones[], int boneCount,
+                                          SkBlendMode bmode, const SkPaint& paint) {
+    if (fSerial) {
+        return INHERITED::drawVertices(vertices, bones, boneCount, bmode, paint);
+    }
+
+    sk_sp<SkVertices> verts = sk_ref_sp(vertices);
+    auto boneCopy = std::make_shared<std::vector<SkVertices::Bone>>(bones, bones + boneCount);
+    const SkRect* bounds = boneCount ? nullptr : &vertices->bounds();
+    this->defer(bounds, paint, [=](const SkDraw& draw, SkGlyphRunListPainter*) {
+        draw.drawVertices(verts->mode(), verts->vertexCount(), verts->positions(),
+                          verts->texCoords(), verts->colors(), verts->boneIndices(),
+                          verts->boneWeights(), bmode, verts->indices(), verts->indexCount(),
+                          paint, boneCopy->data(), SkToInt(boneCopy->size()));
+    });
+}
+
+void SkThreadedBitmapDevice::drawDevice(SkBaseDevice* device, int x, int y,
+                                        const SkPaint& paint) {
+    // Finish drawing the layer before we draw it into ourselves.
+    device->flush();
+
+    SkBitmapDevice* src = static_cast<SkBitmapDevice*>(device);
+    if (fSerial || src->fCoverage || paint.getMaskFilter()) {
+        AutoSerial serial(this);
+        return INHERITED::drawDevice(device, x, y, paint);
+    }
+
+    // The layer's device goes away after this, but nothing else will draw into its pixels.
+    SkBitmap bitmap = src->fBitmap;
+    this->deferDevice(SkIRect::MakeXYWH(x, y, bitmap.width(), bitmap.height()),
+                      [=](const SkDraw& draw, SkGlyphRunListPainter*) {
+        draw.drawSprite(bitmap, x, y, paint);
+    });
+}
+
+void SkThreadedBitmapDevice::drawSpecial(SkSpecialImage* src, int x, int y, const SkPaint& paint,
+                                         SkImage* clipImage, const SkMatrix& clipMatrix) {
+    // Image filters are rare and complicated, so we just draw them serially.
+    AutoSerial serial(this);
+    INHERITED::drawSpecial(src, x, y, paint, clipImage, clipMatrix);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void SkThreadedBitmapDevice::setImmutable() {
+    // A layer is made immutable just before it's drawn into its parent, so finish it first.
+    this->flush();
+    INHERITED::setImmutable();
+}
+
+sk_sp<SkSpecialImage> SkThreadedBitmapDevice::snapSpecial() {
+    this->flush();
+    return INHERITED::snapSpecial();
+}
+
+sk_sp<SkSpecialImage> SkThreadedBitmapDevice::snapBackImage(const SkIRect& bounds) {
+    this->flush();
+    return INHERITED::snapBackImage(bounds);
+}
+
+bool SkThreadedBitmapDevice::onReadPixels(const SkPixmap& pm, int x, int y) {
+    this->flush();
+    return INHERITED::onReadPixels(pm, x, y);
+}
+
+bool SkThreadedBitmapDevice::onWritePixels(const SkPixmap& pm, int x, int y) {
+    this->flush();
+    return INHERITED::onWritePixels(pm, x, y);
+}
+
+bool SkThreadedBitmapDevice::onPeekPixels(SkPixmap* pmap) {
+    this->flush();
+    return INHERITED::onPeekPixels(pmap);
+}
+
+bool SkThreadedBitmapDevice::onAccessPixels(SkPixmap* pmap) {
+    this->flush();
+    return INHERITED::onAccessPixels(pmap);
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkThreadedBitmapDevice_DEFINED
+#define SkThreadedBitmapDevice_DEFINED
+
+#include "SkBitmapDevice.h"
+#include "SkRasterClip.h"
+#include "SkTArray.h"
+#include <functional>
+
+class SkDraw;
+class SkExecutor;
+
+// SkThreadedBitmapDevice defers draws instead of rasterizing them right away.  Each deferred
+// draw remembers its matrix, its clip, and conservative device-space bounds.  When the pixels
+// are needed, flush() bins the draws into tiles with an SkRTree and rasterizes the tiles in
+// parallel on an SkExecutor, each tile clipping its draws to its own bounds.
+//
+// Like SkDrawTiler, every tile draws with the same matrices as SkBitmapDevice would, so the
+// result matches drawing serially except along the edges of curves and lines that a tile clips.
+// Draws that are awkward to defer (image filters, mutable bitmaps, coverage tracking, very large
+// devices) flush and then draw serially.
+class SkThreadedBitmapDevice final : public SkBitmapDevice {
+public:
+    // The executor must outlive this device.
+    SkThreadedBitmapDevice(const SkBitmap&, const SkSurfaceProps&, SkExecutor*);
+    ~SkThreadedBitmapDevice() override;
+
+    void flush() override;
+
+protected:
+    void drawPaint(const SkPaint&) override;
+    void drawPoints(SkCanvas::PointMode, size_t count, const SkPoint[], const SkPaint&) override;
+    void drawRect(const SkRect&, const SkPaint&) override;
+    void drawRRect(const SkRRect&, const SkPaint&) override;
+    void drawPath(const SkPath&, const SkPaint&, bool pathIsMutable) override;
+    void drawSprite(const SkBitmap&, int x, int y, const SkPaint&) override;
+    void drawBitmapRect(const SkBitmap&, const SkRect*, const SkRect&,
+                        const SkPaint&, SkCanvas::SrcRectConstraint) override;
+    void drawBitmap(const SkBitmap&, const SkMatrix&, const SkRect* dstOrNull,
+                    const SkPaint&) override;
+    void drawGlyphRunList(const SkGlyphRunList&) override;
+    void drawVertices(const SkVertices*, const SkVertices::Bone bones[], int boneCount,
+                      SkBlendMode, const SkPaint&) override;
+    void drawDevice(SkBaseDevice*, int x, int y, const SkPaint&) override;
+    void drawSpecial(SkSpecialImage*, int x, int y, const SkPaint&,
+                     SkImage*, const SkMatrix&) override;
+
+    void setImmutable() override;
+
+    sk_sp<SkSpecialImage> snapSpecial() override;
+    sk_sp<SkSpecialImage> snapBackImage(const SkIRect&) override;
+
+    bool onReadPixels(const SkPixmap&, int x, int y) override;
+    bool onWritePixels(const SkPixmap&, int, int) override;
+    bool onPeekPixels(SkPixmap*) override;
+    bool onAccessPixels(SkPixmap*) override;
+
+private:
+    using DrawFn = std::function<void(const SkDraw&, SkGlyphRunListPainter*)>;
+
+    struct DrawElement {
+        SkIRect      fBounds;   // Conservative device-space bounds, already clipped.
+        SkMatrix     fMatrix;
+        SkRasterClip fRC;
+        DrawFn       fDraw;
+    };
+
+    class AutoSerial;
+
+    SkBaseDevice* onCreateDevice(const CreateInfo&, const SkPaint*) override;
+
+    // Defer a draw touching at most localBounds (mapped by the CTM), or the whole clip if null.
+    void defer(const SkRect* localBounds, const SkPaint&, DrawFn);
+
+    // Defer a draw touching at most the given device-space bounds.
+    void deferDevice(const SkIRect& devBounds, DrawFn);
+
+    SkExecutor*               fExecutor;
+    SkTArray<DrawElement>     fQueue;
+    bool                      fSerial;  // When true, draw immediately with SkBitmapDevice.
+
+    typedef SkBitmapDevice INHERITED;
+};
+
+#endif//SkThreadedBitmapDevice_DEFINED
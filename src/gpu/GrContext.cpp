@@ -278,6 +278,16 @@ void GrContext::storeVkPipelineCacheData() {
     }
 }
 
+sk_sp<SkData> GrContext::dumpRecordedPrograms() const {
+    return fGpu ? fGpu->dumpRecordedPrograms() : nullptr;
+}
+
+bool GrContext::precompile(const SkData& data) {
+    ASSERT_SINGLE_OWNER
+    RETURN_FALSE_IF_ABANDONED
+    return fGpu->precompile(data);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 std::unique_ptr<GrFragmentProcessor> GrContext::createPMToUPMEffect(
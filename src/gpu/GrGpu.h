@@ -463,6 +463,10 @@ public:
 
     virtual void storeVkPipelineCacheData() {}
 
+    /** See GrContext::dumpRecordedPrograms() and GrContext::precompile(). */
+    virtual sk_sp<SkData> dumpRecordedPrograms() const { return nullptr; }
+    virtual bool precompile(const SkData&) { return false; }
+
 protected:
     // Handles cases where a surface will be updated without a call to flushRenderTarget.
     void didWriteToSurface(GrSurface* surface, GrSurfaceOrigin origin, const SkIRect* bounds,
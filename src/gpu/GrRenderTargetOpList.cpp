@@ -22,11 +22,19 @@
 #include "ops/GrClearOp.h"
 #include "ops/GrCopySurfaceOp.h"
 
+#include <algorithm>
+
 ////////////////////////////////////////////////////////////////////////////////
 
 // Experimentally we have found that most combining occurs within the first 10 comparisons.
 static const int kMaxOpMergeDistance = 10;
-static const int kMaxOpChainDistance = 10;
+// Chains are only compared with chains of the same op class that they can be reordered with, so
+// these comparisons can reach much further back than kMaxOpMergeDistance does.
+static const int kMaxOpChainCandidates = 10;
+
+// The grid of the op chain index has a cell about every 64 pixels, up to 16 in each direction.
+static const int kOpChainIndexCellSize = 64;
+static const int kMaxOpChainIndexGridSize = 16;
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -357,6 +365,104 @@ GrRenderTargetOpList::GrRenderTargetOpList(GrResourceProvider* resourceProvider,
         SkDEBUGCODE(, fNumClips(0)) {
 }
 
+void GrRenderTargetOpList::OpChainIndex::reset(SkISize targetSize) {
+    // A target whose size isn't known yet gets a single cell.
+    auto gridSize = [](int size) {
+        return SkTPin((size + kOpChainIndexCellSize - 1) / kOpChainIndexCellSize, 1,
+                      kMaxOpChainIndexGridSize);
+    };
+    fGridWidth = gridSize(targetSize.width());
+    fGridHeight = gridSize(targetSize.height());
+    fCellsPerX = targetSize.width() > 0 ? fGridWidth / SkIntToScalar(targetSize.width()) : 0;
+    fCellsPerY = targetSize.height() > 0 ? fGridHeight / SkIntToScalar(targetSize.height()) : 0;
+    fCells.reset(fGridWidth * fGridHeight);
+    fBounds.rewind();
+    fChainsByClass.reset();
+}
+
+SkIRect GrRenderTargetOpList::OpChainIndex::cellRange(const SkRect& bounds) const {
+    auto cell = [](SkScalar x, SkScalar cellsPerX, int gridSize) {
+        // Pin before converting, the bounds may be far outside of the target.
+        return SkScalarFloorToInt(SkTPin(x * cellsPerX, 0.f, SkIntToScalar(gridSize - 1)));
+    };
+    return SkIRect::MakeLTRB(cell(bounds.fLeft, fCellsPerX, fGridWidth),
+                             cell(bounds.fTop, fCellsPerY, fGridHeight),
+                             cell(bounds.fRight, fCellsPerX, fGridWidth),
+                             cell(bounds.fBottom, fCellsPerY, fGridHeight));
+}
+
+void GrRenderTargetOpList::OpChainIndex::addChain(int index, uint32_t classID,
+                                                  const SkRect& bounds) {
+    SkASSERT(index == fBounds.count());
+    *fBounds.append() = bounds;
+    SkTDArray<int>* chains = fChainsByClass.find(classID);
+    if (!chains) {
+        chains = fChainsByClass.set(classID, SkTDArray<int>());
+    }
+    *chains->append() = index;
+    SkIRect cells = this->cellRange(bounds);
+    for (int y = cells.fTop; y <= cells.fBottom; ++y) {
+        for (int x = cells.fLeft; x <= cells.fRight; ++x) {
+            *this->cell(x, y).append() = index;
+        }
+    }
+}
+
+void GrRenderTargetOpList::OpChainIndex::growChain(int index, const SkRect& bounds) {
+    SkIRect oldCells = this->cellRange(fBounds[index]);
+    fBounds[index] = bounds;
+    SkIRect cells = this->cellRange(bounds);
+    for (int y = cells.fTop; y <= cells.fBottom; ++y) {
+        for (int x = cells.fLeft; x <= cells.fRight; ++x) {
+            if (oldCells.fLeft <= x && x <= oldCells.fRight &&
+                oldCells.fTop <= y && y <= oldCells.fBottom) {
+                continue;
+            }
+            // Later chains may already be in the cell, keep it in order.
+            SkTDArray<int>& chains = this->cell(x, y);
+            int i = std::upper_bound(chains.begin(), chains.end(), index) - chains.begin();
+            *chains.insert(i) = index;
+        }
+    }
+}
+
+int GrRenderTargetOpList::OpChainIndex::lastOverlap(const SkRect& bounds) const {
+    int last = -1;
+    SkIRect cells = this->cellRange(bounds);
+    for (int y = cells.fTop; y <= cells.fBottom; ++y) {
+        for (int x = cells.fLeft; x <= cells.fRight; ++x) {
+            const SkTDArray<int>& chains = this->cell(x, y);
+            for (int i = chains.count() - 1; i >= 0 && chains[i] > last; --i) {
+                if (GrRectsOverlap(fBounds[chains[i]], bounds)) {
+                    last = chains[i];
+                    break;
+                }
+            }
+        }
+    }
+    return last;
+}
+
+int GrRenderTargetOpList::OpChainIndex::firstOverlapAfter(int index, const SkRect& bounds) const {
+    int first = INT_MAX;
+    SkIRect cells = this->cellRange(bounds);
+    for (int y = cells.fTop; y <= cells.fBottom; ++y) {
+        for (int x = cells.fLeft; x <= cells.fRight; ++x) {
+            const SkTDArray<int>& chains = this->cell(x, y);
+            for (const int* chain = std::upper_bound(chains.begin(), chains.end(), index);
+                 chain != chains.end() && *chain < first; ++chain) {
+                if (GrRectsOverlap(fBounds[*chain], bounds)) {
+                    first = *chain;
+                    break;
+                }
+            }
+        }
+    }
+    return first;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void GrRenderTargetOpList::deleteOps() {
     for (auto& chain : fOpChains) {
         chain.deleteOps(fOpMemoryPool.get());
@@ -661,10 +767,11 @@ void GrRenderTargetOpList::recordOp(
         return;
     }
 
-    // Check if there is an op we can combine with by linearly searching back until we either
-    // 1) check every op
-    // 2) intersect with something
-    // 3) find a 'blocker'
+    // Check if there is a chain we can add the op to, by searching back through the chains of the
+    // op's class until we either
+    // 1) check every chain of the class
+    // 2) reach the last chain the op intersects
+    // 3) have tried kMaxOpChainCandidates chains
     GR_AUDIT_TRAIL_ADD_OP(fAuditTrail, op.get(), fTarget.get()->uniqueID());
     GrOP_INFO("opList: %d Recording (%s, opID: %u)\n"
               "\tBounds [L: %.2f, T: %.2f R: %.2f B: %.2f]\n",
@@ -675,34 +782,37 @@ void GrRenderTargetOpList::recordOp(
                op->bounds().fRight, op->bounds().fBottom);
     GrOP_INFO(SkTabString(op->dumpInfo(), 1).c_str());
     GrOP_INFO("\tOutcome:\n");
-    int maxCandidates = SkTMin(kMaxOpChainDistance, fOpChains.count());
-    if (maxCandidates) {
-        int i = 0;
-        while (true) {
-            OpChain& candidate = fOpChains.fromBack(i);
+    if (fOpChains.empty()) {
+        fOpChainIndex.reset(fTarget.get()->isize());
+        GrOP_INFO("\t\tBackward: FirstOp\n");
+    } else if (const SkTDArray<int>* candidates = fOpChainIndex.chainsOfClass(op->classID())) {
+        // The op can be added to any chain of its class after the last one it overlaps.
+        int blocker = fOpChainIndex.lastOverlap(op->bounds());
+        int numCandidates = 0;
+        for (int i = candidates->count() - 1; i >= 0 && (*candidates)[i] >= blocker; --i) {
+            int candidateIdx = (*candidates)[i];
+            OpChain& candidate = fOpChains[candidateIdx];
             op = candidate.appendOp(std::move(op), processorAnalysis, dstProxy, clip, caps,
                                     fOpMemoryPool.get(), fAuditTrail);
             if (!op) {
+                fOpChainIndex.growChain(candidateIdx, candidate.bounds());
                 return;
             }
-            // Stop going backwards if we would cause a painter's order violation.
-            if (!can_reorder(candidate.bounds(), op->bounds())) {
-                GrOP_INFO("\t\tBackward: Intersects with chain (%s, head opID: %u)\n",
-                          candidate.head()->name(), candidate.head()->uniqueID());
-                break;
-            }
-            if (++i == maxCandidates) {
-                GrOP_INFO("\t\tBackward: Reached max lookback or beginning of op array %d\n", i);
+            if (++numCandidates == kMaxOpChainCandidates) {
+                GrOP_INFO("\t\tBackward: Reached max candidates %d\n", numCandidates);
                 break;
             }
         }
-    } else {
-        GrOP_INFO("\t\tBackward: FirstOp\n");
+        if (blocker >= 0) {
+            GrOP_INFO("\t\tBackward: Intersects with chain (%s, head opID: %u)\n",
+                      fOpChains[blocker].head()->name(), fOpChains[blocker].head()->uniqueID());
+        }
     }
     if (clip) {
         clip = fClipAllocator.make<GrAppliedClip>(std::move(*clip));
         SkDEBUGCODE(fNumClips++;)
     }
+    fOpChainIndex.addChain(fOpChains.count(), op->classID(), op->bounds());
     fOpChains.emplace_back(std::move(op), processorAnalysis, clip, dstProxy);
 }
 
@@ -712,24 +822,21 @@ void GrRenderTargetOpList::forwardCombine(const GrCaps& caps) {
 
     for (int i = 0; i < fOpChains.count() - 1; ++i) {
         OpChain& chain = fOpChains[i];
-        int maxCandidateIdx = SkTMin(i + kMaxOpChainDistance, fOpChains.count() - 1);
-        int j = i + 1;
-        while (true) {
-            OpChain& candidate = fOpChains[j];
+        // The chain can be moved into any later chain of its class up to, and including, the first
+        // one it overlaps.
+        int blocker = fOpChainIndex.firstOverlapAfter(i, chain.bounds());
+        const SkTDArray<int>* candidates = fOpChainIndex.chainsOfClass(chain.head()->classID());
+        SkASSERT(candidates);
+        int numCandidates = 0;
+        for (const int* candidateIdx = std::upper_bound(candidates->begin(), candidates->end(), i);
+             candidateIdx != candidates->end() && *candidateIdx <= blocker; ++candidateIdx) {
+            OpChain& candidate = fOpChains[*candidateIdx];
             if (candidate.prependChain(&chain, caps, fOpMemoryPool.get(), fAuditTrail)) {
+                fOpChainIndex.growChain(*candidateIdx, candidate.bounds());
                 break;
             }
-            // Stop traversing if we would cause a painter's order violation.
-            if (!can_reorder(chain.bounds(), candidate.bounds())) {
-                GrOP_INFO(
-                        "\t\t%d: chain (%s head opID: %u) -> "
-                        "Intersects with chain (%s, head opID: %u)\n",
-                        i, chain.head()->name(), chain.head()->uniqueID(), candidate.head()->name(),
-                        candidate.head()->uniqueID());
-                break;
-            }
-            if (++j > maxCandidateIdx) {
-                GrOP_INFO("\t\t%d: chain (%s opID: %u) -> Reached max lookahead or end of array\n",
+            if (++numCandidates == kMaxOpChainCandidates) {
+                GrOP_INFO("\t\t%d: chain (%s opID: %u) -> Reached max candidates\n",
                           i, chain.head()->name(), chain.head()->uniqueID());
                 break;
             }
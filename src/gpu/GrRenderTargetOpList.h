@@ -20,6 +20,8 @@
 #include "SkStringUtils.h"
 #include "SkStrokeRec.h"
 #include "SkTArray.h"
+#include "SkTDArray.h"
+#include "SkTHash.h"
 #include "SkTLazy.h"
 #include "SkTypes.h"
 
@@ -214,6 +216,47 @@ private:
         SkRect fBounds;
     };
 
+    // Finds the recorded chains that an op or chain could be combined with, without visiting every
+    // chain in between. Chains are listed by the class of their ops, and by the cells of a coarse
+    // grid over the target that their bounds touch, so that the nearest chain a new op must draw
+    // after can be found by looking only at the chains near it.
+    class OpChainIndex {
+    public:
+        // Empties the index, and sizes its grid for a target of 'targetSize'.
+        void reset(SkISize targetSize);
+
+        // Adds chain 'index', which must be later than every chain added so far.
+        void addChain(int index, uint32_t classID, const SkRect& bounds);
+        // Chain 'index' has grown to 'bounds', by combining with an op or another chain.
+        void growChain(int index, const SkRect& bounds);
+
+        // The latest chain whose bounds overlap 'bounds', or -1.
+        int lastOverlap(const SkRect& bounds) const;
+        // The earliest chain after 'index' whose bounds overlap 'bounds', or INT_MAX.
+        int firstOverlapAfter(int index, const SkRect& bounds) const;
+
+        // The chains whose ops are of class 'classID', in order, or null.
+        const SkTDArray<int>* chainsOfClass(uint32_t classID) const {
+            return fChainsByClass.find(classID);
+        }
+
+    private:
+        // The grid cells touched by 'bounds', clamped to the grid so that rects that overlap
+        // always share a cell.
+        SkIRect cellRange(const SkRect& bounds) const;
+        SkTDArray<int>& cell(int x, int y) { return fCells[y * fGridWidth + x]; }
+        const SkTDArray<int>& cell(int x, int y) const { return fCells[y * fGridWidth + x]; }
+
+        int fGridWidth = 0;
+        int fGridHeight = 0;
+        SkScalar fCellsPerX = 0;
+        SkScalar fCellsPerY = 0;
+        // The chains touching each cell, in order.
+        SkTArray<SkTDArray<int>> fCells;
+        SkTDArray<SkRect> fBounds;
+        SkTHashMap<uint32_t, SkTDArray<int>> fChainsByClass;
+    };
+
     void purgeOpsWithUninstantiatedProxies() override;
 
     void gatherProxyIntervals(GrResourceAllocator*) const override;
@@ -232,6 +275,8 @@ private:
 
     // For ops/opList we have mean: 5 stdDev: 28
     SkSTArray<25, OpChain, true> fOpChains;
+    // Only used while recording, and by forwardCombine().
+    OpChainIndex fOpChainIndex;
 
     // MDB TODO: 4096 for the first allocation of the clip space will be huge overkill.
     // Gather statistics to determine the correct size.
@@ -8,10 +8,12 @@
 #include "GrGLGpu.h"
 #include "GrBackendSemaphore.h"
 #include "GrBackendSurface.h"
+#include "GrContextPriv.h"
 #include "GrCpuBuffer.h"
 #include "GrFixedClip.h"
 #include "GrGLBuffer.h"
 #include "GrGLGpuCommandBuffer.h"
+#include "GrGLPrecompiler.h"
 #include "GrGLSemaphore.h"
 #include "GrGLStencilAttachment.h"
 #include "GrGLTextureRenderTarget.h"
@@ -411,6 +413,10 @@ GrGLGpu::GrGLGpu(std::unique_ptr<GrGLContext> ctx, GrContext* context)
     if (this->glCaps().samplerObjectSupport()) {
         fSamplerObjectCache.reset(new SamplerObjectCache(this));
     }
+
+    const GrContextOptions& options = context->priv().options();
+    fPrecompiler.reset(new GrGLPrecompiler(this->glCaps().shaderCaps(), options.fExecutor,
+                                           options.fRecordProgramsForPrecompile));
 }
 
 GrGLGpu::~GrGLGpu() {
@@ -513,6 +519,14 @@ void GrGLGpu::disconnect(DisconnectType type) {
     }
 }
 
+sk_sp<SkData> GrGLGpu::dumpRecordedPrograms() const {
+    return fPrecompiler->dump();
+}
+
+bool GrGLGpu::precompile(const SkData& data) {
+    return fPrecompiler->precompile(data);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 void GrGLGpu::onResetContext(uint32_t resetBits) {
@@ -27,6 +27,7 @@
 class GrGLBuffer;
 class GrGLGpuRTCommandBuffer;
 class GrGLGpuTextureCommandBuffer;
+class GrGLPrecompiler;
 class GrPipeline;
 class GrSwizzle;
 
@@ -55,6 +56,12 @@ public:
         return static_cast<GrGLPathRendering*>(pathRendering());
     }
 
+    // Used by GrGLProgramBuilder to record generated SkSL and look up precompiled GLSL.
+    GrGLPrecompiler* precompiler() const { return fPrecompiler.get(); }
+
+    sk_sp<SkData> dumpRecordedPrograms() const override;
+    bool precompile(const SkData&) override;
+
     // Used by GrGLProgram to configure OpenGL state.
     void bindTexture(int unitIdx, GrSamplerState samplerState, GrGLTexture* texture);
 
@@ -431,6 +438,7 @@ private:
 
     // GL program-related state
     ProgramCache*               fProgramCache;
+    std::unique_ptr<GrGLPrecompiler> fPrecompiler;
 
     ///////////////////////////////////////////////////////////////////////////
     ///@name Caching of GL State
@@ -0,0 +1,246 @@
+/*
+ * Copyright 2019 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "gl/GrGLPrecompiler.h"
+
+#include "GrProgramDesc.h"
+#include "GrShaderCaps.h"
+#include "SkExecutor.h"
+#include "SkSLCompiler.h"
+#include "SkStream.h"
+#include "SkTaskGroup.h"
+#include "SkTime.h"
+#include "SkTraceEvent.h"
+
+// Serialized layout:
+//   uint32_t magic, version, entry count
+//   per entry:
+//     uint32_t key length, key bytes
+//     uint32_t flags
+//     per shader type: uint32_t SkSL length, SkSL bytes
+static constexpr uint32_t kMagic = SkSetFourByteTag('G', 'L', 'P', 'C');
+static constexpr uint32_t kVersion = 1;
+
+static SkSL::Program::Kind program_kind(int shaderType) {
+    switch (shaderType) {
+        case kVertex_GrShaderType:   return SkSL::Program::kVertex_Kind;
+        case kGeometry_GrShaderType: return SkSL::Program::kGeometry_Kind;
+        case kFragment_GrShaderType: return SkSL::Program::kFragment_Kind;
+    }
+    SK_ABORT("unexpected shader type");
+    return SkSL::Program::kFragment_Kind;
+}
+
+static SkString desc_key(const GrProgramDesc& desc) {
+    return SkString(reinterpret_cast<const char*>(desc.asKey()), desc.keyLength());
+}
+
+static uint32_t entry_flags(const SkSL::Program::Settings& settings) {
+    using Entry = GrGLPrecompiler::Entry;
+    return (settings.fFlipY              ? Entry::kFlipY_Flag              : 0) |
+           (settings.fSharpenTextures    ? Entry::kSharpenTextures_Flag    : 0) |
+           (settings.fFragColorIsInOut   ? Entry::kFragColorIsInOut_Flag   : 0) |
+           (settings.fForceHighPrecision ? Entry::kForceHighPrecision_Flag : 0);
+}
+
+static bool read_string(SkStream* stream, size_t remaining, SkString* str) {
+    uint32_t length;
+    if (!stream->readU32(&length) || length > remaining) {
+        return false;
+    }
+    str->resize(length);
+    return stream->read(str->writable_str(), length) == length;
+}
+
+GrGLPrecompiler::GrGLPrecompiler(const GrShaderCaps* shaderCaps, SkExecutor* executor,
+                                 bool recordPrograms)
+        : fShaderCaps(shaderCaps)
+        , fExecutor(executor)
+        , fRecordPrograms(recordPrograms) {}
+
+GrGLPrecompiler::~GrGLPrecompiler() {
+    // The background tasks reference fShaderCaps and fPrograms.
+    this->wait();
+}
+
+void GrGLPrecompiler::record(const GrProgramDesc& desc, const SkSL::Program::Settings& settings,
+                             const SkSL::String sksl[kGrShaderTypeCount]) {
+    if (!fRecordPrograms) {
+        return;
+    }
+    SkString key = desc_key(desc);
+    if (fRecordedKeys.contains(key)) {
+        return;
+    }
+    fRecordedKeys.add(key);
+
+    Entry& entry = fRecorded.push_back();
+    entry.fKey = std::move(key);
+    entry.fFlags = entry_flags(settings);
+    for (int i = 0; i < kGrShaderTypeCount; ++i) {
+        entry.fSkSL[i] = sksl[i];
+    }
+}
+
+sk_sp<SkData> GrGLPrecompiler::dump() const {
+    if (fRecorded.empty()) {
+        return nullptr;
+    }
+    SkDynamicMemoryWStream stream;
+    stream.write32(kMagic);
+    stream.write32(kVersion);
+    stream.write32(fRecorded.count());
+    for (const Entry& entry : fRecorded) {
+        stream.write32(SkToU32(entry.fKey.size()));
+        stream.write(entry.fKey.c_str(), entry.fKey.size());
+        stream.write32(entry.fFlags);
+        for (int i = 0; i < kGrShaderTypeCount; ++i) {
+            stream.write32(SkToU32(entry.fSkSL[i].size()));
+            stream.write(entry.fSkSL[i].c_str(), entry.fSkSL[i].size());
+        }
+    }
+    return stream.detachAsData();
+}
+
+bool GrGLPrecompiler::Parse(const SkData& data, SkTArray<Entry>* entries) {
+    SkMemoryStream stream(data.data(), data.size(), false);
+    uint32_t magic, version, count;
+    if (!stream.readU32(&magic) || magic != kMagic ||
+        !stream.readU32(&version) || version != kVersion ||
+        !stream.readU32(&count)) {
+        return false;
+    }
+    SkTArray<Entry> parsed;
+    for (uint32_t n = 0; n < count; ++n) {
+        Entry& entry = parsed.push_back();
+        size_t remaining = stream.getLength() - stream.getPosition();
+        if (!read_string(&stream, remaining, &entry.fKey) || entry.fKey.isEmpty() ||
+            !stream.readU32(&entry.fFlags)) {
+            return false;
+        }
+        for (int i = 0; i < kGrShaderTypeCount; ++i) {
+            SkString sksl;
+            remaining = stream.getLength() - stream.getPosition();
+            if (!read_string(&stream, remaining, &sksl)) {
+                return false;
+            }
+            entry.fSkSL[i] = SkSL::String(sksl.c_str(), sksl.size());
+        }
+        if (entry.fSkSL[kVertex_GrShaderType].empty() ||
+            entry.fSkSL[kFragment_GrShaderType].empty()) {
+            return false;
+        }
+    }
+    entries->swap(parsed);
+    return true;
+}
+
+bool GrGLPrecompiler::Compile(SkSL::Compiler* compiler, const GrShaderCaps* caps,
+                              const Entry& entry, Program* program, Stats* stats) {
+    SkSL::Program::Settings settings;
+    settings.fCaps = caps;
+    settings.fFlipY              = SkToBool(entry.fFlags & Entry::kFlipY_Flag);
+    settings.fSharpenTextures    = SkToBool(entry.fFlags & Entry::kSharpenTextures_Flag);
+    settings.fFragColorIsInOut   = SkToBool(entry.fFlags & Entry::kFragColorIsInOut_Flag);
+    settings.fForceHighPrecision = SkToBool(entry.fFlags & Entry::kForceHighPrecision_Flag);
+
+    // Match the program builder, which takes the inputs from the fragment shader.
+    static constexpr int kOrder[] = {
+        kFragment_GrShaderType, kVertex_GrShaderType, kGeometry_GrShaderType
+    };
+    for (int type : kOrder) {
+        const SkSL::String& sksl = entry.fSkSL[type];
+        if (sksl.empty()) {
+            continue;
+        }
+        double start = SkTime::GetMSecs();
+        std::unique_ptr<SkSL::Program> converted =
+                compiler->convertProgram(program_kind(type), sksl, settings);
+        if (!converted || !compiler->toGLSL(*converted, &program->fGLSL[type])) {
+            return false;
+        }
+        if (kFragment_GrShaderType == type) {
+            program->fInputs = converted->fInputs;
+        }
+        if (stats) {
+            stats->fSkSLLength[type] = sksl.size();
+            stats->fGLSLLength[type] = program->fGLSL[type].size();
+            stats->fCompileMs[type] = SkTime::GetMSecs() - start;
+        }
+    }
+    return true;
+}
+
+void GrGLPrecompiler::compileEntries(const SkTArray<Entry>& entries) {
+    TRACE_EVENT0("skia.gpu", TRACE_FUNC);
+    SkSL::Compiler compiler;
+    for (const Entry& entry : entries) {
+        {
+            SkAutoMutexAcquire lock(fProgramsMutex);
+            if (fPrograms.find(entry.fKey)) {
+                continue;
+            }
+        }
+        std::unique_ptr<Program> program(new Program);
+        if (!Compile(&compiler, fShaderCaps, entry, program.get())) {
+            continue;
+        }
+        program->fSource = entry;
+        SkAutoMutexAcquire lock(fProgramsMutex);
+        if (!fPrograms.find(entry.fKey)) {
+            fPrograms.set(entry.fKey, std::move(program));
+        }
+    }
+}
+
+bool GrGLPrecompiler::precompile(const SkData& data) {
+    SkTArray<Entry> entries;
+    if (!Parse(data, &entries)) {
+        return false;
+    }
+    if (entries.empty()) {
+        return true;
+    }
+    if (!fTaskGroup) {
+        if (!fExecutor) {
+            fOwnedExecutor = SkExecutor::MakeFIFOThreadPool(1);
+            fExecutor = fOwnedExecutor.get();
+        }
+        fTaskGroup.reset(new SkTaskGroup(*fExecutor));
+    }
+    // SkSL::Compiler is not thread safe, so each task compiles its whole batch with its own.
+    fTaskGroup->add([this, entries] { this->compileEntries(entries); });
+    return true;
+}
+
+const GrGLPrecompiler::Program* GrGLPrecompiler::find(const GrProgramDesc& desc) const {
+    if (!fTaskGroup) {
+        return nullptr;
+    }
+    SkAutoMutexAcquire lock(fProgramsMutex);
+    const std::unique_ptr<Program>* program = fPrograms.find(desc_key(desc));
+    return program ? program->get() : nullptr;
+}
+
+bool GrGLPrecompiler::Program::matches(const SkSL::Program::Settings& settings,
+                                       const SkSL::String sksl[kGrShaderTypeCount]) const {
+    if (fSource.fFlags != entry_flags(settings)) {
+        return false;
+    }
+    for (int i = 0; i < kGrShaderTypeCount; ++i) {
+        if (fSource.fSkSL[i] != sksl[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void GrGLPrecompiler::wait() {
+    if (fTaskGroup) {
+        fTaskGroup->wait();
+    }
+}
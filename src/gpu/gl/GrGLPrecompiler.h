@@ -0,0 +1,137 @@
+/*
+ * Copyright 2019 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef GrGLPrecompiler_DEFINED
+#define GrGLPrecompiler_DEFINED
+
+#include "GrTypesPriv.h"
+#include "SkData.h"
+#include "SkMutex.h"
+#include "SkString.h"
+#include "SkTArray.h"
+#include "SkTHash.h"
+#include "ir/SkSLProgram.h"
+
+#include <memory>
+
+class GrProgramDesc;
+class GrShaderCaps;
+class SkExecutor;
+class SkTaskGroup;
+
+namespace SkSL {
+class Compiler;
+}
+
+/**
+ * Records the SkSL generated for each GL program a context builds, so that it can be handed back
+ * to a later context through GrContext::precompile(). Precompiling runs the SkSL->GLSL step for
+ * each recorded program on a background thread; the program builder then only has to compile and
+ * link the resulting GLSL the first time the program is actually used.
+ */
+class GrGLPrecompiler {
+public:
+    /** The SkSL and settings recorded for a single program, keyed by its GrProgramDesc. */
+    struct Entry {
+        enum Flags : uint32_t {
+            kFlipY_Flag              = 0x1,
+            kSharpenTextures_Flag    = 0x2,
+            kFragColorIsInOut_Flag   = 0x4,
+            kForceHighPrecision_Flag = 0x8,
+        };
+
+        SkString     fKey;
+        uint32_t     fFlags = 0;
+        SkSL::String fSkSL[kGrShaderTypeCount];
+    };
+
+    /**
+     * The output of the SkSL->GLSL step for a program. Unused shader stages are left empty. A
+     * GrProgramDesc doesn't pin down the SkSL that a program builds from (the dump may come from
+     * another build of Skia, or be damaged), so the program remembers the SkSL and settings it was
+     * compiled from, and must only be used for a program generating the same.
+     */
+    struct Program {
+        SkSL::Program::Inputs fInputs;
+        SkSL::String          fGLSL[kGrShaderTypeCount];
+        Entry                 fSource;
+
+        bool matches(const SkSL::Program::Settings&,
+                     const SkSL::String sksl[kGrShaderTypeCount]) const;
+    };
+
+    /** Optional statistics gathered by Compile(), indexed by GrShaderType. */
+    struct Stats {
+        size_t fSkSLLength[kGrShaderTypeCount] = {};
+        size_t fGLSLLength[kGrShaderTypeCount] = {};
+        double fCompileMs[kGrShaderTypeCount] = {};
+    };
+
+    /**
+     * The shader caps must outlive the precompiler. If executor is null, precompile() creates its
+     * own background thread.
+     */
+    GrGLPrecompiler(const GrShaderCaps*, SkExecutor*, bool recordPrograms);
+    ~GrGLPrecompiler();
+
+    bool isRecording() const { return fRecordPrograms; }
+
+    /**
+     * Remembers the SkSL for a program the first time it is built. Shader stages with no strings
+     * are treated as unused.
+     */
+    void record(const GrProgramDesc&, const SkSL::Program::Settings&,
+                const SkSL::String sksl[kGrShaderTypeCount]);
+
+    /** Serializes every recorded program. Returns null if nothing was recorded. */
+    sk_sp<SkData> dump() const;
+
+    /**
+     * Parses the output of dump() and converts each program to GLSL in the background. Returns
+     * false if the data is malformed, in which case nothing is scheduled.
+     */
+    bool precompile(const SkData&);
+
+    /**
+     * Returns the precompiled GLSL for the desc, or null if it is not available (yet). The result
+     * stays valid for the lifetime of the precompiler. Check it matches() the program being built
+     * before using it.
+     */
+    const Program* find(const GrProgramDesc&) const;
+
+    /** Blocks until all scheduled background work has finished. */
+    void wait();
+
+    static bool Parse(const SkData&, SkTArray<Entry>*);
+
+    /**
+     * Converts the entry's SkSL to GLSL using the given compiler and caps. Returns false if any
+     * stage fails to compile.
+     */
+    static bool Compile(SkSL::Compiler*, const GrShaderCaps*, const Entry&, Program*,
+                        Stats* = nullptr);
+
+private:
+    void compileEntries(const SkTArray<Entry>&);
+
+    const GrShaderCaps*               fShaderCaps;
+    SkExecutor*                       fExecutor;
+    bool                              fRecordPrograms;
+
+    // Only touched on the context's thread.
+    SkTArray<Entry>                   fRecorded;
+    SkTHashSet<SkString>              fRecordedKeys;
+
+    std::unique_ptr<SkExecutor>       fOwnedExecutor;
+    std::unique_ptr<SkTaskGroup>      fTaskGroup;
+
+    // Written by the background tasks, read by the program builder.
+    mutable SkMutex                   fProgramsMutex;
+    SkTHashMap<SkString, std::unique_ptr<Program>> fPrograms;
+};
+
+#endif
@@ -257,6 +257,46 @@ void GrGLProgramBuilder::storeShaderInCache(const SkSL::Program::Inputs& inputs,
     }
 }
 
+void GrGLProgramBuilder::precompilerSkSL(const SkSL::Program::Settings& settings,
+                                         SkSL::Program::Settings* precompilerSettings,
+                                         SkSL::String sksl[kGrShaderTypeCount]) const {
+    *precompilerSettings = settings;
+    precompilerSettings->fForceHighPrecision = fFS.fForceHighPrecision;
+    auto append = [](const GrGLSLShaderBuilder& shader, SkSL::String* out) {
+        for (int i = 0; i < shader.fCompilerStrings.count(); ++i) {
+            out->append(shader.fCompilerStrings[i], shader.fCompilerStringLengths[i]);
+        }
+    };
+    append(fVS, &sksl[kVertex_GrShaderType]);
+    if (this->primitiveProcessor().willUseGeoShader()) {
+        append(fGS, &sksl[kGeometry_GrShaderType]);
+    }
+    append(fFS, &sksl[kFragment_GrShaderType]);
+}
+
+void GrGLProgramBuilder::recordForPrecompile(const SkSL::Program::Settings& settings) {
+    GrGLPrecompiler* precompiler = this->gpu()->precompiler();
+    if (!precompiler->isRecording()) {
+        return;
+    }
+    SkSL::Program::Settings recordedSettings;
+    SkSL::String sksl[kGrShaderTypeCount];
+    this->precompilerSkSL(settings, &recordedSettings, sksl);
+    precompiler->record(*this->desc(), recordedSettings, sksl);
+}
+
+const GrGLPrecompiler::Program* GrGLProgramBuilder::findPrecompiled(
+        const SkSL::Program::Settings& settings) {
+    const GrGLPrecompiler::Program* program = this->gpu()->precompiler()->find(*this->desc());
+    if (!program) {
+        return nullptr;
+    }
+    SkSL::Program::Settings precompiledSettings;
+    SkSL::String sksl[kGrShaderTypeCount];
+    this->precompilerSkSL(settings, &precompiledSettings, sksl);
+    return program->matches(precompiledSettings, sksl) ? program : nullptr;
+}
+
 GrGLProgram* GrGLProgramBuilder::finalize() {
     TRACE_EVENT0("skia", TRACE_FUNC);
 
@@ -282,6 +322,7 @@ GrGLProgram* GrGLProgramBuilder::finalize() {
     settings.fSharpenTextures =
                     this->gpu()->getContext()->priv().options().fSharpenMipmappedTextures;
     settings.fFragColorIsInOut = this->fragColorIsInOut();
+    this->recordForPrecompile(settings);
 
     SkSL::Program::Inputs inputs;
     SkTDArray<GrGLuint> shadersToDelete;
@@ -328,6 +369,15 @@ GrGLProgram* GrGLProgramBuilder::finalize() {
             }
         }
     }
+    if (!cached) {
+        // GrContext::precompile() may already have done the SkSL->GLSL step for us
+        if (const GrGLPrecompiler::Program* precompiled = this->findPrecompiled(settings)) {
+            inputs = precompiled->fInputs;
+            for (int i = 0; i < kGrShaderTypeCount; ++i) {
+                glsl.fGLSL[i] = precompiled->fGLSL[i];
+            }
+        }
+    }
     if (!cached || !fGpu->glCaps().programBinarySupport()) {
         // either a cache miss, or we can't store binaries in the cache
         if (glsl.fs().empty()) {
@@ -9,6 +9,7 @@
 #define GrGLProgramBuilder_DEFINED
 
 #include "GrPipeline.h"
+#include "gl/GrGLPrecompiler.h"
 #include "gl/GrGLProgram.h"
 #include "gl/GrGLProgramDataManager.h"
 #include "gl/GrGLUniformHandler.h"
@@ -71,6 +72,13 @@ private:
                                  bool bindAttribLocations);
     void storeShaderInCache(const SkSL::Program::Inputs& inputs, GrGLuint programID,
                             const GrGLSLSet& glsl);
+    // Gathers the SkSL and settings GrGLPrecompiler records for this program.
+    void precompilerSkSL(const SkSL::Program::Settings& settings,
+                         SkSL::Program::Settings* precompilerSettings,
+                         SkSL::String sksl[kGrShaderTypeCount]) const;
+    void recordForPrecompile(const SkSL::Program::Settings& settings);
+    // Returns GLSL that GrContext::precompile() made from this program's exact SkSL, if any.
+    const GrGLPrecompiler::Program* findPrecompiled(const SkSL::Program::Settings& settings);
     GrGLProgram* finalize();
     void bindProgramResourceLocations(GrGLuint programID);
     bool checkLinkStatus(GrGLuint programID);
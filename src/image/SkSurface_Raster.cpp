@@ -10,14 +10,17 @@
 #include "SkImagePriv.h"
 #include "SkCanvas.h"
 #include "SkDevice.h"
+#include "SkExecutor.h"
 #include "SkMallocPixelRef.h"
+#include "SkThreadedBitmapDevice.h"
 
 class SkSurface_Raster : public SkSurface_Base {
 public:
     SkSurface_Raster(const SkImageInfo&, void*, size_t rb,
                      void (*releaseProc)(void* pixels, void* context), void* context,
                      const SkSurfaceProps*);
-    SkSurface_Raster(const SkImageInfo& info, sk_sp<SkPixelRef>, const SkSurfaceProps*);
+    SkSurface_Raster(const SkImageInfo& info, sk_sp<SkPixelRef>, const SkSurfaceProps*,
+                     SkExecutor* = nullptr);
 
     SkCanvas* onNewCanvas() override;
     sk_sp<SkSurface> onNewSurface(const SkImageInfo&) override;
@@ -28,9 +31,13 @@ public:
     void onRestoreBackingMutability() override;
 
 private:
+    // Rasterize any draws our canvas has deferred.
+    void flushPendingDraws();
+
     SkBitmap    fBitmap;
     size_t      fRowBytes;
     bool        fWeOwnThePixels;
+    SkExecutor* fExecutor;      // If set, our canvas draws with an SkThreadedBitmapDevice.
 
     typedef SkSurface_Base INHERITED;
 };
@@ -75,30 +82,48 @@ SkSurface_Raster::SkSurface_Raster(const SkImageInfo& info, void* pixels, size_t
     fBitmap.installPixels(info, pixels, rb, releaseProc, context);
     fRowBytes = 0;              // don't need to track the rowbytes
     fWeOwnThePixels = false;    // We are "Direct"
+    fExecutor = nullptr;
 }
 
 SkSurface_Raster::SkSurface_Raster(const SkImageInfo& info, sk_sp<SkPixelRef> pr,
-                                   const SkSurfaceProps* props)
+                                   const SkSurfaceProps* props, SkExecutor* executor)
     : INHERITED(pr->width(), pr->height(), props)
 {
     fBitmap.setInfo(info, pr->rowBytes());
     fRowBytes = pr->rowBytes(); // we track this, so that subsequent re-allocs will match
     fBitmap.setPixelRef(std::move(pr), 0, 0);
     fWeOwnThePixels = true;
+    fExecutor = executor;
 }
 
-SkCanvas* SkSurface_Raster::onNewCanvas() { return new SkCanvas(fBitmap, this->props()); }
+SkCanvas* SkSurface_Raster::onNewCanvas() {
+    if (fExecutor) {
+        return new SkCanvas(sk_make_sp<SkThreadedBitmapDevice>(fBitmap, this->props(), fExecutor));
+    }
+    return new SkCanvas(fBitmap, this->props());
+}
+
+void SkSurface_Raster::flushPendingDraws() {
+    if (fExecutor) {
+        this->getCachedCanvas()->flush();
+    }
+}
 
 sk_sp<SkSurface> SkSurface_Raster::onNewSurface(const SkImageInfo& info) {
+    if (fExecutor) {
+        return SkSurface::MakeRasterThreaded(info, fExecutor, &this->props());
+    }
     return SkSurface::MakeRaster(info, &this->props());
 }
 
 void SkSurface_Raster::onDraw(SkCanvas* canvas, SkScalar x, SkScalar y,
                               const SkPaint* paint) {
+    this->flushPendingDraws();
     canvas->drawBitmap(fBitmap, x, y, paint);
 }
 
 sk_sp<SkImage> SkSurface_Raster::onNewImageSnapshot(const SkIRect* subset) {
+    this->flushPendingDraws();
     if (subset) {
         SkASSERT(SkIRect::MakeWH(fBitmap.width(), fBitmap.height()).contains(*subset));
         SkBitmap dst;
@@ -125,6 +150,7 @@ sk_sp<SkImage> SkSurface_Raster::onNewImageSnapshot(const SkIRect* subset) {
 }
 
 void SkSurface_Raster::onWritePixels(const SkPixmap& src, int x, int y) {
+    this->flushPendingDraws();
     fBitmap.writePixels(src, x, y);
 }
 
@@ -136,6 +162,7 @@ void SkSurface_Raster::onRestoreBackingMutability() {
 }
 
 void SkSurface_Raster::onCopyOnWrite(ContentChangeMode mode) {
+    this->flushPendingDraws();
     // are we sharing pixelrefs with the image?
     sk_sp<SkImage> cached(this->refCachedImage());
     SkASSERT(cached);
@@ -203,3 +230,19 @@ sk_sp<SkSurface> SkSurface::MakeRasterN32Premul(int width, int height,
                                                 const SkSurfaceProps* surfaceProps) {
     return MakeRaster(SkImageInfo::MakeN32Premul(width, height), surfaceProps);
 }
+
+sk_sp<SkSurface> SkSurface::MakeRasterThreaded(const SkImageInfo& info, SkExecutor* executor,
+                                               const SkSurfaceProps* props) {
+    if (!SkSurfaceValidateRasterInfo(info)) {
+        return nullptr;
+    }
+
+    sk_sp<SkPixelRef> pr = SkMallocPixelRef::MakeZeroed(info, 0);
+    if (!pr) {
+        return nullptr;
+    }
+    if (!executor) {
+        executor = &SkExecutor::GetDefault();
+    }
+    return sk_make_sp<SkSurface_Raster>(info, std::move(pr), props, executor);
+}
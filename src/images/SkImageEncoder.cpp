@@ -77,7 +77,7 @@ bool SkEncodeImage(SkWStream* dst, const SkPixmap& src,
 
 bool SkEncoder::encodeRows(int numRows) {
     SkASSERT(numRows > 0 && fCurrRow < fSrc.height());
-    if (numRows <= 0 || fCurrRow >= fSrc.height()) {
+    if (numRows <= 0 || fCurrRow >= fSrc.height() || !fSrc.addr()) {
         return false;
     }
 
@@ -85,7 +85,27 @@ bool SkEncoder::encodeRows(int numRows) {
         numRows = fSrc.height() - fCurrRow;
     }
 
-    if (!this->onEncodeRows(numRows)) {
+    SkPixmap rows;
+    SkAssertResult(fSrc.extractSubset(&rows,
+                                      SkIRect::MakeXYWH(0, fCurrRow, fSrc.width(), numRows)));
+    return this->encodeRows(rows);
+}
+
+bool SkEncoder::encodeRows(const SkPixmap& rows) {
+    SkASSERT(rows.height() > 0 && fCurrRow < fSrc.height());
+    if (rows.height() <= 0 || fCurrRow >= fSrc.height() || !rows.addr() ||
+            rows.width() != fSrc.width() || rows.colorType() != fSrc.colorType() ||
+            rows.alphaType() != fSrc.alphaType()) {
+        return false;
+    }
+
+    SkPixmap clipped = rows;
+    if (fCurrRow + rows.height() > fSrc.height()) {
+        SkAssertResult(rows.extractSubset(&clipped, SkIRect::MakeWH(rows.width(),
+                                                                    fSrc.height() - fCurrRow)));
+    }
+
+    if (!this->onEncodeRows(clipped)) {
         // If we fail, short circuit any future calls.
         fCurrRow = fSrc.height();
         return false;
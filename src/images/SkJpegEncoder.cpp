@@ -169,6 +169,20 @@ std::unique_ptr<SkEncoder> SkJpegEncoder::Make(SkWStream* dst, const SkPixmap& s
         return nullptr;
     }
 
+    return MakeEncoder(dst, src, options);
+}
+
+std::unique_ptr<SkEncoder> SkJpegEncoder::Make(SkWStream* dst, const SkImageInfo& info,
+                                               const Options& options) {
+    if (!SkImageInfoIsValid(info)) {
+        return nullptr;
+    }
+
+    return MakeEncoder(dst, SkPixmap(info, nullptr, info.minRowBytes()), options);
+}
+
+std::unique_ptr<SkEncoder> SkJpegEncoder::MakeEncoder(SkWStream* dst, const SkPixmap& src,
+                                                      const Options& options) {
     std::unique_ptr<SkJpegEncoderMgr> encoderMgr = SkJpegEncoderMgr::Make(dst);
 
     skjpeg_error_mgr::AutoPushJmpBuf jmp(encoderMgr->errorMgr());
@@ -208,13 +222,14 @@ SkJpegEncoder::SkJpegEncoder(std::unique_ptr<SkJpegEncoderMgr> encoderMgr, const
 
 SkJpegEncoder::~SkJpegEncoder() {}
 
-bool SkJpegEncoder::onEncodeRows(int numRows) {
+bool SkJpegEncoder::onEncodeRows(const SkPixmap& rows) {
     skjpeg_error_mgr::AutoPushJmpBuf jmp(fEncoderMgr->errorMgr());
     if (setjmp(jmp)) {
         return false;
     }
 
-    const void* srcRow = fSrc.addr(0, fCurrRow);
+    const int numRows = rows.height();
+    const void* srcRow = rows.addr();
     for (int i = 0; i < numRows; i++) {
         JSAMPLE* jpegSrcRow = (JSAMPLE*) srcRow;
         if (fEncoderMgr->proc()) {
@@ -226,7 +241,7 @@ bool SkJpegEncoder::onEncodeRows(int numRows) {
         }
 
         jpeg_write_scanlines(fEncoderMgr->cinfo(), &jpegSrcRow, 1);
-        srcRow = SkTAddOffset<const void>(srcRow, fSrc.rowBytes());
+        srcRow = SkTAddOffset<const void>(srcRow, rows.rowBytes());
     }
 
     fCurrRow += numRows;
@@ -10,15 +10,20 @@
 #ifdef SK_HAS_PNG_LIBRARY
 
 #include "SkColorTable.h"
+#include "SkEndian.h"
 #include "SkImageEncoderFns.h"
 #include "SkImageInfoPriv.h"
+#include "SkSemaphore.h"
 #include "SkStream.h"
 #include "SkString.h"
 #include "SkPngEncoder.h"
 #include "SkPngPriv.h"
+#include "SkTaskGroup.h"
+#include <deque>
 #include <vector>
 
 #include "png.h"
+#include "zlib.h"
 
 static_assert(PNG_FILTER_NONE  == (int)SkPngEncoder::FilterFlag::kNone,  "Skia libpng filter err.");
 static_assert(PNG_FILTER_SUB   == (int)SkPngEncoder::FilterFlag::kSub,   "Skia libpng filter err.");
@@ -44,6 +49,299 @@ static void sk_write_fn(png_structp png_ptr, png_bytep data, png_size_t len) {
     }
 }
 
+namespace {
+
+/*
+ * Writes the IDAT chunks of a png whose rows are compressed on an executor.
+ *
+ * Rows are filtered as they arrive, the way libpng would filter them, and collected into chunks
+ * of about kChunkBytes.  Each chunk is deflated on its own, as a raw deflate stream primed with
+ * the 32K of filtered data before it, and ends on a byte boundary (Z_SYNC_FLUSH), so the chunks
+ * can be concatenated into a single zlib stream.  Its adler32 checksum is combined from those
+ * of the chunks.  Finished chunks are written in order, each as an IDAT chunk.
+ */
+class ParallelIDATWriter : SkNoncopyable {
+public:
+    ParallelIDATWriter(SkWStream* stream, SkExecutor* executor, size_t rowBytes,
+                       int bytesPerPixel, int filters, int zlibLevel)
+        : fStream(stream)
+        , fRowBytes(rowBytes)
+        , fBytesPerPixel(bytesPerPixel)
+        , fFilters(filters)
+        , fZLibLevel(zlibLevel)
+        , fPrevRow(rowBytes, 0)
+        , fCandidate(rowBytes + 1)
+        , fBest(rowBytes + 1)
+        , fChunk(new Chunk)
+        , fAdler(adler32(0, Z_NULL, 0))
+        , fTaskGroup(*executor)
+    {}
+
+    // |row| holds fRowBytes of unfiltered png data.
+    bool writeRow(const uint8_t* row);
+
+    // Writes the rest of the IDAT chunks, and the IEND chunk.
+    bool finish();
+
+private:
+    static constexpr size_t kChunkBytes       = 256 * 1024;
+    static constexpr size_t kWindowBytes      = 32 * 1024;
+    static constexpr size_t kMaxChunksInFlight = 16;
+
+    struct Chunk {
+        std::vector<uint8_t> fDictionary;
+        std::vector<uint8_t> fFiltered;
+        std::vector<uint8_t> fDeflated;
+        uLong                fAdler = 0;
+        bool                 fLast = false;
+        bool                 fSucceeded = false;
+        SkSemaphore          fDone;
+    };
+
+    static void Deflate(Chunk* chunk, int zlibLevel, int strategy);
+
+    void filterRow(const uint8_t* row);
+    void submit(bool last);
+    bool writeChunks(bool all);
+    bool writePngChunk(const char type[4], const uint8_t* prefix, size_t prefixBytes,
+                       const uint8_t* data, size_t dataBytes,
+                       const uint8_t* suffix, size_t suffixBytes);
+
+    SkWStream*                          fStream;
+    const size_t                        fRowBytes;
+    const int                           fBytesPerPixel;
+    const int                           fFilters;
+    const int                           fZLibLevel;
+    std::vector<uint8_t>                fPrevRow;
+    std::vector<uint8_t>                fCandidate;
+    std::vector<uint8_t>                fBest;
+    std::unique_ptr<Chunk>              fChunk;
+    std::vector<uint8_t>                fWindow;      // The last kWindowBytes submitted.
+    std::deque<std::unique_ptr<Chunk>>  fInFlight;
+    uLong                               fAdler;
+    bool                                fWroteHeader = false;
+    bool                                fFailed = false;
+
+    // Declared last, so it waits for the chunks to be deflated before they are freed.
+    SkTaskGroup                         fTaskGroup;
+};
+
+static inline uint8_t paeth_predictor(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = SkTAbs(p - a);
+    int pb = SkTAbs(p - b);
+    int pc = SkTAbs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return a;
+    }
+    return pb <= pc ? b : c;
+}
+
+// Applies one of the png filters to |row|, writing the filter byte and the filtered row to
+// |dst|.  Returns the sum of the filtered bytes, taken as signed, which libpng uses to choose
+// between filters.
+static uint32_t filter_row(uint8_t* dst, int filter, const uint8_t* row, const uint8_t* prev,
+                           size_t rowBytes, int bpp) {
+    dst[0] = filter;
+    uint8_t* out = dst + 1;
+    for (size_t i = 0; i < rowBytes; i++) {
+        const int a = i >= (size_t) bpp ? row[i - bpp] : 0;
+        const int b = prev[i];
+        const int c = i >= (size_t) bpp ? prev[i - bpp] : 0;
+        switch (filter) {
+            case PNG_FILTER_VALUE_NONE:  out[i] = row[i];                              break;
+            case PNG_FILTER_VALUE_SUB:   out[i] = row[i] - a;                          break;
+            case PNG_FILTER_VALUE_UP:    out[i] = row[i] - b;                          break;
+            case PNG_FILTER_VALUE_AVG:   out[i] = row[i] - ((a + b) >> 1);             break;
+            case PNG_FILTER_VALUE_PAETH: out[i] = row[i] - paeth_predictor(a, b, c);   break;
+        }
+    }
+
+    uint32_t sum = 0;
+    for (size_t i = 0; i < rowBytes; i++) {
+        sum += SkTAbs((int) (int8_t) out[i]);
+    }
+    return sum;
+}
+
+void ParallelIDATWriter::filterRow(const uint8_t* row) {
+    static constexpr int kFilters[] = {
+        PNG_FILTER_NONE, PNG_FILTER_SUB, PNG_FILTER_UP, PNG_FILTER_AVG, PNG_FILTER_PAETH,
+    };
+    static constexpr int kFilterValues[] = {
+        PNG_FILTER_VALUE_NONE, PNG_FILTER_VALUE_SUB, PNG_FILTER_VALUE_UP, PNG_FILTER_VALUE_AVG,
+        PNG_FILTER_VALUE_PAETH,
+    };
+
+    // Like libpng, with no filters chosen, try all of them.
+    const int filters = fFilters ? fFilters : PNG_ALL_FILTERS;
+    uint32_t bestSum = UINT32_MAX;
+    for (size_t i = 0; i < SK_ARRAY_COUNT(kFilters); i++) {
+        if (filters & kFilters[i]) {
+            uint32_t sum = filter_row(fCandidate.data(), kFilterValues[i], row, fPrevRow.data(),
+                                      fRowBytes, fBytesPerPixel);
+            if (sum < bestSum) {
+                bestSum = sum;
+                fCandidate.swap(fBest);
+            }
+        }
+    }
+
+    fChunk->fFiltered.insert(fChunk->fFiltered.end(), fBest.begin(), fBest.end());
+    memcpy(fPrevRow.data(), row, fRowBytes);
+}
+
+void ParallelIDATWriter::Deflate(Chunk* chunk, int zlibLevel, int strategy) {
+    z_stream zStream;
+    memset(&zStream, 0, sizeof(zStream));
+    if (Z_OK != deflateInit2(&zStream, zlibLevel, Z_DEFLATED, -MAX_WBITS, 8, strategy)) {
+        return;
+    }
+    if (!chunk->fDictionary.empty() &&
+            Z_OK != deflateSetDictionary(&zStream, chunk->fDictionary.data(),
+                                         (uInt) chunk->fDictionary.size())) {
+        deflateEnd(&zStream);
+        return;
+    }
+
+    chunk->fDeflated.resize(deflateBound(&zStream, chunk->fFiltered.size()) + 16);
+    zStream.next_in = chunk->fFiltered.data();
+    zStream.avail_in = (uInt) chunk->fFiltered.size();
+    const int flush = chunk->fLast ? Z_FINISH : Z_SYNC_FLUSH;
+    size_t used = 0;
+    for (;;) {
+        zStream.next_out = chunk->fDeflated.data() + used;
+        zStream.avail_out = (uInt) (chunk->fDeflated.size() - used);
+        const int result = deflate(&zStream, flush);
+        used = chunk->fDeflated.size() - zStream.avail_out;
+        if (Z_STREAM_ERROR == result) {
+            deflateEnd(&zStream);
+            return;
+        }
+        if (chunk->fLast ? Z_STREAM_END == result
+                         : 0 == zStream.avail_in && 0 != zStream.avail_out) {
+            break;
+        }
+        chunk->fDeflated.resize(chunk->fDeflated.size() * 2);
+    }
+    // A stream that was only flushed reports Z_DATA_ERROR here; it is still complete.
+    deflateEnd(&zStream);
+
+    chunk->fDeflated.resize(used);
+    chunk->fAdler = adler32(adler32(0, Z_NULL, 0), chunk->fFiltered.data(),
+                            (uInt) chunk->fFiltered.size());
+    chunk->fSucceeded = true;
+}
+
+void ParallelIDATWriter::submit(bool last) {
+    Chunk* chunk = fChunk.get();
+    chunk->fLast = last;
+    chunk->fDictionary = fWindow;
+
+    const std::vector<uint8_t>& filtered = chunk->fFiltered;
+    if (filtered.size() >= kWindowBytes) {
+        fWindow.assign(filtered.end() - kWindowBytes, filtered.end());
+    } else {
+        fWindow.insert(fWindow.end(), filtered.begin(), filtered.end());
+        if (fWindow.size() > kWindowBytes) {
+            fWindow.erase(fWindow.begin(), fWindow.end() - kWindowBytes);
+        }
+    }
+
+    fInFlight.push_back(std::move(fChunk));
+    // As libpng does, tune zlib for filtered data, unless nothing is filtered.
+    const int zlibLevel = fZLibLevel;
+    const int strategy = PNG_FILTER_NONE == fFilters ? Z_DEFAULT_STRATEGY : Z_FILTERED;
+    fTaskGroup.add([chunk, zlibLevel, strategy] {
+        Deflate(chunk, zlibLevel, strategy);
+        chunk->fDone.signal();
+    });
+    fChunk.reset(new Chunk);
+}
+
+bool ParallelIDATWriter::writePngChunk(const char type[4],
+                                       const uint8_t* prefix, size_t prefixBytes,
+                                       const uint8_t* data, size_t dataBytes,
+                                       const uint8_t* suffix, size_t suffixBytes) {
+    const size_t length = prefixBytes + dataBytes + suffixBytes;
+    if (length > PNG_UINT_31_MAX) {
+        return false;
+    }
+    // crc32() starts over when passed a null buffer, so skip empty pieces.
+    uLong crc = crc32(0, Z_NULL, 0);
+    crc = crc32(crc, (const Bytef*) type, 4);
+    for (auto piece : { std::make_pair(prefix, prefixBytes), std::make_pair(data, dataBytes),
+                        std::make_pair(suffix, suffixBytes) }) {
+        if (piece.second) {
+            crc = crc32(crc, piece.first, (uInt) piece.second);
+        }
+    }
+
+    const uint32_t beLength = SkEndian_SwapBE32((uint32_t) length);
+    const uint32_t beCrc = SkEndian_SwapBE32((uint32_t) crc);
+    return fStream->write(&beLength, 4) && fStream->write(type, 4) &&
+           fStream->write(prefix, prefixBytes) && fStream->write(data, dataBytes) &&
+           fStream->write(suffix, suffixBytes) && fStream->write(&beCrc, 4);
+}
+
+bool ParallelIDATWriter::writeChunks(bool all) {
+    while (!fInFlight.empty() && !fFailed) {
+        Chunk* chunk = fInFlight.front().get();
+        if (all || fInFlight.size() > kMaxChunksInFlight) {
+            chunk->fDone.wait();
+        } else if (!chunk->fDone.try_wait()) {
+            break;
+        }
+        if (!chunk->fSucceeded) {
+            fFailed = true;
+            break;
+        }
+
+        // The first chunk starts the zlib stream, and the last ends it.
+        uint8_t header[2];
+        size_t headerBytes = 0;
+        if (!fWroteHeader) {
+            const int flevel = fZLibLevel < 2 ? 0 : fZLibLevel < 6 ? 1 : fZLibLevel == 6 ? 2 : 3;
+            header[0] = 0x78;
+            header[1] = (uint8_t) (flevel << 6);
+            header[1] += 31 - ((header[0] << 8) | header[1]) % 31;
+            headerBytes = sizeof(header);
+            fWroteHeader = true;
+        }
+        fAdler = adler32_combine(fAdler, chunk->fAdler, chunk->fFiltered.size());
+        uint8_t trailer[4];
+        size_t trailerBytes = 0;
+        if (chunk->fLast) {
+            const uint32_t beAdler = SkEndian_SwapBE32((uint32_t) fAdler);
+            memcpy(trailer, &beAdler, sizeof(trailer));
+            trailerBytes = sizeof(trailer);
+        }
+
+        if (!this->writePngChunk("IDAT", header, headerBytes, chunk->fDeflated.data(),
+                                 chunk->fDeflated.size(), trailer, trailerBytes)) {
+            fFailed = true;
+        }
+        fInFlight.pop_front();
+    }
+    return !fFailed;
+}
+
+bool ParallelIDATWriter::writeRow(const uint8_t* row) {
+    this->filterRow(row);
+    if (fChunk->fFiltered.size() >= kChunkBytes) {
+        this->submit(false);
+    }
+    return this->writeChunks(false);
+}
+
+bool ParallelIDATWriter::finish() {
+    this->submit(true);
+    return this->writeChunks(true) &&
+           this->writePngChunk("IEND", nullptr, 0, nullptr, 0, nullptr, 0);
+}
+
+}  // namespace
+
 class SkPngEncoderMgr final : SkNoncopyable {
 public:
 
@@ -58,10 +356,20 @@ public:
     bool writeInfo(const SkImageInfo& srcInfo);
     void chooseProc(const SkImageInfo& srcInfo);
 
+    /*
+     * Compress the image data on |executor|, rather than with libpng.  Call after writeInfo(),
+     * and then pass each row to parallelWriter() instead of libpng.
+     */
+    void useExecutor(SkExecutor* executor);
+
     png_structp pngPtr() { return fPngPtr; }
     png_infop infoPtr() { return fInfoPtr; }
     int pngBytesPerPixel() const { return fPngBytesPerPixel; }
     transform_scanline_proc proc() const { return fProc; }
+    ParallelIDATWriter* parallelWriter() const { return fParallelWriter.get(); }
+
+    // Whether libpng would drop every fourth 16-bit sample of the rows, as png_set_filler() asks.
+    bool dropsFiller() const { return fDropsFiller; }
 
     ~SkPngEncoderMgr() {
         png_destroy_write_struct(&fPngPtr, &fInfoPtr);
@@ -69,15 +377,21 @@ public:
 
 private:
 
-    SkPngEncoderMgr(png_structp pngPtr, png_infop infoPtr)
-        : fPngPtr(pngPtr)
+    SkPngEncoderMgr(SkWStream* stream, png_structp pngPtr, png_infop infoPtr)
+        : fStream(stream)
+        , fPngPtr(pngPtr)
         , fInfoPtr(infoPtr)
     {}
 
-    png_structp             fPngPtr;
-    png_infop               fInfoPtr;
-    int                     fPngBytesPerPixel;
-    transform_scanline_proc fProc;
+    SkWStream*                          fStream;
+    png_structp                         fPngPtr;
+    png_infop                           fInfoPtr;
+    int                                 fPngBytesPerPixel;
+    int                                 fFilters;
+    int                                 fZLibLevel;
+    bool                                fDropsFiller = false;
+    transform_scanline_proc             fProc;
+    std::unique_ptr<ParallelIDATWriter> fParallelWriter;
 };
 
 std::unique_ptr<SkPngEncoderMgr> SkPngEncoderMgr::Make(SkWStream* stream) {
@@ -94,7 +408,7 @@ std::unique_ptr<SkPngEncoderMgr> SkPngEncoderMgr::Make(SkWStream* stream) {
     }
 
     png_set_write_fn(pngPtr, (void*)stream, sk_write_fn, nullptr);
-    return std::unique_ptr<SkPngEncoderMgr>(new SkPngEncoderMgr(pngPtr, infoPtr));
+    return std::unique_ptr<SkPngEncoderMgr>(new SkPngEncoderMgr(stream, pngPtr, infoPtr));
 }
 
 bool SkPngEncoderMgr::setHeader(const SkImageInfo& srcInfo, const SkPngEncoder::Options& options) {
@@ -196,10 +510,12 @@ bool SkPngEncoderMgr::setHeader(const SkImageInfo& srcInfo, const SkPngEncoder::
     int filters = (int)options.fFilterFlags & (int)SkPngEncoder::FilterFlag::kAll;
     SkASSERT(filters == (int)options.fFilterFlags);
     png_set_filter(fPngPtr, PNG_FILTER_TYPE_BASE, filters);
+    fFilters = filters;
 
     int zlibLevel = SkTMin(SkTMax(0, options.fZLibLevel), 9);
     SkASSERT(zlibLevel == options.fZLibLevel);
     png_set_compression_level(fPngPtr, zlibLevel);
+    fZLibLevel = zlibLevel;
 
     // Set comments in tEXt chunk
     const sk_sp<SkDataTable>& comments = options.fComments;
@@ -363,6 +679,7 @@ bool SkPngEncoderMgr::writeInfo(const SkImageInfo& srcInfo) {
         // For kOpaque, kRGBA_F16, we will keep the row as RGBA and tell libpng
         // to skip the alpha channel.
         png_set_filler(fPngPtr, 0, PNG_FILLER_AFTER);
+        fDropsFiller = true;
     }
 
     return true;
@@ -372,12 +689,34 @@ void SkPngEncoderMgr::chooseProc(const SkImageInfo& srcInfo) {
     fProc = choose_proc(srcInfo);
 }
 
+void SkPngEncoderMgr::useExecutor(SkExecutor* executor) {
+    const int bitDepth = png_get_bit_depth(fPngPtr, fInfoPtr);
+    const int bytesPerPixel = png_get_channels(fPngPtr, fInfoPtr) * bitDepth / 8;
+    fParallelWriter.reset(new ParallelIDATWriter(fStream, executor,
+                                                 png_get_rowbytes(fPngPtr, fInfoPtr),
+                                                 bytesPerPixel, fFilters, fZLibLevel));
+}
+
 std::unique_ptr<SkEncoder> SkPngEncoder::Make(SkWStream* dst, const SkPixmap& src,
                                               const Options& options) {
     if (!SkPixmapIsValid(src)) {
         return nullptr;
     }
 
+    return MakeEncoder(dst, src, options);
+}
+
+std::unique_ptr<SkEncoder> SkPngEncoder::Make(SkWStream* dst, const SkImageInfo& info,
+                                              const Options& options) {
+    if (!SkImageInfoIsValid(info)) {
+        return nullptr;
+    }
+
+    return MakeEncoder(dst, SkPixmap(info, nullptr, info.minRowBytes()), options);
+}
+
+std::unique_ptr<SkEncoder> SkPngEncoder::MakeEncoder(SkWStream* dst, const SkPixmap& src,
+                                                     const Options& options) {
     std::unique_ptr<SkPngEncoderMgr> encoderMgr = SkPngEncoderMgr::Make(dst);
     if (!encoderMgr) {
         return nullptr;
@@ -396,6 +735,9 @@ std::unique_ptr<SkEncoder> SkPngEncoder::Make(SkWStream* dst, const SkPixmap& sr
     }
 
     encoderMgr->chooseProc(src.info());
+    if (options.fExecutor) {
+        encoderMgr->useExecutor(options.fExecutor);
+    }
 
     return std::unique_ptr<SkPngEncoder>(new SkPngEncoder(std::move(encoderMgr), src));
 }
@@ -407,25 +749,42 @@ SkPngEncoder::SkPngEncoder(std::unique_ptr<SkPngEncoderMgr> encoderMgr, const Sk
 
 SkPngEncoder::~SkPngEncoder() {}
 
-bool SkPngEncoder::onEncodeRows(int numRows) {
+bool SkPngEncoder::onEncodeRows(const SkPixmap& rows) {
     if (setjmp(png_jmpbuf(fEncoderMgr->pngPtr()))) {
         return false;
     }
 
-    const void* srcRow = fSrc.addr(0, fCurrRow);
+    ParallelIDATWriter* parallelWriter = fEncoderMgr->parallelWriter();
+    const int numRows = rows.height();
+    const void* srcRow = rows.addr();
     for (int y = 0; y < numRows; y++) {
         fEncoderMgr->proc()((char*)fStorage.get(),
                             (const char*)srcRow,
                             fSrc.width(),
                             SkColorTypeBytesPerPixel(fSrc.colorType()));
 
-        png_bytep rowPtr = (png_bytep) fStorage.get();
-        png_write_rows(fEncoderMgr->pngPtr(), &rowPtr, 1);
-        srcRow = SkTAddOffset<const void>(srcRow, fSrc.rowBytes());
+        if (parallelWriter) {
+            if (fEncoderMgr->dropsFiller()) {
+                uint8_t* pixels = (uint8_t*) fStorage.get();
+                for (int x = 0; x < fSrc.width(); x++) {
+                    memmove(pixels + 6 * x, pixels + 8 * x, 6);
+                }
+            }
+            if (!parallelWriter->writeRow((const uint8_t*) fStorage.get())) {
+                return false;
+            }
+        } else {
+            png_bytep rowPtr = (png_bytep) fStorage.get();
+            png_write_rows(fEncoderMgr->pngPtr(), &rowPtr, 1);
+        }
+        srcRow = SkTAddOffset<const void>(srcRow, rows.rowBytes());
     }
 
     fCurrRow += numRows;
     if (fCurrRow == fSrc.height()) {
+        if (parallelWriter) {
+            return parallelWriter->finish();
+        }
         png_write_end(fEncoderMgr->pngPtr(), fEncoderMgr->infoPtr());
     }
 
@@ -11,6 +11,9 @@
 #include "SkPathPriv.h"
 #include "SkPathOps.h"
 #include "SkPathOpsCommon.h"
+#include "SkTaskGroup.h"
+
+#include <atomic>
 
 static bool one_contour(const SkPath& path) {
     SkSTArenaAlloc<256> allocator;
@@ -193,3 +196,49 @@ bool SkOpBuilder::resolve(SkPath* result) {
     }
     return success;
 }
+
+bool SkOpBuilder::resolve(SkPath* result, SkExecutor* executor) {
+    int count = fOps.count();
+    bool allUnion = count > 1;
+    for (int index = 0; allUnion && index < count; ++index) {
+        allUnion = kUnion_SkPathOp == fOps[index] && !fPathRefs[index].isInverseFillType();
+    }
+    if (!allUnion) {
+        return this->resolve(result);
+    }
+    // Each level unions neighboring pairs of the paths left by the level below, in place, and
+    // packs the sums to the front. The pairs on a level are independent of each other.
+    while (count > 1) {
+        const int pairCount = count / 2;
+        std::atomic<bool> failed{false};
+        auto unionPair = [this, &failed](int pair) {
+            if (!Op(fPathRefs[2 * pair], fPathRefs[2 * pair + 1], kUnion_SkPathOp,
+                    &fPathRefs[2 * pair])) {
+                failed = true;
+            }
+        };
+        if (executor && pairCount > 1) {
+            SkTaskGroup group(*executor);
+            group.batch(pairCount, unionPair);
+            group.wait();
+        } else {
+            for (int pair = 0; pair < pairCount; ++pair) {
+                unionPair(pair);
+            }
+        }
+        if (failed) {
+            reset();
+            return false;
+        }
+        for (int pair = 1; pair < pairCount; ++pair) {
+            fPathRefs[pair] = fPathRefs[2 * pair];
+        }
+        if (count & 1) {
+            fPathRefs[pairCount] = fPathRefs[count - 1];
+        }
+        count = pairCount + (count & 1);
+    }
+    *result = fPathRefs[0];
+    reset();
+    return true;
+}
@@ -13,3 +13,13 @@ sk_sp<SkDocument> SkPDF::MakeDocument(SkWStream*, const SkPDF::Metadata&) { retu
 void SkPDF::SetNodeId(SkCanvas* c, int n) {
     c->drawAnnotation({0, 0, 0, 0}, "PDF_Node_Key", SkData::MakeWithCopy(&n, sizeof(n)).get());
 }
+
+class SkPDFResourceCache {};
+
+SkPDF::ResourceCache::ResourceCache(size_t) {}
+
+SkPDF::ResourceCache::~ResourceCache() = default;
+
+size_t SkPDF::ResourceCache::bytesUsed() const { return 0; }
+
+void SkPDF::ResourceCache::purgeAll() {}
@@ -15,6 +15,7 @@
 #include "SkImageInfoPriv.h"
 #include "SkJpegInfo.h"
 #include "SkPDFDocumentPriv.h"
+#include "SkPDFResourceCache.h"
 #include "SkPDFTypes.h"
 #include "SkPDFUtils.h"
 #include "SkStream.h"
@@ -66,13 +67,12 @@ static SkColor get_neighbor_avg_color(const SkPixmap& bm, int xOrig, int yOrig)
 }
 
 template <typename T>
-static void emit_image_stream(SkPDFDocument* doc,
+static void emit_image_stream(T* out,
                               SkPDFIndirectReference ref,
-                              T writeStream,
+                              const SkData& data,
                               SkISize size,
                               const char* colorSpace,
                               SkPDFIndirectReference sMask,
-                              int length,
                               bool isJpeg) {
     SkPDFDict pdfDict("XObject");
     pdfDict.insertName("Subtype", "Image");
@@ -94,11 +94,20 @@ static void emit_image_stream(SkPDFDocument* doc,
     if (isJpeg) {
         pdfDict.insertInt("ColorTransform", 0);
     }
-    pdfDict.insertInt("Length", length);
-    doc->emitStream(pdfDict, std::move(writeStream), ref);
+    pdfDict.insertInt("Length", SkToInt(data.size()));
+    out->emitStream(pdfDict,
+                    [&data](SkWStream* dst) { dst->write(data.data(), data.size()); },
+                    ref);
 }
 
-static void do_deflated_alpha(const SkPixmap& pm, SkPDFDocument* doc, SkPDFIndirectReference ref) {
+static sk_sp<SkData> finish_stream(SkDynamicMemoryWStream* buffer) {
+    #ifdef SK_PDF_BASE85_BINARY
+    SkPDFUtils::Base85Encode(buffer->detachAsStream(), buffer);
+    #endif
+    return buffer->detachAsData();
+}
+
+static sk_sp<SkData> deflate_alpha(const SkPixmap& pm) {
     SkDynamicMemoryWStream buffer;
     SkDeflateWStream deflateWStream(&buffer);
     if (kAlpha_8_SkColorType == pm.colorType()) {
@@ -124,38 +133,24 @@ static void do_deflated_alpha(const SkPixmap& pm, SkPDFDocument* doc, SkPDFIndir
         deflateWStream.write(byteBuffer, dst - byteBuffer);
     }
     deflateWStream.finalize();
-
-    #ifdef SK_PDF_BASE85_BINARY
-    SkPDFUtils::Base85Encode(buffer.detachAsStream(), &buffer);
-    #endif
-    int length = SkToInt(buffer.bytesWritten());
-    emit_image_stream(doc, ref, [&buffer](SkWStream* stream) { buffer.writeToAndReset(stream); },
-                      pm.info().dimensions(), "DeviceGray", SkPDFIndirectReference(),
-                      length, false);
+    return finish_stream(&buffer);
 }
 
-static void do_deflated_image(const SkPixmap& pm,
-                              SkPDFDocument* doc,
-                              bool isOpaque,
-                              SkPDFIndirectReference ref) {
-    SkPDFIndirectReference sMask;
-    if (!isOpaque) {
-        sMask = doc->reserveRef();
-    }
+static void deflate_image(const SkPixmap& pm, bool isOpaque, SkPDFEncodedImage* image) {
     SkDynamicMemoryWStream buffer;
     SkDeflateWStream deflateWStream(&buffer);
-    const char* colorSpace = "DeviceGray";
+    image->fColorSpace = "DeviceGray";
     switch (pm.colorType()) {
         case kAlpha_8_SkColorType:
             fill_stream(&deflateWStream, '\x00', pm.width() * pm.height());
             break;
         case kGray_8_SkColorType:
-            SkASSERT(sMask.fValue = -1);
+            SkASSERT(isOpaque);
             SkASSERT(pm.rowBytes() == (size_t)pm.width());
             deflateWStream.write(pm.addr8(), pm.width() * pm.height());
             break;
         default:
-            colorSpace = "DeviceRGB";
+            image->fColorSpace = "DeviceRGB";
             SkASSERT(pm.alphaType() == kUnpremul_SkAlphaType);
             SkASSERT(pm.colorType() == kBGRA_8888_SkColorType);
             SkASSERT(pm.rowBytes() == (size_t)pm.width() * 4);
@@ -182,19 +177,13 @@ static void do_deflated_image(const SkPixmap& pm,
             deflateWStream.write(byteBuffer, dst - byteBuffer);
     }
     deflateWStream.finalize();
-    #ifdef SK_PDF_BASE85_BINARY
-    SkPDFUtils::Base85Encode(buffer.detachAsStream(), &buffer);
-    #endif
-    int length = SkToInt(buffer.bytesWritten());
-    emit_image_stream(doc, ref, [&buffer](SkWStream* stream) { buffer.writeToAndReset(stream); },
-                      pm.info().dimensions(), colorSpace, sMask, length, false);
-    if (!isOpaque) {
-        do_deflated_alpha(pm, doc, sMask);
-    }
+    image->fSize = pm.info().dimensions();
+    image->fIsJpeg = false;
+    image->fData = finish_stream(&buffer);
+    image->fAlpha = isOpaque ? nullptr : deflate_alpha(pm);
 }
 
-static bool do_jpeg(sk_sp<SkData> data, SkPDFDocument* doc, SkISize size,
-                    SkPDFIndirectReference ref) {
+static bool jpeg_image(sk_sp<SkData> data, SkISize size, SkPDFEncodedImage* image) {
     SkISize jpegSize;
     SkEncodedInfo::Color jpegColorType;
     SkEncodedOrigin exifOrientation;
@@ -215,10 +204,11 @@ static bool do_jpeg(sk_sp<SkData> data, SkPDFDocument* doc, SkISize size,
     data = buffer.detachAsData();
     #endif
 
-    emit_image_stream(doc, ref,
-                      [&data](SkWStream* dst) { dst->write(data->data(), data->size()); },
-                      jpegSize, yuv ? "DeviceRGB" : "DeviceGray",
-                      SkPDFIndirectReference(), SkToInt(data->size()), true);
+    image->fSize = jpegSize;
+    image->fColorSpace = yuv ? "DeviceRGB" : "DeviceGray";
+    image->fIsJpeg = true;
+    image->fData = std::move(data);
+    image->fAlpha = nullptr;
     return true;
 }
 
@@ -245,46 +235,95 @@ static SkBitmap to_pixels(const SkImage* image) {
     return bm;
 }
 
-void serialize_image(const SkImage* img,
-                     int encodingQuality,
-                     SkPDFDocument* doc,
-                     SkPDFIndirectReference ref) {
+// Compresses the pixels, as a JPEG if they're opaque and lossy encoding is allowed.
+static SkPDFEncodedImage encode_pixels(const SkImage* img, const SkPixmap& pm, bool isOpaque,
+                                       int encodingQuality) {
     SkASSERT(img);
-    SkASSERT(doc);
     SkASSERT(encodingQuality >= 0);
-    SkISize dimensions = img->dimensions();
-    sk_sp<SkData> data = img->refEncodedData();
-    if (data && do_jpeg(std::move(data), doc, dimensions, ref)) {
-        return;
-    }
-    SkBitmap bm = to_pixels(img);
-    SkPixmap pm = bm.pixmap();
-    bool isOpaque = pm.isOpaque() || pm.computeIsOpaque();
+    SkPDFEncodedImage image;
     if (encodingQuality <= 100 && isOpaque) {
         sk_sp<SkData> data = img->encodeToData(SkEncodedImageFormat::kJPEG, encodingQuality);
-        if (data && do_jpeg(std::move(data), doc, dimensions, ref)) {
-            return;
+        if (data && jpeg_image(std::move(data), img->dimensions(), &image)) {
+            return image;
         }
     }
-    do_deflated_image(pm, doc, isOpaque, ref);
+    deflate_image(pm, isOpaque, &image);
+    return image;
+}
+
+template <typename T>
+static void emit_encoded_image(const SkPDFEncodedImage& image,
+                               T* out,
+                               SkPDFIndirectReference ref,
+                               SkPDFIndirectReference sMask) {
+    SkASSERT(!sMask == !image.fAlpha);
+    emit_image_stream(out, ref, *image.fData, image.fSize, image.fColorSpace, sMask,
+                      image.fIsJpeg);
+    if (sMask) {
+        emit_image_stream(out, sMask, *image.fAlpha, image.fSize, "DeviceGray",
+                          SkPDFIndirectReference(), false);
+    }
 }
 
 SkPDFIndirectReference SkPDFSerializeImage(const SkImage* img,
                                            SkPDFDocument* doc,
-                                           int encodingQuality) {
+                                           int encodingQuality,
+                                           const SkBitmapKey* bitmapKey) {
     SkASSERT(img);
     SkASSERT(doc);
+    SkPDFResourceCache* cache = bitmapKey ? doc->resourceCache() : nullptr;
+    SkPDFResourceCache::ImageKey key;
+    if (cache) {
+        key = SkPDFResourceCache::ImageKey{*bitmapKey, encodingQuality};
+    }
+
+    // Find out whether the image needs a soft mask before reserving any numbers, so that only
+    // the objects we write are numbered, in an order that doesn't depend on the executor.  That
+    // means reading the pixels here; only compressing them is left to the executor.
+    SkPDFEncodedImage image;
+    SkBitmap bm;
+    bool isOpaque = true;
+    bool encoded = cache && cache->findImage(key, &image);
+    if (!encoded) {
+        sk_sp<SkData> data = img->refEncodedData();
+        if (data && jpeg_image(std::move(data), img->dimensions(), &image)) {
+            encoded = true;
+            if (cache) {
+                cache->addImage(key, image);
+            }
+        } else {
+            bm = to_pixels(img);
+            isOpaque = img->isOpaque() || bm.pixmap().isOpaque() || bm.pixmap().computeIsOpaque();
+        }
+    }
+    bool hasAlpha = encoded ? SkToBool(image.fAlpha) : !isOpaque;
+
     SkPDFIndirectReference ref = doc->reserveRef();
+    SkPDFIndirectReference sMask = hasAlpha ? doc->reserveRef() : SkPDFIndirectReference();
+    if (encoded) {
+        emit_encoded_image(image, doc, ref, sMask);
+        return ref;
+    }
     if (SkExecutor* executor = doc->executor()) {
+        SkPDFObjectBatch* batch = doc->beginBatch();
         SkRef(img);
         doc->incrementJobCount();
-        executor->add([img, encodingQuality, doc, ref]() {
-            serialize_image(img, encodingQuality, doc, ref);
+        executor->add([img, bm, isOpaque, encodingQuality, cache, key, doc, batch, ref, sMask]() {
+            SkPDFEncodedImage image = encode_pixels(img, bm.pixmap(), isOpaque, encodingQuality);
+            if (cache) {
+                cache->addImage(key, image);
+            }
+            emit_encoded_image(image, batch, ref, sMask);
             SkSafeUnref(img);
+            doc->endBatch(batch);
             doc->signalJobComplete();
         });
         return ref;
     }
-    serialize_image(img, encodingQuality, doc, ref);
+    image = encode_pixels(img, bm.pixmap(), isOpaque, encodingQuality);
+    if (cache) {
+        cache->addImage(key, image);
+    }
+    emit_encoded_image(image, doc, ref, sMask);
     return ref;
 }
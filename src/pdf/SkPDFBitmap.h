@@ -9,14 +9,18 @@
 
 class SkImage;
 class SkPDFDocument;
+struct SkBitmapKey;
 struct SkPDFIndirectReference;
 
 /**
  * Serialize a SkImage as an Image Xobject.
  *  quality > 100 means lossless
+ *  If key is not null and the document has a resource cache, the encoded
+ *  image is looked up in and added to the cache under that key.
  */
 SkPDFIndirectReference SkPDFSerializeImage(const SkImage* img,
                                            SkPDFDocument* doc,
-                                           int encodingQuality = 101);
+                                           int encodingQuality = 101,
+                                           const SkBitmapKey* key = nullptr);
 
 #endif  // SkPDFBitmap_DEFINED
@@ -80,16 +80,30 @@ static void serializeHeader(SkPDFOffsetMap* offsetMap, SkWStream* wStream) {
 }
 #undef SKPDF_MAGIC
 
+static void write_object_header(SkPDFIndirectReference ref, SkWStream* s) {
+    s->writeDecAsText(ref.fValue);
+    s->writeText(" 0 obj\n");  // Generation number is always 0.
+}
+
 static void begin_indirect_object(SkPDFOffsetMap* offsetMap,
                                   SkPDFIndirectReference ref,
                                   SkWStream* s) {
     offsetMap->markStartOfObject(ref.fValue, s);
-    s->writeDecAsText(ref.fValue);
-    s->writeText(" 0 obj\n");  // Generation number is always 0.
+    write_object_header(ref, s);
 }
 
 static void end_indirect_object(SkWStream* s) { s->writeText("\nendobj\n"); }
 
+////////////////////////////////////////////////////////////////////////////////
+
+SkWStream* SkPDFObjectBatch::beginObject(SkPDFIndirectReference ref) {
+    fObjects.push_back(Object{ref, fData.bytesWritten()});
+    write_object_header(ref, &fData);
+    return &fData;
+}
+
+void SkPDFObjectBatch::endObject() { end_indirect_object(&fData); }
+
 // Xref table and footer
 static void serialize_footer(const SkPDFOffsetMap& offsetMap,
                              SkWStream* wStream,
@@ -113,18 +127,22 @@ static void serialize_footer(const SkPDFOffsetMap& offsetMap,
     wStream->writeText("\n%%EOF");
 }
 
+// PDF wants a tree describing all the pages in the document.  We arbitrary
+// choose 8 as the number of allowed children.
+static constexpr size_t kMaxPageTreeNodeSize = 8;
+
 static SkPDFIndirectReference generate_page_tree(
         SkPDFDocument* doc,
-        std::vector<std::unique_ptr<SkPDFDict>> pages,
+        const std::vector<SkPDFIndirectReference>& leafRefs,
         const std::vector<SkPDFIndirectReference>& pageRefs) {
-    // PDF wants a tree describing all the pages in the document.  We arbitrary
-    // choose 8 (kNodeSize) as the number of allowed children.  The internal
-    // nodes have type "Pages" with an array of children, a parent pointer, and
-    // the number of leaves below the node as "Count."  The leaves are passed
-    // into the method, have type "Page" and need a parent pointer. This method
-    // builds the tree bottom up, skipping internal nodes that would have only
-    // one child.
-    SkASSERT(pages.size() > 0);
+    // The internal nodes have type "Pages" with an array of children, a parent
+    // pointer, and the number of leaves below the node as "Count."  The pages
+    // have already been written by write_pages(), pointing at the leaf node
+    // reserved for each run of kMaxPageTreeNodeSize pages.  This method builds
+    // the rest of the tree bottom up, skipping internal nodes that would have
+    // only one child.
+    SkASSERT(pageRefs.size() > 0);
+    SkASSERT(leafRefs.size() == (pageRefs.size() - 1) / kMaxPageTreeNodeSize + 1);
     struct PageTreeNode {
         std::unique_ptr<SkPDFDict> fNode;
         SkPDFIndirectReference fReservedRef;
@@ -132,23 +150,21 @@ static SkPDFIndirectReference generate_page_tree(
 
         static std::vector<PageTreeNode> Layer(std::vector<PageTreeNode> vec, SkPDFDocument* doc) {
             std::vector<PageTreeNode> result;
-            static constexpr size_t kMaxNodeSize = 8;
             const size_t n = vec.size();
-            SkASSERT(n >= 1);
-            const size_t result_len = (n - 1) / kMaxNodeSize + 1;
-            SkASSERT(result_len >= 1);
-            SkASSERT(n == 1 || result_len < n);
+            SkASSERT(n > 1);
+            const size_t result_len = (n - 1) / kMaxPageTreeNodeSize + 1;
+            SkASSERT(result_len < n);
             result.reserve(result_len);
             size_t index = 0;
             for (size_t i = 0; i < result_len; ++i) {
-                if (n != 1 && index + 1 == n) {  // No need to create a new node.
+                if (index + 1 == n) {  // No need to create a new node.
                     result.push_back(std::move(vec[index++]));
                     continue;
                 }
                 SkPDFIndirectReference parent = doc->reserveRef();
                 auto kids_list = SkPDFMakeArray();
                 int descendantCount = 0;
-                for (size_t j = 0; j < kMaxNodeSize && index < n; ++j) {
+                for (size_t j = 0; j < kMaxPageTreeNodeSize && index < n; ++j) {
                     PageTreeNode& node = vec[index++];
                     node.fNode->insertRef("Parent", parent);
                     kids_list->appendRef(doc->emit(*node.fNode, node.fReservedRef));
@@ -163,12 +179,20 @@ static SkPDFIndirectReference generate_page_tree(
         }
     };
     std::vector<PageTreeNode> currentLayer;
-    currentLayer.reserve(pages.size());
-    SkASSERT(pages.size() == pageRefs.size());
-    for (size_t i = 0; i < pages.size(); ++i) {
-        currentLayer.push_back(PageTreeNode{std::move(pages[i]), pageRefs[i], 1});
+    currentLayer.reserve(leafRefs.size());
+    for (size_t i = 0; i < leafRefs.size(); ++i) {
+        const size_t first = i * kMaxPageTreeNodeSize;
+        const size_t end = SkTMin(first + kMaxPageTreeNodeSize, pageRefs.size());
+        auto kids_list = SkPDFMakeArray();
+        kids_list->reserve(SkToInt(end - first));
+        for (size_t j = first; j < end; ++j) {
+            kids_list->appendRef(pageRefs[j]);
+        }
+        auto leaf = SkPDFMakeDict("Pages");
+        leaf->insertInt("Count", end - first);
+        leaf->insertObject("Kids", std::move(kids_list));
+        currentLayer.push_back(PageTreeNode{std::move(leaf), leafRefs[i], SkToInt(end - first)});
     }
-    currentLayer = PageTreeNode::Layer(std::move(currentLayer), doc);
     while (currentLayer.size() > 1) {
         currentLayer = PageTreeNode::Layer(std::move(currentLayer), doc);
     }
@@ -177,6 +201,25 @@ static SkPDFIndirectReference generate_page_tree(
     return doc->emit(*root.fNode, root.fReservedRef);
 }
 
+// Writes out the pages that have ended since the last call, all pointing at a
+// newly reserved leaf of the page tree, so that at most kMaxPageTreeNodeSize
+// page dictionaries are held at once.
+static void write_pages(SkPDFDocument* doc,
+                        std::vector<std::unique_ptr<SkPDFDict>>* pages,
+                        const std::vector<SkPDFIndirectReference>& pageRefs,
+                        std::vector<SkPDFIndirectReference>* leafRefs) {
+    SkASSERT(pages->size() > 0 && pages->size() <= kMaxPageTreeNodeSize);
+    SkASSERT(pageRefs.size() == leafRefs->size() * kMaxPageTreeNodeSize + pages->size());
+    SkPDFIndirectReference leaf = doc->reserveRef();
+    const size_t first = pageRefs.size() - pages->size();
+    for (size_t i = 0; i < pages->size(); ++i) {
+        (*pages)[i]->insertRef("Parent", leaf);
+        doc->emit(*(*pages)[i], pageRefs[first + i]);
+    }
+    pages->clear();
+    leafRefs->push_back(leaf);
+}
+
 template<typename T, typename... Args>
 static void reset_object(T* dst, Args&&... args) {
     dst->~T();
@@ -198,6 +241,9 @@ SkPDFDocument::SkPDFDocument(SkWStream* stream,
         fTagTree.init(fMetadata.fStructureElementTreeRoot);
     }
     fExecutor = metadata.fExecutor;
+    if (metadata.fResourceCache) {
+        fResourceCache = metadata.fResourceCache->fCache.get();
+    }
 }
 
 SkPDFDocument::~SkPDFDocument() {
@@ -213,21 +259,60 @@ SkPDFIndirectReference SkPDFDocument::emit(const SkPDFObject& object, SkPDFIndir
 
 SkWStream* SkPDFDocument::beginObject(SkPDFIndirectReference ref) {
     fMutex.acquire();
+    if (!fBatches.empty()) {
+        // Batches begun earlier are still being filled in, and this object must follow them.
+        if (!fBatches.back()->fDone) {
+            fBatches.emplace_back(new SkPDFObjectBatch);
+            fBatches.back()->fDone = true;
+        }
+        return fBatches.back()->beginObject(ref);
+    }
     begin_indirect_object(&fOffsetMap, ref, this->getStream());
     return this->getStream();
 };
 
 void SkPDFDocument::endObject() {
-    end_indirect_object(this->getStream());
+    if (!fBatches.empty()) {
+        fBatches.back()->endObject();
+    } else {
+        end_indirect_object(this->getStream());
+    }
     fMutex.release();
 };
 
+SkPDFObjectBatch* SkPDFDocument::beginBatch() {
+    SkAutoMutexAcquire autoMutexAcquire(fMutex);
+    fBatches.emplace_back(new SkPDFObjectBatch);
+    return fBatches.back().get();
+}
+
+void SkPDFDocument::endBatch(SkPDFObjectBatch* batch) {
+    SkAutoMutexAcquire autoMutexAcquire(fMutex);
+    batch->fDone = true;
+    this->writeFinishedBatches();
+}
+
+void SkPDFDocument::writeFinishedBatches() {
+    SkWStream* stream = this->getStream();
+    while (!fBatches.empty() && fBatches.front()->fDone) {
+        SkPDFObjectBatch* batch = fBatches.front().get();
+        const size_t size = batch->fData.bytesWritten();
+        std::unique_ptr<SkStreamAsset> data = batch->fData.detachAsStream();
+        for (size_t i = 0; i < batch->fObjects.size(); ++i) {
+            size_t end = i + 1 < batch->fObjects.size() ? batch->fObjects[i + 1].fOffset : size;
+            fOffsetMap.markStartOfObject(batch->fObjects[i].fRef.fValue, stream);
+            stream->writeStream(data.get(), end - batch->fObjects[i].fOffset);
+        }
+        fBatches.pop_front();
+    }
+}
+
 static SkSize operator*(SkISize u, SkScalar s) { return SkSize{u.width() * s, u.height() * s}; }
 static SkSize operator*(SkSize u, SkScalar s) { return SkSize{u.width() * s, u.height() * s}; }
 
 SkCanvas* SkPDFDocument::onBeginPage(SkScalar width, SkScalar height) {
     SkASSERT(fCanvas.imageInfo().dimensions().isZero());
-    if (fPages.empty()) {
+    if (fPageRefs.empty()) {
         // if this is the first page if the document.
         {
             SkAutoMutexAcquire autoMutexAcquire(fMutex);
@@ -289,6 +374,9 @@ void SkPDFDocument::onEndPage() {
     // 0-based page index.
     page->insertInt("StructParents", SkToInt(this->currentPageIndex()));
     fPages.emplace_back(std::move(page));
+    if (fPages.size() == kMaxPageTreeNodeSize) {
+        write_pages(this, &fPages, fPageRefs, &fPageTreeLeafRefs);
+    }
 }
 
 void SkPDFDocument::onAbort() {
@@ -452,7 +540,7 @@ static std::vector<const SkPDFFont*> get_fonts(const SkPDFDocument& canon) {
 
 void SkPDFDocument::onClose(SkWStream* stream) {
     SkASSERT(fCanvas.imageInfo().dimensions().isZero());
-    if (fPages.empty()) {
+    if (fPageRefs.empty()) {
         this->waitForJobs();
         return;
     }
@@ -465,7 +553,10 @@ void SkPDFDocument::onClose(SkWStream* stream) {
         docCatalog->insertObject("OutputIntents", make_srgb_output_intents(this));
     }
 
-    docCatalog->insertRef("Pages", generate_page_tree(this, std::move(fPages), fPageRefs));
+    if (!fPages.empty()) {
+        write_pages(this, &fPages, fPageRefs, &fPageTreeLeafRefs);
+    }
+    docCatalog->insertRef("Pages", generate_page_tree(this, fPageTreeLeafRefs, fPageRefs));
 
     if (fDests.size() > 0) {
         docCatalog->insertRef("Dests", this->emit(fDests));
@@ -483,9 +574,7 @@ void SkPDFDocument::onClose(SkWStream* stream) {
 
     auto docCatalogRef = this->emit(*docCatalog);
 
-    for (const SkPDFFont* f : get_fonts(*this)) {
-        f->emitSubset(this);
-    }
+    SkPDFFont::EmitSubsets(get_fonts(*this), this);
 
     this->waitForJobs();
     {
@@ -504,6 +593,7 @@ void SkPDFDocument::waitForJobs() {
          fSemaphore.wait();
          --fJobCount;
      }
+     SkASSERT(fBatches.empty());
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -16,12 +16,14 @@
 #include "SkTHash.h"
 
 #include <atomic>
+#include <deque>
 #include <vector>
 #include <memory>
 
 class SkExecutor;
 class SkPDFDevice;
 class SkPDFFont;
+class SkPDFResourceCache;
 struct SkAdvancedTypefaceMetrics;
 struct SkBitmapKey;
 struct SkPDFFillGraphicState;
@@ -47,6 +49,36 @@ private:
     size_t fBaseOffset = SIZE_MAX;
 };
 
+/** A run of indirect objects serialized apart from the document on one of its executor's
+    threads.  The document copies each batch into its stream in the order the batches were
+    begun, so the output does not depend on which thread finishes first. */
+class SkPDFObjectBatch {
+public:
+    template <typename T>
+    void emitStream(const SkPDFDict& dict, T writeStream, SkPDFIndirectReference ref) {
+        SkWStream* stream = this->beginObject(ref);
+        dict.emitObject(stream);
+        stream->writeText(" stream\n");
+        writeStream(stream);
+        stream->writeText("\nendstream");
+        this->endObject();
+    }
+
+private:
+    friend class SkPDFDocument;
+
+    SkWStream* beginObject(SkPDFIndirectReference);
+    void endObject();
+
+    struct Object {
+        SkPDFIndirectReference fRef;
+        size_t fOffset;  // In fData.
+    };
+    SkDynamicMemoryWStream fData;
+    std::vector<Object> fObjects;
+    bool fDone = false;
+};
+
 /** Concrete implementation of SkDocument that creates PDF files. This
     class does not produced linearized or optimized PDFs; instead it
     it attempts to use a minimum amount of RAM. */
@@ -81,6 +113,17 @@ public:
         this->endObject();
     }
 
+    /**
+       Begins a batch of objects, which will be written after every object
+       emitted or batch begun before it, even if it is filled in on another
+       thread.  Call from the thread that calls emit().  The batch belongs to
+       the document, which will write it and delete it after endBatch().
+       Only work handed to the executor needs a batch; objects emitted
+       while no batch is pending go straight to the document's stream.
+     */
+    SkPDFObjectBatch* beginBatch();
+    void endBatch(SkPDFObjectBatch*);
+
     const SkPDF::Metadata& metadata() const { return fMetadata; }
 
     SkPDFIndirectReference getPage(size_t pageIndex) const;
@@ -90,9 +133,10 @@ public:
     SkPDFIndirectReference reserveRef() { return SkPDFIndirectReference{fNextObjectNumber++}; }
 
     SkExecutor* executor() const { return fExecutor; }
+    SkPDFResourceCache* resourceCache() const { return fResourceCache; }
     void incrementJobCount();
     void signalJobComplete();
-    size_t currentPageIndex() { return fPages.size(); }
+    size_t currentPageIndex() { SkASSERT(!fPageRefs.empty()); return fPageRefs.size() - 1; }
     size_t pageCount() { return fPageRefs.size(); }
 
     // Canonicalized objects
@@ -114,8 +158,9 @@ public:
 private:
     SkPDFOffsetMap fOffsetMap;
     SkCanvas fCanvas;
-    std::vector<std::unique_ptr<SkPDFDict>> fPages;
+    std::vector<std::unique_ptr<SkPDFDict>> fPages;  // Ended, but not yet written.
     std::vector<SkPDFIndirectReference> fPageRefs;
+    std::vector<SkPDFIndirectReference> fPageTreeLeafRefs;
     SkPDFDict fDests;
     sk_sp<SkPDFDevice> fPageDevice;
     std::atomic<int> fNextObjectNumber = {1};
@@ -127,16 +172,20 @@ private:
     SkScalar fRasterScale = 1;
     SkScalar fInverseRasterScale = 1;
     SkExecutor* fExecutor = nullptr;
+    SkPDFResourceCache* fResourceCache = nullptr;
 
     // For tagged PDFs.
     SkPDFTagTree fTagTree;
 
     SkMutex fMutex;
     SkSemaphore fSemaphore;
+    // Batches waiting to be written, in order.  Guarded by fMutex.
+    std::deque<std::unique_ptr<SkPDFObjectBatch>> fBatches;
 
     void waitForJobs();
     SkWStream* beginObject(SkPDFIndirectReference);
     void endObject();
+    void writeFinishedBatches();
 };
 
 #endif  // SkPDFDocumentPriv_DEFINED
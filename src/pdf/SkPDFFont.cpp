@@ -19,14 +19,17 @@
 #include "SkPDFDocumentPriv.h"
 #include "SkPDFMakeCIDGlyphWidthsArray.h"
 #include "SkPDFMakeToUnicodeCmap.h"
+#include "SkPDFResourceCache.h"
 #include "SkPDFResourceDict.h"
 #include "SkPDFSubsetFont.h"
 #include "SkPDFUtils.h"
 #include "SkPaint.h"
 #include "SkRefCnt.h"
 #include "SkScalar.h"
+#include "SkSemaphore.h"
 #include "SkStream.h"
 #include "SkStrike.h"
+#include "SkTaskGroup.h"
 #include "SkTo.h"
 #include "SkTypes.h"
 #include "SkUTF.h"
@@ -283,7 +286,62 @@ static sk_sp<SkData> stream_to_data(std::unique_ptr<SkStreamAsset> stream) {
     return SkData::MakeFromStream(stream.get(), size);
 }
 
-static void emit_subset_type0(const SkPDFFont& font, SkPDFDocument* doc) {
+namespace {
+// The slow parts of a Type0 font: subsetting its font program, and measuring the glyphs it
+// uses.  They don't touch the document, so they can be done on its executor.
+struct Type0Subset {
+    std::unique_ptr<SkStreamAsset> fFontAsset;  // The whole font program, if not subset.
+    size_t fFontSize = 0;  // Of the whole font program, or the cached subset; 0 if neither.
+    sk_sp<SkData> fSubsetFontData;
+    std::unique_ptr<SkPDFArray> fWidths;
+    int16_t fDefaultWidth = 0;
+    int fEmSize = 0;
+};
+}
+
+static void make_type0_subset(const SkPDFFont& font,
+                              const SkAdvancedTypefaceMetrics& metrics,
+                              SkPDFResourceCache* cache,
+                              Type0Subset* subset) {
+    SkTypeface* face = font.typeface();
+    SkASSERT(face);
+    bool subsettable =
+            font.getType() == SkAdvancedTypefaceMetrics::kTrueType_Font &&
+            !SkToBool(metrics.fFlags & SkAdvancedTypefaceMetrics::kNotSubsettable_FontFlag);
+    if (subsettable && cache) {
+        subset->fSubsetFontData = cache->findFontProgram(*face, font.glyphUsage());
+    }
+    if (subset->fSubsetFontData) {
+        subset->fFontSize = subset->fSubsetFontData->size();
+    } else {
+        int ttcIndex;
+        subset->fFontAsset = face->openStream(&ttcIndex);
+        subset->fFontSize = subset->fFontAsset ? subset->fFontAsset->getLength() : 0;
+        if (subset->fFontSize > 0 && subsettable) {
+            SkASSERT(font.firstGlyphID() == 1);
+            subset->fSubsetFontData = SkPDFSubsetFont(
+                    stream_to_data(std::move(subset->fFontAsset)), font.glyphUsage(),
+                    metrics.fFontName.c_str(), ttcIndex);
+            if (subset->fSubsetFontData) {
+                if (cache) {
+                    cache->addFontProgram(*face, font.glyphUsage(), subset->fSubsetFontData);
+                }
+            } else {
+                // If subsetting fails, fall back to original font data.
+                subset->fFontAsset = face->openStream(&ttcIndex);
+                SkASSERT(subset->fFontAsset);
+                SkASSERT(subset->fFontAsset->getLength() == subset->fFontSize);
+            }
+        }
+    }
+
+    auto glyphCache = SkPDFFont::MakeVectorCache(face, &subset->fEmSize);
+    subset->fWidths = SkPDFMakeCIDGlyphWidthsArray(
+            glyphCache.get(), &font.glyphUsage(), SkToS16(subset->fEmSize),
+            &subset->fDefaultWidth);
+}
+
+static void emit_subset_type0(const SkPDFFont& font, SkPDFDocument* doc, Type0Subset* subset) {
     const SkAdvancedTypefaceMetrics* metricsPtr =
         SkPDFFont::GetMetrics(font.typeface(), doc);
     SkASSERT(metricsPtr);
@@ -294,13 +352,18 @@ static void emit_subset_type0(const SkPDFFont& font, SkPDFDocument* doc) {
     SkTypeface* face = font.typeface();
     SkASSERT(face);
 
+    Type0Subset serialSubset;
+    if (!subset) {
+        make_type0_subset(font, metrics, doc->resourceCache(), &serialSubset);
+        subset = &serialSubset;
+    }
+
     auto descriptor = SkPDFMakeDict("FontDescriptor");
     uint16_t emSize = SkToU16(font.typeface()->getUnitsPerEm());
     add_common_font_descriptor_entries(descriptor.get(), metrics, emSize , 0);
 
-    int ttcIndex;
-    std::unique_ptr<SkStreamAsset> fontAsset = face->openStream(&ttcIndex);
-    size_t fontSize = fontAsset ? fontAsset->getLength() : 0;
+    std::unique_ptr<SkStreamAsset> fontAsset = std::move(subset->fFontAsset);
+    size_t fontSize = subset->fFontSize;
     if (0 == fontSize) {
         SkDebugf("Error: (SkTypeface)(%p)::openStream() returned "
                  "empty stream (%p) when identified as kType1CID_Font "
@@ -308,28 +371,18 @@ static void emit_subset_type0(const SkPDFFont& font, SkPDFDocument* doc) {
     } else {
         switch (type) {
             case SkAdvancedTypefaceMetrics::kTrueType_Font: {
-                if (!SkToBool(metrics.fFlags &
-                              SkAdvancedTypefaceMetrics::kNotSubsettable_FontFlag)) {
-                    SkASSERT(font.firstGlyphID() == 1);
-                    sk_sp<SkData> subsetFontData = SkPDFSubsetFont(
-                            stream_to_data(std::move(fontAsset)), font.glyphUsage(),
-                            metrics.fFontName.c_str(), ttcIndex);
-                    if (subsetFontData) {
-                        std::unique_ptr<SkPDFDict> tmp = SkPDFMakeDict();
-                        tmp->insertInt("Length1", SkToInt(subsetFontData->size()));
-                        descriptor->insertRef(
-                                "FontFile2",
-                                SkPDFStreamOut(std::move(tmp),
-                                               SkMemoryStream::Make(std::move(subsetFontData)),
-                                               doc, true));
-                        break;
-                    }
-                    // If subsetting fails, fall back to original font data.
-                    fontAsset = face->openStream(&ttcIndex);
-                    SkASSERT(fontAsset);
-                    SkASSERT(fontAsset->getLength() == fontSize);
-                    if (!fontAsset || fontAsset->getLength() == 0) { break; }
+                if (subset->fSubsetFontData) {
+                    sk_sp<SkData> subsetFontData = std::move(subset->fSubsetFontData);
+                    std::unique_ptr<SkPDFDict> tmp = SkPDFMakeDict();
+                    tmp->insertInt("Length1", SkToInt(subsetFontData->size()));
+                    descriptor->insertRef(
+                            "FontFile2",
+                            SkPDFStreamOut(std::move(tmp),
+                                           SkMemoryStream::Make(std::move(subsetFontData)),
+                                           doc, true));
+                    break;
                 }
+                if (!fontAsset || fontAsset->getLength() == 0) { break; }
                 std::unique_ptr<SkPDFDict> tmp = SkPDFMakeDict();
                 tmp->insertInt("Length1", fontSize);
                 descriptor->insertRef("FontFile2",
@@ -371,18 +424,11 @@ static void emit_subset_type0(const SkPDFFont& font, SkPDFDocument* doc) {
     sysInfo->insertInt("Supplement", 0);
     newCIDFont->insertObject("CIDSystemInfo", std::move(sysInfo));
 
-    int16_t defaultWidth = 0;
-    {
-        int emSize;
-        auto glyphCache = SkPDFFont::MakeVectorCache(face, &emSize);
-        std::unique_ptr<SkPDFArray> widths = SkPDFMakeCIDGlyphWidthsArray(
-                glyphCache.get(), &font.glyphUsage(), SkToS16(emSize), &defaultWidth);
-        if (widths && widths->size() > 0) {
-            newCIDFont->insertObject("W", std::move(widths));
-        }
-        newCIDFont->insertScalar(
-                "DW", scaleFromFontUnits(defaultWidth, SkToS16(emSize)));
+    if (subset->fWidths && subset->fWidths->size() > 0) {
+        newCIDFont->insertObject("W", std::move(subset->fWidths));
     }
+    newCIDFont->insertScalar(
+            "DW", scaleFromFontUnits(subset->fDefaultWidth, SkToS16(subset->fEmSize)));
 
     ////////////////////////////////////////////////////////////////////////////
 
@@ -765,7 +811,7 @@ void SkPDFFont::emitSubset(SkPDFDocument* doc) const {
     switch (fFontType) {
         case SkAdvancedTypefaceMetrics::kType1CID_Font:
         case SkAdvancedTypefaceMetrics::kTrueType_Font:
-            return emit_subset_type0(*this, doc);
+            return emit_subset_type0(*this, doc, nullptr);
         case SkAdvancedTypefaceMetrics::kType1_Font:
             return emit_subset_type1(*this, doc);
         default:
@@ -773,6 +819,48 @@ void SkPDFFont::emitSubset(SkPDFDocument* doc) const {
     }
 }
 
+void SkPDFFont::EmitSubsets(const std::vector<const SkPDFFont*>& fonts, SkPDFDocument* doc) {
+    SkExecutor* executor = doc->executor();
+    if (!executor) {
+        for (const SkPDFFont* font : fonts) {
+            font->emitSubset(doc);
+        }
+        return;
+    }
+
+    // Start subsetting every Type0 font, then write each font in turn as soon as its subset
+    // is ready.  The metrics are cached by the document, so fetch them on this thread.
+    SkPDFResourceCache* cache = doc->resourceCache();
+    const size_t count = fonts.size();
+    std::vector<Type0Subset> subsets(count);
+    std::unique_ptr<SkSemaphore[]> ready(new SkSemaphore[count]);
+    SkTaskGroup tasks(*executor);  // Waits for the tasks before the above are destroyed.
+    for (size_t i = 0; i < count; ++i) {
+        if (!fonts[i]->multiByteGlyphs()) {
+            continue;
+        }
+        const SkPDFFont* font = fonts[i];
+        if (const SkAdvancedTypefaceMetrics* metrics = GetMetrics(font->typeface(), doc)) {
+            Type0Subset* subset = &subsets[i];
+            SkSemaphore* done = &ready[i];
+            tasks.add([font, metrics, cache, subset, done]() {
+                make_type0_subset(*font, *metrics, cache, subset);
+                done->signal();
+            });
+        } else {
+            ready[i].signal();
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (fonts[i]->multiByteGlyphs()) {
+            ready[i].wait();
+            emit_subset_type0(*fonts[i], doc, &subsets[i]);
+        } else {
+            fonts[i]->emitSubset(doc);
+        }
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 bool SkPDFFont::CanEmbedTypeface(SkTypeface* typeface, SkPDFDocument* doc) {
@@ -100,6 +100,11 @@ public:
 
     void emitSubset(SkPDFDocument*) const;
 
+    /** Emits the subsets of these fonts in order.  If the document has an
+     *  executor, the font programs are subset and the glyphs measured on it.
+     */
+    static void EmitSubsets(const std::vector<const SkPDFFont*>&, SkPDFDocument*);
+
     /**
      *  Return false iff the typeface has its NotEmbeddable flag set.
      *  typeface is not nullptr
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkPDFResourceCache.h"
+
+#include "SkChecksum.h"
+#include "SkPDFDocument.h"
+#include "SkPDFGlyphUse.h"
+#include "SkTypeface.h"
+
+namespace {
+enum KeyType : uint32_t {
+    kImage_KeyType,
+    kFontProgram_KeyType,
+};
+}
+
+static std::vector<uint32_t> image_key(const SkPDFResourceCache::ImageKey& key) {
+    const SkIRect& subset = key.fBitmap.fSubset;
+    return {kImage_KeyType, key.fBitmap.fID,
+            (uint32_t)subset.fLeft, (uint32_t)subset.fTop,
+            (uint32_t)subset.fRight, (uint32_t)subset.fBottom,
+            (uint32_t)key.fEncodingQuality};
+}
+
+static std::vector<uint32_t> font_program_key(const SkTypeface& typeface,
+                                              const SkPDFGlyphUse& glyphUsage) {
+    std::vector<uint32_t> key = {kFontProgram_KeyType, typeface.uniqueID(),
+                                 (uint32_t)glyphUsage.firstNonZero() << 16 |
+                                         glyphUsage.lastGlyph()};
+    glyphUsage.getSetValues([&key](unsigned gid) { key.push_back(gid); });
+    return key;
+}
+
+uint32_t SkPDFResourceCache::Traits::Hash(const Key& key) {
+    return SkOpts::hash_fn(key.data(), key.size() * sizeof(uint32_t), 0);
+}
+
+SkPDFResourceCache::SkPDFResourceCache(size_t byteBudget) : fByteBudget(byteBudget) {}
+
+SkPDFResourceCache::~SkPDFResourceCache() { this->purgeAll(); }
+
+SkPDFResourceCache::Entry* SkPDFResourceCache::find(const Key& key) {
+    Entry** found = fMap.find(key);
+    if (!found) {
+        return nullptr;
+    }
+    Entry* entry = *found;
+    if (entry != fLRU.head()) {
+        fLRU.remove(entry);
+        fLRU.addToHead(entry);
+    }
+    return entry;
+}
+
+void SkPDFResourceCache::add(Entry* entry) {
+    entry->fBytes += entry->fKey.size() * sizeof(uint32_t) + sizeof(Entry);
+    SkAutoMutexAcquire lock(fMutex);
+    // Another document may have got here first.
+    if (entry->fBytes > fByteBudget || fMap.find(entry->fKey)) {
+        delete entry;
+        return;
+    }
+    fMap.set(entry);
+    fLRU.addToHead(entry);
+    fBytesUsed += entry->fBytes;
+    while (fBytesUsed > fByteBudget) {
+        this->remove(fLRU.tail());
+    }
+}
+
+void SkPDFResourceCache::remove(Entry* entry) {
+    fMap.remove(entry->fKey);
+    fLRU.remove(entry);
+    fBytesUsed -= entry->fBytes;
+    delete entry;
+}
+
+bool SkPDFResourceCache::findImage(const ImageKey& key, SkPDFEncodedImage* image) {
+    SkAutoMutexAcquire lock(fMutex);
+    if (Entry* entry = this->find(image_key(key))) {
+        *image = entry->fImage;
+        return true;
+    }
+    return false;
+}
+
+void SkPDFResourceCache::addImage(const ImageKey& key, const SkPDFEncodedImage& image) {
+    Entry* entry = new Entry;
+    entry->fKey = image_key(key);
+    entry->fImage = image;
+    entry->fBytes = image.fData->size() + (image.fAlpha ? image.fAlpha->size() : 0);
+    this->add(entry);
+}
+
+sk_sp<SkData> SkPDFResourceCache::findFontProgram(const SkTypeface& typeface,
+                                                  const SkPDFGlyphUse& glyphUsage) {
+    Key key = font_program_key(typeface, glyphUsage);
+    SkAutoMutexAcquire lock(fMutex);
+    Entry* entry = this->find(key);
+    return entry ? entry->fFontProgram : nullptr;
+}
+
+void SkPDFResourceCache::addFontProgram(const SkTypeface& typeface,
+                                        const SkPDFGlyphUse& glyphUsage,
+                                        sk_sp<SkData> program) {
+    SkASSERT(program);
+    Entry* entry = new Entry;
+    entry->fKey = font_program_key(typeface, glyphUsage);
+    entry->fBytes = program->size();
+    entry->fFontProgram = std::move(program);
+    this->add(entry);
+}
+
+size_t SkPDFResourceCache::bytesUsed() const {
+    SkAutoMutexAcquire lock(fMutex);
+    return fBytesUsed;
+}
+
+void SkPDFResourceCache::purgeAll() {
+    SkAutoMutexAcquire lock(fMutex);
+    while (Entry* entry = fLRU.tail()) {
+        this->remove(entry);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+SkPDF::ResourceCache::ResourceCache(size_t byteBudget)
+    : fCache(new SkPDFResourceCache(byteBudget)) {}
+
+SkPDF::ResourceCache::~ResourceCache() = default;
+
+size_t SkPDF::ResourceCache::bytesUsed() const { return fCache->bytesUsed(); }
+
+void SkPDF::ResourceCache::purgeAll() { fCache->purgeAll(); }
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#ifndef SkPDFResourceCache_DEFINED
+#define SkPDFResourceCache_DEFINED
+
+#include "SkBitmapKey.h"
+#include "SkData.h"
+#include "SkMutex.h"
+#include "SkSize.h"
+#include "SkTHash.h"
+#include "SkTInternalLList.h"
+
+#include <vector>
+
+class SkPDFGlyphUse;
+class SkTypeface;
+
+/** An image encoded for PDF, apart from the object numbers of any document it goes in. */
+struct SkPDFEncodedImage {
+    SkISize fSize = {0, 0};
+    const char* fColorSpace = nullptr;  // A string literal.
+    bool fIsJpeg = false;
+    sk_sp<SkData> fData;
+    sk_sp<SkData> fAlpha;  // The deflated soft mask, or null if the image is opaque.
+};
+
+/** The implementation of SkPDF::ResourceCache.  It is safe to use from any thread. */
+class SkPDFResourceCache {
+public:
+    struct ImageKey {
+        SkBitmapKey fBitmap;
+        int fEncodingQuality;
+    };
+
+    explicit SkPDFResourceCache(size_t byteBudget);
+    ~SkPDFResourceCache();
+
+    bool findImage(const ImageKey&, SkPDFEncodedImage*);
+    void addImage(const ImageKey&, const SkPDFEncodedImage&);
+
+    /** Subset font programs, keyed by their typeface and the glyphs kept from it. */
+    sk_sp<SkData> findFontProgram(const SkTypeface&, const SkPDFGlyphUse&);
+    void addFontProgram(const SkTypeface&, const SkPDFGlyphUse&, sk_sp<SkData>);
+
+    size_t bytesUsed() const;
+    void purgeAll();
+
+private:
+    using Key = std::vector<uint32_t>;
+
+    struct Entry {
+        Key fKey;
+        SkPDFEncodedImage fImage;
+        sk_sp<SkData> fFontProgram;
+        size_t fBytes;
+
+        SK_DECLARE_INTERNAL_LLIST_INTERFACE(Entry);
+    };
+
+    struct Traits {
+        static const Key& GetKey(const Entry* e) { return e->fKey; }
+        static uint32_t Hash(const Key&);
+    };
+
+    // Finds an entry and makes it the most recently used.  Call with fMutex held.
+    Entry* find(const Key&);
+    void add(Entry*);
+    void remove(Entry*);
+
+    const size_t fByteBudget;
+    mutable SkMutex fMutex;
+    SkTHashTable<Entry*, Key, Traits> fMap;
+    SkTInternalLList<Entry> fLRU;
+    size_t fBytesUsed = 0;
+};
+
+#endif  // SkPDFResourceCache_DEFINED
@@ -309,7 +309,7 @@ void SkPDFArray::appendScalar(SkScalar value) {
 }
 
 void SkPDFArray::appendName(const char name[]) {
-    this->append(SkPDFUnion::Name(SkString(name)));
+    this->append(SkPDFUnion::Name(name));
 }
 
 void SkPDFArray::appendName(SkString name) {
@@ -418,10 +418,11 @@ void SkPDFDict::insertString(const char key[], SkString value) {
 
 
 
+template <typename T>
 static void serialize_stream(SkPDFDict* origDict,
                              SkStreamAsset* stream,
                              bool deflate,
-                             SkPDFDocument* doc,
+                             T* out,
                              SkPDFIndirectReference ref) {
     // Code assumes that the stream starts at the beginning.
     SkASSERT(stream && stream->hasLength());
@@ -457,7 +458,7 @@ static void serialize_stream(SkPDFDict* origDict,
 
     }
     dict.insertInt("Length", stream->getLength());
-    doc->emitStream(dict,
+    out->emitStream(dict,
                     [stream](SkWStream* dst) { dst->writeStream(stream, stream->getLength()); },
                     ref);
 }
@@ -468,15 +469,17 @@ SkPDFIndirectReference SkPDFStreamOut(std::unique_ptr<SkPDFDict> dict,
                                       bool deflate) {
     SkPDFIndirectReference ref = doc->reserveRef();
     if (SkExecutor* executor = doc->executor()) {
+        SkPDFObjectBatch* batch = doc->beginBatch();
         SkPDFDict* dictPtr = dict.release();
         SkStreamAsset* contentPtr = content.release();
         // Pass ownership of both pointers into a std::function, which should
         // only be executed once.
         doc->incrementJobCount();
-        executor->add([dictPtr, contentPtr, deflate, doc, ref]() {
-            serialize_stream(dictPtr, contentPtr, deflate, doc, ref);
+        executor->add([dictPtr, contentPtr, deflate, doc, batch, ref]() {
+            serialize_stream(dictPtr, contentPtr, deflate, batch, ref);
             delete dictPtr;
             delete contentPtr;
+            doc->endBatch(batch);
             doc->signalJobComplete();
         });
         return ref;
@@ -98,7 +98,8 @@ public:
      */
     void reserve(int length);
 
-    /** Appends a value to the end of the array.
+    /** Appends a value to the end of the array.  Names and strings passed as
+     *  const char[] are not copied, and must outlive the array.
      *  @param value The value to add to the array.
      */
     void appendInt(int32_t);
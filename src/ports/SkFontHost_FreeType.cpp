@@ -124,6 +124,7 @@ public:
         , fLibrary(nullptr)
         , fIsLCDSupported(false)
         , fLCDExtra(0)
+        , fVersion(0)
     {
         if (FT_New_Library(&gFTMemory, &fLibrary)) {
             return;
@@ -138,6 +139,7 @@ public:
 
         FT_Int major, minor, patch;
         FT_Library_Version(fLibrary, &major, &minor, &patch);
+        fVersion = (major << 16) | (minor << 8) | patch;
 
 #if SK_FREETYPE_MINIMUM_RUNTIME_VERSION >= 0x02070100
         fGetVarDesignCoordinates = FT_Get_Var_Design_Coordinates;
@@ -199,6 +201,8 @@ public:
     FT_Library library() { return fLibrary; }
     bool isLCDSupported() { return fIsLCDSupported; }
     int lcdExtra() { return fLCDExtra; }
+    // The runtime FreeType version as 0x00MMmmpp.
+    uint32_t version() { return fVersion; }
 
     // FT_Get_{MM,Var}_{Blend,Design}_Coordinates were added in FreeType 2.7.1.
     // Prior to this there was no way to get the coordinates out of the FT_Face.
@@ -217,6 +221,7 @@ private:
     FT_Library fLibrary;
     bool fIsLCDSupported;
     int fLCDExtra;
+    uint32_t fVersion;
 
     // FT_Library_SetLcdFilterWeights was introduced in FreeType 2.4.0.
     // The following platforms provide FreeType of at least 2.4.0.
@@ -496,6 +501,8 @@ public:
         return fFTSize != nullptr && fFace != nullptr;
     }
 
+    uint64_t getEngineID() const override;
+
 protected:
     unsigned generateGlyphCount() override;
     uint16_t generateCharToGlyph(SkUnichar uni) override;
@@ -1012,6 +1019,12 @@ SkScalerContext_FreeType::~SkScalerContext_FreeType() {
     unref_ft_library();
 }
 
+uint64_t SkScalerContext_FreeType::getEngineID() const {
+    // Our constructor took a ref on the library, so it's alive until our destructor.
+    SkAutoMutexAcquire  ac(gFTMutex);
+    return (uint64_t)SkSetFourByteTag('F', 'T', 'y', 'p') << 32 | gFTLibrary->version();
+}
+
 /*  We call this before each use of the fFace, since we may be sharing
     this face with other context (at different sizes).
 */
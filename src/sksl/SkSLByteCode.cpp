@@ -0,0 +1,193 @@
+/*
+ * Copyright 2019 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SKSL_STANDALONE
+
+#include "SkSLByteCode.h"
+
+#include "SkNx.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace SkSL {
+
+static constexpr int N = ByteCode::kVecWidth;
+
+using F = SkNx<N, float>;
+using I = SkNx<N, int32_t>;
+
+template <typename Fn>
+static F map(const F& x, Fn&& fn) {
+    float lanes[N];
+    x.store(lanes);
+    for (float& lane : lanes) {
+        lane = fn(lane);
+    }
+    return F::Load(lanes);
+}
+
+static F pow(const F& x, const F& y) {
+    float xs[N], ys[N];
+    x.store(xs);
+    y.store(ys);
+    for (int i = 0; i < N; ++i) {
+        xs[i] = std::pow(xs[i], ys[i]);
+    }
+    return F::Load(xs);
+}
+
+static I divide(const I& x, const I& y) {
+    int32_t xs[N], ys[N];
+    x.store(xs);
+    y.store(ys);
+    for (int i = 0; i < N; ++i) {
+        // Lanes that are masked off may hold anything, so this must not trap.
+        if (0 == ys[i]) {
+            xs[i] = 0;
+        } else if (-1 == ys[i]) {
+            xs[i] = (int32_t) (0u - (uint32_t) xs[i]);
+        } else {
+            xs[i] /= ys[i];
+        }
+    }
+    return I::Load(xs);
+}
+
+static void execute(const ByteCode::Function& f, int32_t* regs) {
+    using Op = ByteCode::Op;
+    const ByteCode::Instruction* code = f.fCode.data();
+    const ByteCode::Instruction* end = code + f.fCode.size();
+    const ByteCode::Instruction* ip = code;
+
+    #define REG(r) (regs + (r) * N)
+    #define FA F::Load(REG(inst.fA))
+    #define FB F::Load(REG(inst.fB))
+    #define FC F::Load(REG(inst.fC))
+    #define IA I::Load(REG(inst.fA))
+    #define IB I::Load(REG(inst.fB))
+    #define IC I::Load(REG(inst.fC))
+    #define DST REG(inst.fDst)
+    #define TARGET (code + (inst.fA | (inst.fB << 16)))
+    while (ip < end) {
+        const ByteCode::Instruction& inst = *ip++;
+        switch (inst.fOp) {
+            case Op::kAddF:  (FA + FB).store(DST);                                     break;
+            case Op::kSubF:  (FA - FB).store(DST);                                     break;
+            case Op::kMulF:  (FA * FB).store(DST);                                     break;
+            case Op::kDivF:  (FA / FB).store(DST);                                     break;
+            case Op::kNegF:  (-FA).store(DST);                                         break;
+            case Op::kAbsF:  FA.abs().store(DST);                                      break;
+            case Op::kMinF:  F::Min(FA, FB).store(DST);                                break;
+            case Op::kMaxF:  F::Max(FA, FB).store(DST);                                break;
+            case Op::kFloor: FA.floor().store(DST);                                    break;
+            case Op::kCeil:  (-(-FA).floor()).store(DST);                              break;
+            case Op::kSqrt:  FA.sqrt().store(DST);                                     break;
+            case Op::kSin:   map(FA, [](float x) { return std::sin(x); }).store(DST);  break;
+            case Op::kCos:   map(FA, [](float x) { return std::cos(x); }).store(DST);  break;
+            case Op::kTan:   map(FA, [](float x) { return std::tan(x); }).store(DST);  break;
+            case Op::kPow:   pow(FA, FB).store(DST);                                   break;
+            case Op::kExp:   map(FA, [](float x) { return std::exp(x); }).store(DST);  break;
+            case Op::kLog:   map(FA, [](float x) { return std::log(x); }).store(DST);  break;
+            case Op::kMix: {
+                F a = FA;
+                (a + (FB - a) * FC).store(DST);
+                break;
+            }
+
+            case Op::kAddI: (IA + IB).store(DST);          break;
+            case Op::kSubI: (IA - IB).store(DST);          break;
+            case Op::kMulI: (IA * IB).store(DST);          break;
+            case Op::kDivI: divide(IA, IB).store(DST);     break;
+            case Op::kNegI: (I(0) - IA).store(DST);        break;
+            case Op::kAbsI: IA.abs().store(DST);           break;
+            case Op::kMinI: I::Min(IA, IB).store(DST);     break;
+            case Op::kMaxI: I::Max(IA, IB).store(DST);     break;
+
+            case Op::kAnd:    (IA & IB).store(DST);              break;
+            case Op::kOr:     (IA | IB).store(DST);              break;
+            case Op::kXor:    (IA ^ IB).store(DST);              break;
+            case Op::kNot:    (IA ^ I(~0)).store(DST);           break;
+            case Op::kAndNot: (IA & (IB ^ I(~0))).store(DST);    break;
+
+            case Op::kEqF: (FA == FB).store(DST);            break;
+            case Op::kNeF: (FA != FB).store(DST);            break;
+            case Op::kLtF: (FA <  FB).store(DST);            break;
+            case Op::kLeF: (FA <= FB).store(DST);            break;
+            case Op::kEqI: (IA == IB).store(DST);            break;
+            case Op::kNeI: ((IA == IB) ^ I(~0)).store(DST);  break;
+            case Op::kLtI: (IA < IB).store(DST);             break;
+            case Op::kLeI: ((IA > IB) ^ I(~0)).store(DST);   break;
+
+            case Op::kFloatToInt: SkNx_cast<int32_t>(FA).store(DST); break;
+            case Op::kIntToFloat: SkNx_cast<float>(IA).store(DST);   break;
+
+            case Op::kCopy:   memcpy(DST, REG(inst.fA), N * sizeof(int32_t)); break;
+            case Op::kSelect: IA.thenElse(IB, IC).store(DST);                 break;
+
+            case Op::kJump:
+                ip = TARGET;
+                break;
+            case Op::kJumpIfAny:
+                // Set lanes are ~0, so any of them make the mask register's floats true.
+                if (F::Load(DST).anyTrue()) {
+                    ip = TARGET;
+                }
+                break;
+            case Op::kJumpIfNone:
+                if (!F::Load(DST).anyTrue()) {
+                    ip = TARGET;
+                }
+                break;
+        }
+    }
+    #undef REG
+    #undef FA
+    #undef FB
+    #undef FC
+    #undef IA
+    #undef IB
+    #undef IC
+    #undef DST
+    #undef TARGET
+}
+
+void ByteCode::run(const Function& f, float* args, float* outReturn, int count) const {
+    std::unique_ptr<int32_t[]> regs(new int32_t[f.fRegisterCount * N]());
+    int constantBase = f.fRegisterCount - (int) f.fConstants.size();
+    for (size_t i = 0; i < f.fConstants.size(); ++i) {
+        I(f.fConstants[i]).store(regs.get() + (constantBase + i) * N);
+    }
+    int32_t* mask = regs.get() + kMaskRegister * N;
+    int32_t* params = regs.get() + (kMaskRegister + 1) * N;
+    int32_t* returns = params + f.fParameterCount * N;
+    for (int base = 0; base < count; base += N) {
+        int n = std::min(N, count - base);
+        for (int i = 0; i < N; ++i) {
+            mask[i] = i < n ? ~0 : 0;
+        }
+        for (int p = 0; p < f.fParameterCount; ++p) {
+            memcpy(params + p * N, args + p * count + base, n * sizeof(float));
+        }
+        execute(f, regs.get());
+        for (int p = 0; p < f.fParameterCount; ++p) {
+            if (f.fParameterIsOut[p]) {
+                memcpy(args + p * count + base, params + p * N, n * sizeof(float));
+            }
+        }
+        if (outReturn) {
+            for (int r = 0; r < f.fReturnCount; ++r) {
+                memcpy(outReturn + r * count + base, returns + r * N, n * sizeof(float));
+            }
+        }
+    }
+}
+
+} // namespace
+
+#endif
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2019 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SKSL_BYTECODE
+#define SKSL_BYTECODE
+
+#include "SkSLString.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace SkSL {
+
+/**
+ * A register-based bytecode for SkSL functions, run by a vectorized interpreter.
+ *
+ * Every register holds one 32-bit value (a float, an int, or a bool) for each of kVecWidth
+ * invocations, and every instruction applies to all of them at once, the same way
+ * SkRasterPipeline stages work on a batch of pixels. Bools are stored as masks: 0 for false and
+ * ~0 for true. Divergent control flow is handled with an execution mask in register 0 (see
+ * kMaskRegister): the generated code only writes to variables in lanes whose mask is set, and
+ * only skips code when the mask is empty in every lane.
+ */
+class ByteCode {
+public:
+    static constexpr int kVecWidth = 8;
+
+    enum class Op : uint16_t {
+        // Float arithmetic and intrinsics: dst = op(a, b).
+        kAddF,
+        kSubF,
+        kMulF,
+        kDivF,
+        kNegF,
+        kAbsF,
+        kMinF,
+        kMaxF,
+        kFloor,
+        kCeil,
+        kSqrt,
+        kSin,
+        kCos,
+        kTan,
+        kPow,
+        kExp,
+        kLog,
+        // dst = a + (b - a) * c
+        kMix,
+        // Int arithmetic. Division by zero produces zero.
+        kAddI,
+        kSubI,
+        kMulI,
+        kDivI,
+        kNegI,
+        kAbsI,
+        kMinI,
+        kMaxI,
+        // Bitwise operations, also used for bools.
+        kAnd,
+        kOr,
+        kXor,
+        kNot,
+        // dst = a & ~b
+        kAndNot,
+        // Comparisons, producing masks.
+        kEqF,
+        kNeF,
+        kLtF,
+        kLeF,
+        kEqI,
+        kNeI,
+        kLtI,
+        kLeI,
+        // Conversions.
+        kFloatToInt,
+        kIntToFloat,
+        // dst = a
+        kCopy,
+        // dst = a ? b : c, bitwise
+        kSelect,
+        // Jumps to the instruction at index a | (b << 16), unconditionally or depending on whether
+        // any lane of register dst is set.
+        kJump,
+        kJumpIfAny,
+        kJumpIfNone,
+    };
+
+    struct Instruction {
+        Op       fOp;
+        uint16_t fDst;
+        uint16_t fA;
+        uint16_t fB;
+        uint16_t fC;
+    };
+
+    static constexpr int kMaskRegister = 0;
+
+    /**
+     * A function compiled to bytecode. Calls to other functions are inlined, so a Function is
+     * entirely self-contained.
+     *
+     * The function's parameters occupy one register per component, starting at register 1,
+     * followed by the return value's registers. The last fConstants.size() registers hold
+     * constants; they are filled in once per run() and never written by the code.
+     */
+    struct Function {
+        String fName;
+        int fParameterCount = 0;
+        // For each parameter register, whether the parameter is out or inout.
+        std::vector<bool> fParameterIsOut;
+        int fReturnCount = 0;
+        int fRegisterCount = 0;
+        std::vector<int32_t> fConstants;
+        std::vector<Instruction> fCode;
+    };
+
+    const Function* getFunction(const char* name) const {
+        for (const auto& f : fFunctions) {
+            if (f->fName == name) {
+                return f.get();
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * Runs the function for count invocations. The arguments are laid out one parameter component
+     * at a time: args[i * count + j] is component i of invocation j's arguments. Ints are passed
+     * as their bits, so parameters must be float or int scalars or vectors. Out and inout
+     * parameters are written back to args. If the function returns a value, outReturn receives
+     * its components in the same layout.
+     */
+    void run(const Function& f, float* args, float* outReturn, int count) const;
+
+    std::vector<std::unique_ptr<Function>> fFunctions;
+};
+
+} // namespace
+
+#endif
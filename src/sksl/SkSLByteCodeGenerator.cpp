@@ -0,0 +1,1158 @@
+/*
+ * Copyright 2019 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkSLByteCodeGenerator.h"
+
+#include "SkSLCompiler.h"
+#include "ir/SkSLBoolLiteral.h"
+#include "ir/SkSLFloatLiteral.h"
+#include "ir/SkSLIntLiteral.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace SkSL {
+
+using Op = ByteCode::Op;
+
+static constexpr uint16_t kMask = ByteCode::kMaskRegister;
+
+// Every call inlines the whole callee, so a chain of functions that each call the next twice
+// grows the code exponentially.  These bound the work done for any one function.
+static constexpr size_t kMaxInstructions = 1 << 16;
+static constexpr size_t kMaxInlineDepth = 32;
+
+static bool contains_return(const Statement& s) {
+    switch (s.fKind) {
+        case Statement::kReturn_Kind:
+            return true;
+        case Statement::kBlock_Kind:
+            for (const auto& child : ((const Block&) s).fStatements) {
+                if (contains_return(*child)) {
+                    return true;
+                }
+            }
+            return false;
+        case Statement::kDo_Kind:
+            return contains_return(*((const DoStatement&) s).fStatement);
+        case Statement::kFor_Kind:
+            return contains_return(*((const ForStatement&) s).fStatement);
+        case Statement::kIf_Kind: {
+            const IfStatement& i = (const IfStatement&) s;
+            return contains_return(*i.fIfTrue) || (i.fIfFalse && contains_return(*i.fIfFalse));
+        }
+        case Statement::kWhile_Kind:
+            return contains_return(*((const WhileStatement&) s).fStatement);
+        default:
+            return false;
+    }
+}
+
+// Returns true if the function may return anywhere other than its last statement, in which case
+// lanes that have returned must be masked off for the rest of the function.
+static bool has_early_return(const FunctionDefinition& f) {
+    const Block& body = (const Block&) *f.fBody;
+    for (size_t i = 0; i < body.fStatements.size(); ++i) {
+        const Statement& s = *body.fStatements[i];
+        if (i == body.fStatements.size() - 1 && Statement::kReturn_Kind == s.fKind) {
+            return false;
+        }
+        if (contains_return(s)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool is_out(const Variable& param) {
+    return param.fModifiers.fFlags & Modifiers::kOut_Flag;
+}
+
+bool ByteCodeGenerator::generateCode() {
+    for (const auto& e : fProgram) {
+        if (ProgramElement::kFunction_Kind == e.fKind) {
+            const FunctionDefinition& f = (const FunctionDefinition&) e;
+            fDefinitions[&f.fDeclaration] = &f;
+        }
+    }
+    fFailed = false;
+    for (const auto& e : fProgram) {
+        if (ProgramElement::kFunction_Kind == e.fKind &&
+            !((const FunctionDefinition&) e).fDeclaration.fBuiltin) {
+            this->writeFunction((const FunctionDefinition&) e);
+        }
+    }
+    return !fFailed;
+}
+
+// Returns true if values of the type can be passed to or from ByteCode::run.
+static bool is_runnable_type(const Type& type) {
+    switch (type.kind()) {
+        case Type::kScalar_Kind:
+            return type.isNumber();
+        case Type::kVector_Kind:
+            return type.componentType().isNumber();
+        default:
+            return false;
+    }
+}
+
+void ByteCodeGenerator::writeFunction(const FunctionDefinition& f) {
+    const FunctionDeclaration& decl = f.fDeclaration;
+    for (const Variable* param : decl.fParameters) {
+        if (!is_runnable_type(param->fType)) {
+            return;
+        }
+    }
+    if (decl.fReturnType != *fContext.fVoid_Type && !is_runnable_type(decl.fReturnType)) {
+        return;
+    }
+
+    std::unique_ptr<ByteCode::Function> result(new ByteCode::Function());
+    result->fName = decl.fName;
+    fCode.clear();
+    fConstants.clear();
+    fConstantRegisters.clear();
+    fVariables.clear();
+    fKillRegisters.clear();
+    fLoops.clear();
+    fCalls.clear();
+    fTooLarge = false;
+    fNextRegister = kMask + 1;
+    fRegisterCount = fNextRegister;
+    for (const Variable* param : decl.fParameters) {
+        Value value = this->allocValue(this->slotCount(param->fOffset, param->fType));
+        fVariables[param] = value;
+        for (int i = 0; i < value.fCount; ++i) {
+            result->fParameterIsOut.push_back(is_out(*param));
+        }
+    }
+    result->fParameterCount = fNextRegister - (kMask + 1);
+    Call call;
+    call.fFunction = &f;
+    call.fResult = this->allocValue(this->slotCount(f.fOffset, decl.fReturnType));
+    call.fReturned = -1;
+    result->fReturnCount = call.fResult.fCount;
+
+    fMasked = false;
+    if (has_early_return(f)) {
+        call.fReturned = this->allocRegister();
+        this->emit(Op::kCopy, call.fReturned, this->constant(0));
+        fKillRegisters.push_back(call.fReturned);
+        fMasked = true;
+    }
+    fCalls.push_back(call);
+    this->writeStatement(*f.fBody);
+    fCalls.pop_back();
+
+    int constantBase = fRegisterCount;
+    if (constantBase + (int) fConstants.size() > 0xFFFF) {
+        fErrors.error(f.fOffset, "function '" + String(decl.fName) + "' is too large");
+        fFailed = true;
+    }
+    if (fFailed) {
+        return;
+    }
+    auto remap = [constantBase](uint16_t* reg) {
+        if (*reg & kConstantBit) {
+            *reg = constantBase + (*reg & ~kConstantBit);
+        }
+    };
+    for (ByteCode::Instruction& inst : fCode) {
+        remap(&inst.fDst);
+        switch (inst.fOp) {
+            case Op::kJump:
+            case Op::kJumpIfAny:
+            case Op::kJumpIfNone:
+                break;
+            default:
+                remap(&inst.fA);
+                remap(&inst.fB);
+                remap(&inst.fC);
+        }
+    }
+    result->fRegisterCount = constantBase + fConstants.size();
+    result->fConstants = std::move(fConstants);
+    result->fCode = std::move(fCode);
+    fOutput.fFunctions.push_back(std::move(result));
+}
+
+void ByteCodeGenerator::emit(Op op, int dst, int a, int b, int c) {
+    fCode.push_back({ op, (uint16_t) dst, (uint16_t) a, (uint16_t) b, (uint16_t) c });
+}
+
+int ByteCodeGenerator::emitJump(Op op, int reg) {
+    this->emit(op, reg);
+    return fCode.size() - 1;
+}
+
+void ByteCodeGenerator::setJumpTarget(int jump) {
+    uint32_t target = fCode.size();
+    fCode[jump].fA = target & 0xFFFF;
+    fCode[jump].fB = target >> 16;
+}
+
+uint16_t ByteCodeGenerator::constant(int32_t value) {
+    auto found = fConstantRegisters.find(value);
+    if (found != fConstantRegisters.end()) {
+        return found->second;
+    }
+    if (fConstants.size() >= kConstantBit) {
+        fErrors.error(-1, "too many constants");
+        fFailed = true;
+        return kConstantBit;
+    }
+    uint16_t result = kConstantBit | fConstants.size();
+    fConstants.push_back(value);
+    fConstantRegisters[value] = result;
+    return result;
+}
+
+uint16_t ByteCodeGenerator::constant(float value) {
+    int32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return this->constant(bits);
+}
+
+uint16_t ByteCodeGenerator::allocRegister() {
+    if (fNextRegister >= kConstantBit) {
+        if (!fFailed) {
+            fErrors.error(-1, "too many registers");
+            fFailed = true;
+        }
+        return kConstantBit - 1;
+    }
+    int result = fNextRegister++;
+    fRegisterCount = std::max(fRegisterCount, fNextRegister);
+    return result;
+}
+
+ByteCodeGenerator::Value ByteCodeGenerator::allocValue(int count) {
+    Value result;
+    result.fCount = count;
+    for (int i = 0; i < count; ++i) {
+        result.fRegs[i] = this->allocRegister();
+    }
+    return result;
+}
+
+ByteCodeGenerator::Value ByteCodeGenerator::copy(const Value& value) {
+    Value result = this->allocValue(value.fCount);
+    for (int i = 0; i < value.fCount; ++i) {
+        this->emit(Op::kCopy, result.fRegs[i], value.fRegs[i]);
+    }
+    return result;
+}
+
+int ByteCodeGenerator::slotCount(int offset, const Type& type) {
+    switch (type.kind()) {
+        case Type::kScalar_Kind:
+            return 1;
+        case Type::kVector_Kind:
+            return type.columns();
+        default:
+            if (type == *fContext.fVoid_Type) {
+                return 0;
+            }
+            fErrors.error(offset, "unsupported type '" + type.description() + "'");
+            fFailed = true;
+            return 0;
+    }
+}
+
+ByteCodeGenerator::Kind ByteCodeGenerator::kind(const Type& type) {
+    const Type& component = Type::kVector_Kind == type.kind() ? type.componentType() : type;
+    if (component.isFloat()) {
+        return Kind::kFloat;
+    }
+    return component.isNumber() ? Kind::kInt : Kind::kBool;
+}
+
+uint16_t ByteCodeGenerator::convert(uint16_t reg, Kind from, Kind to) {
+    if (from == to) {
+        return reg;
+    }
+    uint16_t result = this->allocRegister();
+    switch (to) {
+        case Kind::kFloat:
+            if (Kind::kInt == from) {
+                this->emit(Op::kIntToFloat, result, reg);
+            } else {
+                this->emit(Op::kSelect, result, reg, this->constant(1.0f), this->constant(0.0f));
+            }
+            break;
+        case Kind::kInt:
+            if (Kind::kFloat == from) {
+                this->emit(Op::kFloatToInt, result, reg);
+            } else {
+                this->emit(Op::kSelect, result, reg, this->constant(1), this->constant(0));
+            }
+            break;
+        case Kind::kBool:
+            this->emit(Kind::kFloat == from ? Op::kNeF : Op::kNeI, result, reg, this->constant(0));
+            break;
+    }
+    return result;
+}
+
+void ByteCodeGenerator::saveMask(uint16_t saved) {
+    this->emit(Op::kCopy, saved, kMask);
+}
+
+void ByteCodeGenerator::restoreMask(uint16_t saved) {
+    if (fKillRegisters.empty()) {
+        this->emit(Op::kCopy, kMask, saved);
+        return;
+    }
+    this->emit(Op::kAndNot, kMask, saved, fKillRegisters[0]);
+    for (size_t i = 1; i < fKillRegisters.size(); ++i) {
+        this->emit(Op::kAndNot, kMask, kMask, fKillRegisters[i]);
+    }
+}
+
+void ByteCodeGenerator::store(const Value& lvalue, const Value& value) {
+    Value src = value;
+    // Assigning a swizzle of a variable to the variable itself (v = v.yx) must not overwrite
+    // components that are still to be read.
+    for (int i = 0; i < lvalue.fCount; ++i) {
+        for (int j = i + 1; j < src.fCount; ++j) {
+            if (lvalue.fRegs[i] == src.fRegs[j]) {
+                src = this->copy(src);
+                break;
+            }
+        }
+    }
+    for (int i = 0; i < lvalue.fCount; ++i) {
+        uint16_t reg = src.fRegs[1 == src.fCount ? 0 : i];
+        if (fMasked) {
+            this->emit(Op::kSelect, lvalue.fRegs[i], kMask, reg, lvalue.fRegs[i]);
+        } else if (reg != lvalue.fRegs[i]) {
+            this->emit(Op::kCopy, lvalue.fRegs[i], reg);
+        }
+    }
+}
+
+ByteCodeGenerator::Value ByteCodeGenerator::error(int offset, const String& msg, int count) {
+    fErrors.error(offset, msg);
+    fFailed = true;
+    Value result;
+    result.fCount = std::min(std::max(count, 0), 4);
+    for (int i = 0; i < result.fCount; ++i) {
+        result.fRegs[i] = this->constant(0);
+    }
+    return result;
+}
+
+ByteCodeGenerator::Value ByteCodeGenerator::getLValue(const Expression& expr) {
+    switch (expr.fKind) {
+        case Expression::kVariableReference_Kind:
+            return this->writeVariableReference((const VariableReference&) expr);
+        case Expression::kSwizzle_Kind: {
+            const Swizzle& s = (const Swizzle&) expr;
+            Value base = this->getLValue(*s.fBase);
+            Value result;
+            result.fCount = s.fComponents.size();
+            for (int i = 0; i < result.fCount; ++i) {
+                if (s.fComponents[i] < 0) {
+                    return this->error(expr.fOffset,
+                                       "cannot assign to a constant swizzle component",
+                                       result.fCount);
+                }
+                result.fRegs[i] = base.fRegs[s.fComponents[i]];
+            }
+            return result;
+        }
+        case Expression::kIndex_Kind: {
+            const IndexExpression& i = (const IndexExpression&) expr;
+            return this->writeIndexExpression(i, this->getLValue(*i.fBase));
+        }
+        default:
+            return this->error(expr.fOffset, "unsupported lvalue: " + expr.description(), 1);
+    }
+}
+
+ByteCodeGenerator::Value ByteCodeGenerator::writeExpression(const Expression& expr) {
+    switch (expr.fKind) {
+        case Expression::kBinary_Kind:
+            return this->writeBinaryExpression((const BinaryExpression&) expr);
+        case Expression::kBoolLiteral_Kind: {
+            Value result;
+            result.fCount = 1;
+            result.fRegs[0] = this->constant(((const BoolLiteral&) expr).fValue ? ~0 : 0);
+            return result;
+        }
+        case Expression::kConstructor_Kind:
+            return this->writeConstructor((const Constructor&) expr);
+        case Expression::kFloatLiteral_Kind: {
+            Value result;
+            result.fCount = 1;
+            result.fRegs[0] = this->constant((float) ((const FloatLiteral&) expr).fValue);
+            return result;
+        }
+        case Expression::kFunctionCall_Kind:
+            return this->writeFunctionCall((const FunctionCall&) expr);
+        case Expression::kIndex_Kind: {
+            const IndexExpression& i = (const IndexExpression&) expr;
+            return this->writeIndexExpression(i, this->writeExpression(*i.fBase));
+        }
+        case Expression::kIntLiteral_Kind: {
+            Value result;
+            result.fCount = 1;
+            result.fRegs[0] = this->constant((int32_t) ((const IntLiteral&) expr).fValue);
+            return result;
+        }
+        case Expression::kPrefix_Kind:
+            return this->writePrefixExpression((const PrefixExpression&) expr);
+        case Expression::kPostfix_Kind:
+            return this->writePostfixExpression((const PostfixExpression&) expr);
+        case Expression::kSwizzle_Kind:
+            return this->writeSwizzle((const Swizzle&) expr);
+        case Expression::kTernary_Kind:
+            return this->writeTernaryExpression((const TernaryExpression&) expr);
+        case Expression::kVariableReference_Kind:
+            return this->writeVariableReference((const VariableReference&) expr);
+        default:
+            return this->error(expr.fOffset, "unsupported expression: " + expr.description(), 1);
+    }
+}
+
+ByteCodeGenerator::Value ByteCodeGenerator::writeBinaryExpression(const BinaryExpression& b) {
+    Token::Kind op = b.fOperator;
+    switch (op) {
+        case Token::LOGICALAND:
+        case Token::LOGICALOR:
+            return this->writeLogicalExpression(b);
+        case Token::COMMA:
+            this->writeExpression(*b.fLeft);
+            return this->writeExpression(*b.fRight);
+        case Token::EQ: {
+            Value lvalue = this->getLValue(*b.fLeft);
+            this->store(lvalue, this->writeExpression(*b.fRight));
+            return lvalue;
+        }
+        default:
+            break;
+    }
+    bool assignment = true;
+    switch (op) {
+        case Token::PLUSEQ:       op = Token::PLUS;       break;
+        case Token::MINUSEQ:      op = Token::MINUS;      break;
+        case Token::STAREQ:       op = Token::STAR;       break;
+        case Token::SLASHEQ:      op = Token::SLASH;      break;
+        case Token::PERCENTEQ:    op = Token::PERCENT;    break;
+        case Token::BITWISEANDEQ: op = Token::BITWISEAND; break;
+        case Token::BITWISEOREQ:  op = Token::BITWISEOR;  break;
+        case Token::BITWISEXOREQ: op = Token::BITWISEXOR; break;
+        default:                  assignment = false;     break;
+    }
+    Value lvalue = assignment ? this->getLValue(*b.fLeft) : this->writeExpression(*b.fLeft);
+    Value left = lvalue;
+    if (b.fRight->hasSideEffects()) {
+        // The right side might change the variables the left side refers to.
+        left = this->copy(left);
+    }
+    Value right = this->writeExpression(*b.fRight);
+    Value result = this->writeArithmetic(op, this->kind(b.fLeft->fType),
+                                         std::max(left.fCount, right.fCount), left, right,
+                                         b.fOffset);
+    if (assignment) {
+        this->store(lvalue, result);
+        return lvalue;
+    }
+    return result;
+}
+
+ByteCodeGenerator::Value ByteCodeGenerator::writeArithmetic(Token::Kind op, Kind kind, int count,
+                                                            const Value& left, const Value& right,
+                                                            int offset) {
+    auto component = [](const Value& v, int i) { return v.fRegs[1 == v.fCount ? 0 : i]; };
+    bool isFloat = Kind::kFloat == kind;
+    bool swap = false;
+    Op vecOp;
+    switch (op) {
+        case Token::PLUS:  vecOp = isFloat ? Op::kAddF : Op::kAddI; break;
+        case Token::MINUS: vecOp = isFloat ? Op::kSubF : Op::kSubI; break;
+        case Token::STAR:  vecOp = isFloat ? Op::kMulF : Op::kMulI; break;
+        case Token::SLASH: vecOp = isFloat ? Op::kDivF : Op::kDivI; break;
+        case Token::PERCENT: {
+            if (isFloat) {
+                return this->error(offset, "'%' is not supported on floats", count);
+            }
+            Value result = this->allocValue(count);
+            for (int i = 0; i < count; ++i) {
+                uint16_t a = component(left, i);
+                uint16_t b = component(right, i);
+                this->emit(Op::kDivI, result.fRegs[i], a, b);
+                this->emit(Op::kMulI, result.fRegs[i], result.fRegs[i], b);
+                this->emit(Op::kSubI, result.fRegs[i], a, result.fRegs[i]);
+            }
+            return result;
+        }
+        case Token::BITWISEAND: vecOp = Op::kAnd; break;
+        case Token::BITWISEOR:  vecOp = Op::kOr;  break;
+        case Token::BITWISEXOR:
+        case Token::LOGICALXOR: vecOp = Op::kXor; break;
+        case Token::LT:   vecOp = isFloat ? Op::kLtF : Op::kLtI;               break;
+        case Token::GT:   vecOp = isFloat ? Op::kLtF : Op::kLtI; swap = true;  break;
+        case Token::LTEQ: vecOp = isFloat ? Op::kLeF : Op::kLeI;               break;
+        case Token::GTEQ: vecOp = isFloat ? Op::kLeF : Op::kLeI; swap = true;  break;
+        case Token::EQEQ:
+        case Token::NEQ: {
+            // Vectors are equal if all of their components are.
+            bool eq = Token::EQEQ == op;
+            Op cmp = isFloat ? (eq ? Op::kEqF : Op::kNeF)
+                             : Kind::kInt == kind ? (eq ? Op::kEqI : Op::kNeI)
+                                                  : Op::kXor;
+            Value result = this->allocValue(1);
+            for (int i = 0; i < count; ++i) {
+                uint16_t dst = i ? this->allocRegister() : result.fRegs[0];
+                this->emit(cmp, dst, component(left, i), component(right, i));
+                if (Op::kXor == cmp && eq) {
+                    this->emit(Op::kNot, dst, dst);
+                }
+                if (i) {
+                    this->emit(eq ? Op::kAnd : Op::kOr, result.fRegs[0], result.fRegs[0], dst);
+                }
+            }
+            return result;
+        }
+        default:
+            return this->error(offset,
+                               String("unsupported operator: ") + Compiler::OperatorName(op),
+                               count);
+    }
+    Value result = this->allocValue(count);
+    for (int i = 0; i < count; ++i) {
+        uint16_t a = component(left, i);
+        uint16_t b = component(right, i);
+        this->emit(vecOp, result.fRegs[i], swap ? b : a, swap ? a : b);
+    }
+    return result;
+}
+
+ByteCodeGenerator::Value ByteCodeGenerator::writeLogicalExpression(const BinaryExpression& b) {
+    bool isAnd = Token::LOGICALAND == b.fOperator;
+    Value left = this->writeExpression(*b.fLeft);
+    Value result = this->allocValue(1);
+    if (!b.fRight->hasSideEffects()) {
+        Value right = this->writeExpression(*b.fRight);
+        this->emit(isAnd ? Op::kAnd : Op::kOr, result.fRegs[0], left.fRegs[0], right.fRegs[0]);
+        return result;
+    }
+    // Only evaluate the right side in the lanes the left side doesn't decide.
+    left = this->copy(left);
+    uint16_t saved = this->allocRegister();
+    this->saveMask(saved);
+    this->emit(isAnd ? Op::kAnd : Op::kAndNot, kMask, saved, left.fRegs[0]);
+    bool wasMasked = fMasked;
+    fMasked = true;
+    this->emit(Op::kCopy, result.fRegs[0], left.fRegs[0]);
+    int skip = this->emitJump(Op::kJumpIfNone, kMask);
+    Value right = this->writeExpression(*b.fRight);
+    this->emit(isAnd ? Op::kAnd : Op::kOr, result.fRegs[0], left.fRegs[0], right.fRegs[0]);
+    this->setJumpTarget(skip);
+    fMasked = wasMasked;
+    this->emit(Op::kCopy, kMask, saved);
+    return result;
+}
+
+ByteCodeGenerator::Value ByteCodeGenerator::writeConstructor(const Constructor& c) {
+    int count = this->slotCount(c.fOffset, c.fType);
+    Kind to = this->kind(c.fType);
+    Value result;
+    result.fCount = count;
+    if (1 == c.fArguments.size() && Type::kScalar_Kind == c.fArguments[0]->fType.kind()) {
+        // A conversion, or a vector with every component set to the same value.
+        Value arg = this->writeExpression(*c.fArguments[0]);
+        uint16_t reg = this->convert(arg.fRegs[0], this->kind(c.fArguments[0]->fType), to);
+        for (int i = 0; i < count; ++i) {
+            result.fRegs[i] = reg;
+        }
+        return result;
+    }
+    int n = 0;
+    for (const auto& arg : c.fArguments) {
+        Value value = this->writeExpression(*arg);
+        Kind from = this->kind(arg->fType);
+        for (int i = 0; i < value.fCount && n < count; ++i) {
+            result.fRegs[n++] = this->convert(value.fRegs[i], from, to);
+        }
+    }
+    if (n < count) {
+        return this->error(c.fOffset, "unsupported constructor: " + c.description(), count);
+    }
+    return result;
+}
+
+ByteCodeGenerator::Value ByteCodeGenerator::writeFunctionCall(const FunctionCall& c) {
+    auto found = fDefinitions.find(&c.fFunction);
+    if (c.fFunction.fBuiltin && found == fDefinitions.end()) {
+        return this->writeIntrinsicCall(c);
+    }
+    int returnCount = this->slotCount(c.fOffset, c.fType);
+    if (found == fDefinitions.end()) {
+        return this->error(c.fOffset, "function '" + c.fFunction.description() +
+                                      "' is not defined", returnCount);
+    }
+    const FunctionDefinition& f = *found->second;
+    for (const Call& call : fCalls) {
+        if (call.fFunction == &f) {
+            return this->error(c.fOffset, "recursive calls are not supported", returnCount);
+        }
+    }
+    if (fCode.size() > kMaxInstructions || fCalls.size() > kMaxInlineDepth) {
+        // Report this once, rather than for every call left to inline.
+        if (fTooLarge) {
+            return this->allocValue(returnCount);
+        }
+        fTooLarge = true;
+        String name(fCalls.front().fFunction->fDeclaration.fName);
+        return this->error(c.fOffset, fCode.size() > kMaxInstructions
+                                          ? "function '" + name + "' is too large"
+                                          : "calls in function '" + name + "' are nested too "
+                                            "deeply",
+                           returnCount);
+    }
+
+    // Parameters that the function doesn't write to share their arguments' registers. Everything
+    // else is copied in, and out parameters are copied back once the function is done.
+    const std::vector<const Variable*>& params = c.fFunction.fParameters;
+    std::vector<Value> outArgs(params.size());
+    for (size_t i = 0; i < params.size(); ++i) {
+        const Variable& param = *params[i];
+        Value arg;
+        if (is_out(param)) {
+            outArgs[i] = arg = this->getLValue(*c.fArguments[i]);
+        } else {
+            arg = this->writeExpression(*c.fArguments[i]);
+            if (!param.fWriteCount) {
+                fVariables[&param] = arg;
+                continue;
+            }
+        }
+        Value local = this->allocValue(arg.fCount);
+        if ((param.fModifiers.fFlags & Modifiers::kIn_Flag) || !is_out(param)) {
+            for (int j = 0; j < arg.fCount; ++j) {
+                this->emit(Op::kCopy, local.fRegs[j], arg.fRegs[j]);
+            }
+        }
+        fVariables[&param] = local;
+    }
+
+    Call call;
+    call.fFunction = &f;
+    call.fResult = this->allocValue(returnCount);
+    call.fReturned = -1;
+    bool wasMasked = fMasked;
+    uint16_t saved = 0;
+    if (has_early_return(f)) {
+        call.fReturned = this->allocRegister();
+        this->emit(Op::kCopy, call.fReturned, this->constant(0));
+        saved = this->allocRegister();
+        this->saveMask(saved);
+        fKillRegisters.push_back(call.fReturned);
+        fMasked = true;
+    }
+    fCalls.push_back(call);
+    this->writeStatement(*f.fBody);
+    fCalls.pop_back();
+    if (call.fReturned >= 0) {
+        fKillRegisters.pop_back();
+        this->emit(Op::kCopy, kMask, saved);
+    }
+    fMasked = wasMasked;
+    for (size_t i = 0; i < params.size(); ++i) {
+        if (is_out(*params[i])) {
+            this->store(outArgs[i], fVariables[params[i]]);
+        }
+    }
+    return call.fResult;
+}
+
+ByteCodeGenerator::Value ByteCodeGenerator::writeIntrinsicCall(const FunctionCall& c) {
+    int count = this->slotCount(c.fOffset, c.fType);
+    std::vector<Value> args;
+    for (const auto& arg : c.fArguments) {
+        args.push_back(this->writeExpression(*arg));
+    }
+    auto component = [](const Value& v, int i) { return v.fRegs[1 == v.fCount ? 0 : i]; };
+    // Applies op to each component of the arguments, producing a value with n components.
+    auto componentwise = [&](Op op, int n) {
+        Value result = this->allocValue(n);
+        for (int i = 0; i < n; ++i) {
+            this->emit(op, result.fRegs[i],
+                       args.size() > 0 ? component(args[0], i) : 0,
+                       args.size() > 1 ? component(args[1], i) : 0,
+                       args.size() > 2 ? component(args[2], i) : 0);
+        }
+        return result;
+    };
+    auto dot = [&](const Value& a, const Value& b) {
+        uint16_t result = this->allocRegister();
+        this->emit(Op::kMulF, result, a.fRegs[0], b.fRegs[0]);
+        for (int i = 1; i < a.fCount; ++i) {
+            uint16_t product = this->allocRegister();
+            this->emit(Op::kMulF, product, a.fRegs[i], b.fRegs[i]);
+            this->emit(Op::kAddF, result, result, product);
+        }
+        return result;
+    };
+    bool isInt = !args.empty() && Kind::kInt == this->kind(c.fArguments[0]->fType);
+    const StringFragment& name = c.fFunction.fName;
+    if ("abs" == name) {
+        return componentwise(isInt ? Op::kAbsI : Op::kAbsF, count);
+    }
+    if ("min" == name) {
+        return componentwise(isInt ? Op::kMinI : Op::kMinF, count);
+    }
+    if ("max" == name) {
+        return componentwise(isInt ? Op::kMaxI : Op::kMaxF, count);
+    }
+    if ("clamp" == name || "saturate" == name) {
+        if ("saturate" == name) {
+            args.push_back(Value());
+            args.back().fCount = 1;
+            args.back().fRegs[0] = this->constant(0.0f);
+            args.push_back(args.back());
+            args.back().fRegs[0] = this->constant(1.0f);
+        }
+        Value result = this->allocValue(count);
+        for (int i = 0; i < count; ++i) {
+            this->emit(isInt ? Op::kMaxI : Op::kMaxF, result.fRegs[i], component(args[0], i),
+                       component(args[1], i));
+            this->emit(isInt ? Op::kMinI : Op::kMinF, result.fRegs[i], result.fRegs[i],
+                       component(args[2], i));
+        }
+        return result;
+    }
+    if ("mix" == name) {
+        if (Kind::kBool == this->kind(c.fArguments[2]->fType)) {
+            Value result = this->allocValue(count);
+            for (int i = 0; i < count; ++i) {
+                this->emit(Op::kSelect, result.fRegs[i], component(args[2], i),
+                           component(args[1], i), component(args[0], i));
+            }
+            return result;
+        }
+        return componentwise(Op::kMix, count);
+    }
+    static const struct {
+        const char* fName;
+        Op fOp;
+    } kFloatIntrinsics[] = {
+        { "ceil",  Op::kCeil  },
+        { "cos",   Op::kCos   },
+        { "exp",   Op::kExp   },
+        { "floor", Op::kFloor },
+        { "log",   Op::kLog   },
+        { "pow",   Op::kPow   },
+        { "sin",   Op::kSin   },
+        { "sqrt",  Op::kSqrt  },
+        { "tan",   Op::kTan   },
+    };
+    for (const auto& intrinsic : kFloatIntrinsics) {
+        if (intrinsic.fName == name) {
+            return componentwise(intrinsic.fOp, count);
+        }
+    }
+    if ("fract" == name) {
+        Value result = componentwise(Op::kFloor, count);
+        for (int i = 0; i < count; ++i) {
+            this->emit(Op::kSubF, result.fRegs[i], args[0].fRegs[i], result.fRegs[i]);
+        }
+        return result;
+    }
+    if ("step" == name) {
+        Value result = this->allocValue(count);
+        for (int i = 0; i < count; ++i) {
+            this->emit(Op::kLtF, result.fRegs[i], component(args[1], i), component(args[0], i));
+            this->emit(Op::kSelect, result.fRegs[i], result.fRegs[i], this->constant(0.0f),
+                       this->constant(1.0f));
+        }
+        return result;
+    }
+    if ("dot" == name) {
+        Value result;
+        result.fCount = 1;
+        result.fRegs[0] = dot(args[0], args[1]);
+        return result;
+    }
+    if ("length" == name || "distance" == name || "normalize" == name) {
+        Value v = args[0];
+        if ("distance" == name) {
+            v = this->allocValue(args[0].fCount);
+            for (int i = 0; i < v.fCount; ++i) {
+                this->emit(Op::kSubF, v.fRegs[i], args[0].fRegs[i], args[1].fRegs[i]);
+            }
+        }
+        uint16_t length = dot(v, v);
+        this->emit(Op::kSqrt, length, length);
+        if ("normalize" != name) {
+            Value result;
+            result.fCount = 1;
+            result.fRegs[0] = length;
+            return result;
+        }
+        Value result = this->allocValue(count);
+        for (int i = 0; i < count; ++i) {
+            this->emit(Op::kDivF, result.fRegs[i], v.fRegs[i], length);
+        }
+        return result;
+    }
+    return this->error(c.fOffset, "unsupported intrinsic '" + String(name) + "'", count);
+}
+
+ByteCodeGenerator::Value ByteCodeGenerator::writeIndexExpression(const IndexExpression& i,
+                                                                 const Value& base) {
+    if (Type::kVector_Kind != i.fBase->fType.kind() ||
+        Expression::kIntLiteral_Kind != i.fIndex->fKind) {
+        return this->error(i.fOffset, "only constant indices into vectors are supported", 1);
+    }
+    int64_t index = ((const IntLiteral&) *i.fIndex).fValue;
+    if (index < 0 || index >= base.fCount) {
+        return this->error(i.fOffset, "index out of range", 1);
+    }
+    Value result;
+    result.fCount = 1;
+    result.fRegs[0] = base.fRegs[index];
+    return result;
+}
+
+ByteCodeGenerator::Value ByteCodeGenerator::writePrefixExpression(const PrefixExpression& p) {
+    Kind kind = this->kind(p.fType);
+    switch (p.fOperator) {
+        case Token::PLUS:
+            return this->writeExpression(*p.fOperand);
+        case Token::MINUS: {
+            Value operand = this->writeExpression(*p.fOperand);
+            Value result = this->allocValue(operand.fCount);
+            for (int i = 0; i < operand.fCount; ++i) {
+                this->emit(Kind::kFloat == kind ? Op::kNegF : Op::kNegI, result.fRegs[i],
+                           operand.fRegs[i]);
+            }
+            return result;
+        }
+        case Token::LOGICALNOT:
+        case Token::BITWISENOT: {
+            Value operand = this->writeExpression(*p.fOperand);
+            Value result = this->allocValue(operand.fCount);
+            for (int i = 0; i < operand.fCount; ++i) {
+                this->emit(Op::kNot, result.fRegs[i], operand.fRegs[i]);
+            }
+            return result;
+        }
+        case Token::PLUSPLUS:
+        case Token::MINUSMINUS: {
+            Value lvalue = this->getLValue(*p.fOperand);
+            Value one;
+            one.fCount = 1;
+            one.fRegs[0] = Kind::kFloat == kind ? this->constant(1.0f) : this->constant(1);
+            this->store(lvalue, this->writeArithmetic(
+                                        Token::PLUSPLUS == p.fOperator ? Token::PLUS : Token::MINUS,
+                                        kind, lvalue.fCount, lvalue, one, p.fOffset));
+            return lvalue;
+        }
+        default:
+            return this->error(p.fOffset, "unsupported expression: " + p.description(), 1);
+    }
+}
+
+ByteCodeGenerator::Value ByteCodeGenerator::writePostfixExpression(const PostfixExpression& p) {
+    Kind kind = this->kind(p.fType);
+    Value lvalue = this->getLValue(*p.fOperand);
+    Value result = this->copy(lvalue);
+    Value one;
+    one.fCount = 1;
+    one.fRegs[0] = Kind::kFloat == kind ? this->constant(1.0f) : this->constant(1);
+    this->store(lvalue, this->writeArithmetic(
+                                Token::PLUSPLUS == p.fOperator ? Token::PLUS : Token::MINUS,
+                                kind, lvalue.fCount, result, one, p.fOffset));
+    return result;
+}
+
+ByteCodeGenerator::Value ByteCodeGenerator::writeSwizzle(const Swizzle& s) {
+    Value base = this->writeExpression(*s.fBase);
+    bool isFloat = Kind::kFloat == this->kind(s.fType);
+    Value result;
+    result.fCount = s.fComponents.size();
+    for (int i = 0; i < result.fCount; ++i) {
+        switch (s.fComponents[i]) {
+            case SKSL_SWIZZLE_0:
+                result.fRegs[i] = this->constant(0);
+                break;
+            case SKSL_SWIZZLE_1:
+                result.fRegs[i] = isFloat ? this->constant(1.0f) : this->constant(1);
+                break;
+            default:
+                result.fRegs[i] = base.fRegs[s.fComponents[i]];
+        }
+    }
+    return result;
+}
+
+ByteCodeGenerator::Value ByteCodeGenerator::writeTernaryExpression(const TernaryExpression& t) {
+    Value test = this->writeExpression(*t.fTest);
+    int count = this->slotCount(t.fOffset, t.fType);
+    Value result = this->allocValue(count);
+    if (!t.fIfTrue->hasSideEffects() && !t.fIfFalse->hasSideEffects()) {
+        Value ifTrue = this->writeExpression(*t.fIfTrue);
+        Value ifFalse = this->writeExpression(*t.fIfFalse);
+        for (int i = 0; i < count; ++i) {
+            this->emit(Op::kSelect, result.fRegs[i], test.fRegs[0], ifTrue.fRegs[i],
+                       ifFalse.fRegs[i]);
+        }
+        return result;
+    }
+    // Each side may only have an effect in its own lanes.
+    test = this->copy(test);
+    uint16_t saved = this->allocRegister();
+    this->saveMask(saved);
+    bool wasMasked = fMasked;
+    fMasked = true;
+    this->emit(Op::kAnd, kMask, saved, test.fRegs[0]);
+    Value ifTrue = this->writeExpression(*t.fIfTrue);
+    for (int i = 0; i < count; ++i) {
+        this->emit(Op::kCopy, result.fRegs[i], ifTrue.fRegs[i]);
+    }
+    this->emit(Op::kAndNot, kMask, saved, test.fRegs[0]);
+    Value ifFalse = this->writeExpression(*t.fIfFalse);
+    for (int i = 0; i < count; ++i) {
+        this->emit(Op::kSelect, result.fRegs[i], kMask, ifFalse.fRegs[i], result.fRegs[i]);
+    }
+    fMasked = wasMasked;
+    this->emit(Op::kCopy, kMask, saved);
+    return result;
+}
+
+ByteCodeGenerator::Value ByteCodeGenerator::writeVariableReference(const VariableReference& v) {
+    auto found = fVariables.find(&v.fVariable);
+    if (found == fVariables.end()) {
+        return this->error(v.fOffset, "unsupported variable '" + String(v.fVariable.fName) + "'",
+                           1);
+    }
+    return found->second;
+}
+
+void ByteCodeGenerator::writeStatement(const Statement& s) {
+    // Registers allocated for temporaries are released at the end of each statement.
+    int level = fNextRegister;
+    switch (s.fKind) {
+        case Statement::kBlock_Kind:
+            this->writeBlock((const Block&) s);
+            break;
+        case Statement::kBreak_Kind:
+        case Statement::kContinue_Kind: {
+            if (fLoops.empty()) {
+                this->error(s.fOffset, "unsupported statement: " + s.description(), 0);
+                break;
+            }
+            uint16_t reg = Statement::kBreak_Kind == s.fKind ? fLoops.back().fBreak
+                                                              : fLoops.back().fContinue;
+            this->emit(Op::kOr, reg, reg, kMask);
+            this->emit(Op::kCopy, kMask, this->constant(0));
+            break;
+        }
+        case Statement::kDo_Kind:
+            this->writeDoStatement((const DoStatement&) s);
+            break;
+        case Statement::kExpression_Kind:
+            this->writeExpression(*((const ExpressionStatement&) s).fExpression);
+            break;
+        case Statement::kFor_Kind:
+            this->writeForStatement((const ForStatement&) s);
+            break;
+        case Statement::kIf_Kind:
+            this->writeIfStatement((const IfStatement&) s);
+            break;
+        case Statement::kNop_Kind:
+            break;
+        case Statement::kReturn_Kind:
+            this->writeReturnStatement((const ReturnStatement&) s);
+            break;
+        case Statement::kVarDeclarations_Kind:
+            // The variables stay allocated until the end of the enclosing block.
+            this->writeVarDeclarations(*((const VarDeclarationsStatement&) s).fDeclaration);
+            return;
+        case Statement::kWhile_Kind:
+            this->writeWhileStatement((const WhileStatement&) s);
+            break;
+        default:
+            this->error(s.fOffset, "unsupported statement: " + s.description(), 0);
+            break;
+    }
+    fNextRegister = level;
+}
+
+void ByteCodeGenerator::writeBlock(const Block& b) {
+    for (const auto& s : b.fStatements) {
+        this->writeStatement(*s);
+    }
+}
+
+void ByteCodeGenerator::writeVarDeclarations(const VarDeclarations& decl) {
+    for (const auto& s : decl.fVars) {
+        const VarDeclaration& v = (const VarDeclaration&) *s;
+        if (!v.fSizes.empty()) {
+            this->error(v.fOffset, "arrays are not supported", 0);
+            continue;
+        }
+        Value var = this->allocValue(this->slotCount(v.fOffset, v.fVar->fType));
+        int level = fNextRegister;
+        // Lanes that are masked off never read the variable before it is declared again, so
+        // there's no need to respect the mask here.
+        Value value;
+        if (v.fValue) {
+            value = this->writeExpression(*v.fValue);
+        } else {
+            value.fCount = 1;
+            value.fRegs[0] = this->constant(0);
+        }
+        for (int i = 0; i < var.fCount; ++i) {
+            this->emit(Op::kCopy, var.fRegs[i], value.fRegs[1 == value.fCount ? 0 : i]);
+        }
+        fNextRegister = level;
+        fVariables[v.fVar] = var;
+    }
+}
+
+void ByteCodeGenerator::writeIfStatement(const IfStatement& i) {
+    Value test = this->writeExpression(*i.fTest);
+    uint16_t saved = this->allocRegister();
+    this->saveMask(saved);
+    uint16_t elseMask = 0;
+    if (i.fIfFalse) {
+        // Computed up front, since the true branch might change the variables in the test.
+        elseMask = this->allocRegister();
+        this->emit(Op::kAndNot, elseMask, saved, test.fRegs[0]);
+    }
+    bool wasMasked = fMasked;
+    fMasked = true;
+    this->emit(Op::kAnd, kMask, saved, test.fRegs[0]);
+    int skipTrue = this->emitJump(Op::kJumpIfNone, kMask);
+    this->writeStatement(*i.fIfTrue);
+    this->setJumpTarget(skipTrue);
+    if (i.fIfFalse) {
+        this->emit(Op::kCopy, kMask, elseMask);
+        int skipFalse = this->emitJump(Op::kJumpIfNone, kMask);
+        this->writeStatement(*i.fIfFalse);
+        this->setJumpTarget(skipFalse);
+    }
+    fMasked = wasMasked;
+    this->restoreMask(saved);
+}
+
+void ByteCodeGenerator::writeForStatement(const ForStatement& f) {
+    if (f.fInitializer) {
+        this->writeStatement(*f.fInitializer);
+    }
+    Loop loop;
+    uint16_t saved = this->allocRegister();
+    this->saveMask(saved);
+    loop.fBreak = this->allocRegister();
+    loop.fContinue = this->allocRegister();
+    this->emit(Op::kCopy, loop.fBreak, this->constant(0));
+    fLoops.push_back(loop);
+    fKillRegisters.push_back(loop.fBreak);
+    fKillRegisters.push_back(loop.fContinue);
+    bool wasMasked = fMasked;
+    fMasked = true;
+    int level = fNextRegister;
+
+    int top = fCode.size();
+    this->emit(Op::kCopy, loop.fContinue, this->constant(0));
+    if (f.fTest) {
+        Value test = this->writeExpression(*f.fTest);
+        this->emit(Op::kAnd, kMask, kMask, test.fRegs[0]);
+        fNextRegister = level;
+    }
+    int exit = this->emitJump(Op::kJumpIfNone, kMask);
+    this->writeStatement(*f.fStatement);
+    this->emit(Op::kOr, kMask, kMask, loop.fContinue);
+    if (f.fNext) {
+        this->writeExpression(*f.fNext);
+        fNextRegister = level;
+    }
+    this->emit(Op::kJump, 0, top & 0xFFFF, top >> 16);
+    this->setJumpTarget(exit);
+
+    fMasked = wasMasked;
+    fKillRegisters.resize(fKillRegisters.size() - 2);
+    fLoops.pop_back();
+    this->restoreMask(saved);
+}
+
+void ByteCodeGenerator::writeWhileStatement(const WhileStatement& w) {
+    Loop loop;
+    uint16_t saved = this->allocRegister();
+    this->saveMask(saved);
+    loop.fBreak = this->allocRegister();
+    loop.fContinue = this->allocRegister();
+    this->emit(Op::kCopy, loop.fBreak, this->constant(0));
+    fLoops.push_back(loop);
+    fKillRegisters.push_back(loop.fBreak);
+    fKillRegisters.push_back(loop.fContinue);
+    bool wasMasked = fMasked;
+    fMasked = true;
+    int level = fNextRegister;
+
+    int top = fCode.size();
+    this->emit(Op::kCopy, loop.fContinue, this->constant(0));
+    Value test = this->writeExpression(*w.fTest);
+    this->emit(Op::kAnd, kMask, kMask, test.fRegs[0]);
+    fNextRegister = level;
+    int exit = this->emitJump(Op::kJumpIfNone, kMask);
+    this->writeStatement(*w.fStatement);
+    this->emit(Op::kOr, kMask, kMask, loop.fContinue);
+    this->emit(Op::kJump, 0, top & 0xFFFF, top >> 16);
+    this->setJumpTarget(exit);
+
+    fMasked = wasMasked;
+    fKillRegisters.resize(fKillRegisters.size() - 2);
+    fLoops.pop_back();
+    this->restoreMask(saved);
+}
+
+void ByteCodeGenerator::writeDoStatement(const DoStatement& d) {
+    Loop loop;
+    uint16_t saved = this->allocRegister();
+    this->saveMask(saved);
+    loop.fBreak = this->allocRegister();
+    loop.fContinue = this->allocRegister();
+    this->emit(Op::kCopy, loop.fBreak, this->constant(0));
+    fLoops.push_back(loop);
+    fKillRegisters.push_back(loop.fBreak);
+    fKillRegisters.push_back(loop.fContinue);
+    bool wasMasked = fMasked;
+    fMasked = true;
+
+    int top = fCode.size();
+    this->emit(Op::kCopy, loop.fContinue, this->constant(0));
+    this->writeStatement(*d.fStatement);
+    this->emit(Op::kOr, kMask, kMask, loop.fContinue);
+    Value test = this->writeExpression(*d.fTest);
+    this->emit(Op::kAnd, kMask, kMask, test.fRegs[0]);
+    this->emit(Op::kJumpIfAny, kMask, top & 0xFFFF, top >> 16);
+
+    fMasked = wasMasked;
+    fKillRegisters.resize(fKillRegisters.size() - 2);
+    fLoops.pop_back();
+    this->restoreMask(saved);
+}
+
+void ByteCodeGenerator::writeReturnStatement(const ReturnStatement& r) {
+    if (r.fExpression) {
+        Value value = this->writeExpression(*r.fExpression);
+        this->store(fCalls.back().fResult, value);
+    }
+    int returned = fCalls.back().fReturned;
+    if (returned >= 0) {
+        this->emit(Op::kOr, returned, returned, kMask);
+        this->emit(Op::kCopy, kMask, this->constant(0));
+    }
+}
+
+} // namespace
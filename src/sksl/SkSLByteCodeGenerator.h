@@ -0,0 +1,193 @@
+/*
+ * Copyright 2019 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SKSL_BYTECODEGENERATOR
+#define SKSL_BYTECODEGENERATOR
+
+#include <unordered_map>
+#include <vector>
+
+#include "SkSLByteCode.h"
+#include "SkSLCodeGenerator.h"
+#include "ir/SkSLBinaryExpression.h"
+#include "ir/SkSLBlock.h"
+#include "ir/SkSLConstructor.h"
+#include "ir/SkSLDoStatement.h"
+#include "ir/SkSLExpressionStatement.h"
+#include "ir/SkSLForStatement.h"
+#include "ir/SkSLFunctionCall.h"
+#include "ir/SkSLFunctionDefinition.h"
+#include "ir/SkSLIfStatement.h"
+#include "ir/SkSLIndexExpression.h"
+#include "ir/SkSLPostfixExpression.h"
+#include "ir/SkSLPrefixExpression.h"
+#include "ir/SkSLProgramElement.h"
+#include "ir/SkSLReturnStatement.h"
+#include "ir/SkSLStatement.h"
+#include "ir/SkSLSwizzle.h"
+#include "ir/SkSLTernaryExpression.h"
+#include "ir/SkSLVarDeclarationsStatement.h"
+#include "ir/SkSLVariableReference.h"
+#include "ir/SkSLWhileStatement.h"
+
+namespace SkSL {
+
+/**
+ * Compiles each function defined by a program to ByteCode. Only scalars and vectors of float, int
+ * and bool are supported. Calls to functions defined by the program are inlined.
+ *
+ * Functions whose parameters include bools can't be run directly, but may still be called by
+ * other functions.
+ */
+class ByteCodeGenerator : public CodeGenerator {
+public:
+    ByteCodeGenerator(const Context* context, const Program* program, ErrorReporter* errors,
+                      ByteCode* output)
+    : INHERITED(program, errors, nullptr)
+    , fContext(*context)
+    , fOutput(*output) {}
+
+    bool generateCode() override;
+
+private:
+    enum class Kind {
+        kFloat,
+        kInt,
+        kBool,
+    };
+
+    // The registers holding each component of a value. Variable references and swizzles don't
+    // copy anything; they refer to the registers of the variable itself.
+    struct Value {
+        int fCount = 0;
+        uint16_t fRegs[4];
+    };
+
+    struct Loop {
+        uint16_t fBreak;
+        uint16_t fContinue;
+    };
+
+    struct Call {
+        const FunctionDefinition* fFunction;
+        Value fResult;
+        // The lanes that have returned, or -1 if the function only returns at its very end.
+        int fReturned;
+    };
+
+    // Constants are given registers of their own after all of the other registers are allocated.
+    static constexpr int kConstantBit = 0x8000;
+
+    void writeFunction(const FunctionDefinition& f);
+
+    void emit(ByteCode::Op op, int dst, int a = 0, int b = 0, int c = 0);
+
+    int emitJump(ByteCode::Op op, int reg);
+
+    void setJumpTarget(int jump);
+
+    uint16_t constant(int32_t value);
+
+    uint16_t constant(float value);
+
+    uint16_t allocRegister();
+
+    Value allocValue(int count);
+
+    Value copy(const Value& value);
+
+    // Returns the number of registers a value of the given type needs, reporting an error if it
+    // can't be represented.
+    int slotCount(int offset, const Type& type);
+
+    Kind kind(const Type& type);
+
+    uint16_t convert(uint16_t reg, Kind from, Kind to);
+
+    void saveMask(uint16_t saved);
+
+    void restoreMask(uint16_t saved);
+
+    void store(const Value& lvalue, const Value& value);
+
+    Value getLValue(const Expression& expr);
+
+    Value writeExpression(const Expression& expr);
+
+    Value writeBinaryExpression(const BinaryExpression& b);
+
+    Value writeArithmetic(Token::Kind op, Kind kind, int count, const Value& left,
+                          const Value& right, int offset);
+
+    Value writeLogicalExpression(const BinaryExpression& b);
+
+    Value writeConstructor(const Constructor& c);
+
+    Value writeFunctionCall(const FunctionCall& c);
+
+    Value writeIntrinsicCall(const FunctionCall& c);
+
+    Value writeIndexExpression(const IndexExpression& i, const Value& base);
+
+    Value writePrefixExpression(const PrefixExpression& p);
+
+    Value writePostfixExpression(const PostfixExpression& p);
+
+    Value writeSwizzle(const Swizzle& s);
+
+    Value writeTernaryExpression(const TernaryExpression& t);
+
+    Value writeVariableReference(const VariableReference& v);
+
+    Value error(int offset, const String& msg, int count);
+
+    void writeStatement(const Statement& s);
+
+    void writeBlock(const Block& b);
+
+    void writeDoStatement(const DoStatement& d);
+
+    void writeForStatement(const ForStatement& f);
+
+    void writeIfStatement(const IfStatement& i);
+
+    void writeReturnStatement(const ReturnStatement& r);
+
+    void writeVarDeclarations(const VarDeclarations& decl);
+
+    void writeWhileStatement(const WhileStatement& w);
+
+    const Context& fContext;
+    ByteCode& fOutput;
+
+    std::unordered_map<const FunctionDeclaration*, const FunctionDefinition*> fDefinitions;
+
+    // The state of the function being generated.
+    std::vector<ByteCode::Instruction> fCode;
+    std::vector<int32_t> fConstants;
+    std::unordered_map<int32_t, uint16_t> fConstantRegisters;
+    std::unordered_map<const Variable*, Value> fVariables;
+    int fNextRegister;
+    int fRegisterCount;
+    // Whether some lanes may be inactive, in which case variables must be written through the
+    // execution mask.
+    bool fMasked;
+    // Registers holding lanes that have left the current statement through a break, continue or
+    // return, and must stay inactive when the mask is restored.
+    std::vector<uint16_t> fKillRegisters;
+    std::vector<Loop> fLoops;
+    std::vector<Call> fCalls;
+    // Whether the function has grown past the limits on inlining, which has been reported.
+    bool fTooLarge;
+    bool fFailed;
+
+    typedef CodeGenerator INHERITED;
+};
+
+} // namespace
+
+#endif
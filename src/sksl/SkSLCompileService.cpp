@@ -0,0 +1,123 @@
+/*
+ * Copyright 2019 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SKSL_STANDALONE
+
+#include "SkSLCompileService.h"
+
+#include "SkExecutor.h"
+#include "SkTaskGroup.h"
+#include "SkTraceEvent.h"
+
+#include <atomic>
+
+namespace SkSL {
+
+static void compile_job(Compiler* compiler, const CompileService::Job& job,
+                        CompileService::Result* result) {
+    std::unique_ptr<Program> program = compiler->convertProgram(job.fKind, job.fText,
+                                                                job.fSettings);
+    bool success = program != nullptr;
+    if (success) {
+        switch (job.fTarget) {
+            case CompileService::Target::kGLSL:
+                success = compiler->toGLSL(*program, &result->fCode);
+                break;
+            case CompileService::Target::kMetal:
+                success = compiler->toMetal(*program, &result->fCode);
+                break;
+            case CompileService::Target::kSPIRV:
+                success = compiler->toSPIRV(*program, &result->fCode);
+                break;
+        }
+        result->fInputs = program->fInputs;
+    }
+    result->fSuccess = success;
+    if (!success) {
+        result->fErrors = compiler->errorText();
+    }
+}
+
+CompileService::CompileService(SkExecutor* executor, int maxThreads)
+        : fExecutor(executor)
+        , fMaxThreads(SkTMax(maxThreads, 1)) {}
+
+CompileService::~CompileService() {}
+
+std::unique_ptr<Compiler> CompileService::acquireCompiler() {
+    {
+        SkAutoMutexAcquire lock(fMutex);
+        if (!fIdleCompilers.empty()) {
+            std::unique_ptr<Compiler> compiler = std::move(fIdleCompilers.back());
+            fIdleCompilers.pop_back();
+            return compiler;
+        }
+        ++fCompilersCreated;
+    }
+    // Building the built-in modules is the expensive part, so do it outside the lock.
+    TRACE_EVENT0("skia", "SkSL::CompileService::createCompiler");
+    return std::unique_ptr<Compiler>(new Compiler());
+}
+
+void CompileService::releaseCompiler(std::unique_ptr<Compiler> compiler) {
+    SkAutoMutexAcquire lock(fMutex);
+    fIdleCompilers.push_back(std::move(compiler));
+}
+
+void CompileService::compile(const Job jobs[], int count, Result results[]) {
+    TRACE_EVENT1("skia", TRACE_FUNC, "count", count);
+    if (count <= 0) {
+        return;
+    }
+    // Every thread pulls jobs until there are none left, holding on to one compiler from its
+    // first job on.  Threads that start after the last job is claimed never need a compiler.
+    std::atomic<int> nextJob{0};
+    auto work = [&] {
+        std::unique_ptr<Compiler> compiler;
+        for (int i = nextJob++; i < count; i = nextJob++) {
+            if (!compiler) {
+                compiler = this->acquireCompiler();
+            }
+            results[i] = Result();
+            compile_job(compiler.get(), jobs[i], &results[i]);
+        }
+        if (compiler) {
+            this->releaseCompiler(std::move(compiler));
+        }
+    };
+
+    int threads = fExecutor ? SkTMin(count, fMaxThreads) : 1;
+    if (threads == 1) {
+        work();
+        return;
+    }
+    SkTaskGroup group(*fExecutor);
+    for (int i = 1; i < threads; ++i) {
+        group.add(work);
+    }
+    work();
+    group.wait();
+}
+
+void CompileService::warmUp(int count) {
+    std::vector<std::unique_ptr<Compiler>> compilers;
+    for (int i = 0; i < count; ++i) {
+        compilers.push_back(this->acquireCompiler());
+    }
+    for (auto& compiler : compilers) {
+        this->releaseCompiler(std::move(compiler));
+    }
+}
+
+int CompileService::compilersCreated() const {
+    SkAutoMutexAcquire lock(fMutex);
+    return fCompilersCreated;
+}
+
+} // namespace
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2019 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SKSL_COMPILESERVICE
+#define SKSL_COMPILESERVICE
+
+#include "SkMutex.h"
+#include "SkSLCompiler.h"
+
+#include <memory>
+#include <vector>
+
+class SkExecutor;
+
+namespace SkSL {
+
+/**
+ * Compiles many SkSL programs concurrently. Constructing a Compiler parses and converts all of the
+ * built-in include modules, which is most of the cost of compiling a small program, and a Compiler
+ * may only be used by one thread at a time. The service therefore keeps a pool of compilers: each
+ * one is built the first time it is needed, and its built-in modules are then reused by every
+ * later job that runs on it.
+ *
+ * Programs never leave the service (they refer back to the compiler that created them); each job
+ * produces generated code instead.
+ */
+class CompileService {
+public:
+    enum class Target {
+        kGLSL,
+        kMetal,
+        kSPIRV,
+    };
+
+    struct Job {
+        Program::Kind     fKind = Program::kFragment_Kind;
+        String            fText;
+        Program::Settings fSettings;
+        Target            fTarget = Target::kGLSL;
+    };
+
+    struct Result {
+        bool           fSuccess = false;
+        String         fCode;
+        Program::Inputs fInputs;
+        String         fErrors;
+    };
+
+    /**
+     * Jobs are spread over at most maxThreads threads: the calling thread plus tasks added to the
+     * executor. With no executor, every job is compiled on the calling thread.
+     */
+    explicit CompileService(SkExecutor* executor = nullptr, int maxThreads = 4);
+    ~CompileService();
+
+    /**
+     * Compiles count jobs, writing the outcome of jobs[i] to results[i]. Blocks until every job has
+     * finished. May be called from several threads at once.
+     */
+    void compile(const Job jobs[], int count, Result results[]);
+
+    Result compile(const Job& job) {
+        Result result;
+        this->compile(&job, 1, &result);
+        return result;
+    }
+
+    /** Builds compilers ahead of time, e.g. on a background thread during startup. */
+    void warmUp(int count);
+
+    /** Returns how many compilers have been constructed so far. */
+    int compilersCreated() const;
+
+private:
+    std::unique_ptr<Compiler> acquireCompiler();
+    void releaseCompiler(std::unique_ptr<Compiler>);
+
+    SkExecutor* fExecutor;
+    int         fMaxThreads;
+
+    mutable SkMutex                        fMutex;
+    std::vector<std::unique_ptr<Compiler>> fIdleCompilers;
+    int                                    fCompilersCreated = 0;
+};
+
+} // namespace
+
+#endif
@@ -55,6 +55,7 @@ void Interpreter::run(const FunctionDefinition& f) {
     while (fCurrentIndex.size()) {
         this->runStatement();
     }
+    fVars.pop_back();
 }
 
 void Interpreter::push(Value value) {
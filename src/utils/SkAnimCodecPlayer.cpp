@@ -9,13 +9,80 @@
 #include "SkCodec.h"
 #include "SkCodecImageGenerator.h"
 #include "SkData.h"
+#include "SkExecutor.h"
 #include "SkImage.h"
+#include "SkMutex.h"
+#include "SkTaskGroup.h"
 #include <algorithm>
 
+// The most keyframes to have decoding ahead at once.
+static constexpr int kMaxPrefetchingFrames = 4;
+
+// Decodes frame index.  If prior is not null, it is frame priorIndex, which index depends on.
+static sk_sp<SkImage> decode_frame(SkCodec* codec, const SkImageInfo& info, int index,
+                                   int priorIndex, const SkImage* prior) {
+    size_t rb = info.minRowBytes();
+    size_t size = info.computeByteSize(rb);
+    auto data = SkData::MakeUninitialized(size);
+
+    SkCodec::Options opts;
+    opts.fFrameIndex = index;
+
+    SkPixmap priorPM;
+    if (prior && prior->peekPixels(&priorPM)) {
+        sk_careful_memcpy(data->writable_data(), priorPM.addr(), size);
+        opts.fPriorFrame = priorIndex;
+    }
+    if (SkCodec::kSuccess == codec->getPixels(info, data->writable_data(), rb, &opts)) {
+        return SkImage::MakeRasterData(info, std::move(data), rb);
+    }
+    return nullptr;
+}
+
+struct SkAnimCodecPlayer::Prefetcher {
+    Prefetcher(sk_sp<SkData> data, SkExecutor& executor, int frameCount)
+        : fData(std::move(data))
+        , fPending(frameCount, false)
+        , fTaskGroup(executor) {}
+
+    const sk_sp<SkData> fData;
+
+    // Only used by the player's thread.
+    std::vector<bool>   fPending;
+    int                 fPendingCount = 0;
+
+    // Codecs not being used by a task, and the frames tasks have finished.
+    SkMutex                                      fMutex;
+    std::vector<std::unique_ptr<SkCodec>>        fIdleCodecs;
+    std::vector<std::pair<int, sk_sp<SkImage>>>  fDecoded;
+
+    // Declared last, so that it waits for its tasks before the rest is destroyed.
+    SkTaskGroup         fTaskGroup;
+};
+
 SkAnimCodecPlayer::SkAnimCodecPlayer(std::unique_ptr<SkCodec> codec) : fCodec(std::move(codec)) {
+    this->init();
+}
+
+SkAnimCodecPlayer::SkAnimCodecPlayer(sk_sp<SkData> data, SkExecutor* executor, size_t cacheBytes)
+        : fCodec(SkCodec::MakeFromData(data))
+        , fCacheBytes(cacheBytes) {
+    if (!fCodec) {
+        fTotalDuration = 0;
+        fImages.push_back(nullptr);
+        return;
+    }
+    this->init();
+    if (executor && fTotalDuration) {
+        fPrefetcher.reset(new Prefetcher(std::move(data), *executor, (int)fFrameInfos.size()));
+    }
+}
+
+void SkAnimCodecPlayer::init() {
     fImageInfo = fCodec->getInfo();
     fFrameInfos = fCodec->getFrameInfo();
     fImages.resize(fFrameInfos.size());
+    fLastUse.resize(fFrameInfos.size());
 
     // change the interpretation of fDuration to a end-time for that frame
     size_t dur = 0;
@@ -43,38 +110,155 @@ SkISize SkAnimCodecPlayer::dimensions() {
 sk_sp<SkImage> SkAnimCodecPlayer::getFrameAt(int index) {
     SkASSERT((unsigned)index < fFrameInfos.size());
 
-    if (fImages[index]) {
-        return fImages[index];
-    }
+    this->collectPrefetched(false);
 
-    size_t rb = fImageInfo.minRowBytes();
-    size_t size = fImageInfo.computeByteSize(rb);
-    auto data = SkData::MakeUninitialized(size);
+    // Walk back to a cached frame or a keyframe, then replay forward from there.
+    std::vector<int> replay;
+    for (int i = index; i != SkCodec::kNoFrame && !fImages[i];
+         i = fFrameInfos[i].fRequiredFrame) {
+        if (fPrefetcher && fPrefetcher->fPending[i]) {
+            this->collectPrefetched(true);
+            if (fImages[i]) {
+                break;
+            }
+        }
+        replay.push_back(i);
+    }
+    for (auto i = replay.rbegin(); i != replay.rend(); ++i) {
+        if (!this->decodeFrame(*i)) {
+            return nullptr;
+        }
+    }
 
-    SkCodec::Options opts;
-    opts.fFrameIndex = index;
+    fLastUse[index] = ++fUseCount;
+    return fImages[index];
+}
 
+bool SkAnimCodecPlayer::decodeFrame(int index) {
     const int requiredFrame = fFrameInfos[index].fRequiredFrame;
-    if (requiredFrame != SkCodec::kNoFrame) {
-        auto requiredImage = fImages[requiredFrame];
-        SkPixmap requiredPM;
-        if (requiredImage && requiredImage->peekPixels(&requiredPM)) {
-            sk_careful_memcpy(data->writable_data(), requiredPM.addr(), size);
-            opts.fPriorFrame = requiredFrame;
+    const SkImage* requiredImage = requiredFrame != SkCodec::kNoFrame
+                                 ? fImages[requiredFrame].get() : nullptr;
+    sk_sp<SkImage> image = decode_frame(fCodec.get(), fImageInfo, index, requiredFrame,
+                                        requiredImage);
+    if (!image) {
+        return false;
+    }
+    fCachedBytes += fImageInfo.computeMinByteSize();
+    this->cacheFrame(index, std::move(image));
+    if (!this->makeRoom(false, index)) {
+        this->makeRoom(true, index);
+    }
+    return true;
+}
+
+void SkAnimCodecPlayer::cacheFrame(int index, sk_sp<SkImage> image) {
+    fImages[index] = std::move(image);
+    fLastUse[index] = ++fUseCount;
+}
+
+bool SkAnimCodecPlayer::makeRoom(bool evictKeyframes, int keep) {
+    while (fCachedBytes > fCacheBytes) {
+        int lru = -1;
+        for (int i = 0; i < (int)fImages.size(); i++) {
+            if (fImages[i] && i != keep &&
+                (evictKeyframes || fFrameInfos[i].fRequiredFrame != SkCodec::kNoFrame) &&
+                (lru < 0 || fLastUse[i] < fLastUse[lru])) {
+                lru = i;
+            }
+        }
+        if (lru < 0) {
+            return false;
         }
+        fImages[lru] = nullptr;
+        fCachedBytes -= fImageInfo.computeMinByteSize();
     }
-    if (SkCodec::kSuccess == fCodec->getPixels(fImageInfo, data->writable_data(), rb, &opts)) {
-        return fImages[index] = SkImage::MakeRasterData(fImageInfo, std::move(data), rb);
+    return true;
+}
+
+void SkAnimCodecPlayer::collectPrefetched(bool wait) {
+    if (!fPrefetcher || 0 == fPrefetcher->fPendingCount) {
+        return;
+    }
+    if (wait) {
+        fPrefetcher->fTaskGroup.wait();
+    }
+
+    std::vector<std::pair<int, sk_sp<SkImage>>> decoded;
+    {
+        SkAutoMutexAcquire lock(fPrefetcher->fMutex);
+        decoded.swap(fPrefetcher->fDecoded);
+    }
+    for (auto& frame : decoded) {
+        fPrefetcher->fPending[frame.first] = false;
+        fPrefetcher->fPendingCount--;
+        if (frame.second) {
+            this->cacheFrame(frame.first, std::move(frame.second));
+        } else {
+            // Give back the room we set aside for it.
+            fCachedBytes -= fImageInfo.computeMinByteSize();
+        }
+    }
+}
+
+void SkAnimCodecPlayer::prefetch() {
+    if (!fPrefetcher) {
+        return;
+    }
+
+    // Start on the next keyframes that aren't cached, as long as they fit without evicting
+    // another keyframe.
+    const int frameCount = (int)fFrameInfos.size();
+    for (int n = 1; n < frameCount && fPrefetcher->fPendingCount < kMaxPrefetchingFrames; n++) {
+        const int index = (fCurrIndex + n) % frameCount;
+        if (fImages[index] || fPrefetcher->fPending[index] ||
+            fFrameInfos[index].fRequiredFrame != SkCodec::kNoFrame) {
+            continue;
+        }
+        fCachedBytes += fImageInfo.computeMinByteSize();
+        if (!this->makeRoom(false, fCurrIndex)) {
+            fCachedBytes -= fImageInfo.computeMinByteSize();
+            return;
+        }
+        fPrefetcher->fPending[index] = true;
+        fPrefetcher->fPendingCount++;
+
+        Prefetcher* prefetcher = fPrefetcher.get();
+        SkImageInfo info = fImageInfo;
+        prefetcher->fTaskGroup.add([prefetcher, info, index] {
+            std::unique_ptr<SkCodec> codec;
+            {
+                SkAutoMutexAcquire lock(prefetcher->fMutex);
+                if (!prefetcher->fIdleCodecs.empty()) {
+                    codec = std::move(prefetcher->fIdleCodecs.back());
+                    prefetcher->fIdleCodecs.pop_back();
+                }
+            }
+            if (!codec) {
+                codec = SkCodec::MakeFromData(prefetcher->fData);
+            }
+            sk_sp<SkImage> image;
+            if (codec) {
+                image = decode_frame(codec.get(), info, index, SkCodec::kNoFrame, nullptr);
+            }
+
+            SkAutoMutexAcquire lock(prefetcher->fMutex);
+            if (codec) {
+                prefetcher->fIdleCodecs.push_back(std::move(codec));
+            }
+            prefetcher->fDecoded.emplace_back(index, std::move(image));
+        });
     }
-    return nullptr;
 }
 
 sk_sp<SkImage> SkAnimCodecPlayer::getFrame() {
     SkASSERT(fTotalDuration > 0 || fImages.size() == 1);
 
-    return fTotalDuration > 0
-        ? this->getFrameAt(fCurrIndex)
-        : fImages.front();
+    if (!fTotalDuration) {
+        return fImages.front();
+    }
+    sk_sp<SkImage> image = this->getFrameAt(fCurrIndex);
+    this->prefetch();
+    return image;
 }
 
 bool SkAnimCodecPlayer::seek(uint32_t msec) {
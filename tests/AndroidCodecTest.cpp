@@ -295,3 +295,169 @@ DEF_TEST(AndroidCodec_sampledOrientation, r) {
         ERRORF(r, "got result \"%s\"\n", SkCodec::ResultToString(result));
     }
 }
+
+// Averages the pixels of |rect| in |src| down to |size|, the slow way.
+static SkBitmap box_filter(const SkBitmap& src, const SkIRect& rect, const SkISize& size) {
+    auto overlap = [](double a0, double a1, double b0, double b1) {
+        return std::max(0.0, std::min(a1, b1) - std::max(a0, b0));
+    };
+    const double sx = (double) rect.width() / size.width();
+    const double sy = (double) rect.height() / size.height();
+
+    SkBitmap dst;
+    dst.allocPixels(src.info().makeWH(size.width(), size.height()));
+    for (int y = 0; y < size.height(); y++) {
+        for (int x = 0; x < size.width(); x++) {
+            double sums[4] = { 0, 0, 0, 0 };
+            for (int v = (int) (y * sy); v < std::min(rect.height(), (int) ((y + 1) * sy) + 1);
+                    v++) {
+                const double wy = overlap(v, v + 1, y * sy, (y + 1) * sy);
+                for (int u = (int) (x * sx);
+                        u < std::min(rect.width(), (int) ((x + 1) * sx) + 1); u++) {
+                    const double w = wy * overlap(u, u + 1, x * sx, (x + 1) * sx);
+                    const uint8_t* p = (const uint8_t*) src.getAddr32(rect.x() + u,
+                                                                      rect.y() + v);
+                    for (int c = 0; c < 4; c++) {
+                        sums[c] += w * p[c];
+                    }
+                }
+            }
+            uint8_t* out = (uint8_t*) dst.getAddr32(x, y);
+            for (int c = 0; c < 4; c++) {
+                out[c] = (uint8_t) (sums[c] / (sx * sy) + 0.5);
+            }
+        }
+    }
+    return dst;
+}
+
+static int max_difference(const SkBitmap& a, const SkBitmap& b) {
+    int difference = 0;
+    for (int y = 0; y < a.height(); y++) {
+        const uint8_t* pa = (const uint8_t*) a.getAddr(0, y);
+        const uint8_t* pb = (const uint8_t*) b.getAddr(0, y);
+        for (size_t i = 0; i < a.info().minRowBytes(); i++) {
+            difference = std::max(difference, std::abs(pa[i] - pb[i]));
+        }
+    }
+    return difference;
+}
+
+// Decoding with fAreaAverage should match averaging a full size decode, for any size, and
+// whether the codec decodes a row at a time from the top or bottom, or can't.  A jpeg is
+// averaged from the smallest size libjpeg can scale it to that is still large enough.
+DEF_TEST(AndroidCodec_areaAverage, r) {
+    const char* paths[] = {
+        "images/mandrill_512.png",
+        "images/rle.bmp",
+        "images/test640x479.gif",
+        "images/mandrill_512_q075.jpg",
+    };
+    for (const char* path : paths) {
+        auto codec = SkAndroidCodec::MakeFromData(GetResourceAsData(path));
+        if (!codec) {
+            ERRORF(r, "Could not decode %s", path);
+            continue;
+        }
+        const SkImageInfo info = codec->getInfo().makeColorType(kN32_SkColorType)
+                                                 .makeAlphaType(kPremul_SkAlphaType);
+        const bool isJpeg = SkEncodedImageFormat::kJPEG == codec->getEncodedFormat();
+
+        // The full image, scaled down by each sample size libjpeg supports.
+        SkBitmap scaled[9];
+        for (int sampleSize : { 1, 2, 4, 8 }) {
+            if (1 != sampleSize && !isJpeg) {
+                continue;
+            }
+            SkAndroidCodec::AndroidOptions options;
+            options.fSampleSize = sampleSize;
+            scaled[sampleSize].allocPixels(info.makeWH(
+                    codec->getSampledDimensions(sampleSize).width(),
+                    codec->getSampledDimensions(sampleSize).height()));
+            REPORTER_ASSERT(r, SkCodec::kSuccess == codec->getAndroidPixels(
+                    scaled[sampleSize].info(), scaled[sampleSize].getPixels(),
+                    scaled[sampleSize].rowBytes(), &options));
+        }
+
+        SkIRect rects[] = {
+            SkIRect::MakeSize(info.dimensions()),
+            SkIRect::MakeXYWH(30, 40, info.width() / 2 + 11, info.height() / 2 + 3),
+        };
+        for (SkIRect& rect : rects) {
+            const SkISize sizes[] = {
+                { 1, 1 },
+                { 100, 100 },
+                { rect.width() / 3, rect.height() / 7 },
+                { rect.width() - 1, rect.height() * 2 / 3 },
+            };
+            for (const SkISize& size : sizes) {
+                SkAndroidCodec::AndroidOptions options;
+                options.fAreaAverage = true;
+                if (rect != SkIRect::MakeSize(info.dimensions())) {
+                    options.fSubset = &rect;
+                }
+
+                SkBitmap averaged;
+                averaged.allocPixels(info.makeWH(size.width(), size.height()));
+                REPORTER_ASSERT(r, SkCodec::kSuccess == codec->getAndroidPixels(
+                        averaged.info(), averaged.getPixels(), averaged.rowBytes(), &options));
+
+                int sampleSize = 1;
+                SkIRect scaledRect = rect;
+                for (int s : { 8, 4, 2 }) {
+                    if (!isJpeg) {
+                        break;
+                    }
+                    const SkIRect candidate = SkIRect::MakeLTRB(
+                            rect.left() / s, rect.top() / s,
+                            std::min(scaled[s].width(), (rect.right() + s - 1) / s),
+                            std::min(scaled[s].height(), (rect.bottom() + s - 1) / s));
+                    if (candidate.width() >= size.width() &&
+                            candidate.height() >= size.height()) {
+                        sampleSize = s;
+                        scaledRect = candidate;
+                        break;
+                    }
+                }
+                const int difference = max_difference(
+                        averaged, box_filter(scaled[sampleSize], scaledRect, size));
+                if (difference > 1) {
+                    ERRORF(r, "%s averaged to %dx%d is off by %d", path, size.width(),
+                           size.height(), difference);
+                }
+
+                // Other color types are averaged the same way.
+                SkBitmap f16;
+                f16.allocPixels(averaged.info().makeColorType(kRGBA_F16_SkColorType));
+                REPORTER_ASSERT(r, SkCodec::kSuccess == codec->getAndroidPixels(
+                        f16.info(), f16.getPixels(), f16.rowBytes(), &options));
+                SkBitmap f16As8888;
+                f16As8888.allocPixels(averaged.info());
+                REPORTER_ASSERT(r, f16.readPixels(f16As8888.pixmap()));
+                REPORTER_ASSERT(r, max_difference(averaged, f16As8888) <= 1);
+
+                SkBitmap rgb565;
+                rgb565.allocPixels(averaged.info().makeColorType(kRGB_565_SkColorType)
+                                                  .makeAlphaType(kOpaque_SkAlphaType));
+                if (averaged.info().isOpaque() || codec->getInfo().isOpaque()) {
+                    REPORTER_ASSERT(r, SkCodec::kSuccess == codec->getAndroidPixels(
+                            rgb565.info(), rgb565.getPixels(), rgb565.rowBytes(), &options));
+                    SkBitmap expected565;
+                    expected565.allocPixels(rgb565.info());
+                    REPORTER_ASSERT(r, averaged.readPixels(expected565.pixmap()));
+                    REPORTER_ASSERT(r, 0 == memcmp(rgb565.getPixels(), expected565.getPixels(),
+                                                   rgb565.computeByteSize()));
+                }
+            }
+        }
+    }
+
+    // The result can't be larger than the image.
+    auto codec = SkAndroidCodec::MakeFromData(GetResourceAsData("images/mandrill_512.png"));
+    SkAndroidCodec::AndroidOptions options;
+    options.fAreaAverage = true;
+    SkBitmap bitmap;
+    bitmap.allocPixels(codec->getInfo().makeWH(513, 100));
+    REPORTER_ASSERT(r, SkCodec::kInvalidScale == codec->getAndroidPixels(
+            bitmap.info(), bitmap.getPixels(), bitmap.rowBytes(), &options));
+}
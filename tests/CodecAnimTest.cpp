@@ -13,8 +13,12 @@
 #include "SkCodec.h"
 #include "SkCodecAnimation.h"
 #include "SkData.h"
+#include "SkExecutor.h"
+#include "SkImage.h"
 #include "SkImageInfo.h"
 #include "SkMakeUnique.h"
+#include "SkPixmap.h"
+#include "SkRandom.h"
 #include "SkRefCnt.h"
 #include "SkSize.h"
 #include "SkString.h"
@@ -484,3 +488,52 @@ DEF_TEST(AnimCodecPlayer, r) {
         REPORTER_ASSERT(r, f1->bounds().size() == test.fSize);
     }
 }
+
+// Decoding keyframes ahead and evicting from a small cache should not change any frame, whatever
+// order the frames are asked for in.
+DEF_TEST(AnimCodecPlayer_prefetch, r) {
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(4);
+    for (const char* file : { "images/alphabetAnim.gif", "images/randPixelsAnim.gif",
+                              "images/flightAnim.gif" }) {
+        sk_sp<SkData> data = GetResourceAsData(file);
+        if (!data) {
+            continue;
+        }
+        SkAnimCodecPlayer expected(SkCodec::MakeFromData(data));
+
+        // The end of each frame is a time within it.
+        std::vector<uint32_t> times;
+        uint32_t time = 0;
+        for (const SkCodec::FrameInfo& info : SkCodec::MakeFromData(data)->getFrameInfo()) {
+            time += info.fDuration;
+            times.push_back(time);
+        }
+        // Play through in order, then scrub around.
+        SkRandom random;
+        const size_t frameCount = times.size();
+        for (size_t i = 0; i < 2 * frameCount; i++) {
+            times.push_back(times[random.nextULessThan(frameCount)]);
+        }
+
+        const size_t frameBytes = expected.dimensions().width() *
+                                  expected.dimensions().height() * 4;
+        for (size_t cacheBytes : { 3 * frameBytes, SIZE_MAX }) {
+            for (SkExecutor* e : { (SkExecutor*) nullptr, executor.get() }) {
+                SkAnimCodecPlayer player(data, e, cacheBytes);
+                REPORTER_ASSERT(r, player.duration() == expected.duration());
+                for (uint32_t t : times) {
+                    expected.seek(t);
+                    player.seek(t);
+                    sk_sp<SkImage> a = expected.getFrame(),
+                                   b = player.getFrame();
+                    SkPixmap pa, pb;
+                    REPORTER_ASSERT(r, a && b && a->peekPixels(&pa) && b->peekPixels(&pb));
+                    if (!a || !b || 0 != memcmp(pa.addr(), pb.addr(), pa.computeByteSize())) {
+                        ERRORF(r, "%s differs at %u ms", file, t);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
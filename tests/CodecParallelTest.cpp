@@ -0,0 +1,216 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Resources.h"
+#include "SkAndroidCodec.h"
+#include "SkBitmap.h"
+#include "SkCodec.h"
+#include "SkColorSpace.h"
+#include "SkData.h"
+#include "SkExecutor.h"
+#include "SkPngEncoder.h"
+#include "SkRandom.h"
+#include "SkStream.h"
+#include "SkTDArray.h"
+#include "Test.h"
+
+#include <cstring>
+#include <memory>
+
+// icc-v2-gbr.jpg has a restart marker at the start of each of its 16 pixel MCU rows.  Make a
+// taller image with restart markers by repeating its whole MCU rows, so that it is worth
+// decoding in stripes.
+static sk_sp<SkData> make_tall_jpeg(const SkData& src, int mcuRows) {
+    const uint8_t* data = src.bytes();
+    size_t heightOffset = 0;
+    size_t offset = 2;
+    while (offset + 4 <= src.size()) {
+        const uint8_t marker = data[offset + 1];
+        if (0xC0 == marker) {
+            heightOffset = offset + 5;
+        }
+        offset += 2 + ((data[offset + 2] << 8) | data[offset + 3]);
+        if (0xDA == marker) {
+            break;
+        }
+    }
+    const size_t scanStart = offset;
+
+    // The entropy-coded data of each interval starts after the SOS or an RSTn marker.
+    SkTDArray<size_t> starts;
+    SkTDArray<size_t> ends;
+    *starts.append() = scanStart;
+    for (; offset + 1 < src.size(); offset++) {
+        if (0xFF == data[offset] && 0xD0 <= data[offset + 1] && data[offset + 1] <= 0xD7) {
+            *ends.append() = offset;
+            *starts.append() = offset + 2;
+        }
+    }
+    // Skip the last interval, which is only partly in the image.
+    const int fullRows = ends.count();
+
+    SkDynamicMemoryWStream stream;
+    stream.write(data, heightOffset);
+    stream.write8((mcuRows * 16) >> 8);
+    stream.write8((mcuRows * 16) & 0xFF);
+    stream.write(data + heightOffset + 2, scanStart - heightOffset - 2);
+    for (int i = 0; i < mcuRows; i++) {
+        if (i > 0) {
+            stream.write8(0xFF);
+            stream.write8(0xD0 + ((i - 1) & 7));
+        }
+        const int row = i % fullRows;
+        stream.write(data + starts[row], ends[row] - starts[row]);
+    }
+    stream.write8(0xFF);
+    stream.write8(0xD9);
+    return stream.detachAsData();
+}
+
+static sk_sp<SkData> make_png() {
+    SkBitmap bm;
+    bm.allocPixels(SkImageInfo::MakeN32(300, 700, kUnpremul_SkAlphaType));
+    SkRandom random;
+    for (int y = 0; y < bm.height(); y++) {
+        for (int x = 0; x < bm.width(); x++) {
+            *bm.getAddr32(x, y) = random.nextU() | (y << 24);
+        }
+    }
+    SkDynamicMemoryWStream stream;
+    if (!SkPngEncoder::Encode(&stream, bm.pixmap(), SkPngEncoder::Options())) {
+        return nullptr;
+    }
+    return stream.detachAsData();
+}
+
+// Decoding with an executor should give exactly the same pixels as decoding without one, whether
+// or not the image can be split.
+DEF_TEST(Codec_parallel, r) {
+    sk_sp<SkData> gbr = GetResourceAsData("images/icc-v2-gbr.jpg");
+    if (!gbr) {
+        return;
+    }
+    sk_sp<SkData> images[] = {
+        make_tall_jpeg(*gbr, 40),
+        GetResourceAsData("images/mandrill_512_q075.jpg"),
+        make_png(),
+        GetResourceAsData("images/mandrill_512.png"),
+    };
+
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(4);
+    for (const sk_sp<SkData>& data : images) {
+        std::unique_ptr<SkCodec> codec = SkCodec::MakeFromData(data);
+        REPORTER_ASSERT(r, codec);
+        if (!codec) {
+            continue;
+        }
+
+        const SkImageInfo infos[] = {
+            codec->getInfo().makeColorType(kN32_SkColorType)
+                            .makeAlphaType(codec->getInfo().isOpaque() ? kOpaque_SkAlphaType
+                                                                       : kPremul_SkAlphaType),
+            codec->getInfo().makeColorType(kRGBA_F16_SkColorType)
+                            .makeColorSpace(SkColorSpace::MakeSRGBLinear()),
+            codec->getInfo().makeColorType(kRGBA_8888_SkColorType)
+                            .makeColorSpace(SkColorSpace::MakeRGB(SkNamedTransferFn::k2Dot2,
+                                                                  SkNamedGamut::kDCIP3)),
+        };
+        for (const SkImageInfo& info : infos) {
+            SkBitmap serial, parallel;
+            serial.allocPixels(info);
+            parallel.allocPixels(info);
+            // Make sure every pixel gets written.
+            memset(parallel.getPixels(), 0xA5, parallel.computeByteSize());
+
+            REPORTER_ASSERT(r, SkCodec::kSuccess ==
+                               codec->getPixels(info, serial.getPixels(), serial.rowBytes()));
+            SkCodec::Options options;
+            options.fExecutor = executor.get();
+            REPORTER_ASSERT(r, SkCodec::kSuccess ==
+                               codec->getPixels(info, parallel.getPixels(), parallel.rowBytes(),
+                                                &options));
+            // Decoding serially again after a parallel decode should still work.
+            REPORTER_ASSERT(r, SkCodec::kSuccess ==
+                               codec->getPixels(info, serial.getPixels(), serial.rowBytes()));
+
+            for (int y = 0; y < info.height(); y++) {
+                if (0 != memcmp(serial.getAddr(0, y), parallel.getAddr(0, y),
+                                info.minRowBytes())) {
+                    ERRORF(r, "Row %d of a %dx%d image differs when decoded in parallel",
+                           y, info.width(), info.height());
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// Subset decodes using a region index should match those without one, and an index should only
+// be accepted by a codec for the image it came from.
+DEF_TEST(Codec_regionIndex, r) {
+    sk_sp<SkData> gbr = GetResourceAsData("images/icc-v2-gbr.jpg");
+    if (!gbr) {
+        return;
+    }
+    sk_sp<SkData> data = make_tall_jpeg(*gbr, 40);
+
+    sk_sp<SkData> index = SkCodec::MakeFromData(data)->makeRegionIndex();
+    REPORTER_ASSERT(r, index);
+    if (!index) {
+        return;
+    }
+
+    std::unique_ptr<SkCodec> indexedCodec = SkCodec::MakeFromData(data);
+    REPORTER_ASSERT(r, indexedCodec->setRegionIndex(*index));
+    auto indexed = SkAndroidCodec::MakeFromCodec(std::move(indexedCodec));
+    auto plain = SkAndroidCodec::MakeFromData(data);
+
+    SkIRect subsets[] = {
+        SkIRect::MakeXYWH(0, 0, 100, 100),
+        SkIRect::MakeXYWH(30, 300, 200, 100),
+        SkIRect::MakeXYWH(100, 500, 175, 140),
+        SkIRect::MakeXYWH(0, 632, 275, 8),
+    };
+    for (SkIRect& subset : subsets) {
+        for (int sampleSize : { 1, 2, 4 }) {
+            SkAndroidCodec::AndroidOptions options;
+            options.fSubset = &subset;
+            options.fSampleSize = sampleSize;
+            const SkImageInfo info = plain->getInfo().makeWH(
+                    plain->getSampledSubsetDimensions(sampleSize, subset).width(),
+                    plain->getSampledSubsetDimensions(sampleSize, subset).height());
+
+            SkBitmap expected, actual;
+            expected.allocPixels(info);
+            actual.allocPixels(info);
+            REPORTER_ASSERT(r, SkCodec::kSuccess == plain->getAndroidPixels(
+                    info, expected.getPixels(), expected.rowBytes(), &options));
+            REPORTER_ASSERT(r, SkCodec::kSuccess == indexed->getAndroidPixels(
+                    info, actual.getPixels(), actual.rowBytes(), &options));
+            REPORTER_ASSERT(r, 0 == memcmp(expected.getPixels(), actual.getPixels(),
+                                           expected.computeByteSize()));
+        }
+    }
+
+    // Images without restart markers can't be indexed.
+    sk_sp<SkData> mandrill = GetResourceAsData("images/mandrill_512_q075.jpg");
+    REPORTER_ASSERT(r, !SkCodec::MakeFromData(mandrill)->makeRegionIndex());
+
+    // An index for another image is rejected, as is a damaged one.
+    std::unique_ptr<SkCodec> codec = SkCodec::MakeFromData(make_tall_jpeg(*gbr, 41));
+    REPORTER_ASSERT(r, !codec->setRegionIndex(*index));
+    REPORTER_ASSERT(r, codec->setRegionIndex(*codec->makeRegionIndex()));
+    REPORTER_ASSERT(r, !SkCodec::MakeFromData(mandrill)->setRegionIndex(*index));
+    codec = SkCodec::MakeFromData(data);
+    for (size_t i = 0; i < index->size(); i++) {
+        sk_sp<SkData> damaged = SkData::MakeWithCopy(index->data(), index->size());
+        ((uint8_t*) damaged->writable_data())[i] ^= 0x40;
+        REPORTER_ASSERT(r, !codec->setRegionIndex(*damaged));
+    }
+    REPORTER_ASSERT(r, !codec->setRegionIndex(*SkData::MakeSubset(index.get(), 0,
+                                                                   index->size() - 4)));
+}
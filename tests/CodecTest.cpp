@@ -1040,6 +1040,62 @@ DEF_TEST(Codec_ColorXform, r) {
     check_color_xform(r, "images/mandrill_512.png");
 }
 
+// 8-bit RGB pngs are color transformed straight from the decoded rows, like RGBA pngs.  Both
+// should give the same pixels, with or without sampling.
+DEF_TEST(Codec_PngRGBColorXform, r) {
+    SkBitmap src;
+    if (!GetResourceAsBitmap("images/mandrill_512.png", &src)) {
+        return;
+    }
+    src.setImmutable();
+
+    auto encode = [](const SkPixmap& pixmap) {
+        SkDynamicMemoryWStream stream;
+        SkAssertResult(SkPngEncoder::Encode(&stream, pixmap, SkPngEncoder::Options()));
+        return stream.detachAsData();
+    };
+    SkPixmap pixmap;
+    SkAssertResult(src.peekPixels(&pixmap));
+    SkPixmap opaque(pixmap.info().makeAlphaType(kOpaque_SkAlphaType).makeColorSpace(nullptr),
+                    pixmap.addr(), pixmap.rowBytes());
+    SkPixmap unpremul(pixmap.info().makeAlphaType(kUnpremul_SkAlphaType).makeColorSpace(nullptr),
+                      pixmap.addr(), pixmap.rowBytes());
+    auto rgb = SkAndroidCodec::MakeFromData(encode(opaque));
+    auto rgba = SkAndroidCodec::MakeFromData(encode(unpremul));
+    REPORTER_ASSERT(r, rgb->getInfo().isOpaque() && !rgba->getInfo().isOpaque());
+
+    const SkIRect subset = SkIRect::MakeXYWH(33, 17, 301, 200);
+    const sk_sp<SkColorSpace> colorSpaces[] = {
+        SkColorSpace::MakeSRGBLinear(),
+        SkColorSpace::MakeRGB(SkNamedTransferFn::kSRGB, SkNamedGamut::kDCIP3),
+    };
+    for (const SkIRect* s : { (const SkIRect*) nullptr, &subset }) {
+        for (int sampleSize : { 1, 3 }) {
+            SkIRect bounds = s ? *s : SkIRect::MakeSize(rgb->getInfo().dimensions());
+            SkAndroidCodec::AndroidOptions options;
+            options.fSampleSize = sampleSize;
+            options.fSubset = s ? &bounds : nullptr;
+            const SkISize size = rgb->getSampledSubsetDimensions(sampleSize, bounds);
+
+            for (const sk_sp<SkColorSpace>& cs : colorSpaces) {
+                for (SkColorType ct : { kN32_SkColorType, kRGBA_F16_SkColorType }) {
+                    SkImageInfo info = SkImageInfo::Make(size.width(), size.height(), ct,
+                                                         kPremul_SkAlphaType, cs);
+                    SkBitmap expected, actual;
+                    expected.allocPixels(info);
+                    actual.allocPixels(info);
+                    REPORTER_ASSERT(r, SkCodec::kSuccess == rgba->getAndroidPixels(
+                            info, expected.getPixels(), expected.rowBytes(), &options));
+                    REPORTER_ASSERT(r, SkCodec::kSuccess == rgb->getAndroidPixels(
+                            info, actual.getPixels(), actual.rowBytes(), &options));
+                    REPORTER_ASSERT(r, 0 == memcmp(expected.getPixels(), actual.getPixels(),
+                                                   expected.computeByteSize()));
+                }
+            }
+        }
+    }
+}
+
 static bool color_type_match(SkColorType origColorType, SkColorType codecColorType) {
     switch (origColorType) {
         case kRGBA_8888_SkColorType:
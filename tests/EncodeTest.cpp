@@ -9,8 +9,10 @@
 #include "Test.h"
 
 #include "SkBitmap.h"
+#include "SkCodec.h"
 #include "SkColorPriv.h"
 #include "SkEncodedImageFormat.h"
+#include "SkExecutor.h"
 #include "SkImage.h"
 #include "SkJpegEncoder.h"
 #include "SkPngEncoder.h"
@@ -99,6 +101,71 @@ DEF_TEST(Encode, r) {
     test_encode(r, SkEncodedImageFormat::kPNG);
 }
 
+// An encoder made from an SkImageInfo, and given the rows in bands, should write the same image
+// as one given all of the pixels up front.
+static void test_encode_streaming(skiatest::Reporter* r, SkEncodedImageFormat format) {
+    SkBitmap bitmap;
+    if (!GetResourceAsBitmap("images/mandrill_128.png", &bitmap)) {
+        return;
+    }
+    const SkPixmap& src = bitmap.pixmap();
+
+    auto make_streaming = [format](SkWStream* dst, const SkImageInfo& info)
+            -> std::unique_ptr<SkEncoder> {
+        switch (format) {
+            case SkEncodedImageFormat::kJPEG:
+                return SkJpegEncoder::Make(dst, info, SkJpegEncoder::Options());
+            case SkEncodedImageFormat::kPNG:
+                return SkPngEncoder::Make(dst, info, SkPngEncoder::Options());
+            default:
+                return nullptr;
+        }
+    };
+
+    SkDynamicMemoryWStream expected;
+    REPORTER_ASSERT(r, encode(format, &expected, src));
+    sk_sp<SkData> expectedData = expected.detachAsData();
+
+    for (int bandHeight : { 1, 7, 64, 200 }) {
+        SkDynamicMemoryWStream dst;
+        auto encoder = make_streaming(&dst, src.info());
+        REPORTER_ASSERT(r, encoder);
+        if (!encoder) {
+            return;
+        }
+
+        // There are no pixels to encode rows from.
+        REPORTER_ASSERT(r, !encoder->encodeRows(1));
+
+        for (int y = 0; y < src.height(); y += bandHeight) {
+            SkPixmap band;
+            const int height = SkTMin(bandHeight, src.height() - y);
+            REPORTER_ASSERT(r, src.extractSubset(&band,
+                                                 SkIRect::MakeXYWH(0, y, src.width(), height)));
+            REPORTER_ASSERT(r, encoder->encodeRows(band));
+        }
+        sk_sp<SkData> data = dst.detachAsData();
+        REPORTER_ASSERT(r, data->equals(expectedData.get()));
+    }
+
+    // Rows that don't match the image are rejected.
+    SkDynamicMemoryWStream dst;
+    auto encoder = make_streaming(&dst, src.info());
+    SkPixmap narrow;
+    REPORTER_ASSERT(r, src.extractSubset(&narrow, SkIRect::MakeWH(src.width() - 1, 8)));
+    REPORTER_ASSERT(r, !encoder->encodeRows(narrow));
+    SkPixmap wrongType(src.info().makeColorType(kRGB_565_SkColorType), src.addr(),
+                       src.rowBytes());
+    REPORTER_ASSERT(r, !encoder->encodeRows(wrongType));
+
+    REPORTER_ASSERT(r, !make_streaming(&dst, SkImageInfo::MakeN32Premul(0, 10)));
+}
+
+DEF_TEST(Encode_streaming, r) {
+    test_encode_streaming(r, SkEncodedImageFormat::kJPEG);
+    test_encode_streaming(r, SkEncodedImageFormat::kPNG);
+}
+
 static inline bool almost_equals(SkPMColor a, SkPMColor b, int tolerance) {
     if (SkTAbs((int)SkGetPackedR32(a) - (int)SkGetPackedR32(b)) > tolerance) {
         return false;
@@ -291,6 +358,88 @@ DEF_TEST(Encode_PngOptions, r) {
     REPORTER_ASSERT(r, almost_equals(bm0, bm2, 0));
 }
 
+static SkBitmap decode_png(skiatest::Reporter* r, sk_sp<SkData> data) {
+    SkBitmap bitmap;
+    std::unique_ptr<SkCodec> codec = SkCodec::MakeFromData(std::move(data));
+    REPORTER_ASSERT(r, codec);
+    if (codec) {
+        bitmap.allocPixels(codec->getInfo());
+        REPORTER_ASSERT(r, SkCodec::kSuccess ==
+                           codec->getPixels(bitmap.info(), bitmap.getPixels(), bitmap.rowBytes()));
+    }
+    return bitmap;
+}
+
+// A png compressed on an executor is not the same bytes as one compressed by libpng, but it
+// should decode to the same pixels, and be about the same size.
+DEF_TEST(Encode_PngExecutor, r) {
+    SkBitmap mandrill;
+    if (!GetResourceAsBitmap("images/mandrill_512.png", &mandrill)) {
+        return;
+    }
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(4);
+
+    const SkImageInfo infos[] = {
+        mandrill.info().makeColorType(kRGBA_8888_SkColorType).makeAlphaType(kUnpremul_SkAlphaType),
+        mandrill.info().makeColorType(kRGBA_8888_SkColorType).makeAlphaType(kOpaque_SkAlphaType),
+        mandrill.info().makeColorType(kRGBA_F16_SkColorType).makeAlphaType(kOpaque_SkAlphaType),
+        mandrill.info().makeColorType(kRGBA_F16_SkColorType).makeAlphaType(kUnpremul_SkAlphaType),
+        mandrill.info().makeColorType(kGray_8_SkColorType).makeAlphaType(kOpaque_SkAlphaType),
+    };
+    const SkPngEncoder::FilterFlag filters[] = {
+        SkPngEncoder::FilterFlag::kAll,
+        SkPngEncoder::FilterFlag::kZero,
+        SkPngEncoder::FilterFlag::kPaeth,
+        SkPngEncoder::FilterFlag::kSub | SkPngEncoder::FilterFlag::kAvg,
+    };
+    for (const SkImageInfo& info : infos) {
+        SkBitmap src;
+        src.allocPixels(info);
+        REPORTER_ASSERT(r, mandrill.readPixels(src.pixmap()));
+
+        for (SkPngEncoder::FilterFlag filter : filters) {
+            for (int zlibLevel : { 0, 6, 9 }) {
+                SkPngEncoder::Options options;
+                options.fFilterFlags = filter;
+                options.fZLibLevel = zlibLevel;
+                SkDynamicMemoryWStream serial;
+                REPORTER_ASSERT(r, SkPngEncoder::Encode(&serial, src.pixmap(), options));
+
+                options.fExecutor = executor.get();
+                SkDynamicMemoryWStream parallel;
+                REPORTER_ASSERT(r, SkPngEncoder::Encode(&parallel, src.pixmap(), options));
+
+                sk_sp<SkData> serialData = serial.detachAsData();
+                sk_sp<SkData> parallelData = parallel.detachAsData();
+                REPORTER_ASSERT(r, parallelData->size() <
+                                   serialData->size() * 101 / 100 + 1024);
+
+                SkBitmap expected = decode_png(r, serialData);
+                SkBitmap actual = decode_png(r, parallelData);
+                REPORTER_ASSERT(r, expected.info() == actual.info());
+                REPORTER_ASSERT(r, expected.computeByteSize() == actual.computeByteSize() &&
+                                   0 == memcmp(expected.getPixels(), actual.getPixels(),
+                                               expected.computeByteSize()));
+            }
+        }
+    }
+
+    // Rows streamed in bands are compressed the same way.
+    SkPngEncoder::Options options;
+    options.fExecutor = executor.get();
+    SkDynamicMemoryWStream whole, bands;
+    REPORTER_ASSERT(r, SkPngEncoder::Encode(&whole, mandrill.pixmap(), options));
+    auto encoder = SkPngEncoder::Make(&bands, mandrill.info(), options);
+    for (int y = 0; y < mandrill.height(); y += 100) {
+        SkPixmap band;
+        mandrill.pixmap().extractSubset(&band, SkIRect::MakeXYWH(0, y, mandrill.width(), 100));
+        REPORTER_ASSERT(r, encoder->encodeRows(band));
+    }
+    sk_sp<SkData> wholeData = whole.detachAsData();
+    sk_sp<SkData> bandsData = bands.detachAsData();
+    REPORTER_ASSERT(r, wholeData->equals(bandsData.get()));
+}
+
 #ifndef SK_BUILD_FOR_GOOGLE3
 DEF_TEST(Encode_WebpQuality, r) {
     SkBitmap bm;
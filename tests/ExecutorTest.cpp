@@ -0,0 +1,53 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkExecutor.h"
+#include "SkTaskGroup.h"
+#include "Test.h"
+#include <atomic>
+
+static void test_executor(skiatest::Reporter* r, SkExecutor& executor) {
+    std::atomic<int> count{0};
+
+    SkTaskGroup group(executor);
+    for (int i = 0; i < 100; i++) {
+        group.add([&] { count++; });
+    }
+    // Nested groups add work from the pool's own threads, and wait() by borrowing.
+    group.batch(100, [&](int) {
+        SkTaskGroup inner(executor);
+        inner.batch(10, [&](int) { count++; });
+        inner.add([&] { count++; });
+        inner.wait();
+    });
+    group.wait();
+
+    REPORTER_ASSERT(r, count.load() == 100 + 100 * 11);
+}
+
+DEF_TEST(SkExecutor_ThreadPools, r) {
+    test_executor(r, *SkExecutor::MakeFIFOThreadPool(4));
+    test_executor(r, *SkExecutor::MakeLIFOThreadPool(4));
+    test_executor(r, *SkExecutor::MakeWorkStealingPool(4));
+    test_executor(r, *SkExecutor::MakeWorkStealingPool(1));
+}
+
+DEF_TEST(SkExecutor_Batch, r) {
+    auto pool = SkExecutor::MakeWorkStealingPool(3);
+
+    std::atomic<int> seen[64];
+    for (auto& s : seen) {
+        s = 0;
+    }
+    SkTaskGroup group(*pool);
+    group.batch(64, [&](int i) { seen[i]++; });
+    group.wait();
+
+    for (auto& s : seen) {
+        REPORTER_ASSERT(r, s.load() == 1);
+    }
+}
@@ -0,0 +1,231 @@
+/*
+ * Copyright 2019 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkTypes.h"
+
+#include "GrContextFactory.h"
+#include "GrContextPriv.h"
+#include "GrProgramDesc.h"
+#include "SkCanvas.h"
+#include "SkGradientShader.h"
+#include "SkSLCompiler.h"
+#include "SkSLUtil.h"
+#include "SkSurface.h"
+#include "Test.h"
+#include "gl/GrGLGpu.h"
+#include "gl/GrGLPrecompiler.h"
+
+using sk_gpu_test::GrContextFactory;
+
+namespace {
+class TestDesc : public GrProgramDesc {
+public:
+    explicit TestDesc(uint32_t value) {
+        this->key().push_back_n(sizeof(value), reinterpret_cast<const uint8_t*>(&value));
+    }
+    explicit TestDesc(const SkString& key) {
+        this->key().push_back_n(key.size(), reinterpret_cast<const uint8_t*>(key.c_str()));
+    }
+};
+}
+
+static const char* kVS = "void main() { sk_Position = float4(1); }";
+static const char* kFS = "void main() { sk_FragColor = half4(half(sk_FragCoord.y)); }";
+
+DEF_TEST(GrGLPrecompiler_RoundTrip, reporter) {
+    sk_sp<GrShaderCaps> caps = SkSL::ShaderCapsFactory::Default();
+    SkSL::String sksl[kGrShaderTypeCount];
+    sksl[kVertex_GrShaderType] = kVS;
+    sksl[kFragment_GrShaderType] = kFS;
+
+    SkSL::Program::Settings settings;
+    settings.fCaps = caps.get();
+    TestDesc descA(1), descB(2), descC(3);
+
+    GrGLPrecompiler recorder(caps.get(), nullptr, true);
+    REPORTER_ASSERT(reporter, !recorder.dump());
+    recorder.record(descA, settings, sksl);
+    settings.fFlipY = true;
+    recorder.record(descB, settings, sksl);
+    recorder.record(descA, settings, sksl);  // already recorded, ignored
+    sk_sp<SkData> data = recorder.dump();
+    REPORTER_ASSERT(reporter, data);
+
+    SkTArray<GrGLPrecompiler::Entry> entries;
+    REPORTER_ASSERT(reporter, GrGLPrecompiler::Parse(*data, &entries));
+    REPORTER_ASSERT(reporter, 2 == entries.count());
+    REPORTER_ASSERT(reporter, !(entries[0].fFlags & GrGLPrecompiler::Entry::kFlipY_Flag));
+    REPORTER_ASSERT(reporter, entries[1].fFlags & GrGLPrecompiler::Entry::kFlipY_Flag);
+
+    // A precompiler that isn't recording ignores record().
+    GrGLPrecompiler precompiler(caps.get(), nullptr, false);
+    precompiler.record(descC, settings, sksl);
+    REPORTER_ASSERT(reporter, !precompiler.dump());
+
+    REPORTER_ASSERT(reporter, precompiler.precompile(*data));
+    precompiler.wait();
+    SkSL::Compiler compiler;
+    for (const TestDesc* desc : {&descA, &descB}) {
+        const GrGLPrecompiler::Program* program = precompiler.find(*desc);
+        REPORTER_ASSERT(reporter, program);
+        if (!program) {
+            continue;
+        }
+        GrGLPrecompiler::Program expected;
+        REPORTER_ASSERT(reporter, GrGLPrecompiler::Compile(&compiler, caps.get(),
+                                                           entries[desc == &descA ? 0 : 1],
+                                                           &expected));
+        for (int i = 0; i < kGrShaderTypeCount; ++i) {
+            REPORTER_ASSERT(reporter, program->fGLSL[i] == expected.fGLSL[i]);
+        }
+        REPORTER_ASSERT(reporter, program->fInputs.fRTHeight == expected.fInputs.fRTHeight);
+    }
+    REPORTER_ASSERT(reporter, !precompiler.find(descC));
+
+    // Programs only match the SkSL and settings they were compiled from.
+    SkSL::Program::Settings settingsA;
+    settingsA.fCaps = caps.get();
+    const GrGLPrecompiler::Program* programA = precompiler.find(descA);
+    if (programA) {
+        REPORTER_ASSERT(reporter, programA->matches(settingsA, sksl));
+        REPORTER_ASSERT(reporter, !programA->matches(settings, sksl));
+        SkSL::String other[kGrShaderTypeCount];
+        other[kVertex_GrShaderType] = kVS;
+        other[kFragment_GrShaderType] = "void main() { sk_FragColor = half4(1); }";
+        REPORTER_ASSERT(reporter, !programA->matches(settingsA, other));
+    }
+
+    // Truncated or foreign data is rejected without scheduling anything.
+    sk_sp<SkData> truncated = SkData::MakeSubset(data.get(), 0, data->size() - 1);
+    REPORTER_ASSERT(reporter, !precompiler.precompile(*truncated));
+    sk_sp<SkData> garbage = SkData::MakeWithCString("not a program dump");
+    REPORTER_ASSERT(reporter, !precompiler.precompile(*garbage));
+}
+
+static bool draw_and_read(GrContext* context, SkBitmap* bitmap) {
+    SkImageInfo info = SkImageInfo::MakeN32Premul(64, 64);
+    sk_sp<SkSurface> surface = SkSurface::MakeRenderTarget(context, SkBudgeted::kNo, info);
+    if (!surface) {
+        return false;
+    }
+    SkCanvas* canvas = surface->getCanvas();
+    canvas->clear(SK_ColorWHITE);
+    SkPoint pts[] = {{0, 0}, {64, 64}};
+    SkColor colors[] = {SK_ColorRED, SK_ColorBLUE};
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    paint.setShader(SkGradientShader::MakeLinear(pts, colors, nullptr, 2,
+                                                 SkShader::kClamp_TileMode));
+    canvas->drawCircle(32, 32, 24, paint);
+    paint.setShader(nullptr);
+    paint.setColor(SK_ColorGREEN);
+    canvas->drawRect(SkRect::MakeXYWH(4, 4, 8, 8), paint);
+    bitmap->allocPixels(info);
+    return surface->readPixels(*bitmap, 0, 0);
+}
+
+DEF_GPUTEST(GrGLPrecompiler_Context, reporter, options) {
+    for (int i = 0; i < GrContextFactory::kContextTypeCnt; ++i) {
+        GrContextFactory::ContextType type = static_cast<GrContextFactory::ContextType>(i);
+        if (GrContextFactory::ContextTypeBackend(type) != GrBackendApi::kOpenGL ||
+            !GrContextFactory::IsRenderingContext(type)) {
+            continue;
+        }
+
+        GrContextOptions recordOptions = options;
+        recordOptions.fRecordProgramsForPrecompile = true;
+        GrContextFactory recordFactory(recordOptions);
+        GrContext* recordContext = recordFactory.get(type);
+        SkBitmap expected;
+        if (!recordContext || !draw_and_read(recordContext, &expected)) {
+            continue;
+        }
+        sk_sp<SkData> programs = recordContext->dumpRecordedPrograms();
+        REPORTER_ASSERT(reporter, programs);
+        if (!programs) {
+            continue;
+        }
+
+        GrContextFactory factory(options);
+        GrContext* context = factory.get(type);
+        if (!context) {
+            continue;
+        }
+        REPORTER_ASSERT(reporter, context->precompile(*programs));
+        static_cast<GrGLGpu*>(context->priv().getGpu())->precompiler()->wait();
+        REPORTER_ASSERT(reporter, !context->dumpRecordedPrograms());
+
+        SkBitmap actual;
+        REPORTER_ASSERT(reporter, draw_and_read(context, &actual));
+        REPORTER_ASSERT(reporter, 0 == memcmp(expected.getPixels(), actual.getPixels(),
+                                              expected.computeByteSize()));
+    }
+}
+
+// A dump whose SkSL doesn't match what the context generates for the same GrProgramDesc, as from
+// another build of Skia, must not change what's drawn.
+DEF_GPUTEST(GrGLPrecompiler_MismatchedDump, reporter, options) {
+    for (int i = 0; i < GrContextFactory::kContextTypeCnt; ++i) {
+        GrContextFactory::ContextType type = static_cast<GrContextFactory::ContextType>(i);
+        if (GrContextFactory::ContextTypeBackend(type) != GrBackendApi::kOpenGL ||
+            !GrContextFactory::IsRenderingContext(type)) {
+            continue;
+        }
+
+        GrContextOptions recordOptions = options;
+        recordOptions.fRecordProgramsForPrecompile = true;
+        GrContextFactory recordFactory(recordOptions);
+        GrContext* recordContext = recordFactory.get(type);
+        SkBitmap expected;
+        if (!recordContext || !draw_and_read(recordContext, &expected)) {
+            continue;
+        }
+        sk_sp<SkData> programs = recordContext->dumpRecordedPrograms();
+        SkTArray<GrGLPrecompiler::Entry> entries;
+        REPORTER_ASSERT(reporter, programs && GrGLPrecompiler::Parse(*programs, &entries));
+
+        // Keep every key and its settings, but give each one a different fragment shader.
+        sk_sp<GrShaderCaps> caps = SkSL::ShaderCapsFactory::Default();
+        GrGLPrecompiler recorder(caps.get(), nullptr, true);
+        for (const GrGLPrecompiler::Entry& entry : entries) {
+            SkSL::Program::Settings settings;
+            settings.fFlipY = entry.fFlags & GrGLPrecompiler::Entry::kFlipY_Flag;
+            settings.fSharpenTextures =
+                    entry.fFlags & GrGLPrecompiler::Entry::kSharpenTextures_Flag;
+            settings.fFragColorIsInOut =
+                    entry.fFlags & GrGLPrecompiler::Entry::kFragColorIsInOut_Flag;
+            settings.fForceHighPrecision =
+                    entry.fFlags & GrGLPrecompiler::Entry::kForceHighPrecision_Flag;
+            SkSL::String sksl[kGrShaderTypeCount];
+            for (int j = 0; j < kGrShaderTypeCount; ++j) {
+                sksl[j] = entry.fSkSL[j];
+            }
+            sksl[kFragment_GrShaderType] = kFS;
+            recorder.record(TestDesc(entry.fKey), settings, sksl);
+        }
+        sk_sp<SkData> mismatched = recorder.dump();
+        REPORTER_ASSERT(reporter, mismatched);
+        if (!mismatched) {
+            continue;
+        }
+
+        GrContextFactory factory(options);
+        GrContext* context = factory.get(type);
+        if (!context) {
+            continue;
+        }
+        GrGLPrecompiler* precompiler =
+                static_cast<GrGLGpu*>(context->priv().getGpu())->precompiler();
+        REPORTER_ASSERT(reporter, context->precompile(*mismatched));
+        precompiler->wait();
+
+        SkBitmap actual;
+        REPORTER_ASSERT(reporter, draw_and_read(context, &actual));
+        REPORTER_ASSERT(reporter, 0 == memcmp(expected.getPixels(), actual.getPixels(),
+                                              expected.computeByteSize()));
+    }
+}
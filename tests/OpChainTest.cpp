@@ -13,6 +13,8 @@
 #include "Test.h"
 #include "ops/GrOp.h"
 
+#include <functional>
+
 // We create Ops that write a value into a range of a buffer. We create ranges from
 // kNumOpPositions starting positions x kRanges canonical ranges. We repeat each range kNumRepeats
 // times (with a different value written by each of the repeats).
@@ -238,3 +240,179 @@ DEF_GPUTEST(OpChainTest, reporter, /*ctxInfo*/) {
         }
     }
 }
+
+namespace {
+/**
+ * An op that writes a value into a range of a buffer, like TestOp, but whose bounds are just its
+ * range. Ops of the same class merge when they both allow it; ops of different classes never
+ * combine. Counts how many times chains of them execute.
+ */
+template <int kClass> class FillOp : public GrOp {
+public:
+    DEFINE_OP_CLASS_ID
+
+    static std::unique_ptr<GrOp> Make(GrContext* context, int value, const Range& range,
+                                      bool canMerge, int result[], int* numExecutions) {
+        GrOpMemoryPool* pool = context->priv().opMemoryPool();
+        return pool->allocate<FillOp>(value, range, canMerge, result, numExecutions);
+    }
+
+    const char* name() const override { return "FillOp"; }
+
+private:
+    friend class ::GrOpMemoryPool;  // for ctor
+
+    FillOp(int value, const Range& range, bool canMerge, int result[], int* numExecutions)
+            : INHERITED(ClassID())
+            , fCanMerge(canMerge)
+            , fResult(result)
+            , fNumExecutions(numExecutions) {
+        fValueRanges.push_back({value, range});
+        this->setBounds(SkRect::MakeXYWH(range.fOffset, 0, range.fLength, 1),
+                        HasAABloat::kNo, IsZeroArea::kNo);
+    }
+
+    void onPrepare(GrOpFlushState*) override {}
+
+    void onExecute(GrOpFlushState*, const SkRect& chainBounds) override {
+        ++*fNumExecutions;
+        for (const auto& op : ChainRange<FillOp>(this)) {
+            for (const auto& vr : op.fValueRanges) {
+                std::fill_n(fResult + vr.fRange.fOffset, vr.fRange.fLength, vr.fValue);
+            }
+        }
+    }
+
+    CombineResult onCombineIfPossible(GrOp* t, const GrCaps&) override {
+        auto that = t->cast<FillOp>();
+        if (!fCanMerge || !that->fCanMerge) {
+            return CombineResult::kCannotCombine;
+        }
+        std::move(that->fValueRanges.begin(), that->fValueRanges.end(),
+                  std::back_inserter(fValueRanges));
+        return CombineResult::kMerged;
+    }
+
+    struct ValueRange {
+        int fValue;
+        Range fRange;
+    };
+    std::vector<ValueRange> fValueRanges;
+    bool fCanMerge;
+    int* fResult;
+    int* fNumExecutions;
+
+    typedef GrOp INHERITED;
+};
+}  // namespace
+
+/**
+ * Tests that ops combine with the chains of their class however far back they were recorded, as
+ * long as no chain they overlap was recorded after them, and that painter's order is kept when
+ * ops of several classes are spread across a target wide enough to need several cells of the op
+ * list's chain index.
+ */
+DEF_GPUTEST(OpChainIndexTest, reporter, /*ctxInfo*/) {
+    auto context = GrContext::MakeMock(nullptr);
+    SkASSERT(context);
+    static constexpr int kWidth = 1024;
+    GrSurfaceDesc desc;
+    desc.fConfig = kRGBA_8888_GrPixelConfig;
+    desc.fWidth = kWidth;
+    desc.fHeight = 1;
+    desc.fFlags = kRenderTarget_GrSurfaceFlag;
+
+    const GrBackendFormat format =
+            context->priv().caps()->getBackendFormatFromColorType(kRGBA_8888_SkColorType);
+
+    auto proxy = context->priv().proxyProvider()->createProxy(
+            format, desc, kTopLeft_GrSurfaceOrigin, GrMipMapped::kNo, SkBackingFit::kExact,
+            SkBudgeted::kNo, GrInternalSurfaceFlags::kNone);
+    SkASSERT(proxy);
+    proxy->instantiate(context->priv().resourceProvider());
+    const GrCaps& caps = *context->priv().caps();
+
+    int result[kWidth];
+    int validResult[kWidth];
+    int numExecutions;
+    // Records ops made by 'addOps' and executes them, into 'result'.
+    auto run = [&](const std::function<void(GrRenderTargetOpList*)>& addOps) {
+        std::fill_n(result, kWidth, -1);
+        std::fill_n(validResult, kWidth, -1);
+        numExecutions = 0;
+        GrTokenTracker tracker;
+        GrOpFlushState flushState(context->priv().getGpu(), context->priv().resourceProvider(),
+                                  &tracker);
+        GrRenderTargetOpList opList(context->priv().resourceProvider(),
+                                    sk_ref_sp(context->priv().opMemoryPool()),
+                                    proxy->asRenderTargetProxy(), context->priv().auditTrail());
+        addOps(&opList);
+        opList.makeClosed(caps);
+        opList.prepare(&flushState);
+        opList.execute(&flushState);
+        opList.endFlush();
+    };
+    auto add = [&](GrRenderTargetOpList* opList, std::unique_ptr<GrOp> op, int value,
+                   const Range& range) {
+        std::fill_n(validResult + range.fOffset, range.fLength, value);
+        opList->addOp(std::move(op), caps);
+    };
+
+    // Two ops of one class merge across many chains of another class that they don't overlap.
+    static constexpr int kNumBetween = 40;
+    run([&](GrRenderTargetOpList* opList) {
+        add(opList, FillOp<0>::Make(context.get(), 0, {0, 1}, true, result, &numExecutions), 0,
+            {0, 1});
+        for (int i = 1; i <= kNumBetween; ++i) {
+            Range range = {2u * i, 1};
+            add(opList, FillOp<1>::Make(context.get(), i, range, false, result, &numExecutions),
+                i, range);
+        }
+        add(opList, FillOp<0>::Make(context.get(), kNumBetween + 1, {kWidth - 1, 1}, true, result,
+                                    &numExecutions),
+            kNumBetween + 1, {kWidth - 1, 1});
+    });
+    REPORTER_ASSERT(reporter, std::equal(result, result + kWidth, validResult));
+    REPORTER_ASSERT(reporter, numExecutions == kNumBetween + 1);
+
+    // ... but not when an op of the other class between them overlaps both of them.
+    run([&](GrRenderTargetOpList* opList) {
+        add(opList, FillOp<0>::Make(context.get(), 0, {495, 10}, true, result, &numExecutions), 0,
+            {495, 10});
+        add(opList, FillOp<1>::Make(context.get(), 1, {500, 10}, false, result, &numExecutions),
+            1, {500, 10});
+        add(opList, FillOp<0>::Make(context.get(), 2, {505, 1}, true, result, &numExecutions), 2,
+            {505, 1});
+    });
+    REPORTER_ASSERT(reporter, std::equal(result, result + kWidth, validResult));
+    REPORTER_ASSERT(reporter, numExecutions == 3);
+
+    SkRandom random;
+    static constexpr int kNumOps = 300;
+    for (int t = 0; t < 50; ++t) {
+        run([&](GrRenderTargetOpList* opList) {
+            for (int i = 0; i < kNumOps; ++i) {
+                unsigned length = 1 + random.nextULessThan(64);
+                Range range = {random.nextULessThan(kWidth - length + 1), length};
+                bool canMerge = random.nextBool();
+                std::unique_ptr<GrOp> op;
+                switch (random.nextULessThan(3)) {
+                    case 0:
+                        op = FillOp<0>::Make(context.get(), i, range, canMerge, result,
+                                             &numExecutions);
+                        break;
+                    case 1:
+                        op = FillOp<1>::Make(context.get(), i, range, canMerge, result,
+                                             &numExecutions);
+                        break;
+                    default:
+                        op = FillOp<2>::Make(context.get(), i, range, canMerge, result,
+                                             &numExecutions);
+                        break;
+                }
+                add(opList, std::move(op), i, range);
+            }
+        });
+        REPORTER_ASSERT(reporter, std::equal(result, result + kWidth, validResult));
+    }
+}
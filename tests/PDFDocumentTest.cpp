@@ -8,6 +8,7 @@
 
 #include "Resources.h"
 #include "SkCanvas.h"
+#include "SkColorPriv.h"
 #include "SkExecutor.h"
 #include "SkOSFile.h"
 #include "SkOSPath.h"
@@ -256,3 +257,101 @@ DEF_TEST(SkPDF_abort_jobs, rep) {
     doc->abort();
 }
 
+
+static std::vector<SkBitmap> make_test_bitmaps() {
+    std::vector<SkBitmap> bitmaps(11);
+    SkBitmap& opaque = bitmaps[0];
+    SkBitmap& translucent = bitmaps[1];
+    SkBitmap& opaqueUnpremul = bitmaps[2];
+    opaque.allocN32Pixels(100, 80, true);
+    translucent.allocN32Pixels(90, 70);
+    opaqueUnpremul.allocPixels(SkImageInfo::MakeN32(60, 50, kUnpremul_SkAlphaType));
+    for (int y = 0; y < 80; ++y) {
+        for (int x = 0; x < 100; ++x) {
+            *opaque.getAddr32(x, y) = SkPackARGB32(0xFF, x, y, x ^ y);
+            if (x < 90 && y < 70) {
+                *translucent.getAddr32(x, y) = SkPreMultiplyARGB(x + y, x, y, 0x80);
+            }
+            if (x < 60 && y < 50) {
+                *opaqueUnpremul.getAddr32(x, y) = SkPackARGB32NoCheck(0xFF, y, x, 0x40);
+            }
+        }
+    }
+    // A distinct image for each page.
+    for (int i = 0; i < 8; ++i) {
+        bitmaps[3 + i].allocN32Pixels(30 + i, 20);
+        bitmaps[3 + i].eraseColor(SkColorSetARGB(0xFF * (i & 1), 0x10 * i, 0, 0xFF));
+    }
+    return bitmaps;
+}
+
+static sk_sp<SkData> make_test_document(const std::vector<SkBitmap>& bitmaps,
+                                        SkExecutor* executor,
+                                        SkPDF::ResourceCache* cache) {
+    SkPDF::Metadata metadata;
+    metadata.fExecutor = executor;
+    metadata.fResourceCache = cache;
+    SkDynamicMemoryWStream stream;
+    auto doc = SkPDF::MakeDocument(&stream, metadata);
+    for (int i = 0; i < 8; ++i) {
+        SkCanvas* canvas = doc->beginPage(612, 792);
+        canvas->drawColor(SkColorSetARGB(0xFF, 0x20 * i, 0xFF - 0x20 * i, 0x80));
+        canvas->drawBitmap(bitmaps[0], 10, 10);
+        canvas->drawBitmap(bitmaps[1], 120, 10);
+        canvas->drawBitmap(bitmaps[2], 220, 10);
+        canvas->drawBitmap(bitmaps[3 + i], 300, 10);
+        canvas->drawString("Deterministic output", 10, 200, SkFont(nullptr, 12 + i), SkPaint());
+        doc->endPage();
+    }
+    doc->close();
+    return stream.detachAsData();
+}
+
+// Work done on an executor should not change what is written, or where.
+DEF_TEST(SkPDF_executor_output, r) {
+    REQUIRE_PDF_DOCUMENT(SkPDF_executor_output, r);
+    std::vector<SkBitmap> bitmaps = make_test_bitmaps();
+    sk_sp<SkData> serial = make_test_document(bitmaps, nullptr, nullptr);
+    // The unpremul bitmap's pixels are opaque, so no soft mask is reserved for it and left null.
+    REPORTER_ASSERT(r, !contains(serial->bytes(), serial->size(), " 0 obj\nnull"));
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(4);
+    for (int i = 0; i < 3; ++i) {
+        sk_sp<SkData> threaded = make_test_document(bitmaps, executor.get(), nullptr);
+        REPORTER_ASSERT(r, serial->equals(threaded.get()));
+    }
+}
+
+// Documents sharing a resource cache should come out the same as those without one.
+DEF_TEST(SkPDF_resource_cache, r) {
+    REQUIRE_PDF_DOCUMENT(SkPDF_resource_cache, r);
+    std::vector<SkBitmap> bitmaps = make_test_bitmaps();
+    sk_sp<SkData> uncached = make_test_document(bitmaps, nullptr, nullptr);
+
+    SkPDF::ResourceCache cache(1 << 20);
+    REPORTER_ASSERT(r, cache.bytesUsed() == 0);
+    sk_sp<SkData> first = make_test_document(bitmaps, nullptr, &cache);
+    REPORTER_ASSERT(r, uncached->equals(first.get()));
+    const size_t bytesUsed = cache.bytesUsed();
+    REPORTER_ASSERT(r, bytesUsed > 0);
+
+    // Everything the second document needs is already cached.
+    sk_sp<SkData> second = make_test_document(bitmaps, nullptr, &cache);
+    REPORTER_ASSERT(r, uncached->equals(second.get()));
+    REPORTER_ASSERT(r, cache.bytesUsed() == bytesUsed);
+
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(4);
+    sk_sp<SkData> threaded = make_test_document(bitmaps, executor.get(), &cache);
+    REPORTER_ASSERT(r, uncached->equals(threaded.get()));
+
+    cache.purgeAll();
+    REPORTER_ASSERT(r, cache.bytesUsed() == 0);
+
+    // A cache too small to hold everything drops what it can't fit.
+    SkPDF::ResourceCache small(bytesUsed / 2);
+    for (int i = 0; i < 2; ++i) {
+        sk_sp<SkData> evicting = make_test_document(bitmaps, nullptr, &small);
+        REPORTER_ASSERT(r, uncached->equals(evicting.get()));
+        REPORTER_ASSERT(r, small.bytesUsed() > 0);
+        REPORTER_ASSERT(r, small.bytesUsed() <= bytesUsed / 2);
+    }
+}
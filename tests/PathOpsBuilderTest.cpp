@@ -8,6 +8,8 @@
 #include "PathOpsExtendedTest.h"
 #include "PathOpsTestCommon.h"
 #include "SkBitmap.h"
+#include "SkExecutor.h"
+#include "SkRandom.h"
 #include "Test.h"
 
 DEF_TEST(PathOpsBuilder, reporter) {
@@ -361,3 +363,46 @@ SkOpBuilder builder;
     builder.add(path1, SkPathOp::kUnion_SkPathOp);
     builder.resolve(&path);
 }
+
+// Unioning in a tree of ops covers the same area as unioning one path at a time, with or
+// without an executor. Anything but a union is resolved one op at a time.
+DEF_TEST(SkOpBuilderTree, reporter) {
+    SkRandom rand;
+    SkPath paths[13];
+    for (SkPath& path : paths) {
+        const SkScalar x = rand.nextRangeScalar(0, 80);
+        const SkScalar y = rand.nextRangeScalar(0, 80);
+        const SkPath::Direction dir = rand.nextBool() ? SkPath::kCW_Direction
+                                                      : SkPath::kCCW_Direction;
+        if (rand.nextBool()) {
+            path.addOval({x, y, x + 30, y + 20}, dir);
+        } else {
+            path.addRect({x, y, x + 20, y + 30}, dir);
+        }
+    }
+    SkOpBuilder builder;
+    for (const SkPath& path : paths) {
+        builder.add(path, kUnion_SkPathOp);
+    }
+    SkPath expected;
+    REPORTER_ASSERT(reporter, builder.resolve(&expected));
+
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(2);
+    for (SkExecutor* e : { (SkExecutor*) nullptr, executor.get() }) {
+        for (const SkPath& path : paths) {
+            builder.add(path, kUnion_SkPathOp);
+        }
+        SkPath result;
+        REPORTER_ASSERT(reporter, builder.resolve(&result, e));
+        REPORTER_ASSERT(reporter, !comparePaths(reporter, __FUNCTION__, expected, result));
+    }
+
+    builder.add(paths[0], kUnion_SkPathOp);
+    builder.add(paths[1], kDifference_SkPathOp);
+    builder.add(paths[2], kUnion_SkPathOp);
+    SkPath result;
+    REPORTER_ASSERT(reporter, builder.resolve(&result, executor.get()));
+    REPORTER_ASSERT(reporter, Op(paths[0], paths[1], kDifference_SkPathOp, &expected));
+    REPORTER_ASSERT(reporter, Op(expected, paths[2], kUnion_SkPathOp, &expected));
+    REPORTER_ASSERT(reporter, expected == result);
+}
@@ -5,6 +5,7 @@
  * found in the LICENSE file.
  */
 #include "PathOpsExtendedTest.h"
+#include "SkRandom.h"
 
 #define TEST(name) { name, #name }
 
@@ -9357,11 +9358,34 @@ static void bug8290(skiatest::Reporter* reporter, const char* filename) {
     testSimplify(reporter, path, filename);
 }
 
+// Overlapping contours with enough segments that their intersections are found by sweeping.
+static void manySegments(skiatest::Reporter* reporter, const char* filename) {
+    SkRandom rand;
+    SkPath path;
+    for (int contour = 0; contour < 3; ++contour) {
+        const SkScalar cx = 100 + contour * 40;
+        for (int i = 0; i < 120; ++i) {
+            const SkScalar angle = i * 2 * SK_ScalarPI / 120;
+            const SkScalar radius = 50 + rand.nextRangeScalar(0, 20);
+            const SkPoint pt = {cx + radius * SkScalarCos(angle),
+                                100 + radius * SkScalarSin(angle)};
+            if (i) {
+                path.lineTo(pt);
+            } else {
+                path.moveTo(pt);
+            }
+        }
+        path.close();
+    }
+    testSimplify(reporter, path, filename);
+}
+
 static void (*skipTest)(skiatest::Reporter* , const char* filename) = nullptr;
 static void (*firstTest)(skiatest::Reporter* , const char* filename) = nullptr;
 static void (*stopTest)(skiatest::Reporter* , const char* filename) = nullptr;
 
 static TestDesc tests[] = {
+    TEST(manySegments),
     TEST(bug8290),
     TEST(bug8249),
     TEST(grshapearc),
@@ -14,12 +14,17 @@
 #include "SkClipOpPriv.h"
 #include "SkColor.h"
 #include "SkData.h"
+#include "SkEndian.h"
+#include "SkExecutor.h"
+#include "SkFont.h"
 #include "SkFontStyle.h"
+#include "SkImage.h"
 #include "SkImageInfo.h"
 #include "SkMatrix.h"
 #include "SkMiniRecorder.h"
 #include "SkPaint.h"
 #include "SkPath.h"
+#include "SkPictureData.h"
 #include "SkPicturePriv.h"
 #include "SkPictureRecorder.h"
 #include "SkPixelRef.h"
@@ -28,10 +33,14 @@
 #include "SkRectPriv.h"
 #include "SkRefCnt.h"
 #include "SkScalar.h"
+#include "SkSerialProcs.h"
 #include "SkShader.h"
 #include "SkStream.h"
+#include "SkSurface.h"
+#include "SkTextBlob.h"
 #include "SkTypeface.h"
 #include "SkTypes.h"
+#include "SkVertices.h"
 #include "Test.h"
 
 #include <memory>
@@ -879,3 +888,343 @@ DEF_TEST(Picture_empty_serial, reporter) {
     REPORTER_ASSERT(reporter, pic2);
 }
 
+
+// Drawing a picture's tiles with playbackParallel() should match playing it back into each tile
+// in turn, whether or not it was recorded with a bounding box hierarchy.
+DEF_TEST(Picture_playbackParallel, r) {
+    const int kSize = 256, kTile = 64;
+    const int kTilesPerRow = kSize / kTile;
+    const int kTileCount = kTilesPerRow * kTilesPerRow;
+
+    auto executor = SkExecutor::MakeFIFOThreadPool(4);
+    SkRTreeFactory factory;
+    for (SkBBHFactory* bbh : {(SkBBHFactory*)nullptr, (SkBBHFactory*)&factory}) {
+        SkPictureRecorder recorder;
+        SkCanvas* canvas = recorder.beginRecording(SkRect::MakeIWH(kSize, kSize), bbh);
+        SkPaint paint;
+        SkRandom rand;
+        for (int i = 0; i < 50; i++) {
+            paint.setColor(rand.nextU() | 0xFF000000);
+            SkRect rect = SkRect::MakeXYWH(SkIntToScalar(rand.nextULessThan(kSize)),
+                                           SkIntToScalar(rand.nextULessThan(kSize)),
+                                           SkIntToScalar(rand.nextRangeU(1, 80)),
+                                           SkIntToScalar(rand.nextRangeU(1, 80)));
+            switch (i % 4) {
+                case 0:
+                    canvas->drawRect(rect, paint);
+                    break;
+                case 1:
+                    canvas->save();
+                    canvas->clipRect(rect.makeOutset(-4, -4));
+                    canvas->drawOval(rect, paint);
+                    canvas->restore();
+                    break;
+                case 2:
+                    canvas->saveLayerAlpha(&rect, 0x80);
+                    canvas->drawPaint(paint);
+                    canvas->restore();
+                    break;
+                case 3:
+                    canvas->save();
+                    canvas->translate(rect.left(), rect.top());
+                    canvas->drawCircle(0, 0, 20, paint);
+                    canvas->restore();
+                    break;
+            }
+        }
+        sk_sp<SkPicture> pic = recorder.finishRecordingAsPicture();
+
+        auto make_tiles = [&](sk_sp<SkSurface> tiles[]) {
+            for (int i = 0; i < kTileCount; i++) {
+                tiles[i] = SkSurface::MakeRaster(SkImageInfo::MakeN32Premul(kTile, kTile));
+                tiles[i]->getCanvas()->clear(SK_ColorWHITE);
+                tiles[i]->getCanvas()->translate(-SkIntToScalar(i % kTilesPerRow * kTile),
+                                                 -SkIntToScalar(i / kTilesPerRow * kTile));
+            }
+        };
+
+        sk_sp<SkSurface> expected[kTileCount], actual[kTileCount];
+        make_tiles(expected);
+        for (int i = 0; i < kTileCount; i++) {
+            pic->playback(expected[i]->getCanvas());
+        }
+        make_tiles(actual);
+        pic->playbackParallel(kTileCount, [&](int i) { return actual[i]->getCanvas(); },
+                              executor.get());
+
+        int mismatches = 0;
+        for (int i = 0; i < kTileCount; i++) {
+            SkPixmap expectedPixels, actualPixels;
+            REPORTER_ASSERT(r, expected[i]->peekPixels(&expectedPixels));
+            REPORTER_ASSERT(r, actual[i]->peekPixels(&actualPixels));
+            for (int y = 0; y < kTile; y++) {
+                if (0 != memcmp(expectedPixels.addr32(0, y), actualPixels.addr32(0, y),
+                                kTile * sizeof(uint32_t))) {
+                    mismatches++;
+                }
+            }
+        }
+        REPORTER_ASSERT(r, mismatches == 0, "%d mismatched rows", mismatches);
+    }
+}
+
+static sk_sp<SkImage> make_checker_image(SkColor color) {
+    SkBitmap bm;
+    bm.allocN32Pixels(16, 16);
+    bm.eraseColor(color);
+    bm.erase(SK_ColorBLACK, SkIRect::MakeWH(8, 8));
+    bm.setImmutable();
+    return SkImage::MakeFromBitmap(bm);
+}
+
+// Draws each of the payloads a lazy picture defers, once inside and once outside the clip.
+static void draw_lazy_payloads(SkCanvas* canvas, SkScalar x, SkScalar y, SkColor color) {
+    SkPaint paint;
+    paint.setColor(color);
+    canvas->drawImage(make_checker_image(color), x, y);
+    canvas->drawImageRect(make_checker_image(color), SkRect::MakeXYWH(x + 20, y, 32, 32), &paint);
+    canvas->drawTextBlob(SkTextBlob::MakeFromString("lazy", SkFont(nullptr, 12)), x, y + 50,
+                         paint);
+    const SkPoint pts[] = { {x, y + 60}, {x + 40, y + 60}, {x, y + 90} };
+    canvas->drawVertices(SkVertices::MakeCopy(SkVertices::kTriangles_VertexMode, 3, pts,
+                                              nullptr, nullptr),
+                         SkBlendMode::kSrcOver, paint);
+}
+
+// A lazily loaded picture should draw just like one that was decoded up front, but only decode
+// the images it actually draws.
+DEF_TEST(Picture_lazy, r) {
+    SkPictureRecorder recorder;
+    SkCanvas* canvas = recorder.beginRecording(SkRect::MakeWH(400, 100));
+    draw_lazy_payloads(canvas, 10, 0, SK_ColorBLUE);
+    draw_lazy_payloads(canvas, 210, 0, SK_ColorRED);
+    {
+        SkPictureRecorder nested;
+        draw_lazy_payloads(nested.beginRecording(SkRect::MakeWH(400, 100)), 110, 0,
+                           SK_ColorGREEN);
+        draw_lazy_payloads(nested.getRecordingCanvas(), 310, 0, SK_ColorYELLOW);
+        canvas->drawPicture(nested.finishRecordingAsPicture());
+    }
+    sk_sp<SkData> data = recorder.finishRecordingAsPicture()->serialize();
+
+    int decodedImages = 0;
+    SkDeserialProcs procs;
+    procs.fImageProc = [](const void*, size_t, void* ctx) -> sk_sp<SkImage> {
+        ++*static_cast<int*>(ctx);
+        return nullptr;  // Fall back to the default decoder.
+    };
+    procs.fImageCtx = &decodedImages;
+
+    sk_sp<SkPicture> eager = SkPicture::MakeFromData(data.get(), &procs);
+    REPORTER_ASSERT(r, eager && decodedImages == 8);
+
+    decodedImages = 0;
+    sk_sp<SkPicture> lazy = SkPicture::MakeLazyFromData(data, &procs);
+    REPORTER_ASSERT(r, lazy && decodedImages == 0);
+    if (!eager || !lazy) {
+        return;
+    }
+    REPORTER_ASSERT(r, lazy->cullRect() == eager->cullRect());
+
+    auto draw = [](const SkPicture* pic, const SkRect& clip) {
+        auto surface = SkSurface::MakeRasterN32Premul(400, 100);
+        surface->getCanvas()->clear(SK_ColorWHITE);
+        surface->getCanvas()->clipRect(clip);
+        surface->getCanvas()->drawPicture(pic);
+        SkBitmap bm;
+        bm.allocN32Pixels(400, 100);
+        surface->readPixels(bm, 0, 0);
+        return bm;
+    };
+    auto same_pixels = [](const SkBitmap& a, const SkBitmap& b) {
+        return 0 == memcmp(a.getPixels(), b.getPixels(), a.computeByteSize());
+    };
+
+    // Only the blue and green images are inside this clip.
+    const SkRect left = SkRect::MakeWH(200, 100);
+    REPORTER_ASSERT(r, same_pixels(draw(lazy.get(), left), draw(eager.get(), left)));
+    REPORTER_ASSERT(r, decodedImages == 4);
+
+    const SkRect all = SkRect::MakeWH(400, 100);
+    REPORTER_ASSERT(r, same_pixels(draw(lazy.get(), all), draw(eager.get(), all)));
+    REPORTER_ASSERT(r, decodedImages == 8);
+
+    // Serializing a lazy picture keeps everything, even what it hasn't drawn.
+    sk_sp<SkPicture> lazyLeft = SkPicture::MakeLazyFromData(data);
+    REPORTER_ASSERT(r, same_pixels(draw(lazyLeft.get(), left), draw(eager.get(), left)));
+    sk_sp<SkPicture> copy = SkPicture::MakeFromData(lazyLeft->serialize().get());
+    REPORTER_ASSERT(r, copy && same_pixels(draw(copy.get(), all), draw(eager.get(), all)));
+
+    // Truncated data should fail to load, not crash.
+    for (size_t size : { data->size() / 2, data->size() - 8 }) {
+        REPORTER_ASSERT(r, !SkPicture::MakeLazyFromData(SkData::MakeSubset(data.get(), 0, size)));
+    }
+}
+
+// A picture loaded from serializeMappable() should draw like the original without decoding
+// anything up front, and damaged data should be rejected when it's loaded.
+DEF_TEST(Picture_mapped, r) {
+    SkPictureRecorder recorder;
+    SkCanvas* canvas = recorder.beginRecording(SkRect::MakeWH(400, 100));
+    draw_lazy_payloads(canvas, 10, 0, SK_ColorBLUE);
+    draw_lazy_payloads(canvas, 210, 0, SK_ColorRED);
+    {
+        SkPaint stroke;
+        stroke.setStyle(SkPaint::kStroke_Style);
+        stroke.setStrokeWidth(3);
+        canvas->drawPath(SkPath().moveTo(5, 95).cubicTo(100, 0, 300, 100, 395, 5), stroke);
+    }
+    {
+        SkPictureRecorder nested;
+        draw_lazy_payloads(nested.beginRecording(SkRect::MakeWH(400, 100)), 110, 0,
+                           SK_ColorGREEN);
+        draw_lazy_payloads(nested.getRecordingCanvas(), 310, 0, SK_ColorYELLOW);
+        canvas->drawPicture(nested.finishRecordingAsPicture());
+    }
+    sk_sp<SkPicture> original = recorder.finishRecordingAsPicture();
+    sk_sp<SkData> data = original->serializeMappable();
+
+    int decodedImages = 0;
+    SkDeserialProcs procs;
+    procs.fImageProc = [](const void*, size_t, void* ctx) -> sk_sp<SkImage> {
+        ++*static_cast<int*>(ctx);
+        return nullptr;  // Fall back to the default decoder.
+    };
+    procs.fImageCtx = &decodedImages;
+
+    sk_sp<SkPicture> mapped = SkPicture::MakeLazyFromData(data, &procs);
+    REPORTER_ASSERT(r, mapped && decodedImages == 0);
+    if (!mapped) {
+        return;
+    }
+    REPORTER_ASSERT(r, mapped->cullRect() == original->cullRect());
+    REPORTER_ASSERT(r, mapped->approximateOpCount() > 0);
+
+    auto draw = [](const SkPicture* pic, const SkRect& clip) {
+        auto surface = SkSurface::MakeRasterN32Premul(400, 100);
+        surface->getCanvas()->clear(SK_ColorWHITE);
+        surface->getCanvas()->clipRect(clip);
+        surface->getCanvas()->drawPicture(pic);
+        SkBitmap bm;
+        bm.allocN32Pixels(400, 100);
+        surface->readPixels(bm, 0, 0);
+        return bm;
+    };
+    auto same_pixels = [](const SkBitmap& a, const SkBitmap& b) {
+        return 0 == memcmp(a.getPixels(), b.getPixels(), a.computeByteSize());
+    };
+
+    // Only the blue and green images are inside this clip.
+    const SkRect left = SkRect::MakeWH(200, 100);
+    REPORTER_ASSERT(r, same_pixels(draw(mapped.get(), left), draw(original.get(), left)));
+    REPORTER_ASSERT(r, decodedImages == 4);
+
+    const SkRect all = SkRect::MakeWH(400, 100);
+    REPORTER_ASSERT(r, same_pixels(draw(mapped.get(), all), draw(original.get(), all)));
+    REPORTER_ASSERT(r, decodedImages == 8);
+
+    // Mapped pictures can be serialized again, either way.
+    sk_sp<SkPicture> copy = SkPicture::MakeFromData(mapped->serialize().get());
+    REPORTER_ASSERT(r, copy && same_pixels(draw(copy.get(), all), draw(original.get(), all)));
+    copy = SkPicture::MakeLazyFromData(mapped->serializeMappable());
+    REPORTER_ASSERT(r, copy && same_pixels(draw(copy.get(), all), draw(original.get(), all)));
+
+    // Data that isn't 4-byte aligned is copied.
+    {
+        sk_sp<SkData> padded = SkData::MakeUninitialized(data->size() + 1);
+        memcpy(padded->writable_data() + 1, data->data(), data->size());
+        copy = SkPicture::MakeLazyFromData(SkData::MakeSubset(padded.get(), 1, data->size()));
+        REPORTER_ASSERT(r, copy && same_pixels(draw(copy.get(), all), draw(original.get(), all)));
+    }
+
+    // Truncated data should fail to load, not crash.
+    for (size_t size : { (size_t)16, data->size() / 2, data->size() - 4 }) {
+        REPORTER_ASSERT(r, !SkPicture::MakeLazyFromData(SkData::MakeSubset(data.get(), 0, size)));
+    }
+
+    // Data written with the other byte order is rejected up front.
+    {
+        sk_sp<SkData> swapped = SkData::MakeWithCopy(data->data(), data->size());
+        uint32_t* byteOrder = reinterpret_cast<uint32_t*>(swapped->writable_data()) + 9;
+        REPORTER_ASSERT(r, *byteOrder == 0x01020304);
+        *byteOrder = SkEndianSwap32(*byteOrder);
+        REPORTER_ASSERT(r, !SkPicture::MakeLazyFromData(swapped));
+    }
+
+    // Damaged headers, sections and tables are caught when loading.  Damaged objects are only
+    // caught when they're decoded, so those pictures load, but must still draw safely.
+    for (size_t i = 8; i < data->size(); i += 4) {
+        sk_sp<SkData> damaged = SkData::MakeWithCopy(data->data(), data->size());
+        uint32_t* word = reinterpret_cast<uint32_t*>(damaged->writable_data()) + i / 4;
+        *word ^= 0x80000001;
+        if (sk_sp<SkPicture> pic = SkPicture::MakeLazyFromData(damaged)) {
+            draw(pic.get(), all);
+        }
+    }
+}
+
+// Sub-pictures in the mappable layout are checked recursively when loading, so they may neither
+// share bytes nor nest without limit.
+DEF_TEST(Picture_mapped_subpictures, r) {
+    // Every picture records two ops, so that SkCanvas refs it rather than unrolling it.
+    auto record = [](SkColor color, const SkPicture* sub) {
+        SkPictureRecorder recorder;
+        SkCanvas* canvas = recorder.beginRecording(SkRect::MakeWH(10, 10));
+        if (sub) {
+            canvas->drawPicture(sub);
+        } else {
+            canvas->drawColor(color);
+        }
+        SkPaint paint;
+        paint.setColor(color);
+        canvas->drawRect(SkRect::MakeWH(5, 5), paint);
+        return recorder.finishRecordingAsPicture();
+    };
+    auto nest = [&](int depth) {
+        sk_sp<SkPicture> pic = record(SK_ColorRED, nullptr);
+        for (int i = 0; i < depth; i++) {
+            pic = record(SK_ColorBLUE, pic.get());
+        }
+        return pic->serializeMappable();
+    };
+    REPORTER_ASSERT(r, SkPicture::MakeLazyFromData(nest(SkPictureData::kMaxMappedDepth)));
+    REPORTER_ASSERT(r, !SkPicture::MakeLazyFromData(nest(SkPictureData::kMaxMappedDepth + 1)));
+
+    SkPictureRecorder recorder;
+    SkCanvas* canvas = recorder.beginRecording(SkRect::MakeWH(10, 10));
+    for (SkColor color : { SK_ColorRED, SK_ColorBLUE }) {
+        canvas->drawPicture(record(color, nullptr));
+    }
+    sk_sp<SkData> data = recorder.finishRecordingAsPicture()->serializeMappable();
+    REPORTER_ASSERT(r, SkPicture::MakeLazyFromData(data));
+
+    // Find the picture table: a 40 byte header, then sections of {tag, count, offset, size}, and
+    // entries of {offset, size, bounds}.
+    const uint32_t* words = static_cast<const uint32_t*>(data->data());
+    const uint32_t sectionCount = words[8];
+    uint32_t table = 0;
+    for (uint32_t i = 0; i < sectionCount; i++) {
+        const uint32_t* section = words + 10 + 4 * i;
+        if (section[0] == SK_PICT_PICTURE_TAG) {
+            REPORTER_ASSERT(r, section[1] == 2);
+            table = section[2];
+        }
+    }
+    REPORTER_ASSERT(r, table != 0);
+    if (!table) {
+        return;
+    }
+
+    auto damage = [&](uint32_t secondOffset, uint32_t secondSize) {
+        sk_sp<SkData> damaged = SkData::MakeWithCopy(data->data(), data->size());
+        uint32_t* entries = static_cast<uint32_t*>(damaged->writable_data()) + table / 4;
+        entries[6] = secondOffset;
+        entries[7] = secondSize;
+        return damaged;
+    };
+    const uint32_t* entries = words + table / 4;
+    // The second entry repeating the first...
+    REPORTER_ASSERT(r, !SkPicture::MakeLazyFromData(damage(entries[0], entries[1])));
+    // ... or overlapping its end is rejected.
+    REPORTER_ASSERT(r, !SkPicture::MakeLazyFromData(damage(entries[6] - 8, entries[7] + 8)));
+}
@@ -5,7 +5,9 @@
  * found in the LICENSE file.
  */
 
+#include "SkArenaAlloc.h"
 #include "SkHalf.h"
+#include "SkMatrix.h"
 #include "SkRasterPipeline.h"
 #include "SkTo.h"
 #include "Test.h"
@@ -202,3 +204,169 @@ DEF_TEST(SkRasterPipeline_lowp_clamp01, r) {
     p.append(SkRasterPipeline::store_8888, &ptr);
     p.run(0,0,1,1);
 }
+
+DEF_TEST(SkRasterPipeline_lowp_bilinear, r) {
+    // Lowp bilinear sampling rounds its weights to 1/16 of a pixel, as SkBitmapProcState does,
+    // so it only matches highp to within that: each weight may be off by 1/32, on both axes.
+    const int kTolerance = 255/16 + 1;
+
+    uint32_t src[4*4];
+    for (int i = 0; i < 16; i++) {
+        src[i] = 0xff000000 | ((i*31) & 0xff) << 16 | ((i*97) & 0xff) << 8 | ((i*53) & 0xff);
+    }
+    SkRasterPipeline_GatherCtx gather = { src, 4, 4.0f, 4.0f };
+    SkRasterPipeline_TileCtx   limit  = { 4.0f, 0.25f };
+
+    SkMatrix matrix = SkMatrix::MakeScale(0.37f, 0.41f);
+    matrix.postTranslate(0.3f, 0.2f);
+
+    uint32_t dst[2][37*5];
+    for (int highp = 0; highp < 2; highp++) {
+        SkSTArenaAlloc<256> alloc;
+        SkRasterPipeline_SamplerCtx sampler;
+        SkRasterPipeline_MemoryCtx dstCtx = { dst[highp], 37 };
+        float scratch[4*SkRasterPipeline_kMaxStride];
+
+        SkRasterPipeline p(&alloc);
+        p.append(SkRasterPipeline::seed_shader);
+        p.append_matrix(&alloc, matrix);
+        p.append(SkRasterPipeline::save_xy, &sampler);
+        for (auto x : { SkRasterPipeline::bilinear_nx, SkRasterPipeline::bilinear_px })
+        for (auto y : { SkRasterPipeline::bilinear_ny, SkRasterPipeline::bilinear_py }) {
+            p.append(x, &sampler);
+            p.append(y, &sampler);
+            p.append(SkRasterPipeline::repeat_x, &limit);
+            p.append(SkRasterPipeline::repeat_y, &limit);
+            p.append(SkRasterPipeline::gather_8888, &gather);
+            p.append(SkRasterPipeline::accumulate, &sampler);
+        }
+        p.append(SkRasterPipeline::move_dst_src);
+        if (highp) {
+            p.append(SkRasterPipeline::store_src, scratch);  // There's no lowp store_src.
+        }
+        p.append(SkRasterPipeline::store_8888, &dstCtx);
+        p.run(0,0, 37,5);
+    }
+
+    for (int i = 0; i < 37*5; i++) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            int lowp  = (dst[0][i] >> shift) & 0xff,
+                highp = (dst[1][i] >> shift) & 0xff;
+            if (abs(lowp - highp) > kTolerance) {
+                ERRORF(r, "pixel %d: got %08x in lowp, want %08x\n", i, dst[0][i], dst[1][i]);
+                break;
+            }
+        }
+    }
+}
+
+// Whether or not LLVM is built in, the JIT caches stage lists as it sees them, and anything it
+// hasn't fused still runs through SkOpts.
+DEF_TEST(SkRasterPipeline_JIT_cache, r) {
+    bool wasEnabled = SkRasterPipelineJIT::Enabled();
+    SkRasterPipelineJIT::PurgeAll();
+    SkRasterPipelineJIT::SetEnabled(true);
+
+    // This runs too few times for the JIT to compile it, so it always falls back to SkOpts.
+    uint32_t src[5] = { 0xff000000, 0x80402010, 0x01020304, 0xffffffff, 0x12345678 },
+             dst[5];
+    SkRasterPipeline_MemoryCtx srcCtx = { src, 0 },
+                               dstCtx = { dst, 0 };
+    for (int loop = 0; loop < 3; loop++) {
+        memset(dst, 0, sizeof(dst));
+        SkRasterPipeline_<256> p;
+        p.append(SkRasterPipeline::load_8888,  &srcCtx);
+        p.append(SkRasterPipeline::swap_rb);
+        p.append(SkRasterPipeline::store_8888, &dstCtx);
+        p.compile()(0,0, 5,1);
+        for (int i = 0; i < 5; i++) {
+            uint32_t want = (src[i] & 0xff00ff00) | (src[i] & 0xff) << 16 | (src[i] >> 16 & 0xff);
+            REPORTER_ASSERT(r, dst[i] == want);
+        }
+    }
+
+    // Each stage is keyed along with whether it has a context.
+    const uint32_t ops[] = {
+        SkRasterPipeline::load_8888  << 1 | 1,
+        SkRasterPipeline::swap_rb    << 1 | 0,
+        SkRasterPipeline::store_8888 << 1 | 1,
+    };
+    REPORTER_ASSERT(r, SkRasterPipelineJIT::SeenCount(ops, 3) == 3);
+    const uint32_t withCtx[] = { ops[0], ops[1] | 1, ops[2] };
+    REPORTER_ASSERT(r, SkRasterPipelineJIT::SeenCount(withCtx, 3) == 0);
+    REPORTER_ASSERT(r, !SkRasterPipelineJIT::Find(withCtx, 3));
+    REPORTER_ASSERT(r, SkRasterPipelineJIT::SeenCount(withCtx, 3) == 1);
+    REPORTER_ASSERT(r, SkRasterPipelineJIT::SeenCount(ops, 2) == 0);
+    REPORTER_ASSERT(r, SkRasterPipelineJIT::SeenCount(ops, 3) == 3);
+
+    // While the JIT is off, lookups find and count nothing.
+    SkRasterPipelineJIT::SetEnabled(false);
+    REPORTER_ASSERT(r, !SkRasterPipelineJIT::Find(ops, 3));
+    REPORTER_ASSERT(r, SkRasterPipelineJIT::SeenCount(ops, 3) == 3);
+    SkRasterPipelineJIT::SetEnabled(true);
+
+    // The least recently used stage lists make room for new ones.
+    uint32_t other[] = { ops[0], ops[1], 0, ops[2] };
+    for (int i = 0; i < SkRasterPipelineJIT::kMaxPrograms; i++) {
+        other[2] = (uint32_t)i << 1;
+        SkRasterPipelineJIT::Find(other, 4);
+    }
+    REPORTER_ASSERT(r, SkRasterPipelineJIT::SeenCount(other, 4) == 1);
+    REPORTER_ASSERT(r, SkRasterPipelineJIT::SeenCount(withCtx, 3) == 0);
+    REPORTER_ASSERT(r, SkRasterPipelineJIT::SeenCount(ops, 3) == 0);
+
+    SkRasterPipelineJIT::PurgeAll();
+    REPORTER_ASSERT(r, SkRasterPipelineJIT::SeenCount(other, 4) == 0);
+    SkRasterPipelineJIT::SetEnabled(wasEnabled);
+}
+
+#ifdef SK_LLVM_AVAILABLE
+
+DEF_TEST(SkRasterPipeline_JIT_fused, r) {
+    // Fused programs should match the SkOpts stages, including in the tail of each row.  SkOpts
+    // may run this pipeline in lowp, so we allow off-by-one rounding.
+    uint32_t src[3*37], cov8[3*37], dst[2][3*37];
+    for (int i = 0; i < 3*37; i++) {
+        uint32_t a = (i * 7) & 0xff;
+        src[i] = a << 24 | (a/2) << 16 | (a/3) << 8 | (a/4);
+        cov8[i] = 0x01010101 * ((i * 13) & 0xff);
+    }
+
+    bool wasEnabled = SkRasterPipelineJIT::Enabled();
+    for (int jit = 0; jit < 2; jit++) {
+        SkRasterPipelineJIT::SetEnabled(jit);
+        // Run it enough times for the JIT to decide it's worth compiling.
+        for (int loop = 0; loop < 16; loop++) {
+            for (int i = 0; i < 3*37; i++) {
+                dst[jit][i] = 0xff000000 | (i * 0x010305);
+            }
+
+            SkRasterPipeline_MemoryCtx srcCtx = { src,  37 },
+                                       covCtx = { cov8, 37*4 },
+                                       dstCtx = { dst[jit], 37 };
+            SkRasterPipeline_<256> p;
+            p.append(SkRasterPipeline::load_8888,     &srcCtx);
+            p.append(SkRasterPipeline::swap_rb);
+            p.append(SkRasterPipeline::scale_u8,      &covCtx);
+            p.append(SkRasterPipeline::load_8888_dst, &dstCtx);
+            p.append(SkRasterPipeline::srcover);
+            p.append(SkRasterPipeline::store_8888,    &dstCtx);
+            // Only compile() uses the JIT.
+            p.compile()(1,0, 35,3);
+        }
+    }
+    SkRasterPipelineJIT::SetEnabled(wasEnabled);
+
+    for (int i = 0; i < 3*37; i++) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            int want = (dst[0][i] >> shift) & 0xff,
+                got  = (dst[1][i] >> shift) & 0xff;
+            if (abs(want - got) > 1) {
+                ERRORF(r, "pixel %d: got %08x from the JIT, want %08x\n", i, dst[1][i], dst[0][i]);
+                break;
+            }
+        }
+    }
+}
+
+#endif
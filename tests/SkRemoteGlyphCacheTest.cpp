@@ -846,3 +846,42 @@ DEF_TEST(SkRemoteGlyphCache_ReWriteGlyph, reporter) {
     // Must unlock everything on termination, otherwise valgrind complains about memory leaks.
     discardableManager->unlockAndDeleteAll();
 }
+
+// A client fills in exclusive strikes, so a cache it's using must not hand out shared ones.
+DEF_TEST(SkRemoteGlyphCache_NoSharedStrikesWithClient, reporter) {
+    sk_sp<DiscardableManager> discardableManager = sk_make_sp<DiscardableManager>();
+    SkStrikeServer server(discardableManager.get());
+    SkStrikeCache strikeCache;
+    strikeCache.setSharedStrikes(true);
+
+    auto isShared = [&](const SkTypeface* typeface) {
+        SkFont font;
+        font.setTypeface(sk_ref_sp(typeface));
+        SkPaint paint;
+        SkAutoDescriptor ad;
+        SkScalerContextRec rec;
+        SkScalerContextEffects effects;
+        SkScalerContext::MakeRecAndEffects(
+                font, paint, SkSurfacePropsCopyOrDefault(nullptr), SkScalerContextFlags::kNone,
+                SkMatrix::I(), &rec, &effects);
+        auto desc = SkScalerContext::AutoDescriptorGivenRecAndEffects(rec, effects, &ad);
+        return strikeCache.findOrCreateStrikeExclusive(*desc, effects, *typeface)->isShared();
+    };
+
+    auto localTf = SkTypeface::MakeDefault();
+    sk_sp<SkTypeface> clientTf;
+    {
+        SkStrikeClient client(discardableManager, false, &strikeCache);
+        auto serverTfData = server.serializeTypeface(localTf.get());
+        clientTf = client.deserializeTypeface(serverTfData->data(), serverTfData->size());
+        REPORTER_ASSERT(reporter, clientTf);
+
+        // Only the client's own typefaces keep exclusive strikes.
+        REPORTER_ASSERT(reporter, !isShared(clientTf.get()));
+        REPORTER_ASSERT(reporter, isShared(localTf.get()));
+    }
+    REPORTER_ASSERT(reporter, isShared(localTf.get()));
+
+    // Must unlock everything on termination, otherwise valgrind complains about memory leaks.
+    discardableManager->unlockAndDeleteAll();
+}
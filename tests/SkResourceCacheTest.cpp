@@ -17,6 +17,7 @@
 #include "SkPictureRecorder.h"
 #include "SkResourceCache.h"
 #include "SkSurface.h"
+#include "SkTaskGroup.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////
 
@@ -291,3 +292,70 @@ DEF_TEST(ResourceCache_purge, reporter) {
         }
     }
 }
+
+static bool test_rec_visitor(const SkResourceCache::Rec& rec, void* context) {
+    *(int32_t*)context = static_cast<const TestRec&>(rec).fKey.fData;
+    return true;
+}
+
+DEF_TEST(ResourceCache_shards, reporter) {
+    int shards = SkResourceCache::GetShardCount() == 8 ? 4 : 8;
+    int prevShards = SkResourceCache::SetShardCount(shards);
+    REPORTER_ASSERT(reporter, SkResourceCache::GetShardCount() == shards);
+    SkResourceCache::PurgeAll();
+
+    const int kCount = 64;
+    int flags[kCount];
+    for (int i = 0; i < kCount; i++) {
+        flags[i] = 0;
+        auto rec = skstd::make_unique<TestRec>(0, i, &flags[i]);
+        rec->fCanBePurged = true;
+        SkResourceCache::Add(rec.release());
+        REPORTER_ASSERT(reporter, flags[i] & TestRec::kDidInstall);
+    }
+    REPORTER_ASSERT(reporter, SkResourceCache::GetTotalBytesUsed() >= kCount * 1024);
+
+    // Every rec should be found again, from any thread, whichever shard it landed in.
+    std::atomic<int> misses{0};
+    SkTaskGroup().batch(kCount, [&](int i) {
+        int32_t found = -1;
+        if (!SkResourceCache::Find(TestKey(0, i), test_rec_visitor, &found) || found != i) {
+            misses++;
+        }
+    });
+    REPORTER_ASSERT(reporter, misses == 0);
+
+    // Changing the shard count starts over.
+    SkResourceCache::SetShardCount(prevShards);
+    int32_t found = -1;
+    REPORTER_ASSERT(reporter, !SkResourceCache::Find(TestKey(0, 0), test_rec_visitor, &found));
+    REPORTER_ASSERT(reporter, SkResourceCache::GetShardCount() == prevShards);
+
+    // Recs added while another thread changes the count are either purged or put where Find()
+    // will look for them under the new count.
+    const int kRaceCount = 512;
+    std::vector<int> raceFlags(kRaceCount);
+    SkTaskGroup().batch(kRaceCount, [&](int i) {
+        if (i % 32 == 0) {
+            SkResourceCache::SetShardCount(i % 64 == 0 ? 3 : 5);
+        } else {
+            auto rec = skstd::make_unique<TestRec>(1, i, &raceFlags[i]);
+            rec->fCanBePurged = true;
+            SkResourceCache::Add(rec.release());
+        }
+    });
+    std::vector<int32_t> cached;
+    SkResourceCache::VisitAll([](const SkResourceCache::Rec& rec, void* context) {
+        if (rec.getKey().getNamespace() == &gTestNamespace && rec.getKey().getSharedID() == 1) {
+            auto cached = static_cast<std::vector<int32_t>*>(context);
+            cached->push_back(static_cast<const TestRec&>(rec).fKey.fData);
+        }
+    }, &cached);
+    for (int32_t data : cached) {
+        found = -1;
+        REPORTER_ASSERT(reporter,
+                        SkResourceCache::Find(TestKey(1, data), test_rec_visitor, &found));
+        REPORTER_ASSERT(reporter, found == data);
+    }
+    SkResourceCache::SetShardCount(prevShards);
+}
@@ -0,0 +1,351 @@
+/*
+ * Copyright 2019 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkSLByteCode.h"
+#include "SkSLCompiler.h"
+
+#include "Test.h"
+
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+// Not a multiple of ByteCode::kVecWidth, so every test also covers a partial batch.
+static constexpr int kCount = 19;
+
+static std::unique_ptr<SkSL::ByteCode> compile(skiatest::Reporter* r, SkSL::Compiler* compiler,
+                                               const char* src) {
+    SkSL::Program::Settings settings;
+    std::unique_ptr<SkSL::Program> program = compiler->convertProgram(
+                                                                 SkSL::Program::kPipelineStage_Kind,
+                                                                 SkSL::String(src), settings);
+    if (!program) {
+        ERRORF(r, "%s\n%s", src, compiler->errorText().c_str());
+        return nullptr;
+    }
+    std::unique_ptr<SkSL::ByteCode> byteCode = compiler->toByteCode(*program);
+    if (!byteCode) {
+        ERRORF(r, "%s\n%s", src, compiler->errorText().c_str());
+    }
+    return byteCode;
+}
+
+static void args(float* x, float* y) {
+    for (int i = 0; i < kCount; ++i) {
+        x[i] = (float) (i - 9) * 0.5f;
+        y[i] = (float) (i % 5 - 2);
+    }
+}
+
+static void test(skiatest::Reporter* r, const char* src,
+                 const std::function<float(float, float)>& expected) {
+    SkSL::Compiler compiler;
+    std::unique_ptr<SkSL::ByteCode> byteCode = compile(r, &compiler, src);
+    if (!byteCode) {
+        return;
+    }
+    const SkSL::ByteCode::Function* f = byteCode->getFunction("test");
+    REPORTER_ASSERT(r, f && 2 == f->fParameterCount && 1 == f->fReturnCount);
+    float in[2 * kCount], out[kCount];
+    args(in, in + kCount);
+    byteCode->run(*f, in, out, kCount);
+    for (int i = 0; i < kCount; ++i) {
+        float x = (float) (i - 9) * 0.5f, y = (float) (i % 5 - 2);
+        float want = expected(x, y);
+        if (!(std::fabs(out[i] - want) <= 1e-5f * std::max(1.0f, std::fabs(want)))) {
+            ERRORF(r, "%s\ntest(%g, %g): expected %g, got %g", src, x, y, want, out[i]);
+        }
+    }
+}
+
+static void test_int(skiatest::Reporter* r, const char* src,
+                     const std::function<int(int, int)>& expected) {
+    SkSL::Compiler compiler;
+    std::unique_ptr<SkSL::ByteCode> byteCode = compile(r, &compiler, src);
+    if (!byteCode) {
+        return;
+    }
+    const SkSL::ByteCode::Function* f = byteCode->getFunction("test");
+    REPORTER_ASSERT(r, f && 2 == f->fParameterCount && 1 == f->fReturnCount);
+    // Ints are passed through the float arguments as their bits.
+    int32_t in[2 * kCount], out[kCount];
+    for (int i = 0; i < kCount; ++i) {
+        in[i] = i - 9;
+        in[kCount + i] = i % 7 - 3;
+    }
+    byteCode->run(*f, (float*) in, (float*) out, kCount);
+    for (int i = 0; i < kCount; ++i) {
+        int want = expected(in[i], in[kCount + i]);
+        if (out[i] != want) {
+            ERRORF(r, "%s\ntest(%d, %d): expected %d, got %d", src, in[i], in[kCount + i], want,
+                   out[i]);
+        }
+    }
+}
+
+static void test_error(skiatest::Reporter* r, const char* src, const char* error) {
+    SkSL::Compiler compiler;
+    SkSL::Program::Settings settings;
+    std::unique_ptr<SkSL::Program> program = compiler.convertProgram(
+                                                                 SkSL::Program::kPipelineStage_Kind,
+                                                                 SkSL::String(src), settings);
+    REPORTER_ASSERT(r, program);
+    if (program) {
+        REPORTER_ASSERT(r, !compiler.toByteCode(*program));
+        SkSL::String text = compiler.errorText();
+        if (!strstr(text.c_str(), error)) {
+            ERRORF(r, "%s\nexpected error '%s', got '%s'", src, error, text.c_str());
+        }
+    }
+}
+
+DEF_TEST(SkSLByteCodeArithmetic, r) {
+    test(r, "float test(float x, float y) { return x + y; }",
+         [](float x, float y) { return x + y; });
+    test(r, "float test(float x, float y) { return x - y * 3; }",
+         [](float x, float y) { return x - y * 3; });
+    test(r, "float test(float x, float y) { x *= y; x /= 4; return -x; }",
+         [](float x, float y) { return -(x * y / 4); });
+    test(r, "float test(float x, float y) { return (float2(x) + float2(y, 1)).y; }",
+         [](float x, float y) { return x + 1; });
+    test(r, "float test(float x, float y) { float t = x; x = y; y = t; return x - y; }",
+         [](float x, float y) { return y - x; });
+    test(r, "float test(float x, float y) { return x++ + --y + x; }",
+         [](float x, float y) { return x + (y - 1) + (x + 1); });
+    test_int(r, "int test(int x, int y) { return x * y - x; }",
+             [](int x, int y) { return x * y - x; });
+    test_int(r, "int test(int x, int y) { return y != 0 ? x / y : 1000; }",
+             [](int x, int y) { return y ? x / y : 1000; });
+    test_int(r, "int test(int x, int y) { return y > 0 ? x % y : -x; }",
+             [](int x, int y) { return y > 0 ? x % y : -x; });
+    test_int(r, "int test(int x, int y) { return (x & 6) | (y ^ 1); }",
+             [](int x, int y) { return (x & 6) | (y ^ 1); });
+    test_int(r, "int test(int x, int y) { return int(float(x) * 0.5) + abs(y); }",
+             [](int x, int y) { return (int) ((float) x * 0.5f) + std::abs(y); });
+}
+
+DEF_TEST(SkSLByteCodeVectors, r) {
+    test(r, "float test(float x, float y) {"
+            "    float3 v = float3(x, y, 1);"
+            "    v.zx = v.xy * 2;"
+            "    v.y += v.z;"
+            "    return dot(v, float3(1, 10, 100));"
+            "}",
+         [](float x, float y) { return 2 * y + 10 * (y + 2 * x) + 100 * 2 * x; });
+    test(r, "float test(float x, float y) { float4 v = float4(float2(x, y).yx, 3, 4); "
+            "return v.x * 1000 + v.y * 100 + v[2] * 10 + v.w; }",
+         [](float x, float y) { return y * 1000 + x * 100 + 34; });
+    test(r, "float test(float x, float y) { return float2(x, y) == float2(x, 0) ? 1 : 0; }",
+         [](float x, float y) { return 0 == y ? 1 : 0; });
+    test(r, "float test(float x, float y) { return float3(x, y, 1) != float3(1, y, 1) ? 1 : 0; }",
+         [](float x, float y) { return x != 1 ? 1 : 0; });
+
+    // Vector parameters and return values take one register per component.
+    SkSL::Compiler compiler;
+    std::unique_ptr<SkSL::ByteCode> byteCode =
+            compile(r, &compiler, "float3 test(float2 p, inout float s) {"
+                                  "    s *= 2;"
+                                  "    return p.yxy * s;"
+                                  "}");
+    if (byteCode) {
+        const SkSL::ByteCode::Function* f = byteCode->getFunction("test");
+        REPORTER_ASSERT(r, f && 3 == f->fParameterCount && 3 == f->fReturnCount);
+        float in[3 * kCount], out[3 * kCount];
+        for (int i = 0; i < kCount; ++i) {
+            in[i] = (float) i;
+            in[kCount + i] = (float) -i;
+            in[2 * kCount + i] = 0.5f * i;
+        }
+        byteCode->run(*f, in, out, kCount);
+        for (int i = 0; i < kCount; ++i) {
+            float s = (float) i;
+            REPORTER_ASSERT(r, in[i] == i && in[kCount + i] == -i && in[2 * kCount + i] == s);
+            REPORTER_ASSERT(r, out[i] == -i * s);
+            REPORTER_ASSERT(r, out[kCount + i] == i * s);
+            REPORTER_ASSERT(r, out[2 * kCount + i] == -i * s);
+        }
+    }
+}
+
+DEF_TEST(SkSLByteCodeIf, r) {
+    test(r, "float test(float x, float y) {"
+            "    if (x > y) {"
+            "        return x - y;"
+            "    } else if (x == y) {"
+            "        x = 100;"
+            "    } else {"
+            "        y *= 2;"
+            "    }"
+            "    return x + y;"
+            "}",
+         [](float x, float y) { return x > y ? x - y : x == y ? 100 + y : x + 2 * y; });
+    test(r, "float test(float x, float y) { float z = 0; if (x < 0 && (z = 1) > 0) { z += 10; } "
+            "return z; }",
+         [](float x, float y) { return x < 0 ? 11 : 0; });
+    test(r, "float test(float x, float y) { float z = 5; if (x >= 0 || (z = y) > 0) { z += 10; } "
+            "return z; }",
+         [](float x, float y) { return x >= 0 ? 15 : y > 0 ? y + 10 : y; });
+    test(r, "float test(float x, float y) { bool b = x > 0; if (!b) { return -1; } return 1; }",
+         [](float x, float y) { return x > 0 ? 1 : -1; });
+    test(r, "float test(float x, float y) { return x > 0 ? (y > 0 ? 1 : 2) : 3; }",
+         [](float x, float y) { return x > 0 ? (y > 0 ? 1 : 2) : 3; });
+}
+
+DEF_TEST(SkSLByteCodeLoops, r) {
+    test(r, "float test(float x, float y) {"
+            "    float sum = 0;"
+            "    for (int i = 0; i < 10; ++i) {"
+            "        if (i == int(y) + 2) {"
+            "            continue;"
+            "        }"
+            "        if (float(i) > x) {"
+            "            break;"
+            "        }"
+            "        sum += float(i);"
+            "    }"
+            "    return sum;"
+            "}",
+         [](float x, float y) {
+             float sum = 0;
+             for (int i = 0; i < 10; ++i) {
+                 if (i == (int) y + 2) {
+                     continue;
+                 }
+                 if ((float) i > x) {
+                     break;
+                 }
+                 sum += (float) i;
+             }
+             return sum;
+         });
+    test(r, "float test(float x, float y) { while (x < 3) { x += 1.5; y += 1; } return y; }",
+         [](float x, float y) {
+             while (x < 3) {
+                 x += 1.5f;
+                 y += 1;
+             }
+             return y;
+         });
+    test(r, "float test(float x, float y) { int n = 0; do { x -= 1; ++n; } while (x > y); "
+            "return float(n); }",
+         [](float x, float y) {
+             int n = 0;
+             do {
+                 x -= 1;
+                 ++n;
+             } while (x > y);
+             return (float) n;
+         });
+    test(r, "float test(float x, float y) {"
+            "    for (int i = 0; i < 4; ++i) {"
+            "        for (int j = 0; j < 4; ++j) {"
+            "            if (float(i * 4 + j) >= x + 4) {"
+            "                return float(i * 10 + j);"
+            "            }"
+            "        }"
+            "    }"
+            "    return -1;"
+            "}",
+         [](float x, float y) {
+             for (int i = 0; i < 4; ++i) {
+                 for (int j = 0; j < 4; ++j) {
+                     if ((float) (i * 4 + j) >= x + 4) {
+                         return (float) (i * 10 + j);
+                     }
+                 }
+             }
+             return -1.0f;
+         });
+}
+
+DEF_TEST(SkSLByteCodeCalls, r) {
+    test(r, "void scale(float x, out float a, inout float b) { a = x * 2; b *= x; }"
+            "float helper(float x) { if (x < 0) { return -x; } return x * x; }"
+            "float test(float x, float y) {"
+            "    float a, b = 3;"
+            "    scale(x, a, b);"
+            "    return a + b + helper(y) + helper(helper(x));"
+            "}",
+         [](float x, float y) {
+             auto helper = [](float v) { return v < 0 ? -v : v * v; };
+             return x * 2 + 3 * x + helper(y) + helper(helper(x));
+         });
+    test(r, "float sign_of(float x) { if (x > 0) { return 1; } else if (x < 0) { return -1; } "
+            "return 0; }"
+            "float test(float x, float y) {"
+            "    float sum = 0;"
+            "    for (int i = 0; i < 3; ++i) {"
+            "        sum += sign_of(x + y * float(i));"
+            "    }"
+            "    return sum;"
+            "}",
+         [](float x, float y) {
+             float sum = 0;
+             for (int i = 0; i < 3; ++i) {
+                 float v = x + y * (float) i;
+                 sum += v > 0 ? 1 : v < 0 ? -1 : 0;
+             }
+             return sum;
+         });
+}
+
+DEF_TEST(SkSLByteCodeIntrinsics, r) {
+    test(r, "float test(float x, float y) { return abs(x) + min(x, y) * 10 + max(x, y) * 100; }",
+         [](float x, float y) {
+             return std::fabs(x) + std::min(x, y) * 10 + std::max(x, y) * 100;
+         });
+    test(r, "float test(float x, float y) { return clamp(x, -1, y) + saturate(x) * 10; }",
+         [](float x, float y) {
+             return std::min(std::max(x, -1.0f), y) + std::min(std::max(x, 0.0f), 1.0f) * 10;
+         });
+    test(r, "float test(float x, float y) { return mix(x, y, 0.25) + mix(1, 2, x > y); }",
+         [](float x, float y) { return x + (y - x) * 0.25f + (x > y ? 2 : 1); });
+    test(r, "float test(float x, float y) { return floor(x) * 10 + ceil(x) + fract(x) * 100; }",
+         [](float x, float y) {
+             return std::floor(x) * 10 + std::ceil(x) + (x - std::floor(x)) * 100;
+         });
+    test(r, "float test(float x, float y) { return sqrt(abs(x)) + pow(abs(y), 1.5) + step(y, x); }",
+         [](float x, float y) {
+             return std::sqrt(std::fabs(x)) + std::pow(std::fabs(y), 1.5f) + (x < y ? 0 : 1);
+         });
+    test(r, "float test(float x, float y) { return sin(x) + cos(y) + exp(x * 0.5) + "
+            "log(abs(y) + 1); }",
+         [](float x, float y) {
+             return std::sin(x) + std::cos(y) + std::exp(x * 0.5f) + std::log(std::fabs(y) + 1);
+         });
+    test(r, "float test(float x, float y) { return length(float2(x, y)) + "
+            "normalize(float2(3, 4)).y * 10 + distance(float2(x), float2(y)); }",
+         [](float x, float y) {
+             return std::sqrt(x * x + y * y) + 8 + std::sqrt(2 * (x - y) * (x - y));
+         });
+}
+
+DEF_TEST(SkSLByteCodeErrors, r) {
+    test_error(r, "float test(float x) { return test(x); }", "recursive calls");
+    test_error(r, "float test(float x) { float2x2 m = float2x2(x); return m[0][0]; }",
+               "unsupported type");
+    test_error(r, "float test(float x) { float a[2]; a[0] = x; return a[0]; }",
+               "arrays are not supported");
+    test_error(r, "float test(float x) { return x % 2; }", "'%' is not supported on floats");
+    test_error(r, "float test(float2 v, int i) { return v[i]; }", "only constant indices");
+
+    // Each function calls the previous one twice, so inlining them all would take 2^40 copies.
+    SkSL::String src = "float f0(float x) { return x * x + 1; }\n";
+    for (int i = 1; i <= 40; ++i) {
+        src.appendf("float f%d(float x) { return f%d(f%d(x)); }\n", i, i - 1, i - 1);
+    }
+    src += "float test(float x) { return f40(x); }";
+    test_error(r, src.c_str(), "is too large");
+
+    // Calls nested too deeply are rejected even if they're small.
+    src = "float g0(float x) { return x + 1; }\n";
+    for (int i = 1; i <= 40; ++i) {
+        src.appendf("float g%d(float x) { return g%d(x) + 1; }\n", i, i - 1);
+    }
+    src += "float test(float x) { return g40(x); }";
+    test_error(r, src.c_str(), "nested too deeply");
+}
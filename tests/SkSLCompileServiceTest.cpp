@@ -0,0 +1,87 @@
+/*
+ * Copyright 2019 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkExecutor.h"
+#include "SkSLCompileService.h"
+#include "SkSLCompiler.h"
+#include "SkSLUtil.h"
+#include "SkString.h"
+#include "SkTaskGroup.h"
+
+#include "Test.h"
+
+static SkSL::CompileService::Job make_job(int i, const GrShaderCaps* caps) {
+    SkString src;
+    src.appendf("void main() { sk_FragColor = half4(%d.0 / 64.0, half(sk_FragCoord.y), 0, 1); }",
+                i);
+    SkSL::CompileService::Job job;
+    job.fText = SkSL::String(src.c_str());
+    job.fSettings.fCaps = caps;
+    job.fSettings.fFlipY = true;
+    return job;
+}
+
+static void check_results(skiatest::Reporter* r, const SkSL::CompileService::Job jobs[],
+                          const SkSL::CompileService::Result results[], int count) {
+    SkSL::Compiler compiler;
+    for (int i = 0; i < count; ++i) {
+        std::unique_ptr<SkSL::Program> program =
+                compiler.convertProgram(jobs[i].fKind, jobs[i].fText, jobs[i].fSettings);
+        SkSL::String expected;
+        REPORTER_ASSERT(r, program && compiler.toGLSL(*program, &expected));
+        REPORTER_ASSERT(r, results[i].fSuccess);
+        REPORTER_ASSERT(r, results[i].fCode == expected);
+        REPORTER_ASSERT(r, results[i].fInputs.fRTHeight);
+    }
+}
+
+DEF_TEST(SkSLCompileService, r) {
+    static constexpr int kCount = 24;
+    sk_sp<GrShaderCaps> caps = SkSL::ShaderCapsFactory::Default();
+    SkSL::CompileService::Job jobs[kCount];
+    for (int i = 0; i < kCount; ++i) {
+        jobs[i] = make_job(i, caps.get());
+    }
+    SkSL::CompileService::Result results[kCount];
+
+    // Without an executor everything runs on this thread with a single compiler.
+    {
+        SkSL::CompileService service;
+        service.compile(jobs, kCount, results);
+        check_results(r, jobs, results, kCount);
+        service.compile(jobs, kCount, results);
+        REPORTER_ASSERT(r, 1 == service.compilersCreated());
+    }
+
+    // With an executor, compilers are created on demand and reused by later batches.
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(3);
+    SkSL::CompileService service(executor.get(), 4);
+    service.warmUp(2);
+    REPORTER_ASSERT(r, 2 == service.compilersCreated());
+    service.compile(jobs, kCount, results);
+    check_results(r, jobs, results, kCount);
+    int created = service.compilersCreated();
+    REPORTER_ASSERT(r, created >= 2 && created <= 4);
+    service.compile(jobs, kCount, results);
+    REPORTER_ASSERT(r, created == service.compilersCreated());
+
+    // The service may be used from several threads at once.
+    SkSL::CompileService::Result concurrent[4][kCount];
+    SkTaskGroup().batch(4, [&](int i) {
+        service.compile(jobs, kCount, concurrent[i]);
+    });
+    for (const auto& batch : concurrent) {
+        check_results(r, jobs, batch, kCount);
+    }
+
+    // Errors are reported per job and don't affect the other jobs.
+    jobs[1].fText = "void main() { sk_FragColor = undefined; }";
+    service.compile(jobs, 3, results);
+    REPORTER_ASSERT(r, results[0].fSuccess && results[2].fSuccess);
+    REPORTER_ASSERT(r, !results[1].fSuccess);
+    REPORTER_ASSERT(r, !results[1].fErrors.empty());
+}
@@ -0,0 +1,214 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkFont.h"
+#include "SkOSFile.h"
+#include "SkOSPath.h"
+#include "SkPath.h"
+#include "SkStream.h"
+#include "SkStrike.h"
+#include "SkStrikeCache.h"
+#include "SkSurfaceProps.h"
+#include "SkTaskGroup.h"
+#include "SkTypeface.h"
+#include "Test.h"
+
+#include <atomic>
+
+// Threads asking a shared-strike cache for the same font should all get the same strike, and
+// its glyphs should match those of an ordinary exclusive strike.
+DEF_TEST(SkStrikeCache_shared, reporter) {
+    SkFont font;
+    font.setSize(24);
+    font.setEdging(SkFont::Edging::kAntiAlias);
+    SkPaint paint;
+
+    SkAutoDescriptor ad;
+    SkScalerContextEffects effects;
+    const SkDescriptor* desc = SkScalerContext::CreateDescriptorAndEffectsUsingPaint(
+            font, paint, SkSurfaceProps(0, kUnknown_SkPixelGeometry),
+            SkScalerContextFlags::kNone, SkMatrix::I(), &ad, &effects);
+    SkTypeface* typeface = font.getTypefaceOrDefault();
+
+    SkGlyphID glyphs[64];
+    int glyphCount = SkTMin(typeface->countGlyphs(), (int)SK_ARRAY_COUNT(glyphs));
+    for (int i = 0; i < glyphCount; i++) {
+        glyphs[i] = SkToU16(i);
+    }
+
+    SkStrikeCache sharedCache;
+    sharedCache.setSharedStrikes(true);
+
+    const int kThreads = 8;
+    SkStrike* strikes[kThreads];
+    std::atomic<int> missingImages{0};
+    SkTaskGroup().batch(kThreads, [&](int thread) {
+        auto strike = sharedCache.findOrCreateStrikeExclusive(*desc, effects, *typeface);
+        strikes[thread] = strike.get();
+        // Start each thread at a different glyph so they race to make them.
+        for (int i = 0; i < glyphCount; i++) {
+            const SkGlyph& glyph = strike->getGlyphIDMetrics(glyphs[(i + thread) % glyphCount]);
+            if (!glyph.isEmpty() && glyph.fWidth < kMaxGlyphWidth &&
+                strike->findImage(glyph) == nullptr) {
+                missingImages++;
+            }
+        }
+    });
+
+    REPORTER_ASSERT(reporter, missingImages == 0);
+    REPORTER_ASSERT(reporter, sharedCache.getCacheCountUsed() == 1);
+    for (int i = 1; i < kThreads; i++) {
+        REPORTER_ASSERT(reporter, strikes[i] == strikes[0]);
+    }
+    REPORTER_ASSERT(reporter, strikes[0]->isShared());
+    REPORTER_ASSERT(reporter, strikes[0]->countCachedGlyphs() == glyphCount);
+
+    SkStrikeCache exclusiveCache;
+    auto shared    = sharedCache.findOrCreateStrikeExclusive(*desc, effects, *typeface);
+    auto exclusive = exclusiveCache.findOrCreateStrikeExclusive(*desc, effects, *typeface);
+    REPORTER_ASSERT(reporter, !exclusive->isShared());
+    for (int i = 0; i < glyphCount; i++) {
+        const SkGlyph& a = shared->getGlyphIDMetrics(glyphs[i]);
+        const SkGlyph& b = exclusive->getGlyphIDMetrics(glyphs[i]);
+        REPORTER_ASSERT(reporter, a.fWidth == b.fWidth && a.fHeight == b.fHeight &&
+                                  a.fTop == b.fTop && a.fLeft == b.fLeft &&
+                                  a.fAdvanceX == b.fAdvanceX && a.fAdvanceY == b.fAdvanceY);
+        const void* aImage = shared->findImage(a);
+        const void* bImage = exclusive->findImage(b);
+        REPORTER_ASSERT(reporter, (aImage == nullptr) == (bImage == nullptr));
+        if (aImage && bImage) {
+            REPORTER_ASSERT(reporter, 0 == memcmp(aImage, bImage, a.computeImageSize()));
+        }
+    }
+}
+
+static int count_glyph_files(const char dir[]) {
+    int count = 0;
+    SkOSFile::Iter iter(dir, ".glyphs");
+    for (SkString name; iter.next(&name); ) {
+        count++;
+    }
+    return count;
+}
+
+// Glyphs read back from the disk cache should match freshly made ones, and only glyphs the file
+// didn't have should make the strike save again.
+DEF_TEST(SkStrikeCache_diskCache, reporter) {
+    SkString tmpDir = skiatest::GetTmpDir();
+    if (tmpDir.isEmpty()) {
+        return;
+    }
+    SkString dir = SkOSPath::Join(tmpDir.c_str(), "glyph_disk_cache");
+    sk_mkdir(dir.c_str());
+    {
+        SkOSFile::Iter iter(dir.c_str(), ".glyphs");
+        for (SkString name; iter.next(&name); ) {
+            remove(SkOSPath::Join(dir.c_str(), name.c_str()).c_str());
+        }
+    }
+
+    SkFont font;
+    font.setSize(18);
+    SkPaint paint;
+    SkAutoDescriptor ad;
+    SkScalerContextEffects effects;
+    const SkDescriptor* desc = SkScalerContext::CreateDescriptorAndEffectsUsingPaint(
+            font, paint, SkSurfaceProps(0, kUnknown_SkPixelGeometry),
+            SkScalerContextFlags::kNone, SkMatrix::I(), &ad, &effects);
+    SkTypeface* typeface = font.getTypefaceOrDefault();
+    const int glyphCount = SkTMin(typeface->countGlyphs(), 32);
+
+    // Make metrics and images for every glyph, but paths only for the even ones.
+    auto use = [&](SkStrikeCache* cache, bool oddPaths) {
+        auto strike = cache->findOrCreateStrikeExclusive(*desc, effects, *typeface);
+        for (int i = 0; i < glyphCount; i++) {
+            const SkGlyph& glyph = strike->getGlyphIDMetrics(SkToU16(i));
+            strike->findImage(glyph);
+            if (i % 2 == 0 || oddPaths) {
+                strike->findPath(glyph);
+            }
+        }
+    };
+
+    SkStrikeCache reference;
+    auto expected = reference.findOrCreateStrikeExclusive(*desc, effects, *typeface);
+    auto check = [&](SkStrikeCache* cache) {
+        auto strike = cache->findOrCreateStrikeExclusive(*desc, effects, *typeface);
+        for (int i = 0; i < glyphCount; i++) {
+            const SkGlyph& a = strike->getGlyphIDMetrics(SkToU16(i));
+            const SkGlyph& b = expected->getGlyphIDMetrics(SkToU16(i));
+            REPORTER_ASSERT(reporter, a.fWidth == b.fWidth && a.fHeight == b.fHeight &&
+                                      a.fTop == b.fTop && a.fLeft == b.fLeft &&
+                                      a.fAdvanceX == b.fAdvanceX && a.fAdvanceY == b.fAdvanceY &&
+                                      a.fMaskFormat == b.fMaskFormat);
+            const void* aImage = strike->findImage(a);
+            const void* bImage = expected->findImage(b);
+            REPORTER_ASSERT(reporter, (aImage == nullptr) == (bImage == nullptr));
+            if (aImage && bImage) {
+                REPORTER_ASSERT(reporter, 0 == memcmp(aImage, bImage, a.computeImageSize()));
+            }
+            if (i % 2 == 0) {
+                const SkPath* aPath = strike->findPath(a);
+                const SkPath* bPath = expected->findPath(b);
+                REPORTER_ASSERT(reporter, (aPath == nullptr) == (bPath == nullptr));
+                if (aPath && bPath) {
+                    REPORTER_ASSERT(reporter, *aPath == *bPath);
+                }
+            }
+        }
+    };
+
+    {
+        SkStrikeCache cache;
+        cache.setDiskCacheDirectory(dir.c_str());
+        use(&cache, false);
+        REPORTER_ASSERT(reporter, cache.saveDiskCache() == 1);
+        REPORTER_ASSERT(reporter, cache.saveDiskCache() == 0);
+    }
+    REPORTER_ASSERT(reporter, count_glyph_files(dir.c_str()) == 1);
+
+    {
+        // Everything comes from the file, so there's nothing new to save...
+        SkStrikeCache cache;
+        cache.setDiskCacheDirectory(dir.c_str());
+        check(&cache);
+        REPORTER_ASSERT(reporter, cache.saveDiskCache() == 0);
+
+        // ... until we ask for paths the file doesn't have.
+        use(&cache, true);
+        REPORTER_ASSERT(reporter, cache.saveDiskCache() == 1);
+    }
+    {
+        SkStrikeCache cache;
+        cache.setDiskCacheDirectory(dir.c_str());
+        use(&cache, true);
+        REPORTER_ASSERT(reporter, cache.saveDiskCache() == 0);
+    }
+
+    // A damaged file is ignored and then replaced.
+    SkString path;
+    {
+        SkOSFile::Iter iter(dir.c_str(), ".glyphs");
+        SkString name;
+        REPORTER_ASSERT(reporter, iter.next(&name));
+        path = SkOSPath::Join(dir.c_str(), name.c_str());
+    }
+    sk_sp<SkData> data = SkData::MakeFromFileName(path.c_str());
+    REPORTER_ASSERT(reporter, data);
+    if (data) {
+        // Copy it first; the file is mapped.
+        data = SkData::MakeWithCopy(data->data(), data->size() / 3);
+        SkFILEWStream(path.c_str()).write(data->data(), data->size());
+    }
+    {
+        SkStrikeCache cache;
+        cache.setDiskCacheDirectory(dir.c_str());
+        check(&cache);
+        REPORTER_ASSERT(reporter, cache.saveDiskCache() == 1);
+    }
+    REPORTER_ASSERT(reporter, count_glyph_files(dir.c_str()) == 1);
+}
@@ -15,6 +15,8 @@
 #include "SkCanvas.h"
 #include "SkData.h"
 #include "SkDevice.h"
+#include "SkExecutor.h"
+#include "SkFont.h"
 #include "SkGpuDevice.h"
 #include "SkImage_Base.h"
 #include "SkImage_Gpu.h"
@@ -1045,3 +1047,105 @@ DEF_TEST(surface_image_unity, reporter) {
         }
     }
 }
+
+// A threaded raster surface should draw what a plain raster surface draws.  Only the edges of
+// curves and lines that cross the edge of one of its tiles may come out a little differently.
+DEF_TEST(Surface_RasterThreaded, reporter) {
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeWorkStealingPool(4);
+
+    // Big enough to cover several tiles, and not a multiple of the tile size.
+    const SkImageInfo info = SkImageInfo::MakeN32Premul(700, 500);
+    auto serial   = SkSurface::MakeRaster(info);
+    auto threaded = SkSurface::MakeRasterThreaded(info, executor.get());
+    REPORTER_ASSERT(reporter, serial && threaded);
+
+    // Returns how many pixels differ between the two surfaces.
+    auto count_differences = [&] {
+        SkBitmap expected, actual;
+        expected.allocPixels(info);
+        actual.allocPixels(info);
+        REPORTER_ASSERT(reporter, serial->readPixels(expected, 0, 0));
+        REPORTER_ASSERT(reporter, threaded->readPixels(actual, 0, 0));
+
+        int differences = 0;
+        for (int y = 0; y < info.height(); y++) {
+            for (int x = 0; x < info.width(); x++) {
+                differences += *expected.getAddr32(x, y) != *actual.getAddr32(x, y);
+            }
+        }
+        return differences;
+    };
+
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(40, 30);
+    bitmap.eraseColor(0x8000FF00);
+    bitmap.setImmutable();
+
+    // Rects, sprites, glyph masks and points are clipped pixel by pixel, so these draw exactly
+    // the same even where they cross the edges of the 256x256 tiles.
+    auto draw_exact = [&](SkCanvas* canvas) {
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        canvas->clear(SK_ColorWHITE);
+        for (int i = 0; i < 20; i++) {
+            paint.setColor(0x80000000 | (i * 0x050301));
+            canvas->drawRect(SkRect::MakeXYWH(i * 33.3f, 230.5f + i * 1.7f, 40, 60), paint);
+        }
+        canvas->drawBitmap(bitmap, 240, 240);
+
+        SkPaint layerPaint;
+        layerPaint.setAlpha(0x80);
+        canvas->saveLayer(nullptr, &layerPaint);
+        paint.setColor(SK_ColorBLUE);
+        canvas->drawRect(SkRect::MakeXYWH(200, 200, 400, 250), paint);
+        canvas->drawString("threaded", 180, 270, SkFont(nullptr, 40), paint);
+        canvas->restore();
+
+        // Aliased points may be written straight into the pixels.
+        SkPoint grid[64];
+        for (int i = 0; i < 64; i++) {
+            grid[i] = { 200 + (i % 8) * 15.f, 200 + (i / 8) * 15.f };
+        }
+        paint.setAntiAlias(false);
+        paint.setColor(SK_ColorBLACK);
+        canvas->drawPoints(SkCanvas::kPoints_PointMode, SK_ARRAY_COUNT(grid), grid, paint);
+    };
+    draw_exact(serial->getCanvas());
+    draw_exact(threaded->getCanvas());
+    REPORTER_ASSERT(reporter, 0 == count_differences());
+
+    // Curves and lines are clipped to each tile they cross, like they are to the tiles of
+    // SkDrawTiler, which may change the pixels along their edges where they do.
+    auto draw_edges = [&](SkCanvas* canvas) {
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        canvas->clear(SK_ColorWHITE);
+        for (int i = 0; i < 50; i++) {
+            paint.setColor(0x80000000 | (i * 0x050301));
+            canvas->drawCircle(i * 14.f, 250 + 200 * SkScalarSin(i * 0.3f), 30, paint);
+        }
+
+        canvas->save();
+        canvas->rotate(20);
+        canvas->clipRect(SkRect::MakeXYWH(100, 50, 400, 300));
+        paint.setStyle(SkPaint::kStroke_Style);
+        paint.setStrokeWidth(7);
+        canvas->drawRRect(SkRRect::MakeRectXY(SkRect::MakeXYWH(50, 80, 500, 250), 40, 40),
+                          paint);
+        canvas->drawBitmap(bitmap, 300, 100);
+        canvas->restore();
+
+        const SkPoint pts[] = { {10, 10}, {690, 490}, {10, 490}, {690, 10} };
+        canvas->drawPoints(SkCanvas::kLines_PointMode, SK_ARRAY_COUNT(pts), pts, paint);
+    };
+    draw_edges(serial->getCanvas());
+    draw_edges(threaded->getCanvas());
+    REPORTER_ASSERT(reporter, count_differences() < info.width() * info.height() / 25);
+
+    // A snapshot must see every draw made before it.
+    threaded->getCanvas()->drawColor(SK_ColorRED);
+    sk_sp<SkImage> snapshot = threaded->makeImageSnapshot();
+    SkPixmap pm;
+    REPORTER_ASSERT(reporter, snapshot->peekPixels(&pm));
+    REPORTER_ASSERT(reporter, SK_ColorRED == pm.getColor(699, 499));
+}
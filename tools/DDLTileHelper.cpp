@@ -11,11 +11,16 @@
 #include "SkCanvas.h"
 #include "SkDeferredDisplayListPriv.h"
 #include "SkDeferredDisplayListRecorder.h"
+#include "SkExecutor.h"
 #include "SkImage_Gpu.h"
+#include "SkMutex.h"
 #include "SkPicture.h"
+#include "SkSemaphore.h"
 #include "SkSurface.h"
 #include "SkSurfaceCharacterization.h"
 #include "SkTaskGroup.h"
+#include "SkTDArray.h"
+#include "SkTime.h"
 
 DDLTileHelper::TileData::TileData(sk_sp<SkSurface> s, const SkIRect& clip)
         : fSurface(std::move(s))
@@ -136,10 +141,11 @@ void DDLTileHelper::createSKPPerTile(SkData* compressedPictureData,
     }
 }
 
-void DDLTileHelper::createDDLsInParallel() {
+void DDLTileHelper::createDDLsInParallel(SkExecutor* executor) {
 #if 1
-    SkTaskGroup().batch(fTiles.count(), [&](int i) { fTiles[i].createDDL(); });
-    SkTaskGroup().wait();
+    SkTaskGroup group(executor ? *executor : SkExecutor::GetDefault());
+    group.batch(fTiles.count(), [&](int i) { fTiles[i].createDDL(); });
+    group.wait();
 #else
     // Use this code path to debug w/o threads
     for (int i = 0; i < fTiles.count(); ++i) {
@@ -158,6 +164,48 @@ void DDLTileHelper::drawAllTilesAndFlush(GrContext* context, bool flush) {
     }
 }
 
+void DDLTileHelper::createAndDrawDDLsConcurrently(SkExecutor* recordExecutor, GrContext* context,
+                                                  bool flush, double* drawTime) {
+    // The recording threads queue up the tiles in the order they finish, and signal 'recorded'
+    // once per tile. This thread is the only one taking tiles off the queue.
+    SkMutex mutex;
+    SkTDArray<int> queue;
+    SkSemaphore recorded;
+    queue.setReserve(fTiles.count());
+    SkTaskGroup group(recordExecutor ? *recordExecutor : SkExecutor::GetDefault());
+    group.batch(fTiles.count(), [&](int i) {
+        fTiles[i].createDDL();
+        {
+            SkAutoMutexAcquire lock(mutex);
+            queue.push_back(i);
+        }
+        recorded.signal();
+    });
+
+    double drawSum = 0;
+    for (int drawn = 0; drawn < fTiles.count(); ++drawn) {
+        recorded.wait();
+        int tile;
+        {
+            SkAutoMutexAcquire lock(mutex);
+            tile = queue[drawn];
+        }
+        double start = SkTime::GetSecs();
+        fTiles[tile].draw();
+        drawSum += SkTime::GetSecs() - start;
+    }
+    // The last tasks may still be returning from signal(), and they refer to our locals.
+    group.wait();
+    if (flush) {
+        double start = SkTime::GetSecs();
+        context->flush();
+        drawSum += SkTime::GetSecs() - start;
+    }
+    if (drawTime) {
+        *drawTime = drawSum;
+    }
+}
+
 void DDLTileHelper::composeAllTiles(SkCanvas* dstCanvas) {
     for (int i = 0; i < fTiles.count(); ++i) {
         fTiles[i].compose(dstCanvas);
@@ -16,6 +16,7 @@ class DDLPromiseImageHelper;
 class SkCanvas;
 class SkData;
 class SkDeferredDisplayList;
+class SkExecutor;
 class SkPicture;
 class SkSurface;
 class SkSurfaceCharacterization;
@@ -61,10 +62,17 @@ public:
 
     void createSKPPerTile(SkData* compressedPictureData, const DDLPromiseImageHelper& helper);
 
-    void createDDLsInParallel();
+    // Records the tiles' DDLs on the threads of 'executor', or of the default executor.
+    void createDDLsInParallel(SkExecutor* executor = nullptr);
 
     void drawAllTilesAndFlush(GrContext*, bool flush);
 
+    // Records the tiles' DDLs on the threads of 'recordExecutor' and, on this thread, draws each
+    // into its tile as soon as it has been recorded, rather than waiting for all of them. Only this
+    // thread uses the GrContext. If 'drawTime' isn't null it is set to the seconds spent drawing.
+    void createAndDrawDDLsConcurrently(SkExecutor* recordExecutor, GrContext*, bool flush,
+                                       double* drawTime = nullptr);
+
     void composeAllTiles(SkCanvas* dstCanvas);
 
     void resetAllTiles();
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkCanvas.h"
+#include "SkCommandLineFlags.h"
+#include "SkOSFile.h"
+#include "SkOSPath.h"
+#include "SkPicture.h"
+#include "SkRasterPipeline.h"
+#include "SkStream.h"
+#include "SkSurface.h"
+#include "SkTime.h"
+
+#include <algorithm>
+#include <stdio.h>
+
+// Draws each SKP into a raster surface and reports which SkRasterPipeline stages forced the
+// pipelines built along the way to fall back from lowp to highp, along with the draw time.
+// Skia only counts fallbacks in debug builds, or with SK_RASTER_PIPELINE_COUNT_LOWP_FALLBACKS=1.
+// Build release with that define to get both the counts and meaningful timings; debug builds
+// report the counts alone.
+
+DEFINE_string2(skps, s, "skps", "A path to a directory of skps or a single skp.");
+DEFINE_int32(loops, 1, "How many times to draw each skp.");
+DEFINE_bool(f16, false, "Draw into an F16 surface instead of N32.");
+
+static const char* kStageNames[] = {
+#define M(stage) #stage,
+    SK_RASTER_PIPELINE_STAGES(M)
+#undef M
+};
+
+static bool report(const SkString& path, SkRasterPipeline::LowpFallbacks* totals) {
+    std::unique_ptr<SkStream> stream = SkStream::MakeFromFile(path.c_str());
+    sk_sp<SkPicture> pic = stream ? SkPicture::MakeFromStream(stream.get()) : nullptr;
+    if (!pic) {
+        fprintf(stderr, "Could not read %s.\n", path.c_str());
+        return false;
+    }
+
+    SkIRect bounds = pic->cullRect().roundOut();
+    auto info = SkImageInfo::Make(std::min(bounds.width(), 2048), std::min(bounds.height(), 2048),
+                                  FLAGS_f16 ? kRGBA_F16_SkColorType : kN32_SkColorType,
+                                  kPremul_SkAlphaType);
+    auto surface = SkSurface::MakeRaster(info);
+    if (!surface) {
+        fprintf(stderr, "Could not make a %dx%d surface for %s.\n",
+                info.width(), info.height(), path.c_str());
+        return false;
+    }
+
+    SkRasterPipeline::ResetLowpFallbacks();
+    double start = SkTime::GetMSecs();
+    for (int i = 0; i < FLAGS_loops; i++) {
+        surface->getCanvas()->clear(SK_ColorTRANSPARENT);
+        surface->getCanvas()->drawPicture(pic);
+    }
+    double ms = (SkTime::GetMSecs() - start) / std::max(FLAGS_loops, 1);
+    auto counts = SkRasterPipeline::GetLowpFallbacks();
+
+#ifdef SK_DEBUG
+    (void)ms;
+    printf("%s\n", SkOSPath::Basename(path.c_str()).c_str());
+#else
+    printf("%s\t%.3fms\n", SkOSPath::Basename(path.c_str()).c_str(), ms);
+#endif
+    for (int i = 0; i < SkRasterPipeline::kNumStockStages; i++) {
+        if (counts.stages[i]) {
+            printf("\t%-32s %d\n", kStageNames[i], counts.stages[i]);
+            totals->stages[i] += counts.stages[i];
+        }
+    }
+    if (counts.rawFunctions) {
+        printf("\t%-32s %d\n", "(raw function)", counts.rawFunctions);
+        totals->rawFunctions += counts.rawFunctions;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    SkCommandLineFlags::SetUsage("Usage: lowp_fallbacks -s <dir of skps or skp> [--loops N]\n");
+    SkCommandLineFlags::Parse(argc, argv);
+    if (!SkRasterPipeline::CountsLowpFallbacks()) {
+        fprintf(stderr, "This build doesn't count lowp fallbacks.  "
+                        "Rebuild with SK_RASTER_PIPELINE_COUNT_LOWP_FALLBACKS=1.\n");
+        return 1;
+    }
+#ifdef SK_DEBUG
+    fprintf(stderr, "Debug build: draw times are not reported.\n");
+#endif
+
+    SkRasterPipeline::LowpFallbacks totals;
+    std::fill(std::begin(totals.stages), std::end(totals.stages), 0);
+    totals.rawFunctions = 0;
+
+    const char* inputs = FLAGS_skps[0];
+    if (sk_isdir(inputs)) {
+        SkOSFile::Iter iter(inputs, "skp");
+        for (SkString file; iter.next(&file); ) {
+            report(SkOSPath::Join(inputs, file.c_str()), &totals);
+        }
+    } else if (!report(SkString(inputs), &totals)) {
+        return 1;
+    }
+
+    printf("total\n");
+    for (int i = 0; i < SkRasterPipeline::kNumStockStages; i++) {
+        if (totals.stages[i]) {
+            printf("\t%-32s %d\n", kStageNames[i], totals.stages[i]);
+        }
+    }
+    if (totals.rawFunctions) {
+        printf("\t%-32s %d\n", "(raw function)", totals.rawFunctions);
+    }
+    return 0;
+}
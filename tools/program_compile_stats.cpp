@@ -0,0 +1,103 @@
+/*
+ * Copyright 2019 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkCommandLineFlags.h"
+#include "SkData.h"
+#include "SkOpts.h"
+#include "SkSLCompiler.h"
+#include "SkSLUtil.h"
+#include "gl/GrGLPrecompiler.h"
+
+#include <algorithm>
+#include <stdio.h>
+
+// Reads the programs recorded by GrContext::dumpRecordedPrograms() (e.g. skpbench --writePrograms)
+// and converts each one from SkSL to GLSL on the CPU, reporting how long every stage took. No GPU
+// is needed to read a dump, but only GL contexts record programs; other backends, including the
+// mock context, have nothing to dump.
+
+DEFINE_string2(programs, p, "", "A file written by GrContext::dumpRecordedPrograms().");
+DEFINE_int32(loops, 1, "How many times to compile each program; the fastest time is reported.");
+DEFINE_bool2(quiet, q, false, "Only print the summary.");
+
+static const char* kStageNames[kGrShaderTypeCount] = { "vs", "gs", "fs" };
+
+int main(int argc, char** argv) {
+    SkCommandLineFlags::Parse(argc, argv);
+    if (FLAGS_programs.isEmpty()) {
+        fprintf(stderr, "Missing --programs.\n");
+        return 1;
+    }
+    sk_sp<SkData> data = SkData::MakeFromFileName(FLAGS_programs[0]);
+    SkTArray<GrGLPrecompiler::Entry> entries;
+    if (!data || !GrGLPrecompiler::Parse(*data, &entries)) {
+        fprintf(stderr, "Could not read programs from %s.\n", FLAGS_programs[0]);
+        return 1;
+    }
+
+    sk_sp<GrShaderCaps> caps = SkSL::ShaderCapsFactory::Default();
+    SkSL::Compiler compiler;
+
+    if (!FLAGS_quiet) {
+        printf("program\tkey hash\t");
+        for (const char* stage : kStageNames) {
+            printf("%s sksl\t%s glsl\t%s ms\t", stage, stage, stage);
+        }
+        printf("total ms\n");
+    }
+
+    int failures = 0;
+    double totalMs = 0, maxMs = 0;
+    size_t totalSkSL = 0, totalGLSL = 0;
+    for (int i = 0; i < entries.count(); ++i) {
+        const GrGLPrecompiler::Entry& entry = entries[i];
+        GrGLPrecompiler::Stats best;
+        double bestMs = -1;
+        bool ok = true;
+        for (int loop = 0; ok && loop < std::max(FLAGS_loops, 1); ++loop) {
+            GrGLPrecompiler::Program program;
+            GrGLPrecompiler::Stats stats;
+            ok = GrGLPrecompiler::Compile(&compiler, caps.get(), entry, &program, &stats);
+            double ms = 0;
+            for (double stageMs : stats.fCompileMs) {
+                ms += stageMs;
+            }
+            if (ok && (bestMs < 0 || ms < bestMs)) {
+                best = stats;
+                bestMs = ms;
+            }
+        }
+        if (!ok) {
+            fprintf(stderr, "Program %d failed to compile:\n%s\n", i,
+                    compiler.errorText().c_str());
+            ++failures;
+            continue;
+        }
+
+        totalMs += bestMs;
+        maxMs = std::max(maxMs, bestMs);
+        for (int s = 0; s < kGrShaderTypeCount; ++s) {
+            totalSkSL += best.fSkSLLength[s];
+            totalGLSL += best.fGLSLLength[s];
+        }
+        if (!FLAGS_quiet) {
+            printf("%d\t%08x\t", i, SkOpts::hash(entry.fKey.c_str(), entry.fKey.size()));
+            for (int s = 0; s < kGrShaderTypeCount; ++s) {
+                printf("%zu\t%zu\t%.3f\t",
+                       best.fSkSLLength[s], best.fGLSLLength[s], best.fCompileMs[s]);
+            }
+            printf("%.3f\n", bestMs);
+        }
+    }
+
+    int compiled = entries.count() - failures;
+    printf("%d programs compiled (%d failed): %.3f ms total, %.3f ms mean, %.3f ms max, "
+           "%zu bytes SkSL -> %zu bytes GLSL\n",
+           compiled, failures, totalMs, compiled ? totalMs / compiled : 0.0, maxMs,
+           totalSkSL, totalGLSL);
+    return failures ? 1 : 0;
+}
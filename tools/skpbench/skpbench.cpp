@@ -58,6 +58,7 @@ DEFINE_bool(ddl, false, "record the skp into DDLs before rendering");
 DEFINE_int32(ddlNumAdditionalThreads, 0, "number of DDL recording threads in addition to main one");
 DEFINE_int32(ddlTilingWidthHeight, 0, "number of tiles along one edge when in DDL mode");
 DEFINE_bool(ddlRecordTime, false, "report just the cpu time spent recording DDLs");
+DEFINE_bool(ddlDrawAsRecorded, false, "draw each DDL on the main thread as soon as it is recorded");
 
 DEFINE_int32(duration, 5000, "number of milliseconds to run the benchmark");
 DEFINE_int32(sampleMs, 50, "minimum duration of a sample");
@@ -65,11 +66,15 @@ DEFINE_bool(gpuClock, false, "time on the gpu clock (gpu work only)");
 DEFINE_bool(fps, false, "use fps instead of ms");
 DEFINE_string(src, "", "path to a single .skp or .svg file, or 'warmup' for a builtin warmup run");
 DEFINE_string(png, "", "if set, save a .png proof to disk at this file location");
+DEFINE_string(writePrograms, "",
+              "if set, record the GPU programs built during the run to this file");
+DEFINE_string(precompile, "", "if set, precompile the GPU programs from a --writePrograms file");
 DEFINE_int32(verbosity, 4, "level of verbosity (0=none to 5=debug)");
 DEFINE_bool(suppressHeader, false, "don't print a header row before the results");
 
 static const char* header =
-"   accum    median       max       min   stddev  samples  sample_ms  clock  metric  config    bench";
+"   accum    median       max       min   stddev  samples  sample_ms  clock  metric  config"
+"    bench";
 
 static const char* resultFormat =
 "%8.4g  %8.4g  %8.4g  %8.4g  %6.3g%%  %7li  %9i  %-5s  %-6s  %-9s %s";
@@ -125,10 +130,15 @@ static void ddl_sample(GrContext* context, DDLTileHelper* tiles, GpuSync* gpuSyn
 
     clock::time_point start = *startStopTime;
 
-    tiles->createDDLsInParallel();
-
-    if (!FLAGS_ddlRecordTime) {
-        tiles->drawAllTilesAndFlush(context, true);
+    if (FLAGS_ddlRecordTime) {
+        tiles->createDDLsInParallel();
+    } else {
+        if (FLAGS_ddlDrawAsRecorded) {
+            tiles->createAndDrawDDLsConcurrently(nullptr, context, true);
+        } else {
+            tiles->createDDLsInParallel();
+            tiles->drawAllTilesAndFlush(context, true);
+        }
         if (gpuSync) {
             gpuSync->syncToPreviousFrame();
         }
@@ -390,6 +400,7 @@ int main(int argc, char** argv) {
     // Create a context.
     GrContextOptions ctxOptions;
     SetCtxOptionsFromCommonFlags(&ctxOptions);
+    ctxOptions.fRecordProgramsForPrecompile = !FLAGS_writePrograms.isEmpty();
     sk_gpu_test::GrContextFactory factory(ctxOptions);
     sk_gpu_test::ContextInfo ctxInfo =
         factory.getContextInfo(config->getContextType(), config->getContextOverrides());
@@ -398,6 +409,16 @@ int main(int argc, char** argv) {
         exitf(ExitErr::kUnavailable, "failed to create context for config %s",
                                      config->getTag().c_str());
     }
+    if (!FLAGS_precompile.isEmpty()) {
+        sk_sp<SkData> programs = SkData::MakeFromFileName(FLAGS_precompile[0]);
+        if (!programs) {
+            exitf(ExitErr::kIO, "failed to read programs from \"%s\"", FLAGS_precompile[0]);
+        }
+        if (!ctx->precompile(*programs)) {
+            exitf(ExitErr::kData, "failed to precompile programs from \"%s\"",
+                                  FLAGS_precompile[0]);
+        }
+    }
     if (ctx->maxRenderTargetSize() < SkTMax(width, height)) {
         exitf(ExitErr::kUnavailable, "render target size %ix%i not supported by platform (max: %i)",
               width, height, ctx->maxRenderTargetSize());
@@ -477,6 +498,15 @@ int main(int argc, char** argv) {
         }
     }
 
+    // Save the programs that were built (if requested).
+    if (!FLAGS_writePrograms.isEmpty()) {
+        sk_sp<SkData> programs = ctx->dumpRecordedPrograms();
+        SkFILEWStream stream(FLAGS_writePrograms[0]);
+        if (!programs || !stream.isValid() || !stream.write(programs->data(), programs->size())) {
+            exitf(ExitErr::kIO, "failed to write programs to \"%s\"", FLAGS_writePrograms[0]);
+        }
+    }
+
     exit(0);
 }
 